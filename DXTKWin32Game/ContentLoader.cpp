@@ -0,0 +1,128 @@
+//
+// ContentLoader.cpp
+//
+
+#include "pch.h"
+#include "ContentLoader.h"
+
+using namespace DX;
+
+ContentLoader::ContentLoader(uint32_t threadCount) :
+    m_exiting(false),
+    m_addedCount(0),
+    m_finishedCount(0),
+    m_failedCount(0)
+{
+    // At least two threads, so file reads overlap even on a single core.
+    if (threadCount == 0)
+    {
+        unsigned cores = std::thread::hardware_concurrency();
+        threadCount = (cores > 3) ? cores - 1 : 2;
+    }
+
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        m_threads.emplace_back([this]() { Run(); });
+    }
+}
+
+ContentLoader::~ContentLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exiting = true;
+        m_jobs.clear();
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+void ContentLoader::Add(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+        m_addedCount++;
+    }
+    m_wake.notify_one();
+}
+
+bool ContentLoader::IsDone() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finishedCount == m_addedCount;
+}
+
+void ContentLoader::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_finishedCount == m_addedCount; });
+}
+
+float ContentLoader::GetProgress() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return (m_addedCount > 0) ? static_cast<float>(m_finishedCount) / static_cast<float>(m_addedCount) : 1.0f;
+}
+
+uint32_t ContentLoader::GetAddedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_addedCount;
+}
+
+uint32_t ContentLoader::GetFinishedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finishedCount;
+}
+
+uint32_t ContentLoader::GetFailedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failedCount;
+}
+
+void ContentLoader::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_wake.wait(lock, [this]() { return !m_jobs.empty() || m_exiting; });
+
+        if (m_exiting)
+            break;
+
+        Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+
+        // A missing or corrupt file only loses that piece of content.
+        bool succeeded = true;
+        lock.unlock();
+        try
+        {
+            job();
+        }
+        catch (...)
+        {
+            succeeded = false;
+        }
+        lock.lock();
+
+        m_finishedCount++;
+        if (!succeeded)
+        {
+            m_failedCount++;
+        }
+
+        if (m_finishedCount == m_addedCount)
+        {
+            m_done.notify_all();
+        }
+    }
+}
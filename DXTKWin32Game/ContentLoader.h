@@ -0,0 +1,67 @@
+//
+// ContentLoader.h - Loads content on a pool of worker threads
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+    // Runs loading jobs, such as reading and creating textures, in parallel while the UI
+    // thread keeps pumping messages and drawing a loading screen. Jobs run in the order
+    // added, as threads free up. A job that throws only counts as failed.
+    //
+    // Each job should write its result somewhere only it touches, and the UI thread should
+    // read results once IsDone returns true, which orders the jobs' writes before the read.
+    class ContentLoader
+    {
+    public:
+        typedef std::function<void()> Job;
+
+        // Zero uses one thread per core beyond the one running the UI, and at least two.
+        explicit ContentLoader(uint32_t threadCount = 0);
+
+        // Drops jobs that haven't started, and waits for those that have.
+        ~ContentLoader();
+
+        ContentLoader(ContentLoader const&) = delete;
+        ContentLoader& operator= (ContentLoader const&) = delete;
+
+        void Add(Job job);
+
+        // Whether every job added so far has finished.
+        bool IsDone() const;
+
+        // Blocks until IsDone.
+        void Wait();
+
+        // Finished jobs over added ones; 1 when nothing was added.
+        float GetProgress() const;
+
+        uint32_t GetAddedCount() const;
+        uint32_t GetFinishedCount() const;
+        uint32_t GetFailedCount() const;
+        uint32_t GetThreadCount() const     { return static_cast<uint32_t>(m_threads.size()); }
+
+    private:
+        void Run();
+
+        mutable std::mutex          m_mutex;
+        std::condition_variable     m_wake;
+        std::condition_variable     m_done;
+        std::deque<Job>             m_jobs;
+        bool                        m_exiting;
+        uint32_t                    m_addedCount;
+        uint32_t                    m_finishedCount;
+        uint32_t                    m_failedCount;
+
+        std::vector<std::thread>    m_threads;
+    };
+}
@@ -0,0 +1,67 @@
+//
+// DebugDraw.cpp
+//
+
+#include "pch.h"
+#include "DebugDraw.h"
+
+using namespace DirectX;
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+static_assert(sizeof(DebugVertex) == sizeof(VertexPositionColor), "DebugVertex must match VertexPositionColor");
+
+DebugDraw::DebugDraw(ID3D11DeviceContext* context) :
+    m_lastDrawCallCount(0)
+{
+    ComPtr<ID3D11Device> device;
+    context->GetDevice(device.GetAddressOf());
+
+    m_states = std::make_unique<CommonStates>(device.Get());
+
+    m_effect = std::make_unique<BasicEffect>(device.Get());
+    m_effect->SetVertexColorEnabled(true);
+
+    void const* shaderByteCode;
+    size_t byteCodeLength;
+    m_effect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+
+    DX::ThrowIfFailed(device->CreateInputLayout(
+        VertexPositionColor::InputElements, VertexPositionColor::InputElementCount,
+        shaderByteCode, byteCodeLength,
+        m_inputLayout.ReleaseAndGetAddressOf()));
+
+    // Sized so each batch the queue hands over is exactly one draw call.
+    m_batch = std::make_unique<PrimitiveBatch<VertexPositionColor>>(context, DebugDrawQueue::MaxBatchVertices * 3, DebugDrawQueue::MaxBatchVertices);
+}
+
+void DebugDraw::Render(ID3D11DeviceContext* context, const DebugDrawQueue& queue, FXMMATRIX view, CXMMATRIX projection)
+{
+    if (queue.GetVertexCount() == 0)
+    {
+        m_lastDrawCallCount = 0;
+        return;
+    }
+
+    context->OMSetBlendState(m_states->AlphaBlend(), nullptr, 0xFFFFFFFF);
+    context->OMSetDepthStencilState(m_states->DepthRead(), 0);
+    context->RSSetState(m_states->CullNone());
+
+    m_effect->SetWorld(XMMatrixIdentity());
+    m_effect->SetView(view);
+    m_effect->SetProjection(projection);
+    m_effect->Apply(context);
+
+    context->IASetInputLayout(m_inputLayout.Get());
+
+    m_batch->Begin();
+
+    m_lastDrawCallCount = queue.Flush([&](DebugTopology topology, const DebugVertex* vertices, size_t count)
+    {
+        D3D11_PRIMITIVE_TOPOLOGY primitiveTopology = (topology == DebugTopology::LineList) ? D3D11_PRIMITIVE_TOPOLOGY_LINELIST : D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        m_batch->Draw(primitiveTopology, reinterpret_cast<const VertexPositionColor*>(vertices), count);
+    });
+
+    m_batch->End();
+}
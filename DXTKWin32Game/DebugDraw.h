@@ -0,0 +1,33 @@
+//
+// DebugDraw.h - Draws a DebugDrawQueue with one PrimitiveBatch
+//
+
+#pragma once
+
+#include "DebugDrawQueue.h"
+
+namespace DX
+{
+    // Draws queued debug shapes over the scene, depth tested but not depth written, using
+    // a draw call per topology per MaxBatchVertices vertices.
+    class DebugDraw
+    {
+    public:
+        explicit DebugDraw(_In_ ID3D11DeviceContext* context);
+
+        DebugDraw(DebugDraw const&) = delete;
+        DebugDraw& operator= (DebugDraw const&) = delete;
+
+        void Render(_In_ ID3D11DeviceContext* context, const DebugDrawQueue& queue, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+
+        uint32_t GetLastDrawCallCount() const       { return m_lastDrawCallCount; }
+
+    private:
+        std::unique_ptr<DirectX::CommonStates>                              m_states;
+        std::unique_ptr<DirectX::BasicEffect>                               m_effect;
+        std::unique_ptr<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>> m_batch;
+        Microsoft::WRL::ComPtr<ID3D11InputLayout>                           m_inputLayout;
+
+        uint32_t                                                            m_lastDrawCallCount;
+    };
+}
@@ -0,0 +1,142 @@
+//
+// DebugDrawQueue.cpp
+//
+
+#include "pch.h"
+#include "DebugDrawQueue.h"
+
+#include <cmath>
+
+using namespace DX;
+
+namespace
+{
+    DebugFloat3 Add(const DebugFloat3& a, const DebugFloat3& b)
+    {
+        return DebugFloat3(a.x + b.x, a.y + b.y, a.z + b.z);
+    }
+
+    DebugFloat3 Scale(const DebugFloat3& v, float s)
+    {
+        return DebugFloat3(v.x * s, v.y * s, v.z * s);
+    }
+}
+
+void DebugDrawQueue::AddLine(const DebugFloat3& a, const DebugFloat3& b, const DebugColor& color)
+{
+    DebugVertex line[] = { { a, color }, { b, color } };
+    m_lines.insert(m_lines.end(), line, line + 2);
+}
+
+void DebugDrawQueue::AddTriangle(const DebugFloat3& a, const DebugFloat3& b, const DebugFloat3& c, const DebugColor& color)
+{
+    DebugVertex triangle[] = { { a, color }, { b, color }, { c, color } };
+    m_triangles.insert(m_triangles.end(), triangle, triangle + 3);
+}
+
+void DebugDrawQueue::AddBox(const DebugFloat3& center, const DebugFloat3& extents, const DebugColor& color)
+{
+    // Corner i takes the max of axis n when bit n of i is set.
+    DebugFloat3 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        corners[i] = DebugFloat3(
+            center.x + ((i & 1) ? extents.x : -extents.x),
+            center.y + ((i & 2) ? extents.y : -extents.y),
+            center.z + ((i & 4) ? extents.z : -extents.z));
+    }
+
+    // Each edge joins two corners differing in one bit.
+    for (int i = 0; i < 8; i++)
+    {
+        for (int bit = 1; bit < 8; bit <<= 1)
+        {
+            if (!(i & bit))
+            {
+                AddLine(corners[i], corners[i | bit], color);
+            }
+        }
+    }
+}
+
+void DebugDrawQueue::AddSphere(const DebugFloat3& center, float radius, const DebugColor& color, uint32_t segments)
+{
+    if (segments < 3)
+        segments = 3;
+
+    m_lines.reserve(m_lines.size() + segments * 6);
+
+    const float step = 6.28318530718f / segments;
+    float lastCos = 1.0f;
+    float lastSin = 0.0f;
+
+    for (uint32_t i = 1; i <= segments; i++)
+    {
+        float c = (i == segments) ? 1.0f : std::cos(step * i);
+        float s = (i == segments) ? 0.0f : std::sin(step * i);
+
+        AddLine(Add(center, DebugFloat3(lastCos * radius, lastSin * radius, 0.0f)), Add(center, DebugFloat3(c * radius, s * radius, 0.0f)), color);
+        AddLine(Add(center, DebugFloat3(0.0f, lastCos * radius, lastSin * radius)), Add(center, DebugFloat3(0.0f, c * radius, s * radius)), color);
+        AddLine(Add(center, DebugFloat3(lastSin * radius, 0.0f, lastCos * radius)), Add(center, DebugFloat3(s * radius, 0.0f, c * radius)), color);
+
+        lastCos = c;
+        lastSin = s;
+    }
+}
+
+void DebugDrawQueue::AddGrid(const DebugFloat3& origin, const DebugFloat3& xAxis, const DebugFloat3& yAxis, uint32_t xDivisions, uint32_t yDivisions, const DebugColor& color)
+{
+    if (xDivisions < 1)
+        xDivisions = 1;
+    if (yDivisions < 1)
+        yDivisions = 1;
+
+    m_lines.reserve(m_lines.size() + (xDivisions + yDivisions + 2) * 2);
+
+    for (uint32_t i = 0; i <= xDivisions; i++)
+    {
+        float percent = 2.0f * i / xDivisions - 1.0f;
+        DebugFloat3 offset = Add(origin, Scale(xAxis, percent));
+        AddLine(Add(offset, Scale(yAxis, -1.0f)), Add(offset, yAxis), color);
+    }
+
+    for (uint32_t i = 0; i <= yDivisions; i++)
+    {
+        float percent = 2.0f * i / yDivisions - 1.0f;
+        DebugFloat3 offset = Add(origin, Scale(yAxis, percent));
+        AddLine(Add(offset, Scale(xAxis, -1.0f)), Add(offset, xAxis), color);
+    }
+}
+
+void DebugDrawQueue::AddFrustum(const float (&m)[4][4], const DebugColor& color)
+{
+    // Near corners then far corners, each counterclockwise from the bottom left.
+    static const float ndc[4][2] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f } };
+
+    DebugFloat3 corners[8];
+    for (int i = 0; i < 8; i++)
+    {
+        float x = ndc[i % 4][0];
+        float y = ndc[i % 4][1];
+        float z = (i < 4) ? 0.0f : 1.0f;
+
+        float w = x * m[0][3] + y * m[1][3] + z * m[2][3] + m[3][3];
+        corners[i] = DebugFloat3(
+            (x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0]) / w,
+            (x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1]) / w,
+            (x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2]) / w);
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+        AddLine(corners[i], corners[(i + 1) % 4], color);
+        AddLine(corners[4 + i], corners[4 + (i + 1) % 4], color);
+        AddLine(corners[i], corners[4 + i], color);
+    }
+}
+
+void DebugDrawQueue::Clear()
+{
+    m_lines.clear();
+    m_triangles.clear();
+}
@@ -0,0 +1,115 @@
+//
+// DebugDrawQueue.h - Debug geometry collected during a frame for batched drawing
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+    // Plain vector and color types, so the queue doesn't depend on DirectXMath. With
+    // DirectXMath included they convert from its types and SimpleMath's.
+    struct DebugFloat3
+    {
+        float x;
+        float y;
+        float z;
+
+        DebugFloat3() : x(0.0f), y(0.0f), z(0.0f) {}
+        DebugFloat3(float x, float y, float z) : x(x), y(y), z(z) {}
+#if defined(DIRECTX_MATH_VERSION)
+        DebugFloat3(const DirectX::XMFLOAT3& v) : x(v.x), y(v.y), z(v.z) {}
+#endif
+    };
+
+    struct DebugColor
+    {
+        float r;
+        float g;
+        float b;
+        float a;
+
+        DebugColor() : r(1.0f), g(1.0f), b(1.0f), a(1.0f) {}
+        DebugColor(float r, float g, float b, float a = 1.0f) : r(r), g(g), b(b), a(a) {}
+#if defined(DIRECTX_MATH_VERSION)
+        DebugColor(const DirectX::XMFLOAT4& c) : r(c.x), g(c.y), b(c.z), a(c.w) {}
+        DebugColor(const DirectX::XMVECTORF32& c) : r(c.f[0]), g(c.f[1]), b(c.f[2]), a(c.f[3]) {}
+#endif
+    };
+
+    // Same layout as DirectX::VertexPositionColor.
+    struct DebugVertex
+    {
+        DebugFloat3 position;
+        DebugColor  color;
+    };
+
+    enum class DebugTopology
+    {
+        LineList,
+        TriangleList,
+    };
+
+    // Collects debug shapes from any system as vertices, one list per topology, so a frame's
+    // debug drawing costs a draw call per topology rather than one per shape. Shapes are in
+    // world space. Not thread safe; add shapes from the update thread.
+    class DebugDrawQueue
+    {
+    public:
+        // Vertices per draw call; Flush splits longer lists. Sized to DebugDraw's batch.
+        static const uint32_t MaxBatchVertices = 4096;
+
+        void AddLine(const DebugFloat3& a, const DebugFloat3& b, const DebugColor& color);
+        void AddTriangle(const DebugFloat3& a, const DebugFloat3& b, const DebugFloat3& c, const DebugColor& color);
+
+        // An axis-aligned box, as its center and half size.
+        void AddBox(const DebugFloat3& center, const DebugFloat3& extents, const DebugColor& color);
+
+        // Three circles around the axes.
+        void AddSphere(const DebugFloat3& center, float radius, const DebugColor& color, uint32_t segments = 24);
+
+        // A grid centered at origin, spanning -xAxis to xAxis and -yAxis to yAxis.
+        void AddGrid(const DebugFloat3& origin, const DebugFloat3& xAxis, const DebugFloat3& yAxis, uint32_t xDivisions, uint32_t yDivisions, const DebugColor& color);
+
+        // The frustum of a camera, given the inverse of its view times projection matrix
+        // (row vectors, as DirectXMath uses) and the D3D depth range of 0 to 1.
+        void AddFrustum(const float (&inverseViewProjection)[4][4], const DebugColor& color);
+
+        // Hands each topology's vertices to draw(topology, vertices, count), split so each
+        // call is at most MaxBatchVertices whole primitives. Returns the number of calls,
+        // which is the number of draw calls the frame's debug drawing costs.
+        template<typename TDraw>
+        uint32_t Flush(const TDraw& draw) const
+        {
+            return Flush(DebugTopology::LineList, m_lines, 2, draw) + Flush(DebugTopology::TriangleList, m_triangles, 3, draw);
+        }
+
+        // Call before adding a new frame's shapes. Kept until then, so frames without an
+        // update draw the last one again.
+        void Clear();
+
+        size_t GetVertexCount() const   { return m_lines.size() + m_triangles.size(); }
+
+    private:
+        template<typename TDraw>
+        static uint32_t Flush(DebugTopology topology, const std::vector<DebugVertex>& vertices, uint32_t verticesPerPrimitive, const TDraw& draw)
+        {
+            const size_t batchVertices = MaxBatchVertices - MaxBatchVertices % verticesPerPrimitive;
+
+            uint32_t drawCount = 0;
+            for (size_t start = 0; start < vertices.size(); start += batchVertices)
+            {
+                size_t count = vertices.size() - start;
+                draw(topology, vertices.data() + start, count < batchVertices ? count : batchVertices);
+                drawCount++;
+            }
+            return drawCount;
+        }
+
+        std::vector<DebugVertex>    m_lines;
+        std::vector<DebugVertex>    m_triangles;
+    };
+}
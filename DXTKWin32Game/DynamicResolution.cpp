@@ -0,0 +1,178 @@
+//
+// DynamicResolution.cpp
+//
+
+#include "pch.h"
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+
+const float DynamicResolution::Deadband = 0.05f;
+const float DynamicResolution::ScaleStep = 0.02f;
+const float DynamicResolution::Smoothing = 0.3f;
+
+namespace
+{
+    const float NoCeiling = 2.0f;
+
+    // A frame this far over the target, relative to it, is a hitch unless the one before
+    // missed too.
+    const float HitchError = 0.5f;
+
+    // Whether a probe tries the scale that missed last time. The controller drifts a little
+    // between probes, so a probe within half a step of it counts; otherwise a scale just
+    // under the budget gets probed at the short interval over and over.
+    bool ReachesCeiling(float probe, float ceiling)
+    {
+        return probe + DynamicResolution::ScaleStep * 0.5f >= ceiling;
+    }
+}
+
+DynamicResolution::DynamicResolution() :
+    m_targetTicks(TicksPerSecond / 60),
+    m_minScale(0.5f),
+    m_maxScale(1.0f),
+    m_proportional(0.3f),
+    m_integral(0.1f),
+    m_derivative(0.05f)
+{
+    Reset();
+}
+
+void DynamicResolution::SetScaleRange(float minScale, float maxScale)
+{
+    m_minScale = std::min(std::max(minScale, 0.1f), 1.0f);
+    m_maxScale = std::min(std::max(maxScale, m_minScale), 1.0f);
+
+    m_area = std::min(std::max(m_area, m_minScale * m_minScale), m_maxScale * m_maxScale);
+    m_scale = std::min(std::max(m_scale, m_minScale), m_maxScale);
+}
+
+void DynamicResolution::SetGains(float proportional, float integral, float derivative)
+{
+    m_proportional = proportional;
+    m_integral = integral;
+    m_derivative = derivative;
+}
+
+float DynamicResolution::Update(uint64_t frameTicks)
+{
+    // Positive when there is time to spare. Capped so one long hitch can't wipe out the
+    // resolution.
+    float error = (static_cast<float>(m_targetTicks) - static_cast<float>(frameTicks)) / static_cast<float>(m_targetTicks);
+    error = std::min(std::max(error, -0.5f), 0.5f);
+
+    // Frame time noise is smoothed out before it can move the scale, but a missed frame
+    // still counts against a probe right away. A lone frame far over budget is a hitch, such
+    // as a shader compile or a page fault, that a lower resolution wouldn't have avoided,
+    // so it only reaches the controller if the next frame misses as well.
+    bool missed = error < -Deadband;
+    bool hitch = error <= -HitchError && !m_lastMissed;
+    m_lastMissed = missed;
+
+    // A miss this soon after a probe is blamed on the probe. The frames already queued at
+    // the probe's scale miss as well, so misses in the window only undo the probe and don't
+    // reach the controller as load.
+    bool probing = m_framesSinceProbe < ProbeWindowFrames;
+    if (probing)
+    {
+        m_framesSinceProbe++;
+
+        if (missed && !m_probeMissed)
+        {
+            // The probe went too far, so go back to where it started. Probing that high
+            // again waits twice as long.
+            m_probeMissed = true;
+            m_ceiling = m_probeScale;
+            m_probeFrames = std::min(m_probeFrames * 2, uint32_t(MaxProbeFrames));
+            m_area = std::min(m_area, m_probeArea);
+        }
+        else if (m_framesSinceProbe == ProbeWindowFrames && !m_probeMissed && ReachesCeiling(m_probeScale, m_ceiling))
+        {
+            // It held at the old ceiling, so the load dropped.
+            m_ceiling = NoCeiling;
+            m_probeFrames = ProbeFrames;
+        }
+    }
+
+    if (!hitch && !(probing && missed))
+    {
+        m_smoothedError += Smoothing * (error - m_smoothedError);
+    }
+
+    error = m_smoothedError;
+    if (std::abs(error) < Deadband)
+    {
+        error = 0.0f;
+    }
+
+    // Incremental form: the output is a change in area, so clamping the area is all the
+    // anti-windup it needs.
+    float change = m_proportional * (error - m_lastError)
+        + m_integral * error
+        + m_derivative * (error - 2.0f * m_lastError + m_lastError2);
+
+    m_lastError2 = m_lastError;
+    m_lastError = error;
+
+    float minArea = m_minScale * m_minScale;
+    float maxArea = m_maxScale * m_maxScale;
+    m_area = std::min(std::max(m_area * (1.0f + change), minArea), maxArea);
+
+    if (error > 0.0f)
+    {
+        // Real headroom, so no need to guess.
+        m_ceiling = NoCeiling;
+        m_probeFrames = ProbeFrames;
+    }
+
+    if (error == 0.0f && m_scale < m_maxScale)
+    {
+        // Probes below the last failed one are cheap to try.
+        float probe = std::min(m_scale + ScaleStep, m_maxScale);
+        uint32_t wait = ReachesCeiling(probe, m_ceiling) ? m_probeFrames : ProbeFrames;
+
+        if (++m_settledFrames >= wait)
+        {
+            m_probeArea = m_area;
+            m_probeMissed = false;
+            m_area = std::max(m_area, probe * probe);
+            m_probeScale = probe;
+            m_settledFrames = 0;
+            m_framesSinceProbe = 0;
+        }
+    }
+    else
+    {
+        m_settledFrames = 0;
+    }
+
+    // Only move the scale handed out for a worthwhile change, or to reach the range's ends.
+    float scale = (m_area <= minArea) ? m_minScale : (m_area >= maxArea) ? m_maxScale : std::sqrt(m_area);
+    if (std::abs(scale - m_scale) >= ScaleStep - 0.0001f || ((scale == m_minScale || scale == m_maxScale) && scale != m_scale))
+    {
+        m_scale = scale;
+    }
+
+    return m_scale;
+}
+
+void DynamicResolution::Reset()
+{
+    m_area = m_maxScale * m_maxScale;
+    m_smoothedError = 0.0f;
+    m_lastError = 0.0f;
+    m_lastError2 = 0.0f;
+    m_lastMissed = false;
+    m_scale = m_maxScale;
+    m_settledFrames = 0;
+    m_probeFrames = ProbeFrames;
+    m_framesSinceProbe = ProbeWindowFrames;
+    m_probeScale = m_maxScale;
+    m_probeArea = m_area;
+    m_probeMissed = false;
+    m_ceiling = NoCeiling;
+}
@@ -0,0 +1,91 @@
+//
+// DynamicResolution.h - Picks a render scale that keeps frames within a time budget
+//
+
+#pragma once
+
+#include <stdint.h>
+
+namespace DX
+{
+    // Scales the rendered resolution to hold frames to a target time. Each frame's time goes
+    // through an incremental PID controller acting on pixel count (scale squared), since GPU
+    // cost follows the number of pixels shaded. Times are in ticks of TicksPerSecond, as from
+    // StepTimer, so recorded frame-time traces can drive it directly.
+    //
+    // Two kinds of hysteresis keep the resolution from shimmering: frame times within
+    // Deadband of the target count as on target, and the scale handed out only moves once
+    // the controller wants a change of at least ScaleStep. A single frame far over the target
+    // is taken as a hitch rather than load, and ignored unless the next one misses too.
+    //
+    // Under vsync a frame never takes less than the refresh period, so headroom can't be
+    // measured. While frames hold the target the controller instead probes one ScaleStep
+    // up every so often. When a probe misses, the scale goes straight back and probing that
+    // high again waits twice as long, so a scene right at the budget only misses a frame
+    // every few seconds.
+    class DynamicResolution
+    {
+    public:
+        static const uint64_t TicksPerSecond = 10000000;
+
+        static const float Deadband;
+        static const float ScaleStep;
+        static const float Smoothing;
+
+        static const uint32_t ProbeFrames = 60;
+        static const uint32_t MaxProbeFrames = 480;
+
+        // A miss this soon after a probe is blamed on the probe.
+        static const uint32_t ProbeWindowFrames = 16;
+
+        DynamicResolution();
+
+        // The frame time to hold. Defaults to 60 Hz.
+        void SetTargetFrameTicks(uint64_t ticks)    { m_targetTicks = ticks > 0 ? ticks : 1; }
+
+        // Defaults to 0.5 to 1.
+        void SetScaleRange(float minScale, float maxScale);
+
+        // Gains on the frame time error relative to the target.
+        void SetGains(float proportional, float integral, float derivative);
+
+        // Takes the last frame's time and returns the scale to render the next one at.
+        float Update(uint64_t frameTicks);
+
+        float GetScale() const                      { return m_scale; }
+        uint64_t GetTargetFrameTicks() const        { return m_targetTicks; }
+
+        // Returns to full scale, e.g. after the scene changes.
+        void Reset();
+
+    private:
+        uint64_t    m_targetTicks;
+        float       m_minScale;
+        float       m_maxScale;
+        float       m_proportional;
+        float       m_integral;
+        float       m_derivative;
+
+        // Controller state: the pixel fraction it wants, the smoothed error, the last two
+        // errors it acted on, and whether the last frame missed.
+        float       m_area;
+        float       m_smoothedError;
+        float       m_lastError;
+        float       m_lastError2;
+        bool        m_lastMissed;
+
+        // The scale handed out.
+        float       m_scale;
+
+        // Probing: frames held on target, the wait before probing up to the ceiling (the
+        // last probe that missed), and the latest probe, the area it started from and
+        // whether it missed.
+        uint32_t    m_settledFrames;
+        uint32_t    m_probeFrames;
+        float       m_ceiling;
+        float       m_probeScale;
+        float       m_probeArea;
+        bool        m_probeMissed;
+        uint32_t    m_framesSinceProbe;
+    };
+}
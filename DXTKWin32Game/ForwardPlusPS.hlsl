@@ -0,0 +1,43 @@
+//
+// ForwardPlusPS.hlsl - Shades with the lights of the pixel's tile
+//
+
+#include "LightCulling.hlsli"
+
+StructuredBuffer<uint> TileLights : register(t9);
+
+struct PixelShaderInput
+{
+    float4 position : SV_Position;
+    float3 viewPosition : TEXCOORD0;
+    float3 viewNormal : NORMAL;
+    float4 color : COLOR;
+};
+
+static const float3 AmbientColor = float3(0.05f, 0.05f, 0.05f);
+
+float4 main(PixelShaderInput input) : SV_Target
+{
+    float3 normal = normalize(input.viewNormal);
+    float3 lighting = AmbientColor;
+
+    // Without lights the tile lists aren't rebuilt, so they may be stale.
+    uint start = GetTileListStart(uint2(input.position.xy) / TILE_SIZE);
+    uint count = (LightCount > 0) ? TileLights[start] : 0;
+
+    for (uint i = 0; i < count; i++)
+    {
+        PointLight light = Lights[TileLights[start + 1 + i]];
+
+        float3 toLight = light.position - input.viewPosition;
+        float distance = length(toLight);
+
+        // Falls to zero at the radius the light was culled with.
+        float attenuation = saturate(1.0f - distance / light.radius);
+        attenuation *= attenuation;
+
+        lighting += light.color * attenuation * saturate(dot(normal, toLight / distance));
+    }
+
+    return float4(input.color.rgb * lighting, input.color.a);
+}
@@ -0,0 +1,39 @@
+//
+// ForwardPlusVS.hlsl - Vertex shader for geometry lit by ForwardPlusPS
+//
+
+// Matrices are transposed before upload. WorldView must not scale non-uniformly.
+cbuffer ObjectConstants : register(b0)
+{
+    float4x4 WorldView;
+    float4x4 Projection;
+};
+
+// Matches DirectX::VertexPositionNormalColor.
+struct VertexShaderInput
+{
+    float3 position : SV_Position;
+    float3 normal : NORMAL;
+    float4 color : COLOR;
+};
+
+struct PixelShaderInput
+{
+    float4 position : SV_Position;
+    float3 viewPosition : TEXCOORD0;
+    float3 viewNormal : NORMAL;
+    float4 color : COLOR;
+};
+
+PixelShaderInput main(VertexShaderInput input)
+{
+    PixelShaderInput output;
+
+    float4 viewPosition = mul(float4(input.position, 1.0f), WorldView);
+    output.position = mul(viewPosition, Projection);
+    output.viewPosition = viewPosition.xyz;
+    output.viewNormal = mul(input.normal, (float3x3)WorldView);
+    output.color = input.color;
+
+    return output;
+}
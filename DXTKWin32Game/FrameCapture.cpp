@@ -0,0 +1,286 @@
+//
+// FrameCapture.cpp
+//
+
+#include "pch.h"
+#include "FrameCapture.h"
+
+#include <fstream>
+
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    std::wstring GetFramePath(const std::wstring& directory, const CapturedFrame& frame)
+    {
+        wchar_t name[64];
+        if (frame.format == CaptureFormat::Png)
+        {
+            swprintf_s(name, L"\\frame_%06llu.png", frame.frame);
+        }
+        else
+        {
+            swprintf_s(name, L"\\frame_%06llu_%ux%u.bgra", frame.frame, frame.width, frame.height);
+        }
+
+        return directory + name;
+    }
+
+    void WritePng(IWICImagingFactory* factory, const std::wstring& path, const CapturedFrame& frame)
+    {
+        ComPtr<IWICStream> stream;
+        DX::ThrowIfFailed(factory->CreateStream(stream.GetAddressOf()));
+        DX::ThrowIfFailed(stream->InitializeFromFilename(path.c_str(), GENERIC_WRITE));
+
+        ComPtr<IWICBitmapEncoder> encoder;
+        DX::ThrowIfFailed(factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, encoder.GetAddressOf()));
+        DX::ThrowIfFailed(encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache));
+
+        ComPtr<IWICBitmapFrameEncode> frameEncode;
+        DX::ThrowIfFailed(encoder->CreateNewFrame(frameEncode.GetAddressOf(), nullptr));
+        DX::ThrowIfFailed(frameEncode->Initialize(nullptr));
+        DX::ThrowIfFailed(frameEncode->SetSize(frame.width, frame.height));
+
+        // The back buffer's alpha is meaningless, so ask for 24-bit and convert if needed.
+        WICPixelFormatGUID sourceFormat = GUID_WICPixelFormat32bppBGR;
+        WICPixelFormatGUID targetFormat = GUID_WICPixelFormat24bppBGR;
+        DX::ThrowIfFailed(frameEncode->SetPixelFormat(&targetFormat));
+
+        UINT stride = frame.width * 4;
+        UINT size = stride * frame.height;
+        BYTE* pixels = const_cast<BYTE*>(frame.pixels.data());
+
+        if (IsEqualGUID(targetFormat, sourceFormat))
+        {
+            DX::ThrowIfFailed(frameEncode->WritePixels(frame.height, stride, size, pixels));
+        }
+        else
+        {
+            ComPtr<IWICBitmap> source;
+            DX::ThrowIfFailed(factory->CreateBitmapFromMemory(frame.width, frame.height, sourceFormat, stride, size, pixels, source.GetAddressOf()));
+
+            ComPtr<IWICFormatConverter> converter;
+            DX::ThrowIfFailed(factory->CreateFormatConverter(converter.GetAddressOf()));
+            DX::ThrowIfFailed(converter->Initialize(source.Get(), targetFormat, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeCustom));
+
+            DX::ThrowIfFailed(frameEncode->WriteSource(converter.Get(), nullptr));
+        }
+
+        DX::ThrowIfFailed(frameEncode->Commit());
+        DX::ThrowIfFailed(encoder->Commit());
+    }
+
+    void WriteRaw(const std::wstring& path, const CapturedFrame& frame)
+    {
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(frame.pixels.data()), frame.pixels.size());
+        if (!file)
+        {
+            throw std::exception("WriteRaw");
+        }
+    }
+}
+
+FrameCapture::FrameCapture() :
+    m_stagingDesc{},
+    m_swapRedBlue(false),
+    m_ring(Latency),
+    m_capturing(false),
+    m_framesLeft(0),
+    m_frame(0),
+    m_capturedCount(0),
+    m_copyDroppedCount(0)
+{
+    m_session.format = CaptureFormat::Png;
+    for (auto& session : m_slotSessions)
+    {
+        session.format = CaptureFormat::Png;
+    }
+
+    // The factory is free-threaded, so the encode worker can share it. The worker joins the
+    // process's multithreaded apartment, which wWinMain creates.
+    DX::ThrowIfFailed(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(m_wicFactory.GetAddressOf())));
+
+    ComPtr<IWICImagingFactory> factory = m_wicFactory;
+    m_encodeQueue = std::make_unique<FrameEncodeQueue>([factory](const CapturedFrame& frame)
+    {
+        if (frame.format == CaptureFormat::Png)
+        {
+            WritePng(factory.Get(), frame.path, frame);
+        }
+        else
+        {
+            WriteRaw(frame.path, frame);
+        }
+    }, MaxPendingEncodes);
+}
+
+bool FrameCapture::Start(const wchar_t* directory, CaptureFormat format, uint32_t frameCount)
+{
+    if (!CreateDirectoryW(directory, nullptr) && GetLastError() != ERROR_ALREADY_EXISTS)
+    {
+        return false;
+    }
+
+    // Copies still in the ring keep the settings they were made with.
+    m_session.directory = directory;
+    m_session.format = format;
+
+    m_capturing = true;
+    m_framesLeft = frameCount;
+    return true;
+}
+
+void FrameCapture::Stop()
+{
+    // Copies already made are still read back by the next few OnPresent calls.
+    m_capturing = false;
+}
+
+void FrameCapture::OnPresent(ID3D11DeviceContext* context, ID3D11Texture2D* backBuffer)
+{
+    ReadBack(context);
+
+    if (m_capturing)
+    {
+        D3D11_TEXTURE2D_DESC desc;
+        backBuffer->GetDesc(&desc);
+
+        if (desc.Width != m_stagingDesc.Width || desc.Height != m_stagingDesc.Height || desc.Format != m_stagingDesc.Format || desc.SampleDesc.Count != m_stagingDesc.SampleDesc.Count)
+        {
+            CreateStagingTextures(backBuffer, desc);
+        }
+
+        int slot = m_staging[0] ? m_ring.BeginCopy(m_frame) : ReadbackRing::NoSlot;
+        if (slot == ReadbackRing::NoSlot)
+        {
+            m_copyDroppedCount++;
+        }
+        else
+        {
+            if (m_resolve)
+            {
+                context->ResolveSubresource(m_resolve.Get(), 0, backBuffer, 0, desc.Format);
+                context->CopyResource(m_staging[slot].Get(), m_resolve.Get());
+            }
+            else
+            {
+                context->CopyResource(m_staging[slot].Get(), backBuffer);
+            }
+
+            m_slotSessions[slot] = m_session;
+            m_capturedCount++;
+        }
+
+        if (m_framesLeft > 0 && --m_framesLeft == 0)
+        {
+            m_capturing = false;
+        }
+    }
+
+    m_frame++;
+}
+
+void FrameCapture::ReleaseDevice()
+{
+    for (auto& staging : m_staging)
+    {
+        staging.Reset();
+    }
+    m_resolve.Reset();
+    m_stagingDesc = {};
+
+    m_ring.Reset();
+}
+
+uint64_t FrameCapture::GetDroppedCount() const
+{
+    return m_copyDroppedCount + m_encodeQueue->GetDroppedCount();
+}
+
+void FrameCapture::ReadBack(ID3D11DeviceContext* context)
+{
+    int slot;
+    while ((slot = m_ring.GetReadySlot(m_frame)) != ReadbackRing::NoSlot)
+    {
+        // Never wait; if the copy somehow isn't done, try again next frame.
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        HRESULT hr = context->Map(m_staging[slot].Get(), 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+        if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+            break;
+
+        DX::ThrowIfFailed(hr);
+
+        CapturedFrame frame;
+        frame.frame = m_ring.GetSlotFrame(slot);
+        frame.width = m_stagingDesc.Width;
+        frame.height = m_stagingDesc.Height;
+        frame.pixels.resize(frame.width * frame.height * 4);
+        frame.format = m_slotSessions[slot].format;
+        frame.path = GetFramePath(m_slotSessions[slot].directory, frame);
+
+        UINT rowSize = frame.width * 4;
+        for (UINT y = 0; y < frame.height; y++)
+        {
+            memcpy(frame.pixels.data() + y * rowSize, static_cast<const uint8_t*>(mapped.pData) + y * mapped.RowPitch, rowSize);
+        }
+
+        context->Unmap(m_staging[slot].Get(), 0);
+        m_ring.EndRead(slot);
+
+        if (m_swapRedBlue)
+        {
+            for (size_t i = 0; i < frame.pixels.size(); i += 4)
+            {
+                std::swap(frame.pixels[i], frame.pixels[i + 2]);
+            }
+        }
+
+        // Dropped frames are counted by the queue.
+        m_encodeQueue->Push(std::move(frame));
+    }
+}
+
+void FrameCapture::CreateStagingTextures(ID3D11Texture2D* backBuffer, const D3D11_TEXTURE2D_DESC& desc)
+{
+    // Copies in flight have the old size; drop them rather than read them wrongly.
+    ReleaseDevice();
+
+    switch (desc.Format)
+    {
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        m_swapRedBlue = false;
+        break;
+
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+        m_swapRedBlue = true;
+        break;
+
+    default:
+        // Other formats aren't 32-bit BGRA or RGBA; capture is skipped and frames counted
+        // as dropped.
+        m_stagingDesc = desc;
+        return;
+    }
+
+    ComPtr<ID3D11Device> device;
+    backBuffer->GetDevice(device.GetAddressOf());
+
+    if (desc.SampleDesc.Count > 1)
+    {
+        CD3D11_TEXTURE2D_DESC resolveDesc(desc.Format, desc.Width, desc.Height, 1, 1, 0);
+        DX::ThrowIfFailed(device->CreateTexture2D(&resolveDesc, nullptr, m_resolve.ReleaseAndGetAddressOf()));
+    }
+
+    CD3D11_TEXTURE2D_DESC stagingDesc(desc.Format, desc.Width, desc.Height, 1, 1, 0, D3D11_USAGE_STAGING, D3D11_CPU_ACCESS_READ);
+    for (auto& staging : m_staging)
+    {
+        DX::ThrowIfFailed(device->CreateTexture2D(&stagingDesc, nullptr, staging.ReleaseAndGetAddressOf()));
+    }
+
+    m_stagingDesc = desc;
+}
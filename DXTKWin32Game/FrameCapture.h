@@ -0,0 +1,81 @@
+//
+// FrameCapture.h - Captures presented frames to files without stalling the GPU
+//
+
+#pragma once
+
+#include "FrameEncodeQueue.h"
+#include "ReadbackRing.h"
+
+#include <string>
+#include <wincodec.h>
+
+namespace DX
+{
+    // Copies the back buffer into a ring of staging textures and maps each one Latency
+    // frames later, when the GPU has long finished the copy, so capturing never waits on
+    // the GPU the way SaveWICTextureToFile does. Encoding runs on one worker thread for the
+    // capture's lifetime, and each copy keeps the directory and format of the session that
+    // made it. Frames are dropped, and counted, rather than stalling when the GPU or encoder
+    // falls behind.
+    class FrameCapture
+    {
+    public:
+        static const uint32_t Latency = 3;
+        static const size_t MaxPendingEncodes = 8;
+
+        FrameCapture();
+
+        FrameCapture(FrameCapture const&) = delete;
+        FrameCapture& operator= (FrameCapture const&) = delete;
+
+        // Captures frameCount frames, or every frame until Stop when zero, into directory.
+        // Frames of an earlier session still being read back or encoded are unaffected.
+        // Returns false, and doesn't start, if the directory can't be created.
+        bool Start(_In_z_ const wchar_t* directory, CaptureFormat format, uint32_t frameCount = 0);
+        void Stop();
+
+        bool IsCapturing() const    { return m_capturing; }
+
+        // Whether OnPresent has work to do: capturing, or frames still being read back.
+        bool IsActive() const       { return m_capturing || m_ring.GetPendingCount() > 0; }
+
+        // Call after rendering, before Present, while IsActive.
+        void OnPresent(_In_ ID3D11DeviceContext* context, _In_ ID3D11Texture2D* backBuffer);
+
+        // Frames still in staging textures are lost.
+        void ReleaseDevice();
+
+        uint64_t GetCapturedCount() const   { return m_capturedCount; }
+        uint64_t GetDroppedCount() const;
+
+    private:
+        struct Session
+        {
+            std::wstring    directory;
+            CaptureFormat   format;
+        };
+
+        void ReadBack(_In_ ID3D11DeviceContext* context);
+        void CreateStagingTextures(_In_ ID3D11Texture2D* backBuffer, const D3D11_TEXTURE2D_DESC& desc);
+
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>     m_staging[Latency];
+        Microsoft::WRL::ComPtr<ID3D11Texture2D>     m_resolve;
+        D3D11_TEXTURE2D_DESC                        m_stagingDesc;
+        bool                                        m_swapRedBlue;
+
+        ReadbackRing                                m_ring;
+        Microsoft::WRL::ComPtr<IWICImagingFactory>  m_wicFactory;
+        std::unique_ptr<FrameEncodeQueue>           m_encodeQueue;
+
+        // The current session, and the one each staging texture's copy was made for.
+        Session                                     m_session;
+        Session                                     m_slotSessions[Latency];
+
+        bool                                        m_capturing;
+        uint32_t                                    m_framesLeft;
+        uint64_t                                    m_frame;
+        uint64_t                                    m_capturedCount;
+        uint64_t                                    m_copyDroppedCount;
+    };
+}
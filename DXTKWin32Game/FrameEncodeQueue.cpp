@@ -0,0 +1,118 @@
+//
+// FrameEncodeQueue.cpp
+//
+
+#include "pch.h"
+#include "FrameEncodeQueue.h"
+
+using namespace DX;
+
+FrameEncodeQueue::FrameEncodeQueue(Encoder encoder, size_t maxPending) :
+    m_encoder(std::move(encoder)),
+    m_maxPending(maxPending > 0 ? maxPending : 1),
+    m_encoding(false),
+    m_exiting(false),
+    m_encodedCount(0),
+    m_droppedCount(0),
+    m_failedCount(0)
+{
+    m_thread = std::thread([this]() { Run(); });
+}
+
+FrameEncodeQueue::~FrameEncodeQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exiting = true;
+    }
+    m_wake.notify_one();
+
+    m_thread.join();
+}
+
+bool FrameEncodeQueue::Push(CapturedFrame&& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.size() >= m_maxPending)
+        {
+            m_droppedCount++;
+            return false;
+        }
+
+        m_pending.push_back(std::move(frame));
+    }
+    m_wake.notify_one();
+
+    return true;
+}
+
+void FrameEncodeQueue::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_pending.empty() && !m_encoding; });
+}
+
+uint64_t FrameEncodeQueue::GetEncodedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_encodedCount;
+}
+
+uint64_t FrameEncodeQueue::GetDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_droppedCount;
+}
+
+uint64_t FrameEncodeQueue::GetFailedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failedCount;
+}
+
+void FrameEncodeQueue::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    for (;;)
+    {
+        m_wake.wait(lock, [this]() { return !m_pending.empty() || m_exiting; });
+
+        // Drain what's queued even when exiting, so no captured frame is lost.
+        if (m_pending.empty())
+            break;
+
+        CapturedFrame frame = std::move(m_pending.front());
+        m_pending.pop_front();
+        m_encoding = true;
+
+        // A failed write only loses that frame.
+        bool encoded = true;
+        lock.unlock();
+        try
+        {
+            m_encoder(frame);
+        }
+        catch (...)
+        {
+            encoded = false;
+        }
+        lock.lock();
+
+        m_encoding = false;
+        if (encoded)
+        {
+            m_encodedCount++;
+        }
+        else
+        {
+            m_failedCount++;
+        }
+
+        if (m_pending.empty())
+        {
+            m_idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,82 @@
+//
+// FrameEncodeQueue.h - Encodes captured frames on a worker thread
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace DX
+{
+    enum class CaptureFormat
+    {
+        Png,        // Compressed on the worker; slow, but small files.
+        Raw,        // Tightly packed BGRA rows, named with the frame size.
+    };
+
+    // A frame read back from the GPU, as tightly packed 32-bit BGRA rows, and the file it is
+    // to be written to. Each frame carries its own, so one queue serves every capture session.
+    struct CapturedFrame
+    {
+        uint64_t                frame;
+        uint32_t                width;
+        uint32_t                height;
+        std::vector<uint8_t>    pixels;
+        CaptureFormat           format;
+        std::wstring            path;
+    };
+
+    // Hands captured frames to an encoder on its own thread, so writing files never holds up
+    // the render thread. At most maxPending frames wait; frames pushed past that are dropped
+    // rather than letting memory grow while the encoder falls behind.
+    class FrameEncodeQueue
+    {
+    public:
+        typedef std::function<void(const CapturedFrame&)> Encoder;
+
+        FrameEncodeQueue(Encoder encoder, size_t maxPending);
+
+        // Finishes the queued frames first.
+        ~FrameEncodeQueue();
+
+        FrameEncodeQueue(FrameEncodeQueue const&) = delete;
+        FrameEncodeQueue& operator= (FrameEncodeQueue const&) = delete;
+
+        // Returns false if the frame was dropped.
+        bool Push(CapturedFrame&& frame);
+
+        // Blocks until every queued frame is encoded.
+        void WaitIdle();
+
+        uint64_t GetEncodedCount() const;
+        uint64_t GetDroppedCount() const;
+
+        // Frames whose encoder threw.
+        uint64_t GetFailedCount() const;
+
+    private:
+        void Run();
+
+        Encoder                     m_encoder;
+        size_t                      m_maxPending;
+
+        mutable std::mutex          m_mutex;
+        std::condition_variable     m_wake;
+        std::condition_variable     m_idle;
+        std::deque<CapturedFrame>   m_pending;
+        bool                        m_encoding;
+        bool                        m_exiting;
+        uint64_t                    m_encodedCount;
+        uint64_t                    m_droppedCount;
+        uint64_t                    m_failedCount;
+
+        std::thread                 m_thread;
+    };
+}
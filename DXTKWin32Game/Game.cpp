@@ -5,6 +5,8 @@
 #include "pch.h"
 #include "Game.h"
 
+#include "ReadData.h"
+
 extern void ExitGame();
 
 using namespace DirectX;
@@ -12,14 +14,162 @@ using namespace DirectX::SimpleMath;
 
 using Microsoft::WRL::ComPtr;
 
-Game::Game() :
+namespace
+{
+    DXGI_FORMAT GetBackBufferFormat(DX::BackBufferFormat format)
+    {
+        switch (format)
+        {
+        case DX::BackBufferFormat::Hdr10:   return DXGI_FORMAT_R10G10B10A2_UNORM;
+        case DX::BackBufferFormat::ScRgb:   return DXGI_FORMAT_R16G16B16A16_FLOAT;
+        default:                            return DXGI_FORMAT_B8G8R8A8_UNORM;
+        }
+    }
+
+    DXGI_SWAP_EFFECT GetSwapEffect(DX::SwapEffect swapEffect)
+    {
+        switch (swapEffect)
+        {
+        case DX::SwapEffect::FlipSequential:    return DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL;
+        case DX::SwapEffect::FlipDiscard:       return DXGI_SWAP_EFFECT_FLIP_DISCARD;
+        default:                                return DXGI_SWAP_EFFECT_DISCARD;
+        }
+    }
+
+    // Blends two view matrices as rigid transforms, so the camera turns rather than shears.
+    // A view's translation is the world origin seen from the camera, which swings around as
+    // the camera turns, so the blend works on the cameras' own transforms: their orientations
+    // are slerped and their positions lerped, and the result is inverted back into a view.
+    Matrix InterpolateView(Matrix from, Matrix to, float t)
+    {
+        Matrix fromCamera = from.Invert();
+        Matrix toCamera = to.Invert();
+
+        Vector3 fromScale, toScale;
+        Quaternion fromRotation, toRotation;
+        Vector3 fromPosition, toPosition;
+
+        if (!fromCamera.Decompose(fromScale, fromRotation, fromPosition) || !toCamera.Decompose(toScale, toRotation, toPosition))
+            return Matrix::Lerp(from, to, t);
+
+        Matrix camera = Matrix::CreateFromQuaternion(Quaternion::Slerp(fromRotation, toRotation, t)) *
+            Matrix::CreateTranslation(Vector3::Lerp(fromPosition, toPosition, t));
+        return camera.Invert();
+    }
+
+    // A model of one mesh, a sphere made by GeometricPrimitive, for scenes without model
+    // files. Its winding matches GeometricPrimitive's own drawing.
+    std::unique_ptr<Model> CreateSphereModel(ID3D11Device* device, float diameter)
+    {
+        std::vector<GeometricPrimitive::VertexType> vertices;
+        std::vector<uint16_t> indices;
+        GeometricPrimitive::CreateSphere(vertices, indices, diameter, 16, true);
+
+        auto part = std::make_unique<ModelMeshPart>();
+        part->indexCount = static_cast<uint32_t>(indices.size());
+        part->startIndex = 0;
+        part->vertexOffset = 0;
+        part->vertexStride = sizeof(GeometricPrimitive::VertexType);
+        part->primitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+        part->indexFormat = DXGI_FORMAT_R16_UINT;
+        part->vbDecl = std::make_shared<std::vector<D3D11_INPUT_ELEMENT_DESC>>(
+            GeometricPrimitive::VertexType::InputElements,
+            GeometricPrimitive::VertexType::InputElements + GeometricPrimitive::VertexType::InputElementCount);
+        part->isAlpha = false;
+
+        CD3D11_BUFFER_DESC vertexBufferDesc(static_cast<UINT>(vertices.size() * sizeof(vertices[0])), D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+        D3D11_SUBRESOURCE_DATA vertexData = { vertices.data(), 0, 0 };
+        DX::ThrowIfFailed(device->CreateBuffer(&vertexBufferDesc, &vertexData, part->vertexBuffer.ReleaseAndGetAddressOf()));
+
+        CD3D11_BUFFER_DESC indexBufferDesc(static_cast<UINT>(indices.size() * sizeof(indices[0])), D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+        D3D11_SUBRESOURCE_DATA indexData = { indices.data(), 0, 0 };
+        DX::ThrowIfFailed(device->CreateBuffer(&indexBufferDesc, &indexData, part->indexBuffer.ReleaseAndGetAddressOf()));
+
+        auto mesh = std::make_shared<ModelMesh>();
+        mesh->name = L"Sphere";
+        mesh->ccw = true;
+        mesh->pmalpha = false;
+        mesh->boundingSphere = BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), diameter * 0.5f);
+        mesh->boundingBox = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(diameter * 0.5f, diameter * 0.5f, diameter * 0.5f));
+        mesh->meshParts.push_back(std::move(part));
+
+        auto model = std::make_unique<Model>();
+        model->name = L"Sphere";
+        model->meshes.push_back(mesh);
+        return model;
+    }
+
+    // A test set of point lights for -lights: a grid filling a box in front of the default
+    // camera, with colors around the hue wheel, each reaching a little past its neighbours so
+    // tiles see several at once. The same count always gives the same lights.
+    std::vector<DX::PointLight> GenerateLights(uint32_t count)
+    {
+        const Vector3 boxMin(-20.0f, -2.0f, -40.0f);
+        const Vector3 boxMax(20.0f, 6.0f, -2.0f);
+
+        uint32_t side = 1;
+        while (side * side * side < count)
+        {
+            side++;
+        }
+
+        Vector3 spacing = (boxMax - boxMin) / float(side);
+        float radius = 1.5f * std::max(spacing.x, std::max(spacing.y, spacing.z));
+
+        std::vector<DX::PointLight> lights(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            Vector3 cell(float(i % side), float((i / side) % side), float(i / (side * side)));
+            Vector3 position = boxMin + (cell + Vector3(0.5f)) * spacing;
+
+            float hue = float(i % 6) / 6.0f * XM_2PI;
+            Vector3 color(0.5f + 0.5f * cosf(hue), 0.5f + 0.5f * cosf(hue - XM_2PI / 3.0f), 0.5f + 0.5f * cosf(hue + XM_2PI / 3.0f));
+
+            lights[i].position = position;
+            lights[i].radius = radius;
+            lights[i].color = color;
+        }
+        return lights;
+    }
+}
+
+Game::Game(DX::LaunchOptions const& options) :
     m_window(0),
     m_outputWidth(800),
     m_outputHeight(600),
-    m_featureLevel(D3D_FEATURE_LEVEL_9_1)
+    m_featureLevel(D3D_FEATURE_LEVEL_9_1),
+    m_options(options),
+    m_swapChainConfig(options.swapChain),
+    m_sampleCount(1),
+    m_renderWidth(800),
+    m_renderHeight(600),
+    m_lastTickTime(0),
+    m_benchmarkFrames(0),
+    m_benchmarkStart(0),
+    m_lastGamePad(),
+    m_captureCommands(0),
+    m_frameDebugDraw(nullptr),
+    m_frameModelInstances(nullptr),
+    m_sceneModelIndex(0),
+    m_simulationExiting(false),
+    m_simulationStepTicks(DX::StepTimer::TicksPerSecond / 60),
+    m_inputResetPending(false),
+    m_hasSnapshot(false),
+    m_previousStepEnd(0),
+    m_loadingContent(false),
+    m_contentFailedCount(0),
+    m_startTime(DX::StepTimer::GetCurrentTicks()),
+    m_deviceTime(0),
+    m_firstFrameTime(0),
+    m_interactiveTime(0)
 {
 }
 
+Game::~Game()
+{
+    StopSimulation();
+}
+
 // Initialize the Direct3D resources required to run.
 void Game::Initialize(HWND window, int width, int height)
 {
@@ -27,9 +177,23 @@ void Game::Initialize(HWND window, int width, int height)
     m_outputWidth = std::max(width, 1);
     m_outputHeight = std::max(height, 1);
 
-    CreateDevice();
+    // Creating the device and the objects that load shaders takes a while, so it runs on a
+    // worker while the message loop starts. Nothing touches the device until UpdateStartup
+    // sees it finished, and the swap chain is then created here on the window's thread.
+    m_deviceCreation = std::async(std::launch::async, [this]() { CreateDevice(); });
 
-    CreateResources();
+    m_gamePad = std::make_unique<GamePad>();
+    m_keyboard = std::make_unique<Keyboard>();
+    m_mouse = std::make_unique<Mouse>();
+    m_mouse->SetWindow(window);
+
+    m_frameCapture = std::make_unique<DX::FrameCapture>();
+
+    // Presents don't wait for vsync when benchmarking, so nothing else would pace the loop.
+    if (m_options.swapChain.benchmark)
+    {
+        m_loopPolicy.SetActiveMode(DX::LoopMode::Busy);
+    }
 
     // TODO: Change the timer settings if you want something other than the default variable timestep mode.
     // e.g. for 60 FPS fixed timestep update logic, call:
@@ -42,12 +206,368 @@ void Game::Initialize(HWND window, int width, int height)
 // Executes the basic game loop.
 void Game::Tick()
 {
-    m_timer.Tick([&]()
+    // Until startup finishes, at most the loading screen is drawn.
+    if (!UpdateStartup())
+        return;
+
+    uint64_t now = DX::StepTimer::GetCurrentTicks();
+    SampleGamePad(now);
+
+    if (m_simulationThread.joinable())
     {
-        Update(m_timer);
-    });
+        AcquireSnapshot(now);
+    }
+    else
+    {
+        m_timer.Tick([&]()
+        {
+            // Each step ends the time still left over before now, so input is applied to the
+            // step it happened in rather than all landing in the first step of the frame.
+            RunStep(now - m_timer.GetLeftOverTicks());
+        });
+
+        if (m_timer.GetFrameCount() > 0)
+        {
+            m_frameDebugDraw = &m_debugDrawQueue;
+            m_frameModelInstances = &m_modelInstances;
+            m_frameView = m_view;
+        }
+    }
+
+    ApplyCaptureCommands();
+
+    UpdateRenderSize(now);
 
     Render();
+
+    if (m_interactiveTime == 0 && m_frameDebugDraw)
+    {
+        m_interactiveTime = DX::StepTimer::GetCurrentTicks();
+        ReportStartup();
+    }
+}
+
+// Advances startup: waits for the device, then loads content behind a loading screen.
+// Returns true once the game can run.
+bool Game::UpdateStartup()
+{
+    if (m_deviceCreation.valid())
+    {
+        // Waiting briefly rather than returning right away keeps the message loop from
+        // spinning while there is nothing to draw.
+        if (m_deviceCreation.wait_for(std::chrono::milliseconds(5)) != std::future_status::ready)
+            return false;
+
+        // Rethrows anything CreateDevice threw.
+        m_deviceCreation.get();
+        m_deviceTime = DX::StepTimer::GetCurrentTicks();
+
+        CreateResources();
+
+        LoadContent();
+    }
+
+    if (m_loadingContent)
+    {
+        // Without anything queued there is no loader, and startup finishes right away.
+        if (m_contentLoader && !m_contentLoader->IsDone())
+        {
+            RenderLoadingScreen();
+            return false;
+        }
+
+        m_contentFailedCount = m_contentLoader ? m_contentLoader->GetFailedCount() : 0;
+        m_contentLoader.reset();
+        m_loadingContent = false;
+
+        // Adding a model touches the renderer, so it waits for the UI thread.
+        if (m_modelRenderer && m_sceneModel)
+        {
+            m_sceneModelIndex = m_modelRenderer->AddModel(*m_sceneModel);
+        }
+
+        // Loading time isn't game time.
+        m_timer.ResetElapsedTime();
+
+        if (m_options.simulationThread)
+        {
+            StartSimulation();
+        }
+    }
+
+    return true;
+}
+
+// Queues the content the game needs before it starts. The content threads are only started
+// by the first load queued.
+void Game::LoadContent()
+{
+    m_loadingContent = true;
+
+    // The scene's sphere is built on a content thread as a model file would be loaded.
+    // Textures go through LoadTexture, e.g. LoadTexture(L"ground.dds", m_groundTexture).
+    if (m_modelRenderer)
+    {
+        ComPtr<ID3D11Device> device = m_d3dDevice;
+        std::unique_ptr<Model>* model = &m_sceneModel;
+
+        QueueContent([device, model]()
+        {
+            *model = CreateSphereModel(device.Get(), 1.0f);
+        });
+    }
+}
+
+// Adds a job to the content threads, starting them with the first.
+void Game::QueueContent(DX::ContentLoader::Job job)
+{
+    if (!m_contentLoader)
+    {
+        m_contentLoader = std::make_unique<DX::ContentLoader>();
+    }
+
+    m_contentLoader->Add(std::move(job));
+}
+
+// Queues a texture to load on the content threads. Names are relative to the executable's
+// directory. The DDS and WIC loaders only need the device, which is free-threaded. The
+// texture must not be touched until loading is done.
+void Game::LoadTexture(const wchar_t* fileName, ComPtr<ID3D11ShaderResourceView>& texture)
+{
+    ComPtr<ID3D11Device> device = m_d3dDevice;
+    std::wstring name(fileName);
+    ID3D11ShaderResourceView** result = texture.ReleaseAndGetAddressOf();
+
+    QueueContent([device, name, result]()
+    {
+        auto data = DX::ReadData(name.c_str());
+
+        bool isDDS = name.size() >= 4 && _wcsicmp(name.c_str() + name.size() - 4, L".dds") == 0;
+        if (isDDS)
+        {
+            DX::ThrowIfFailed(CreateDDSTextureFromMemory(device.Get(), data.data(), data.size(), nullptr, result));
+        }
+        else
+        {
+            DX::ThrowIfFailed(CreateWICTextureFromMemory(device.Get(), data.data(), data.size(), nullptr, result));
+        }
+    });
+}
+
+// Draws a progress bar while content loads. It only needs the back buffer, so it can show as
+// soon as the swap chain exists.
+void Game::RenderLoadingScreen()
+{
+    m_d3dContext->ClearRenderTargetView(m_renderTargetView.Get(), Colors::Black);
+    m_d3dContext->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
+
+    CD3D11_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(m_outputWidth), static_cast<float>(m_outputHeight));
+    m_d3dContext->RSSetViewports(1, &viewport);
+
+    RECT track = { m_outputWidth / 4, m_outputHeight * 3 / 4, m_outputWidth * 3 / 4, m_outputHeight * 3 / 4 + 8 };
+    RECT fill = track;
+    fill.right = track.left + static_cast<LONG>((track.right - track.left) * m_contentLoader->GetProgress());
+
+    m_spriteBatch->Begin();
+    m_spriteBatch->Draw(m_whiteTexture.Get(), track, Colors::DimGray);
+    m_spriteBatch->Draw(m_whiteTexture.Get(), fill, Colors::White);
+    m_spriteBatch->End();
+
+    Present();
+}
+
+// Writes startup times to the debugger output. That is the agreed channel for startup
+// metrics: it needs no console or files, and a debugger or DebugView picks it up.
+void Game::ReportStartup()
+{
+    auto milliseconds = [this](uint64_t time)
+    {
+        return DX::StepTimer::TicksToSeconds(time - m_startTime) * 1000.0;
+    };
+
+    wchar_t message[256];
+    swprintf_s(message, L"Startup: device %.1f ms, first frame %.1f ms, interactive %.1f ms, %u content loads failed\n",
+        milliseconds(m_deviceTime), milliseconds(m_firstFrameTime), milliseconds(m_interactiveTime), m_contentFailedCount);
+    OutputDebugStringW(message);
+}
+
+// Starts running the steps on the simulation thread, which owns m_timer until stopped.
+void Game::StartSimulation()
+{
+    if (m_simulationThread.joinable())
+        return;
+
+    m_simulationExiting = false;
+    m_hasSnapshot = false;
+
+    m_timer.SetFixedTimeStep(true);
+    m_timer.SetTargetElapsedTicks(m_simulationStepTicks);
+    m_timer.ResetElapsedTime();
+
+    // Waits are otherwise rounded up to the 15.6 ms system timer.
+    timeBeginPeriod(1);
+
+    m_simulationThread = std::thread([this]() { RunSimulation(); });
+}
+
+void Game::StopSimulation()
+{
+    if (!m_simulationThread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_simulationMutex);
+        m_simulationExiting = true;
+    }
+    m_simulationWake.notify_one();
+
+    m_simulationThread.join();
+
+    timeEndPeriod(1);
+}
+
+// The simulation thread: runs the steps that are due, publishes the result, then sleeps
+// until the next step.
+void Game::RunSimulation()
+{
+    for (;;)
+    {
+        uint64_t now = DX::StepTimer::GetCurrentTicks();
+        uint64_t stepEnd = 0;
+
+        m_timer.Tick([&]()
+        {
+            stepEnd = now - m_timer.GetLeftOverTicks();
+            RunStep(stepEnd);
+        });
+
+        if (stepEnd != 0)
+        {
+            PublishSnapshot(stepEnd);
+        }
+
+        uint64_t due = now + m_simulationStepTicks - std::min(m_timer.GetLeftOverTicks(), m_simulationStepTicks);
+        uint64_t current = DX::StepTimer::GetCurrentTicks();
+        uint64_t wait = (due > current) ? due - current : 0;
+
+        std::unique_lock<std::mutex> lock(m_simulationMutex);
+        if (m_simulationWake.wait_for(lock, std::chrono::microseconds(wait / 10), [this]() { return m_simulationExiting; }))
+            break;
+    }
+}
+
+// Runs one step, ending at stepEnd, on whichever thread owns the simulation.
+void Game::RunStep(uint64_t stepEnd)
+{
+    Matrix projection;
+    {
+        std::lock_guard<std::mutex> lock(m_simulationMutex);
+
+        if (m_inputResetPending)
+        {
+            m_input.Reset();
+            m_inputResetPending = false;
+        }
+
+        m_stepInput.swap(m_pendingInput);
+        projection = m_simulationProjection;
+    }
+
+    for (const PendingInput& input : m_stepInput)
+    {
+        m_input.Push(input.time, input.control, input.value);
+    }
+    m_stepInput.clear();
+
+    m_input.Step(stepEnd);
+
+    // Only the last step's debug shapes and model instances are drawn.
+    m_debugDrawQueue.Clear();
+
+    Matrix viewProjection = m_view * projection;
+    m_modelInstances.Clear();
+    m_modelInstances.SetFrustum(viewProjection.m);
+
+    Update(m_timer);
+}
+
+// Hands what the last step left to draw to the render thread in the next snapshot.
+void Game::PublishSnapshot(uint64_t stepEnd)
+{
+    Snapshot& snapshot = m_snapshots.GetWriteBuffer();
+    snapshot.stepEnd = stepEnd;
+    snapshot.view = m_view;
+
+    // Swapped rather than copied. What comes back is an older snapshot's, which the next
+    // step clears, so the queues keep reusing the same allocations.
+    std::swap(snapshot.debugDraw, m_debugDrawQueue);
+    std::swap(snapshot.modelInstances, m_modelInstances);
+
+    m_snapshots.Publish();
+}
+
+// Takes the simulation's newest snapshot, if there is one, and picks what to draw at now.
+// Shapes and instances are drawn as the newest snapshot has them; only the camera is
+// interpolated, since nothing else is matched up between snapshots.
+void Game::AcquireSnapshot(uint64_t now)
+{
+    // The snapshot being replaced becomes the one to interpolate from.
+    uint64_t heldStepEnd = m_previousStepEnd;
+    Matrix heldView = m_previousView;
+    if (m_hasSnapshot)
+    {
+        heldStepEnd = m_snapshots.GetReadBuffer().stepEnd;
+        heldView = m_snapshots.GetReadBuffer().view;
+    }
+
+    if (m_snapshots.Acquire())
+    {
+        const Snapshot& latest = m_snapshots.GetReadBuffer();
+        m_previousStepEnd = m_hasSnapshot ? heldStepEnd : latest.stepEnd;
+        m_previousView = m_hasSnapshot ? heldView : latest.view;
+        m_hasSnapshot = true;
+    }
+
+    if (!m_hasSnapshot)
+        return;
+
+    Snapshot& latest = m_snapshots.GetReadBuffer();
+
+    float blend = 1.0f;
+    uint64_t drawTime = now - m_simulationStepTicks;
+    if (latest.stepEnd > m_previousStepEnd && drawTime < latest.stepEnd)
+    {
+        blend = (drawTime > m_previousStepEnd) ? float(drawTime - m_previousStepEnd) / float(latest.stepEnd - m_previousStepEnd) : 0.0f;
+    }
+
+    m_frameView = InterpolateView(m_previousView, latest.view, blend);
+    m_frameDebugDraw = &latest.debugDraw;
+    m_frameModelInstances = &latest.modelInstances;
+}
+
+// Starts and stops frame capture as Update asked. Capture follows the presented frames, so
+// it is driven from here rather than from the simulation. A capture that can't start, say
+// on a read-only drive, is skipped; the game carries on and the key can be pressed again.
+void Game::ApplyCaptureCommands()
+{
+    uint32_t commands = m_captureCommands.exchange(0);
+
+    if ((commands & CaptureScreenshot) && !m_frameCapture->IsCapturing())
+    {
+        m_frameCapture->Start(L"Captures", DX::CaptureFormat::Png, 1);
+    }
+
+    if (commands & ToggleCaptureRecording)
+    {
+        if (m_frameCapture->IsCapturing())
+        {
+            m_frameCapture->Stop();
+        }
+        else
+        {
+            m_frameCapture->Start(L"Captures", DX::CaptureFormat::Raw);
+        }
+    }
 }
 
 // Updates the world.
@@ -56,21 +576,154 @@ void Game::Update(DX::StepTimer const& timer)
     float elapsedTime = float(timer.GetElapsedSeconds());
 
     // TODO: Add your game logic here.
+    // Input for this step is in m_input, e.g. m_input.WasPressed(DX::InputControl::PadA).
+    // Debug shapes go in m_debugDrawQueue, e.g. m_debugDrawQueue.AddBox(center, extents, Colors::Red).
     elapsedTime;
+
+    // A field of spheres across the floor of the -lights box, bobbing so the tiles' depth
+    // bounds change from frame to frame. Models go in m_modelInstances when m_modelRenderer
+    // exists.
+    if (m_modelRenderer && m_sceneModel)
+    {
+        const int SceneColumns = 20;
+        const int SceneRows = 19;
+        float totalTime = float(timer.GetTotalSeconds());
+
+        for (int row = 0; row < SceneRows; row++)
+        {
+            for (int column = 0; column < SceneColumns; column++)
+            {
+                float x = -19.0f + 2.0f * column;
+                float z = -39.0f + 2.0f * row;
+                float y = 0.25f * sinf(totalTime * 2.0f + 0.5f * (column + row));
+
+                XMVECTOR color = ((column + row) % 2 == 0) ? Colors::White : Colors::LightGray;
+                m_modelRenderer->AddInstance(m_modelInstances, m_sceneModelIndex, Matrix::CreateTranslation(x, y, z), color);
+            }
+        }
+    }
+
+    if (m_input.WasPressed(VK_F8))
+    {
+        m_captureCommands |= CaptureScreenshot;
+    }
+
+    if (m_input.WasPressed(VK_F9))
+    {
+        m_captureCommands ^= ToggleCaptureRecording;
+    }
+}
+
+// Buffers gamepad changes since the last sample. Pads are polled, so their changes are
+// timestamped when the frame starts.
+void Game::SampleGamePad(uint64_t time)
+{
+    // A disconnected pad reads as all released, so controls don't stay stuck down.
+    GamePad::State pad = m_gamePad->GetState(0);
+    const GamePad::State& last = m_lastGamePad;
+
+    auto sample = [&](uint32_t control, float value, float lastValue)
+    {
+        if (value != lastValue)
+        {
+            PushInput(time, control, value);
+        }
+    };
+
+    sample(DX::InputControl::PadA, pad.buttons.a, last.buttons.a);
+    sample(DX::InputControl::PadB, pad.buttons.b, last.buttons.b);
+    sample(DX::InputControl::PadX, pad.buttons.x, last.buttons.x);
+    sample(DX::InputControl::PadY, pad.buttons.y, last.buttons.y);
+    sample(DX::InputControl::PadLeftShoulder, pad.buttons.leftShoulder, last.buttons.leftShoulder);
+    sample(DX::InputControl::PadRightShoulder, pad.buttons.rightShoulder, last.buttons.rightShoulder);
+    sample(DX::InputControl::PadBack, pad.buttons.back, last.buttons.back);
+    sample(DX::InputControl::PadStart, pad.buttons.start, last.buttons.start);
+    sample(DX::InputControl::PadDPadUp, pad.dpad.up, last.dpad.up);
+    sample(DX::InputControl::PadDPadDown, pad.dpad.down, last.dpad.down);
+    sample(DX::InputControl::PadDPadLeft, pad.dpad.left, last.dpad.left);
+    sample(DX::InputControl::PadDPadRight, pad.dpad.right, last.dpad.right);
+    sample(DX::InputControl::PadLeftStickX, pad.thumbSticks.leftX, last.thumbSticks.leftX);
+    sample(DX::InputControl::PadLeftStickY, pad.thumbSticks.leftY, last.thumbSticks.leftY);
+    sample(DX::InputControl::PadRightStickX, pad.thumbSticks.rightX, last.thumbSticks.rightX);
+    sample(DX::InputControl::PadRightStickY, pad.thumbSticks.rightY, last.thumbSticks.rightY);
+    sample(DX::InputControl::PadLeftTrigger, pad.triggers.left, last.triggers.left);
+    sample(DX::InputControl::PadRightTrigger, pad.triggers.right, last.triggers.right);
+
+    m_lastGamePad = pad;
+}
+
+// Buffers an input event for the step it belongs to, on whichever thread runs the steps.
+void Game::PushInput(uint64_t time, uint32_t control, float value)
+{
+    PendingInput input = { time, control, value };
+
+    std::lock_guard<std::mutex> lock(m_simulationMutex);
+    m_pendingInput.push_back(input);
+}
+
+// Picks the size to draw the scene at, from how long the frames so far took.
+void Game::UpdateRenderSize(uint64_t now)
+{
+    float scale = 1.0f;
+
+    if (m_options.dynamicResolution)
+    {
+        // Only a loop that ticks as fast as it can measures frame cost; a deadline-paced one
+        // spends the time between ticks waiting.
+        DX::LoopMode mode = m_loopPolicy.GetMode();
+        if (m_lastTickTime != 0 && (mode == DX::LoopMode::Busy || mode == DX::LoopMode::VSyncPaced))
+        {
+            scale = m_dynamicResolution.Update(now - m_lastTickTime);
+        }
+        else
+        {
+            scale = m_dynamicResolution.GetScale();
+        }
+
+        m_lastTickTime = now;
+    }
+
+    m_renderWidth = std::max(static_cast<int>(m_outputWidth * scale + 0.5f), 1);
+    m_renderHeight = std::max(static_cast<int>(m_outputHeight * scale + 0.5f), 1);
 }
 
 // Draws the scene.
 void Game::Render()
 {
     // Don't try to render anything before the first Update.
-    if (m_timer.GetFrameCount() == 0)
+    if (!m_frameDebugDraw)
     {
         return;
     }
 
     Clear();
 
-    // TODO: Add your rendering code here.
+    // TODO: Add your rendering code here. For lit scenes, draw opaque geometry depth-only
+    // first so each tile is bounded tightly, then draw it again with ForwardPlusVS.hlsl,
+    // ForwardPlusPS.hlsl and an equal depth test after the lights are culled.
+    if (m_lightCulling)
+    {
+        m_modelRenderer->Prepare(m_d3dContext.Get(), *m_frameModelInstances);
+        m_modelRenderer->Render(m_d3dContext.Get(), *m_frameModelInstances, m_frameView, m_proj, true);
+
+        // The depth buffer can't be read while it is bound for output. With no lights there
+        // is nothing to cull, and Apply leaves every tile empty.
+        if (m_lightCulling->GetLightCount() > 0)
+        {
+            m_d3dContext->OMSetRenderTargets(1, m_sceneTargetView.GetAddressOf(), nullptr);
+            m_lightCulling->SetWindow(m_renderWidth, m_renderHeight);
+            m_lightCulling->Cull(m_d3dContext.Get(), m_depthStencilSRV.Get(), m_frameView, m_proj);
+            m_d3dContext->OMSetRenderTargets(1, m_sceneTargetView.GetAddressOf(), m_depthStencilView.Get());
+        }
+
+        m_lightCulling->Apply(m_d3dContext.Get());
+
+        m_modelRenderer->Render(m_d3dContext.Get(), *m_frameModelInstances, m_frameView, m_proj, false);
+    }
+
+    m_debugDraw->Render(m_d3dContext.Get(), *m_frameDebugDraw, m_frameView, m_proj);
+
+    ResolveScene();
 
     Present();
 }
@@ -79,23 +732,82 @@ void Game::Render()
 void Game::Clear()
 {
     // Clear the views.
-    m_d3dContext->ClearRenderTargetView(m_renderTargetView.Get(), Colors::CornflowerBlue);
+    m_d3dContext->ClearRenderTargetView(m_sceneTargetView.Get(), Colors::CornflowerBlue);
     m_d3dContext->ClearDepthStencilView(m_depthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-    m_d3dContext->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), m_depthStencilView.Get());
+    m_d3dContext->OMSetRenderTargets(1, m_sceneTargetView.GetAddressOf(), m_depthStencilView.Get());
+
+    // Set the viewport to the render size, which is the window size unless dynamic
+    // resolution has scaled it down.
+    CD3D11_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(m_renderWidth), static_cast<float>(m_renderHeight));
+    m_d3dContext->RSSetViewports(1, &viewport);
+}
+
+// Copies the scene target, if there is one, into the back buffer.
+void Game::ResolveScene()
+{
+    if (!m_sceneTarget)
+        return;
+
+    ComPtr<ID3D11Texture2D> backBuffer;
+    DX::ThrowIfFailed(m_swapChain->GetBuffer(0, IID_PPV_ARGS(backBuffer.GetAddressOf())));
+
+    DXGI_FORMAT format = GetBackBufferFormat(m_swapChainConfig.format);
+
+    if (m_renderWidth == m_outputWidth && m_renderHeight == m_outputHeight)
+    {
+        if (m_sampleCount > 1)
+        {
+            m_d3dContext->ResolveSubresource(backBuffer.Get(), 0, m_sceneTarget.Get(), 0, format);
+        }
+        else
+        {
+            m_d3dContext->CopyResource(backBuffer.Get(), m_sceneTarget.Get());
+        }
+        return;
+    }
+
+    // Scale the drawn part up to the window with a bilinear filter.
+    if (m_sampleCount > 1)
+    {
+        m_d3dContext->ResolveSubresource(m_sceneResolve.Get(), 0, m_sceneTarget.Get(), 0, format);
+    }
+
+    m_d3dContext->OMSetRenderTargets(1, m_renderTargetView.GetAddressOf(), nullptr);
 
-    // Set the viewport.
     CD3D11_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(m_outputWidth), static_cast<float>(m_outputHeight));
     m_d3dContext->RSSetViewports(1, &viewport);
+
+    RECT source = { 0, 0, m_renderWidth, m_renderHeight };
+    RECT destination = { 0, 0, m_outputWidth, m_outputHeight };
+
+    m_spriteBatch->Begin(SpriteSortMode_Immediate, m_states->Opaque(), m_states->LinearClamp());
+    m_spriteBatch->Draw(m_sceneSRV.Get(), destination, &source);
+    m_spriteBatch->End();
+
+    // The scene target is bound for output again next frame.
+    ID3D11ShaderResourceView* nullView = nullptr;
+    m_d3dContext->PSSetShaderResources(0, 1, &nullView);
 }
 
 // Presents the back buffer contents to the screen.
 void Game::Present()
 {
-    // The first argument instructs DXGI to block until VSync, putting the application
+    // Capture only queues copies and picks up older ones, so it never waits on the GPU.
+    if (m_frameCapture->IsActive())
+    {
+        ComPtr<ID3D11Texture2D> backBuffer;
+        DX::ThrowIfFailed(m_swapChain->GetBuffer(0, IID_PPV_ARGS(backBuffer.GetAddressOf())));
+
+        m_frameCapture->OnPresent(m_d3dContext.Get(), backBuffer.Get());
+    }
+
+    // A sync interval of 1 instructs DXGI to block until VSync, putting the application
     // to sleep until the next VSync. This ensures we don't waste any cycles rendering
-    // frames that will never be displayed to the screen.
-    HRESULT hr = m_swapChain->Present(1, 0);
+    // frames that will never be displayed to the screen. Benchmark mode uses 0 to
+    // measure how fast frames can be produced.
+    UINT presentFlags = m_swapChainConfig.allowTearing ? DXGI_PRESENT_ALLOW_TEARING : 0;
+    HRESULT hr = m_swapChain->Present(m_swapChainConfig.GetSyncInterval(), presentFlags);
 
     // If the device was reset we must completely reinitialize the renderer.
     if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
@@ -105,6 +817,41 @@ void Game::Present()
     else
     {
         DX::ThrowIfFailed(hr);
+
+        if (m_firstFrameTime == 0)
+        {
+            m_firstFrameTime = DX::StepTimer::GetCurrentTicks();
+        }
+
+        if (m_swapChainConfig.benchmark)
+        {
+            ReportBenchmark();
+        }
+    }
+}
+
+// Shows the presented frame rate in the window title once a second.
+void Game::ReportBenchmark()
+{
+    uint64_t now = DX::StepTimer::GetCurrentTicks();
+    if (m_benchmarkStart == 0)
+    {
+        m_benchmarkStart = now;
+    }
+
+    m_benchmarkFrames++;
+
+    uint64_t elapsed = now - m_benchmarkStart;
+    if (elapsed >= DX::StepTimer::TicksPerSecond)
+    {
+        double seconds = DX::StepTimer::TicksToSeconds(elapsed);
+
+        wchar_t title[128];
+        swprintf_s(title, L"DXTKWin32Game - %.0f fps (%.3f ms)", m_benchmarkFrames / seconds, seconds * 1000.0 / m_benchmarkFrames);
+        SetWindowTextW(m_window, title);
+
+        m_benchmarkFrames = 0;
+        m_benchmarkStart = now;
     }
 }
 
@@ -112,21 +859,45 @@ void Game::Present()
 void Game::OnActivated()
 {
     // TODO: Game is becoming active window.
+    m_loopPolicy.OnActivated();
+
+    // The time since the last background tick isn't a frame time.
+    m_lastTickTime = 0;
 }
 
 void Game::OnDeactivated()
 {
     // TODO: Game is becoming background window.
+    // Keep animating in the background, at a lower rate.
+    m_loopPolicy.OnDeactivated();
+
+    // Key releases won't arrive while in the background. Forgetting the last pad state too
+    // makes the next sample report whatever is still held after the reset.
+    std::lock_guard<std::mutex> lock(m_simulationMutex);
+    m_pendingInput.clear();
+    m_inputResetPending = true;
+    m_lastGamePad = GamePad::State();
 }
 
 void Game::OnSuspending()
 {
     // TODO: Game is being power-suspended (or minimized).
+    // Stop ticking until resumed; the message loop sleeps in the meantime.
+    m_loopPolicy.OnSuspending();
+    StopSimulation();
 }
 
 void Game::OnResuming()
 {
     m_timer.ResetElapsedTime();
+    m_loopPolicy.OnResuming();
+    m_lastTickTime = 0;
+
+    // Unless startup is still going, in which case it starts the simulation when done.
+    if (m_options.simulationThread && !m_deviceCreation.valid() && !m_loadingContent)
+    {
+        StartSimulation();
+    }
 
     // TODO: Game is being power-resumed (or returning from minimize).
 }
@@ -136,11 +907,45 @@ void Game::OnWindowSizeChanged(int width, int height)
     m_outputWidth = std::max(width, 1);
     m_outputHeight = std::max(height, 1);
 
+    // While the device is being created, UpdateStartup sizes the swap chain once it's done.
+    if (m_deviceCreation.valid())
+        return;
+
     CreateResources();
 
     // TODO: Game window is being resized.
 }
 
+void Game::OnInputMessage(UINT message, WPARAM wParam, LPARAM lParam)
+{
+    Keyboard::ProcessMessage(message, wParam, lParam);
+    Mouse::ProcessMessage(message, wParam, lParam);
+
+    // Also buffer key and button changes with the time they arrived, for the step sampler.
+    uint64_t time = DX::StepTimer::GetCurrentTicks();
+
+    switch (message)
+    {
+    case WM_KEYDOWN:
+    case WM_SYSKEYDOWN:
+    case WM_KEYUP:
+    case WM_SYSKEYUP:
+        if (wParam <= 0xFF)
+        {
+            float value = (message == WM_KEYDOWN || message == WM_SYSKEYDOWN) ? 1.0f : 0.0f;
+            PushInput(time, DX::InputControl::KeyFirst + static_cast<uint32_t>(wParam), value);
+        }
+        break;
+
+    case WM_LBUTTONDOWN:    PushInput(time, DX::InputControl::MouseLeft, 1.0f); break;
+    case WM_LBUTTONUP:      PushInput(time, DX::InputControl::MouseLeft, 0.0f); break;
+    case WM_RBUTTONDOWN:    PushInput(time, DX::InputControl::MouseRight, 1.0f); break;
+    case WM_RBUTTONUP:      PushInput(time, DX::InputControl::MouseRight, 0.0f); break;
+    case WM_MBUTTONDOWN:    PushInput(time, DX::InputControl::MouseMiddle, 1.0f); break;
+    case WM_MBUTTONUP:      PushInput(time, DX::InputControl::MouseMiddle, 0.0f); break;
+    }
+}
+
 // Properties
 void Game::GetDefaultSize(int& width, int& height) const
 {
@@ -230,6 +1035,60 @@ void Game::CreateDevice()
     if (SUCCEEDED(m_d3dDevice.As(&m_d3dDevice1)))
         (void)m_d3dContext.As(&m_d3dContext1);
 
+    m_debugDraw = std::make_unique<DX::DebugDraw>(m_d3dContext.Get());
+
+    m_states = std::make_unique<CommonStates>(m_d3dDevice.Get());
+    m_spriteBatch = std::make_unique<SpriteBatch>(m_d3dContext.Get());
+
+    // A white texel, for drawing solid rectangles such as the loading screen's with SpriteBatch.
+    {
+        static const uint32_t white = 0xFFFFFFFF;
+        D3D11_SUBRESOURCE_DATA whiteData = { &white, sizeof(white), 0 };
+
+        CD3D11_TEXTURE2D_DESC whiteDesc(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+        ComPtr<ID3D11Texture2D> whiteTexture;
+        DX::ThrowIfFailed(m_d3dDevice->CreateTexture2D(&whiteDesc, &whiteData, whiteTexture.GetAddressOf()));
+        DX::ThrowIfFailed(m_d3dDevice->CreateShaderResourceView(whiteTexture.Get(), nullptr, m_whiteTexture.ReleaseAndGetAddressOf()));
+    }
+
+    // Use the most samples up to the requested count that the scene and depth formats both
+    // support. The back buffer format may fall back to BGRA8, so check that too.
+    m_sampleCount = m_options.sampleCount;
+    for (; m_sampleCount > 1; m_sampleCount /= 2)
+    {
+        DXGI_FORMAT formats[] = { GetBackBufferFormat(m_options.swapChain.format), DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_D24_UNORM_S8_UINT };
+
+        bool supported = true;
+        for (DXGI_FORMAT format : formats)
+        {
+            UINT qualityLevels = 0;
+            if (FAILED(m_d3dDevice->CheckMultisampleQualityLevels(format, m_sampleCount, &qualityLevels)) || qualityLevels == 0)
+            {
+                supported = false;
+            }
+        }
+
+        if (supported)
+            break;
+    }
+
+    // Tiled light culling needs compute shaders and depth buffer reads.
+    if (m_featureLevel >= D3D_FEATURE_LEVEL_11_0)
+    {
+        m_lightCulling = std::make_unique<DX::LightCulling>(m_d3dDevice.Get(), m_sampleCount > 1);
+
+        if (m_options.lightCount > 0)
+        {
+            std::vector<DX::PointLight> lights = GenerateLights(m_options.lightCount);
+            m_lightCulling->SetLights(lights.data(), lights.size());
+        }
+
+        // Shades with ForwardPlusPS.hlsl, so it needs the light lists too.
+        m_modelRenderer = std::make_unique<DX::InstancedModelRenderer>(m_d3dDevice.Get());
+
+        // The scene's model is loaded with the rest of the content.
+    }
+
     // TODO: Initialize device dependent objects here (independent of window size).
 }
 
@@ -241,18 +1100,24 @@ void Game::CreateResources()
     m_d3dContext->OMSetRenderTargets(_countof(nullViews), nullViews, nullptr);
     m_renderTargetView.Reset();
     m_depthStencilView.Reset();
+    m_depthStencilSRV.Reset();
+    m_sceneTargetView.Reset();
+    m_sceneTarget.Reset();
+    m_sceneResolve.Reset();
+    m_sceneSRV.Reset();
     m_d3dContext->Flush();
 
     UINT backBufferWidth = static_cast<UINT>(m_outputWidth);
     UINT backBufferHeight = static_cast<UINT>(m_outputHeight);
-    DXGI_FORMAT backBufferFormat = DXGI_FORMAT_B8G8R8A8_UNORM;
     DXGI_FORMAT depthBufferFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
-    UINT backBufferCount = 2;
 
     // If the swap chain already exists, resize it, otherwise create one.
     if (m_swapChain)
     {
-        HRESULT hr = m_swapChain->ResizeBuffers(backBufferCount, backBufferWidth, backBufferHeight, backBufferFormat, 0);
+        DXGI_FORMAT backBufferFormat = GetBackBufferFormat(m_swapChainConfig.format);
+        UINT swapChainFlags = m_swapChainConfig.allowTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+
+        HRESULT hr = m_swapChain->ResizeBuffers(m_swapChainConfig.backBufferCount, backBufferWidth, backBufferHeight, backBufferFormat, swapChainFlags);
 
         if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
         {
@@ -282,6 +1147,33 @@ void Game::CreateResources()
         ComPtr<IDXGIFactory1> dxgiFactory;
         DX::ThrowIfFailed(dxgiAdapter->GetParent(IID_PPV_ARGS(dxgiFactory.GetAddressOf())));
 
+        // Flip-discard arrived with DXGI 1.4 and tearing with DXGI 1.5, both on Windows 10.
+        // Flip-sequential works from Windows 8, but the Windows 7 platform update has the same
+        // DXGI 1.2 interfaces without the flip model, so Windows 8 falls back to blt.
+        DX::SwapChainSupport support = {};
+
+        ComPtr<IDXGIFactory4> dxgiFactory4;
+        if (SUCCEEDED(dxgiFactory.As(&dxgiFactory4)))
+        {
+            support.flipSequential = true;
+            support.flipDiscard = true;
+        }
+
+        ComPtr<IDXGIFactory5> dxgiFactory5;
+        if (SUCCEEDED(dxgiFactory.As(&dxgiFactory5)))
+        {
+            BOOL allowTearing = FALSE;
+            if (SUCCEEDED(dxgiFactory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing))))
+            {
+                support.tearing = allowTearing != FALSE;
+            }
+        }
+
+        m_swapChainConfig = m_options.swapChain.Resolve(support);
+
+        DXGI_FORMAT backBufferFormat = GetBackBufferFormat(m_swapChainConfig.format);
+        UINT swapChainFlags = m_swapChainConfig.allowTearing ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+
         ComPtr<IDXGIFactory2> dxgiFactory2;
         if (SUCCEEDED(dxgiFactory.As(&dxgiFactory2)))
         {
@@ -295,7 +1187,9 @@ void Game::CreateResources()
             swapChainDesc.SampleDesc.Count = 1;
             swapChainDesc.SampleDesc.Quality = 0;
             swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-            swapChainDesc.BufferCount = backBufferCount;
+            swapChainDesc.BufferCount = m_swapChainConfig.backBufferCount;
+            swapChainDesc.SwapEffect = GetSwapEffect(m_swapChainConfig.swapEffect);
+            swapChainDesc.Flags = swapChainFlags;
 
             DXGI_SWAP_CHAIN_FULLSCREEN_DESC fsSwapChainDesc = { 0 };
             fsSwapChainDesc.Windowed = TRUE;
@@ -315,7 +1209,7 @@ void Game::CreateResources()
         else
         {
             DXGI_SWAP_CHAIN_DESC swapChainDesc = { 0 };
-            swapChainDesc.BufferCount = backBufferCount;
+            swapChainDesc.BufferCount = m_swapChainConfig.backBufferCount;
             swapChainDesc.BufferDesc.Width = backBufferWidth;
             swapChainDesc.BufferDesc.Height = backBufferHeight;
             swapChainDesc.BufferDesc.Format = backBufferFormat;
@@ -324,6 +1218,8 @@ void Game::CreateResources()
             swapChainDesc.SampleDesc.Count = 1;
             swapChainDesc.SampleDesc.Quality = 0;
             swapChainDesc.Windowed = TRUE;
+            swapChainDesc.SwapEffect = GetSwapEffect(m_swapChainConfig.swapEffect);
+            swapChainDesc.Flags = swapChainFlags;
 
             DX::ThrowIfFailed(dxgiFactory->CreateSwapChain(m_d3dDevice.Get(), &swapChainDesc, m_swapChain.ReleaseAndGetAddressOf()));
         }
@@ -332,6 +1228,24 @@ void Game::CreateResources()
         DX::ThrowIfFailed(dxgiFactory->MakeWindowAssociation(m_window, DXGI_MWA_NO_ALT_ENTER));
     }
 
+    // HDR formats only display correctly once DXGI knows their color space. It is set again
+    // after every resize, since ResizeBuffers may reset it.
+    if (m_swapChainConfig.format != DX::BackBufferFormat::Bgra8)
+    {
+        DXGI_COLOR_SPACE_TYPE colorSpace = (m_swapChainConfig.format == DX::BackBufferFormat::Hdr10)
+            ? DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020
+            : DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709;
+
+        ComPtr<IDXGISwapChain3> swapChain3;
+        UINT colorSpaceSupport = 0;
+        if (SUCCEEDED(m_swapChain.As(&swapChain3))
+            && SUCCEEDED(swapChain3->CheckColorSpaceSupport(colorSpace, &colorSpaceSupport))
+            && (colorSpaceSupport & DXGI_SWAP_CHAIN_COLOR_SPACE_SUPPORT_FLAG_PRESENT))
+        {
+            DX::ThrowIfFailed(swapChain3->SetColorSpace1(colorSpace));
+        }
+    }
+
     // Obtain the backbuffer for this window which will be the final 3D rendertarget.
     ComPtr<ID3D11Texture2D> backBuffer;
     DX::ThrowIfFailed(m_swapChain->GetBuffer(0, IID_PPV_ARGS(backBuffer.GetAddressOf())));
@@ -339,24 +1253,94 @@ void Game::CreateResources()
     // Create a view interface on the rendertarget to use on bind.
     DX::ThrowIfFailed(m_d3dDevice->CreateRenderTargetView(backBuffer.Get(), nullptr, m_renderTargetView.ReleaseAndGetAddressOf()));
 
+    // The scene target matches the back buffer, at full size so the render size can change
+    // every frame without reallocating.
+    if (m_sampleCount > 1 || m_options.dynamicResolution)
+    {
+        DXGI_FORMAT sceneFormat = GetBackBufferFormat(m_swapChainConfig.format);
+        UINT sceneBindFlags = D3D11_BIND_RENDER_TARGET | (m_sampleCount == 1 ? D3D11_BIND_SHADER_RESOURCE : 0);
+        CD3D11_TEXTURE2D_DESC sceneDesc(sceneFormat, backBufferWidth, backBufferHeight, 1, 1, sceneBindFlags, D3D11_USAGE_DEFAULT, 0, m_sampleCount);
+        DX::ThrowIfFailed(m_d3dDevice->CreateTexture2D(&sceneDesc, nullptr, m_sceneTarget.ReleaseAndGetAddressOf()));
+
+        CD3D11_RENDER_TARGET_VIEW_DESC sceneTargetViewDesc(m_sampleCount > 1 ? D3D11_RTV_DIMENSION_TEXTURE2DMS : D3D11_RTV_DIMENSION_TEXTURE2D, sceneFormat);
+        DX::ThrowIfFailed(m_d3dDevice->CreateRenderTargetView(m_sceneTarget.Get(), &sceneTargetViewDesc, m_sceneTargetView.ReleaseAndGetAddressOf()));
+
+        // A scaled multisampled scene is resolved before it is drawn into the back buffer.
+        if (m_options.dynamicResolution)
+        {
+            ID3D11Texture2D* sceneSource = m_sceneTarget.Get();
+            if (m_sampleCount > 1)
+            {
+                CD3D11_TEXTURE2D_DESC resolveDesc(sceneFormat, backBufferWidth, backBufferHeight, 1, 1, D3D11_BIND_SHADER_RESOURCE);
+                DX::ThrowIfFailed(m_d3dDevice->CreateTexture2D(&resolveDesc, nullptr, m_sceneResolve.ReleaseAndGetAddressOf()));
+                sceneSource = m_sceneResolve.Get();
+            }
+
+            DX::ThrowIfFailed(m_d3dDevice->CreateShaderResourceView(sceneSource, nullptr, m_sceneSRV.ReleaseAndGetAddressOf()));
+        }
+    }
+    else
+    {
+        m_sceneTargetView = m_renderTargetView;
+    }
+
     // Allocate a 2-D surface as the depth/stencil buffer and
     // create a DepthStencil view on this surface to use on bind.
-    CD3D11_TEXTURE2D_DESC depthStencilDesc(depthBufferFormat, backBufferWidth, backBufferHeight, 1, 1, D3D11_BIND_DEPTH_STENCIL);
+    // Light culling also reads it, which needs a typeless format that can be viewed both ways.
+    DXGI_FORMAT depthTextureFormat = m_lightCulling ? DXGI_FORMAT_R24G8_TYPELESS : depthBufferFormat;
+    UINT depthBindFlags = D3D11_BIND_DEPTH_STENCIL | (m_lightCulling ? D3D11_BIND_SHADER_RESOURCE : 0);
+    CD3D11_TEXTURE2D_DESC depthStencilDesc(depthTextureFormat, backBufferWidth, backBufferHeight, 1, 1, depthBindFlags, D3D11_USAGE_DEFAULT, 0, m_sampleCount);
 
     ComPtr<ID3D11Texture2D> depthStencil;
     DX::ThrowIfFailed(m_d3dDevice->CreateTexture2D(&depthStencilDesc, nullptr, depthStencil.GetAddressOf()));
 
-    CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2D);
+    CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(m_sampleCount > 1 ? D3D11_DSV_DIMENSION_TEXTURE2DMS : D3D11_DSV_DIMENSION_TEXTURE2D, depthBufferFormat);
     DX::ThrowIfFailed(m_d3dDevice->CreateDepthStencilView(depthStencil.Get(), &depthStencilViewDesc, m_depthStencilView.ReleaseAndGetAddressOf()));
 
+    if (m_lightCulling)
+    {
+        CD3D11_SHADER_RESOURCE_VIEW_DESC depthStencilSRVDesc(m_sampleCount > 1 ? D3D11_SRV_DIMENSION_TEXTURE2DMS : D3D11_SRV_DIMENSION_TEXTURE2D, DXGI_FORMAT_R24_UNORM_X8_TYPELESS);
+        DX::ThrowIfFailed(m_d3dDevice->CreateShaderResourceView(depthStencil.Get(), &depthStencilSRVDesc, m_depthStencilSRV.ReleaseAndGetAddressOf()));
+
+        m_lightCulling->SetWindow(backBufferWidth, backBufferHeight);
+    }
+
+    // TODO: Set m_view from the camera in Update, and change the projection to suit the scene.
+    m_proj = Matrix::CreatePerspectiveFieldOfView(XM_PIDIV4, float(backBufferWidth) / float(backBufferHeight), 0.1f, 100.0f);
+
+    {
+        std::lock_guard<std::mutex> lock(m_simulationMutex);
+        m_simulationProjection = m_proj;
+    }
+
     // TODO: Initialize windows-size dependent objects here.
 }
 
 void Game::OnDeviceLost()
 {
     // TODO: Add Direct3D resource cleanup here.
-
+    // Update may be using the model renderer. Startup restarts the simulation once content
+    // is loaded again.
+    StopSimulation();
+
+    // Loads still in flight would finish on the old device; content is loaded again below.
+    m_contentLoader.reset();
+    m_whiteTexture.Reset();
+
+    m_modelRenderer.reset();
+    m_sceneModel.reset();
+    m_lightCulling.reset();
+    m_debugDraw.reset();
+    m_spriteBatch.reset();
+    m_states.reset();
+    m_frameCapture->ReleaseDevice();
+
+    m_depthStencilSRV.Reset();
     m_depthStencilView.Reset();
+    m_sceneSRV.Reset();
+    m_sceneResolve.Reset();
+    m_sceneTarget.Reset();
+    m_sceneTargetView.Reset();
     m_renderTargetView.Reset();
     m_swapChain1.Reset();
     m_swapChain.Reset();
@@ -368,4 +1352,6 @@ void Game::OnDeviceLost()
     CreateDevice();
 
     CreateResources();
+
+    LoadContent();
 }
\ No newline at end of file
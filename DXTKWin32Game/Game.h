@@ -4,7 +4,23 @@
 
 #pragma once
 
+#include "ContentLoader.h"
+#include "DebugDraw.h"
+#include "DynamicResolution.h"
+#include "FrameCapture.h"
+#include "InputSampler.h"
+#include "InstancedModelRenderer.h"
+#include "LaunchOptions.h"
+#include "LightCulling.h"
+#include "LoopPolicy.h"
 #include "StepTimer.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
 
 
 // A basic game implementation that creates a D3D11 device and
@@ -13,7 +29,8 @@ class Game
 {
 public:
 
-    Game();
+    explicit Game(DX::LaunchOptions const& options = DX::LaunchOptions());
+    ~Game();
 
     // Initialization and management
     void Initialize(HWND window, int width, int height);
@@ -27,18 +44,57 @@ public:
     void OnSuspending();
     void OnResuming();
     void OnWindowSizeChanged(int width, int height);
+    void OnInputMessage(UINT message, WPARAM wParam, LPARAM lParam);
 
     // Properties
     void GetDefaultSize(int& width, int& height) const;
 
+    // Decides when the message loop ticks, following activation and suspension.
+    DX::LoopPolicy& GetLoopPolicy() { return m_loopPolicy; }
+
+    // Input as of the end of the step being updated. With -simthread, only use it and the
+    // debug shapes from Update.
+    const DX::InputSampler& GetInput() const { return m_input; }
+
+    // Debug shapes to draw over the scene, kept until the next Update.
+    DX::DebugDrawQueue& GetDebugDraw() { return m_debugDrawQueue; }
+
+    // Picks the render scale when started with -dynres, e.g. to change the frame budget.
+    DX::DynamicResolution& GetDynamicResolution() { return m_dynamicResolution; }
+
+    // Captures presented frames to files; F8 takes a screenshot and F9 toggles recording.
+    DX::FrameCapture& GetFrameCapture() { return *m_frameCapture; }
+
 private:
 
+    bool UpdateStartup();
+    void LoadContent();
+    void QueueContent(DX::ContentLoader::Job job);
+    void LoadTexture(_In_z_ const wchar_t* fileName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& texture);
+    void RenderLoadingScreen();
+    void ReportStartup();
+
+    void StartSimulation();
+    void StopSimulation();
+    void RunSimulation();
+    void RunStep(uint64_t stepEnd);
+    void PublishSnapshot(uint64_t stepEnd);
+    void AcquireSnapshot(uint64_t now);
+    void ApplyCaptureCommands();
+
     void Update(DX::StepTimer const& timer);
     void Render();
 
     void Clear();
+    void ResolveScene();
     void Present();
 
+    void UpdateRenderSize(uint64_t now);
+
+    void SampleGamePad(uint64_t time);
+    void PushInput(uint64_t time, uint32_t control, float value);
+    void ReportBenchmark();
+
     void CreateDevice();
     void CreateResources();
 
@@ -57,11 +113,120 @@ private:
 
     Microsoft::WRL::ComPtr<IDXGISwapChain>          m_swapChain;
     Microsoft::WRL::ComPtr<IDXGISwapChain1>         m_swapChain1;
+    DX::LaunchOptions                               m_options;          // Including the swap chain requested.
+    DX::SwapChainConfig                             m_swapChainConfig;  // What the system supports of the request.
     Microsoft::WRL::ComPtr<ID3D11RenderTargetView>  m_renderTargetView;
     Microsoft::WRL::ComPtr<ID3D11DepthStencilView>  m_depthStencilView;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_depthStencilSRV;
+
+    // Where the scene is drawn: the back buffer, or with MSAA or dynamic resolution an
+    // offscreen target whose top left is drawn at the render size, then resolved and scaled
+    // into the back buffer.
+    Microsoft::WRL::ComPtr<ID3D11RenderTargetView>  m_sceneTargetView;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D>         m_sceneTarget;
+    Microsoft::WRL::ComPtr<ID3D11Texture2D>         m_sceneResolve;
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_sceneSRV;
+    UINT                                            m_sampleCount;
+    std::unique_ptr<DirectX::CommonStates>          m_states;
+    std::unique_ptr<DirectX::SpriteBatch>           m_spriteBatch;
+
+    // Dynamic resolution, driven by the time between ticks.
+    DX::DynamicResolution                           m_dynamicResolution;
+    int                                             m_renderWidth;
+    int                                             m_renderHeight;
+    uint64_t                                        m_lastTickTime;
+
+    // Tiled light culling, when the device supports it.
+    std::unique_ptr<DX::LightCulling>               m_lightCulling;
+    DirectX::SimpleMath::Matrix                     m_view;
+    DirectX::SimpleMath::Matrix                     m_proj;
+
+    // Model instances added during Update, drawn with a draw per mesh part.
+    DX::ModelInstanceQueue                          m_modelInstances;
+    std::unique_ptr<DX::InstancedModelRenderer>     m_modelRenderer;
+
+    // The scene's model, a sphere built on the content threads, and its index in
+    // m_modelRenderer once loading is done.
+    std::unique_ptr<DirectX::Model>                 m_sceneModel;
+    uint32_t                                        m_sceneModelIndex;
+
+    // Debug shapes added during Update, drawn in one batch.
+    DX::DebugDrawQueue                              m_debugDrawQueue;
+    std::unique_ptr<DX::DebugDraw>                  m_debugDraw;
+
+    // Screenshots and frame sequences, read back a few frames after they are presented.
+    std::unique_ptr<DX::FrameCapture>               m_frameCapture;
 
     // Rendering loop timer.
     DX::StepTimer                                   m_timer;
+    DX::LoopPolicy                                  m_loopPolicy;
+
+    // Frames presented since the benchmark rate was last shown.
+    uint32_t                                        m_benchmarkFrames;
+    uint64_t                                        m_benchmarkStart;
 
+    // Input devices, and input events buffered until the step they belong to.
 	std::unique_ptr<DirectX::GamePad>				m_gamePad;
+    DirectX::GamePad::State                         m_lastGamePad;
+    std::unique_ptr<DirectX::Keyboard>              m_keyboard;
+    std::unique_ptr<DirectX::Mouse>                 m_mouse;
+    DX::InputSampler                                m_input;
+
+    // Requests from Update for the frame capture, which belongs to the render thread.
+    static const uint32_t CaptureScreenshot = 1;
+    static const uint32_t ToggleCaptureRecording = 2;
+    std::atomic<uint32_t>                           m_captureCommands;
+
+    // What Render draws: the state Update left, or with the simulation thread its newest
+    // snapshot, with the camera interpolated. Null until there is something to draw.
+    DX::DebugDrawQueue*                             m_frameDebugDraw;
+    DX::ModelInstanceQueue*                         m_frameModelInstances;
+    DirectX::SimpleMath::Matrix                     m_frameView;
+
+    // The simulation thread (-simthread) runs the fixed steps and m_timer on its own, and
+    // after each tick's steps publishes a snapshot of what to draw. The window thread hands
+    // it input and the projection through m_simulationMutex, and draws one step behind its
+    // latest snapshot so there is usually one on either side to interpolate between.
+    struct PendingInput
+    {
+        uint64_t                                    time;
+        uint32_t                                    control;
+        float                                       value;
+    };
+
+    struct Snapshot
+    {
+        uint64_t                                    stepEnd;
+        DirectX::SimpleMath::Matrix                 view;
+        DX::DebugDrawQueue                          debugDraw;
+        DX::ModelInstanceQueue                      modelInstances;
+    };
+
+    std::thread                                     m_simulationThread;
+    std::mutex                                      m_simulationMutex;
+    std::condition_variable                         m_simulationWake;
+    bool                                            m_simulationExiting;
+    uint64_t                                        m_simulationStepTicks;
+    std::vector<PendingInput>                       m_pendingInput;
+    std::vector<PendingInput>                       m_stepInput;
+    bool                                            m_inputResetPending;
+    DirectX::SimpleMath::Matrix                     m_simulationProjection;
+
+    DX::TripleBuffer<Snapshot>                      m_snapshots;
+    bool                                            m_hasSnapshot;
+    uint64_t                                        m_previousStepEnd;
+    DirectX::SimpleMath::Matrix                     m_previousView;
+
+    // Startup: the device is created on a worker thread, then content loads on the content
+    // threads behind a loading screen. Declared last so the worker finishes before anything
+    // it writes to is destroyed. Times are StepTimer ticks.
+    std::future<void>                               m_deviceCreation;
+    std::unique_ptr<DX::ContentLoader>              m_contentLoader;    // Null until a load is queued.
+    Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_whiteTexture;
+    bool                                            m_loadingContent;
+    uint32_t                                        m_contentFailedCount;
+    uint64_t                                        m_startTime;
+    uint64_t                                        m_deviceTime;
+    uint64_t                                        m_firstFrameTime;
+    uint64_t                                        m_interactiveTime;
 };
\ No newline at end of file
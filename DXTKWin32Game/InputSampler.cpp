@@ -0,0 +1,84 @@
+//
+// InputSampler.cpp
+//
+
+#include "pch.h"
+#include "InputSampler.h"
+
+#include <algorithm>
+
+using namespace DX;
+
+InputSampler::InputSampler() :
+    m_value(InputControl::Count, 0.0f),
+    m_edges(InputControl::Count, 0),
+    m_heldSteps(InputControl::Count, 0),
+    m_lastLatency(0)
+{
+}
+
+void InputSampler::Push(uint64_t time, uint32_t control, float value)
+{
+    if (control >= InputControl::Count)
+        return;
+
+    Event event = { time, control, value };
+    m_events.push_back(event);
+}
+
+void InputSampler::Step(uint64_t stepEnd)
+{
+    for (uint32_t control : m_edgeControls)
+    {
+        m_edges[control] = 0;
+    }
+    m_edgeControls.clear();
+
+    // Sources push in their own order, so sort by time; stable so same-time events keep theirs.
+    std::stable_sort(m_events.begin(), m_events.end(), [](const Event& a, const Event& b)
+    {
+        return a.time < b.time;
+    });
+
+    uint64_t latency = 0;
+    size_t applied = 0;
+    for (; applied < m_events.size() && m_events[applied].time <= stepEnd; applied++)
+    {
+        const Event& event = m_events[applied];
+
+        bool wasDown = IsDown(event.control);
+        m_value[event.control] = event.value;
+        bool isDown = IsDown(event.control);
+
+        if (isDown != wasDown)
+        {
+            if (m_edges[event.control] == 0)
+            {
+                m_edgeControls.push_back(event.control);
+            }
+            m_edges[event.control] |= isDown ? Pressed : Released;
+        }
+
+        latency += stepEnd - event.time;
+    }
+
+    if (applied > 0)
+    {
+        m_lastLatency = latency / applied;
+        m_events.erase(m_events.begin(), m_events.begin() + applied);
+    }
+
+    for (uint32_t control = 0; control < InputControl::Count; control++)
+    {
+        m_heldSteps[control] = IsDown(control) ? m_heldSteps[control] + 1 : 0;
+    }
+}
+
+void InputSampler::Reset()
+{
+    m_events.clear();
+    m_edgeControls.clear();
+    std::fill(m_value.begin(), m_value.end(), 0.0f);
+    std::fill(m_edges.begin(), m_edges.end(), static_cast<uint8_t>(0));
+    std::fill(m_heldSteps.begin(), m_heldSteps.end(), 0u);
+}
@@ -0,0 +1,96 @@
+//
+// InputSampler.h - Timestamped input events resampled onto simulation steps
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+    // Control numbers. Keys use their virtual-key code; mouse buttons and gamepad controls
+    // follow. Analog controls carry their value, digital ones 0 or 1.
+    namespace InputControl
+    {
+        static const uint32_t KeyFirst = 0x000;
+        static const uint32_t MouseLeft = 0x100;
+        static const uint32_t MouseRight = 0x101;
+        static const uint32_t MouseMiddle = 0x102;
+        static const uint32_t PadA = 0x200;
+        static const uint32_t PadB = 0x201;
+        static const uint32_t PadX = 0x202;
+        static const uint32_t PadY = 0x203;
+        static const uint32_t PadLeftShoulder = 0x204;
+        static const uint32_t PadRightShoulder = 0x205;
+        static const uint32_t PadBack = 0x206;
+        static const uint32_t PadStart = 0x207;
+        static const uint32_t PadDPadUp = 0x208;
+        static const uint32_t PadDPadDown = 0x209;
+        static const uint32_t PadDPadLeft = 0x20A;
+        static const uint32_t PadDPadRight = 0x20B;
+        static const uint32_t PadLeftStickX = 0x20C;
+        static const uint32_t PadLeftStickY = 0x20D;
+        static const uint32_t PadRightStickX = 0x20E;
+        static const uint32_t PadRightStickY = 0x20F;
+        static const uint32_t PadLeftTrigger = 0x210;
+        static const uint32_t PadRightTrigger = 0x211;
+        static const uint32_t Count = 0x212;
+    }
+
+    // Buffers input events with the time they happened and hands them to the simulation one
+    // fixed step at a time. Each event is applied to the step whose time span contains it, so
+    // at low simulation rates input is not held back to the next frame, and a press and
+    // release between two steps still registers as a press. Times are in StepTimer ticks.
+    class InputSampler
+    {
+    public:
+        InputSampler();
+
+        // Records a new value for a control. Events may arrive out of order between steps.
+        void Push(uint64_t time, uint32_t control, float value);
+
+        // Advances to the step that ends at stepEnd, applying every event up to it. Events
+        // older than the previous step land in this one.
+        void Step(uint64_t stepEnd);
+
+        // Forgets buffered events and releases every control, e.g. when focus is lost.
+        void Reset();
+
+        // State as of the end of the current step.
+        bool IsDown(uint32_t control) const         { return m_value[control] > 0.5f; }
+        float GetValue(uint32_t control) const      { return m_value[control]; }
+
+        // Edges during the current step. Both can be set by a quick tap.
+        bool WasPressed(uint32_t control) const     { return (m_edges[control] & Pressed) != 0; }
+        bool WasReleased(uint32_t control) const    { return (m_edges[control] & Released) != 0; }
+
+        // Consecutive steps the control has been down at the end of, including this one.
+        uint32_t GetHeldSteps(uint32_t control) const   { return m_heldSteps[control]; }
+
+        // Average time from events to the end of the step they were applied in, over the
+        // last step with events.
+        uint64_t GetLastLatency() const             { return m_lastLatency; }
+
+    private:
+        struct Event
+        {
+            uint64_t    time;
+            uint32_t    control;
+            float       value;
+        };
+
+        static const uint8_t Pressed = 1;
+        static const uint8_t Released = 2;
+
+        std::vector<Event>      m_events;
+        std::vector<float>      m_value;
+        std::vector<uint8_t>    m_edges;
+        std::vector<uint32_t>   m_heldSteps;
+
+        // Controls with edges this step, so they can be cleared without touching every control.
+        std::vector<uint32_t>   m_edgeControls;
+
+        uint64_t                m_lastLatency;
+    };
+}
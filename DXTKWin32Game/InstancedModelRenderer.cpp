@@ -0,0 +1,200 @@
+//
+// InstancedModelRenderer.cpp
+//
+
+#include "pch.h"
+#include "InstancedModelRenderer.h"
+#include "ReadData.h"
+
+#include <cstring>
+
+using namespace DirectX;
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+static_assert(sizeof(ModelInstance) == 64, "ModelInstance must match InstancedModelVS.hlsl");
+
+namespace
+{
+    const D3D11_INPUT_ELEMENT_DESC InstanceElements[] =
+    {
+        { "INSTANCE_TRANSFORM", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "INSTANCE_TRANSFORM", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "INSTANCE_TRANSFORM", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "INSTANCE_COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    };
+}
+
+InstancedModelRenderer::InstancedModelRenderer(ID3D11Device* device) :
+    m_device(device),
+    m_instanceCapacity(0),
+    m_instanceOffset(0),
+    m_firstInstance(0),
+    m_lastDrawCallCount(0)
+{
+    m_vertexShaderCode = DX::ReadData(L"InstancedModelVS.cso");
+    DX::ThrowIfFailed(device->CreateVertexShader(m_vertexShaderCode.data(), m_vertexShaderCode.size(), nullptr, m_vertexShader.ReleaseAndGetAddressOf()));
+
+    auto pixelShader = DX::ReadData(L"ForwardPlusPS.cso");
+    DX::ThrowIfFailed(device->CreatePixelShader(pixelShader.data(), pixelShader.size(), nullptr, m_pixelShader.ReleaseAndGetAddressOf()));
+
+    CD3D11_BUFFER_DESC constantBufferDesc(sizeof(Constants), D3D11_BIND_CONSTANT_BUFFER);
+    DX::ThrowIfFailed(device->CreateBuffer(&constantBufferDesc, nullptr, m_constantBuffer.ReleaseAndGetAddressOf()));
+
+    CD3D11_DEPTH_STENCIL_DESC depthDesc(D3D11_DEFAULT);
+    depthDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+    depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+    DX::ThrowIfFailed(device->CreateDepthStencilState(&depthDesc, m_lessEqualDepth.ReleaseAndGetAddressOf()));
+
+    m_states = std::make_unique<CommonStates>(device);
+
+    CreateInstanceBuffer(4096);
+}
+
+uint32_t InstancedModelRenderer::AddModel(const Model& model)
+{
+    ModelBatches batches = { static_cast<uint32_t>(m_batches.size()), static_cast<uint32_t>(model.meshes.size()) };
+
+    for (auto& mesh : model.meshes)
+    {
+        const BoundingSphere& sphere = mesh->boundingSphere;
+        MeshBatch batch = { mesh.get(), { sphere.Center.x, sphere.Center.y, sphere.Center.z, sphere.Radius } };
+        m_batches.push_back(batch);
+
+        for (auto& part : mesh->meshParts)
+        {
+            if (!part->vbDecl)
+                throw std::exception("InstancedModelRenderer needs the parts' vertex declarations");
+
+            auto& inputLayout = m_inputLayouts[part->vbDecl.get()];
+            if (inputLayout)
+                continue;
+
+            // The mesh's vertices in slot 0, followed by the instances in slot 1.
+            std::vector<D3D11_INPUT_ELEMENT_DESC> elements(*part->vbDecl);
+            elements.insert(elements.end(), std::begin(InstanceElements), std::end(InstanceElements));
+
+            DX::ThrowIfFailed(m_device->CreateInputLayout(elements.data(), static_cast<UINT>(elements.size()),
+                m_vertexShaderCode.data(), m_vertexShaderCode.size(), inputLayout.ReleaseAndGetAddressOf()));
+        }
+    }
+
+    m_models.push_back(batches);
+    return static_cast<uint32_t>(m_models.size() - 1);
+}
+
+void InstancedModelRenderer::AddInstance(ModelInstanceQueue& queue, uint32_t model, FXMMATRIX world, FXMVECTOR color)
+{
+    XMFLOAT4X4 worldMatrix;
+    XMStoreFloat4x4(&worldMatrix, world);
+
+    XMFLOAT4 instanceColor;
+    XMStoreFloat4(&instanceColor, color);
+    const float colorValues[4] = { instanceColor.x, instanceColor.y, instanceColor.z, instanceColor.w };
+
+    const ModelBatches& batches = m_models[model];
+    for (uint32_t i = 0; i < batches.batchCount; i++)
+    {
+        uint32_t batch = batches.firstBatch + i;
+        queue.Add(batch, worldMatrix.m, m_batches[batch].bounds, colorValues);
+    }
+}
+
+void InstancedModelRenderer::Prepare(ID3D11DeviceContext* context, ModelInstanceQueue& queue)
+{
+    queue.Sort();
+
+    size_t count = queue.GetInstanceCount();
+    m_firstInstance = 0;
+
+    if (count == 0)
+        return;
+
+    if (count > m_instanceCapacity)
+    {
+        CreateInstanceBuffer(std::max(count, m_instanceCapacity * 2));
+    }
+
+    // Append after what earlier frames' draws may still be reading, and only discard, which
+    // hands back fresh memory, when the buffer is full.
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (m_instanceOffset + count > m_instanceCapacity)
+    {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        m_instanceOffset = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    DX::ThrowIfFailed(context->Map(m_instanceBuffer.Get(), 0, mapType, 0, &mapped));
+
+    memcpy(static_cast<ModelInstance*>(mapped.pData) + m_instanceOffset, queue.GetInstances(), count * sizeof(ModelInstance));
+
+    context->Unmap(m_instanceBuffer.Get(), 0);
+
+    m_firstInstance = m_instanceOffset;
+    m_instanceOffset += count;
+}
+
+void InstancedModelRenderer::Render(ID3D11DeviceContext* context, const ModelInstanceQueue& queue, FXMMATRIX view, CXMMATRIX projection, bool depthOnly)
+{
+    m_lastDrawCallCount = 0;
+
+    if (queue.GetInstanceCount() == 0)
+        return;
+
+    Constants constants;
+    XMStoreFloat4x4(&constants.view, XMMatrixTranspose(view));
+    XMStoreFloat4x4(&constants.projection, XMMatrixTranspose(projection));
+    context->UpdateSubresource(m_constantBuffer.Get(), 0, nullptr, &constants, 0, 0);
+
+    context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+    context->VSSetConstantBuffers(0, 1, m_constantBuffer.GetAddressOf());
+    context->PSSetShader(depthOnly ? nullptr : m_pixelShader.Get(), nullptr, 0);
+
+    context->OMSetBlendState(m_states->Opaque(), nullptr, 0xFFFFFFFF);
+    context->OMSetDepthStencilState(depthOnly ? m_states->DepthDefault() : m_lessEqualDepth.Get(), 0);
+
+    queue.ForEachBatch([&](uint32_t batch, uint32_t firstInstance, uint32_t instanceCount)
+    {
+        const ModelMesh* mesh = m_batches[batch].mesh;
+
+        context->RSSetState(mesh->ccw ? m_states->CullCounterClockwise() : m_states->CullClockwise());
+
+        for (auto& part : mesh->meshParts)
+        {
+            if (part->isAlpha)
+                continue;
+
+            ID3D11Buffer* vertexBuffers[] = { part->vertexBuffer.Get(), m_instanceBuffer.Get() };
+            UINT strides[] = { part->vertexStride, sizeof(ModelInstance) };
+            UINT offsets[] = { 0, 0 };
+
+            context->IASetInputLayout(m_inputLayouts[part->vbDecl.get()].Get());
+            context->IASetVertexBuffers(0, _countof(vertexBuffers), vertexBuffers, strides, offsets);
+            context->IASetIndexBuffer(part->indexBuffer.Get(), part->indexFormat, 0);
+            context->IASetPrimitiveTopology(part->primitiveType);
+
+            context->DrawIndexedInstanced(part->indexCount, instanceCount, part->startIndex, part->vertexOffset,
+                static_cast<UINT>(m_firstInstance + firstInstance));
+            m_lastDrawCallCount++;
+        }
+    });
+
+    // Leave slot 1 free for whoever draws next.
+    ID3D11Buffer* nullBuffer = nullptr;
+    UINT zero = 0;
+    context->IASetVertexBuffers(1, 1, &nullBuffer, &zero, &zero);
+}
+
+void InstancedModelRenderer::CreateInstanceBuffer(size_t capacity)
+{
+    CD3D11_BUFFER_DESC instanceBufferDesc(static_cast<UINT>(capacity * sizeof(ModelInstance)), D3D11_BIND_VERTEX_BUFFER,
+        D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE);
+    DX::ThrowIfFailed(m_device->CreateBuffer(&instanceBufferDesc, nullptr, m_instanceBuffer.ReleaseAndGetAddressOf()));
+
+    m_instanceCapacity = capacity;
+
+    // So the first map discards.
+    m_instanceOffset = capacity;
+}
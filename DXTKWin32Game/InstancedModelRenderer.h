@@ -0,0 +1,96 @@
+//
+// InstancedModelRenderer.h - Draws DirectX::Model meshes with one instanced draw per part
+//
+
+#pragma once
+
+#include "ModelInstanceQueue.h"
+
+#include <map>
+
+namespace DX
+{
+    // Draws the instances in a ModelInstanceQueue with one DrawIndexedInstanced per opaque
+    // mesh part per batch, where Model::Draw costs an effect update and a draw per part per
+    // instance. Each batch is one mesh of a model added with AddModel.
+    //
+    // A frame's instances are appended to a dynamic vertex buffer with
+    // D3D11_MAP_WRITE_NO_OVERWRITE, discarding only when it wraps, so an upload never waits
+    // for draws still reading earlier frames' instances.
+    //
+    // Vertices are shaded by ForwardPlusPS.hlsl, so this needs feature level 11_0 and
+    // LightCulling applied for the lit pass. Meshes need positions and normals; their
+    // textures and effects aren't used, and alpha parts are skipped.
+    class InstancedModelRenderer
+    {
+    public:
+        explicit InstancedModelRenderer(_In_ ID3D11Device* device);
+
+        InstancedModelRenderer(InstancedModelRenderer const&) = delete;
+        InstancedModelRenderer& operator= (InstancedModelRenderer const&) = delete;
+
+        // Makes a batch of each of the model's meshes and returns an index for AddInstance.
+        // The model must outlive the renderer.
+        uint32_t AddModel(const DirectX::Model& model);
+
+        // Queues an instance of each of a model's meshes, culled by the meshes' bounds.
+        void AddInstance(ModelInstanceQueue& queue, uint32_t model, DirectX::FXMMATRIX world, DirectX::FXMVECTOR color);
+
+        // Sorts the queue and copies its instances to the GPU. Call once a frame, before
+        // Render.
+        void Prepare(_In_ ID3D11DeviceContext* context, ModelInstanceQueue& queue);
+
+        // Draws the instances copied by the last Prepare. depthOnly draws without a pixel
+        // shader, as the depth pass that light culling bounds tiles with; otherwise the
+        // depth test passes equal depths, so the lit pass can follow it without writing depth.
+        void Render(_In_ ID3D11DeviceContext* context, const ModelInstanceQueue& queue, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection, bool depthOnly);
+
+        uint32_t GetLastDrawCallCount() const       { return m_lastDrawCallCount; }
+
+    private:
+        // Matches InstancedModelVS.hlsl.
+        struct Constants
+        {
+            DirectX::XMFLOAT4X4     view;
+            DirectX::XMFLOAT4X4     projection;
+        };
+
+        struct ModelBatches
+        {
+            uint32_t                firstBatch;
+            uint32_t                batchCount;
+        };
+
+        struct MeshBatch
+        {
+            const DirectX::ModelMesh*   mesh;
+            InstanceSphere              bounds;
+        };
+
+        void CreateInstanceBuffer(size_t capacity);
+
+        Microsoft::WRL::ComPtr<ID3D11Device>                m_device;
+        Microsoft::WRL::ComPtr<ID3D11VertexShader>          m_vertexShader;
+        Microsoft::WRL::ComPtr<ID3D11PixelShader>           m_pixelShader;
+        Microsoft::WRL::ComPtr<ID3D11Buffer>                m_constantBuffer;
+        Microsoft::WRL::ComPtr<ID3D11DepthStencilState>     m_lessEqualDepth;
+        std::unique_ptr<DirectX::CommonStates>              m_states;
+        std::vector<uint8_t>                                m_vertexShaderCode;
+
+        // Input layouts by the vertex declaration they were made from, since parts of the
+        // same model usually share one.
+        std::map<const void*, Microsoft::WRL::ComPtr<ID3D11InputLayout>> m_inputLayouts;
+
+        std::vector<ModelBatches>                           m_models;
+        std::vector<MeshBatch>                              m_batches;
+
+        // Instances are appended at m_instanceOffset; the last Prepare's start at
+        // m_firstInstance.
+        Microsoft::WRL::ComPtr<ID3D11Buffer>                m_instanceBuffer;
+        size_t                                              m_instanceCapacity;
+        size_t                                              m_instanceOffset;
+        size_t                                              m_firstInstance;
+
+        uint32_t                                            m_lastDrawCallCount;
+    };
+}
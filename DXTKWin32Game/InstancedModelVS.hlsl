@@ -0,0 +1,47 @@
+//
+// InstancedModelVS.hlsl - Vertex shader for model instances lit by ForwardPlusPS
+//
+
+// Matrices are transposed before upload.
+cbuffer InstanceConstants : register(b0)
+{
+    float4x4 View;
+    float4x4 Projection;
+};
+
+// Slot 0 is the mesh's vertices, slot 1 a DX::ModelInstance per instance. The world
+// matrix must not scale non-uniformly.
+struct VertexShaderInput
+{
+    float3 position : SV_Position;
+    float3 normal : NORMAL;
+    float4 world0 : INSTANCE_TRANSFORM0;
+    float4 world1 : INSTANCE_TRANSFORM1;
+    float4 world2 : INSTANCE_TRANSFORM2;
+    float4 color : INSTANCE_COLOR;
+};
+
+struct PixelShaderInput
+{
+    float4 position : SV_Position;
+    float3 viewPosition : TEXCOORD0;
+    float3 viewNormal : NORMAL;
+    float4 color : COLOR;
+};
+
+PixelShaderInput main(VertexShaderInput input)
+{
+    PixelShaderInput output;
+
+    float3x4 world = float3x4(input.world0, input.world1, input.world2);
+    float3 worldPosition = mul(world, float4(input.position, 1.0f));
+    float3 worldNormal = mul((float3x3)world, input.normal);
+
+    float4 viewPosition = mul(float4(worldPosition, 1.0f), View);
+    output.position = mul(viewPosition, Projection);
+    output.viewPosition = viewPosition.xyz;
+    output.viewNormal = mul(worldNormal, (float3x3)View);
+    output.color = input.color;
+
+    return output;
+}
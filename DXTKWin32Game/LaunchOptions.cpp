@@ -0,0 +1,124 @@
+//
+// LaunchOptions.cpp
+//
+
+#include "pch.h"
+#include "LaunchOptions.h"
+
+#include <cwctype>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Splits on whitespace and lower-cases, since options are case-insensitive.
+    std::vector<std::wstring> Tokenize(const wchar_t* commandLine)
+    {
+        std::vector<std::wstring> tokens;
+        std::wstring token;
+
+        for (const wchar_t* c = commandLine; c && *c; c++)
+        {
+            if (iswspace(*c))
+            {
+                if (!token.empty())
+                {
+                    tokens.push_back(token);
+                    token.clear();
+                }
+            }
+            else
+            {
+                token += static_cast<wchar_t>(towlower(*c));
+            }
+        }
+
+        if (!token.empty())
+        {
+            tokens.push_back(token);
+        }
+
+        return tokens;
+    }
+}
+
+LaunchOptions::LaunchOptions() :
+    sampleCount(1),
+    dynamicResolution(false),
+    simulationThread(false),
+    lightCount(0)
+{
+}
+
+bool LaunchOptions::Parse(const wchar_t* commandLine, std::wstring& error)
+{
+    LaunchOptions options = *this;
+    std::vector<std::wstring> tokens = Tokenize(commandLine);
+
+    // The swap chain takes its options out; the rest are ours.
+    if (!options.swapChain.Parse(tokens, error))
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        const std::wstring& option = tokens[i];
+
+        if (option == L"-msaa")
+        {
+            if (i + 1 >= tokens.size())
+            {
+                error = L"Missing value for " + option;
+                return false;
+            }
+
+            const std::wstring& value = tokens[++i];
+            wchar_t* end = nullptr;
+            unsigned long count = wcstoul(value.c_str(), &end, 10);
+            if (*end != 0 || count < 1 || count > MaxSampleCount || (count & (count - 1)) != 0)
+            {
+                error = L"-msaa must be 1, 2, 4 or 8, not " + value;
+                return false;
+            }
+
+            options.sampleCount = static_cast<uint32_t>(count);
+        }
+        else if (option == L"-dynres")
+        {
+            options.dynamicResolution = true;
+        }
+        else if (option == L"-simthread")
+        {
+            options.simulationThread = true;
+        }
+        else if (option == L"-lights")
+        {
+            if (i + 1 >= tokens.size())
+            {
+                error = L"Missing value for " + option;
+                return false;
+            }
+
+            const std::wstring& value = tokens[++i];
+            wchar_t* end = nullptr;
+            unsigned long count = wcstoul(value.c_str(), &end, 10);
+            if (value.empty() || !iswdigit(value[0]) || *end != 0 || count > MaxLightCount)
+            {
+                error = L"-lights must be 0 to " + std::to_wstring(MaxLightCount) + L", not " + value;
+                return false;
+            }
+
+            options.lightCount = static_cast<uint32_t>(count);
+        }
+        else
+        {
+            error = L"Unknown option " + option;
+            return false;
+        }
+    }
+
+    *this = options;
+    return true;
+}
@@ -0,0 +1,42 @@
+//
+// LaunchOptions.h - Options read from the command line at startup
+//
+
+#pragma once
+
+#include "SwapChainConfig.h"
+
+#include <string>
+
+namespace DX
+{
+    // Everything the command line can ask for: the swap chain, plus options for how the game
+    // itself runs. With MSAA the scene is drawn to an offscreen target and resolved into the
+    // back buffer, which stays single-sampled as flip-model buffers must; the device's support
+    // for the sample count is checked when it is created. Dynamic resolution draws the scene
+    // offscreen at a scale that keeps frames within budget. The simulation thread runs fixed
+    // steps on their own thread, so a slow Present doesn't hold them back. -lights fills the
+    // scene with a generated set of point lights, for exercising light culling.
+    struct LaunchOptions
+    {
+        static const uint32_t MaxSampleCount = 8;
+        static const uint32_t MaxLightCount = 65536;
+
+        LaunchOptions();
+
+        // Reads the swap chain's options, as SwapChainConfig::Parse lists them, and:
+        //   -msaa 1|2|4|8
+        //   -dynres
+        //   -simthread
+        //   -lights 0..MaxLightCount
+        // Returns false and describes the problem in error for an unknown or malformed
+        // option, leaving the options unchanged.
+        bool Parse(const wchar_t* commandLine, std::wstring& error);
+
+        SwapChainConfig     swapChain;
+        uint32_t            sampleCount;
+        bool                dynamicResolution;
+        bool                simulationThread;
+        uint32_t            lightCount;
+    };
+}
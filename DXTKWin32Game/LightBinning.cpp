@@ -0,0 +1,198 @@
+//
+// LightBinning.cpp
+//
+
+#include "pch.h"
+#include "LightBinning.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+
+LightBinning::LightBinning() :
+    m_width(0),
+    m_height(0),
+    m_tilesX(0),
+    m_tilesY(0),
+    m_xScale(1.0f),
+    m_yScale(1.0f),
+    m_nearZ(0.1f),
+    m_farZ(100.0f),
+    m_maxTileLightCount(0)
+{
+}
+
+void LightBinning::SetView(uint32_t width, uint32_t height, float xScale, float yScale, float nearZ, float farZ)
+{
+    m_width = width;
+    m_height = height;
+    m_tilesX = (width + TileSize - 1) / TileSize;
+    m_tilesY = (height + TileSize - 1) / TileSize;
+    m_xScale = xScale;
+    m_yScale = yScale;
+    m_nearZ = nearZ;
+    m_farZ = farZ;
+
+    // The inside of edge x is to its right, where xScale * x / depth >= a.
+    m_edgesX.resize(m_tilesX + 1);
+    m_columns.resize(m_tilesX);
+    for (uint32_t x = 0; x <= m_tilesX; x++)
+    {
+        float a = 2.0f * x * TileSize / width - 1.0f;
+        float length = std::sqrt(xScale * xScale + a * a);
+        m_edgesX[x].across = xScale / length;
+        m_edgesX[x].depth = -a / length;
+    }
+
+    // Rows run down the screen, so the inside of edge y is below it.
+    m_edgesY.resize(m_tilesY + 1);
+    for (uint32_t y = 0; y <= m_tilesY; y++)
+    {
+        float b = 1.0f - 2.0f * y * TileSize / height;
+        float length = std::sqrt(yScale * yScale + b * b);
+        m_edgesY[y].across = -yScale / length;
+        m_edgesY[y].depth = b / length;
+    }
+}
+
+void LightBinning::Bin(const LightSphere* lights, uint32_t count, const float* tileMinDepth, const float* tileMaxDepth)
+{
+    m_hits.clear();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const LightSphere& light = lights[i];
+        float nearDepth = light.depth - light.radius;
+        float farDepth = light.depth + light.radius;
+
+        if (farDepth < m_nearZ || nearDepth > m_farZ)
+            continue;
+
+        int x0 = 0;
+        int x1 = static_cast<int>(m_tilesX) - 1;
+        int y0 = 0;
+        int y1 = static_cast<int>(m_tilesY) - 1;
+
+        // Project the sphere's bounding box. A light around the eye can touch any tile.
+        if (nearDepth > 1e-4f)
+        {
+            float left = light.x - light.radius;
+            float right = light.x + light.radius;
+            float bottom = light.y - light.radius;
+            float top = light.y + light.radius;
+
+            float minX = m_xScale * left / (left < 0.0f ? nearDepth : farDepth);
+            float maxX = m_xScale * right / (right > 0.0f ? nearDepth : farDepth);
+            float minY = m_yScale * bottom / (bottom < 0.0f ? nearDepth : farDepth);
+            float maxY = m_yScale * top / (top > 0.0f ? nearDepth : farDepth);
+
+            // Padded by a tile so rounding never drops one the exact test would keep.
+            x0 = std::max(x0, static_cast<int>(std::floor(ToTileX(minX))) - 1);
+            x1 = std::min(x1, static_cast<int>(std::floor(ToTileX(maxX))) + 1);
+            y0 = std::max(y0, static_cast<int>(std::floor(ToTileY(maxY))) - 1);
+            y1 = std::min(y1, static_cast<int>(std::floor(ToTileY(minY))) + 1);
+        }
+
+        // The edge tests split into columns and rows, so do each once per light rather than
+        // once per tile; what's left per tile is the depth test.
+        for (int x = x0; x <= x1; x++)
+        {
+            const EdgePlane& left = m_edgesX[x];
+            const EdgePlane& right = m_edgesX[x + 1];
+            m_columns[x] = left.across * light.x + left.depth * light.depth >= -light.radius &&
+                -(right.across * light.x + right.depth * light.depth) >= -light.radius;
+        }
+
+        for (int y = y0; y <= y1; y++)
+        {
+            const EdgePlane& top = m_edgesY[y];
+            const EdgePlane& bottom = m_edgesY[y + 1];
+            if (top.across * light.y + top.depth * light.depth < -light.radius ||
+                -(bottom.across * light.y + bottom.depth * light.depth) < -light.radius)
+                continue;
+
+            for (int x = x0; x <= x1; x++)
+            {
+                uint32_t tile = y * m_tilesX + x;
+                float minDepth = tileMinDepth ? tileMinDepth[tile] : m_nearZ;
+                float maxDepth = tileMaxDepth ? tileMaxDepth[tile] : m_farZ;
+
+                if (m_columns[x] && farDepth >= minDepth && nearDepth <= maxDepth)
+                {
+                    m_hits.push_back(static_cast<uint64_t>(tile) << 32 | i);
+                }
+            }
+        }
+    }
+
+    // Counting sort by tile. Hits were found in light order, so each list stays sorted.
+    uint32_t tileCount = m_tilesX * m_tilesY;
+    m_offsets.assign(tileCount + 1, 0);
+    for (uint64_t hit : m_hits)
+    {
+        m_offsets[static_cast<uint32_t>(hit >> 32) + 1]++;
+    }
+
+    m_maxTileLightCount = 0;
+    for (uint32_t tile = 0; tile < tileCount; tile++)
+    {
+        m_maxTileLightCount = std::max(m_maxTileLightCount, m_offsets[tile + 1]);
+        m_offsets[tile + 1] += m_offsets[tile];
+    }
+
+    // Fill using each list's start as its cursor, which leaves it at the next list's start.
+    m_indices.resize(m_hits.size());
+    for (uint64_t hit : m_hits)
+    {
+        m_indices[m_offsets[static_cast<uint32_t>(hit >> 32)]++] = static_cast<uint32_t>(hit);
+    }
+
+    for (uint32_t tile = tileCount; tile > 0; tile--)
+    {
+        m_offsets[tile] = m_offsets[tile - 1];
+    }
+    m_offsets[0] = 0;
+}
+
+const uint32_t* LightBinning::GetTileLights(uint32_t tileX, uint32_t tileY, uint32_t& count) const
+{
+    uint32_t tile = tileY * m_tilesX + tileX;
+    count = m_offsets[tile + 1] - m_offsets[tile];
+    return m_indices.data() + m_offsets[tile];
+}
+
+bool LightBinning::SphereInTile(const LightSphere& light, uint32_t tileX, uint32_t tileY, float minDepth, float maxDepth) const
+{
+    const EdgePlane& left = m_edgesX[tileX];
+    const EdgePlane& right = m_edgesX[tileX + 1];
+    const EdgePlane& top = m_edgesY[tileY];
+    const EdgePlane& bottom = m_edgesY[tileY + 1];
+
+    if (left.across * light.x + left.depth * light.depth < -light.radius)
+        return false;
+
+    if (-(right.across * light.x + right.depth * light.depth) < -light.radius)
+        return false;
+
+    if (top.across * light.y + top.depth * light.depth < -light.radius)
+        return false;
+
+    if (-(bottom.across * light.y + bottom.depth * light.depth) < -light.radius)
+        return false;
+
+    return light.depth + light.radius >= minDepth && light.depth - light.radius <= maxDepth;
+}
+
+float LightBinning::ToTileX(float ndc) const
+{
+    // Clamped first so far off-screen bounds can't overflow the conversion to int.
+    float tile = (ndc * 0.5f + 0.5f) * m_width / TileSize;
+    return std::min(std::max(tile, -2.0f), static_cast<float>(m_tilesX) + 1.0f);
+}
+
+float LightBinning::ToTileY(float ndc) const
+{
+    float tile = (0.5f - ndc * 0.5f) * m_height / TileSize;
+    return std::min(std::max(tile, -2.0f), static_cast<float>(m_tilesY) + 1.0f);
+}
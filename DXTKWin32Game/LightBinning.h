@@ -0,0 +1,90 @@
+//
+// LightBinning.h - CPU reference for tiled light culling
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+    // A point light's bounds in view space. depth is the distance along the view direction,
+    // so it is positive in front of the camera for both left- and right-handed views.
+    struct LightSphere
+    {
+        float x;
+        float y;
+        float depth;
+        float radius;
+    };
+
+    // Bins lights into screen tiles with the same tests as LightCullingCS.hlsl, so GPU light
+    // lists can be checked against it and tools can cull without a device. Each light is
+    // only tested against the tiles its projected bounds touch, so the cost follows the
+    // lists' size rather than lights times tiles.
+    class LightBinning
+    {
+    public:
+        static const uint32_t TileSize = 16;
+
+        LightBinning();
+
+        // Screen size in pixels, the projection's x and y scale (_11 and _22) and the view
+        // depth of the near and far planes.
+        void SetView(uint32_t width, uint32_t height, float xScale, float yScale, float nearZ, float farZ);
+
+        uint32_t GetTilesX() const      { return m_tilesX; }
+        uint32_t GetTilesY() const      { return m_tilesY; }
+
+        // Builds the light list of every tile. tileMinDepth and tileMaxDepth optionally bound
+        // each tile's visible geometry, as the GPU reduces them from the depth buffer; a tile
+        // with min above max gets no lights. Without them tiles span near to far.
+        void Bin(const LightSphere* lights, uint32_t count, const float* tileMinDepth = nullptr, const float* tileMaxDepth = nullptr);
+
+        // Indices of the lights touching a tile, in ascending order.
+        const uint32_t* GetTileLights(uint32_t tileX, uint32_t tileY, uint32_t& count) const;
+
+        // The longest list from the last Bin, to size GPU lists against.
+        uint32_t GetMaxTileLightCount() const   { return m_maxTileLightCount; }
+
+        // The exact per-tile test, as Bin applies it.
+        bool SphereInTile(const LightSphere& light, uint32_t tileX, uint32_t tileY, float minDepth, float maxDepth) const;
+
+    private:
+        // A plane through the eye along a tile edge, as its normal's components across the
+        // screen and along depth.
+        struct EdgePlane
+        {
+            float across;
+            float depth;
+        };
+
+        float ToTileX(float ndc) const;
+        float ToTileY(float ndc) const;
+
+        uint32_t                m_width;
+        uint32_t                m_height;
+        uint32_t                m_tilesX;
+        uint32_t                m_tilesY;
+        float                   m_xScale;
+        float                   m_yScale;
+        float                   m_nearZ;
+        float                   m_farZ;
+
+        // Tile edge planes; tile x lies between m_edgesX[x] and m_edgesX[x + 1].
+        std::vector<EdgePlane>  m_edgesX;
+        std::vector<EdgePlane>  m_edgesY;
+
+        // Lists of every tile, packed; tile t's list starts at m_offsets[t].
+        std::vector<uint32_t>   m_offsets;
+        std::vector<uint32_t>   m_indices;
+        uint32_t                m_maxTileLightCount;
+
+        // Whether each column passes the current light's edge tests.
+        std::vector<uint8_t>    m_columns;
+
+        // Tile and light of each hit, before they are sorted into lists.
+        std::vector<uint64_t>   m_hits;
+    };
+}
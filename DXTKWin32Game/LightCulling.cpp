@@ -0,0 +1,152 @@
+//
+// LightCulling.cpp
+//
+
+#include "pch.h"
+#include "LightCulling.h"
+#include "ReadData.h"
+
+using namespace DirectX;
+using namespace DX;
+
+using Microsoft::WRL::ComPtr;
+
+LightCulling::LightCulling(ID3D11Device* device, bool multisampled) :
+    m_device(device),
+    m_lightCapacity(0),
+    m_tileCapacity(0),
+    m_constants{}
+{
+    auto computeShader = DX::ReadData(multisampled ? L"LightCullingMSCS.cso" : L"LightCullingCS.cso");
+    DX::ThrowIfFailed(device->CreateComputeShader(computeShader.data(), computeShader.size(), nullptr, m_computeShader.ReleaseAndGetAddressOf()));
+
+    // Starts with no lights, for an Apply before the first Cull.
+    CD3D11_BUFFER_DESC constantBufferDesc(sizeof(Constants), D3D11_BIND_CONSTANT_BUFFER);
+    D3D11_SUBRESOURCE_DATA initialConstants = { &m_constants, 0, 0 };
+    DX::ThrowIfFailed(device->CreateBuffer(&constantBufferDesc, &initialConstants, m_constantBuffer.ReleaseAndGetAddressOf()));
+
+    CreateLightBuffer(256);
+}
+
+void LightCulling::SetWindow(uint32_t width, uint32_t height)
+{
+    uint32_t tilesX = (width + TileSize - 1) / TileSize;
+    uint32_t tilesY = (height + TileSize - 1) / TileSize;
+
+    m_constants.screenSize[0] = width;
+    m_constants.screenSize[1] = height;
+
+    m_constants.tileCount[0] = tilesX;
+    m_constants.tileCount[1] = tilesY;
+
+    // Dynamic resolution changes the size every few frames, so keep the largest lists.
+    if (tilesX * tilesY <= m_tileCapacity)
+        return;
+
+    m_tileCapacity = tilesX * tilesY;
+
+    // Each tile's list is its count followed by up to MaxLightsPerTile indices.
+    uint32_t elementCount = m_tileCapacity * (MaxLightsPerTile + 1);
+
+    CD3D11_BUFFER_DESC tileBufferDesc(elementCount * sizeof(uint32_t), D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_UNORDERED_ACCESS,
+        D3D11_USAGE_DEFAULT, 0, D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(uint32_t));
+    DX::ThrowIfFailed(m_device->CreateBuffer(&tileBufferDesc, nullptr, m_tileBuffer.ReleaseAndGetAddressOf()));
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC tileViewDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, elementCount);
+    DX::ThrowIfFailed(m_device->CreateShaderResourceView(m_tileBuffer.Get(), &tileViewDesc, m_tileView.ReleaseAndGetAddressOf()));
+
+    CD3D11_UNORDERED_ACCESS_VIEW_DESC tileAccessDesc(D3D11_UAV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, elementCount);
+    DX::ThrowIfFailed(m_device->CreateUnorderedAccessView(m_tileBuffer.Get(), &tileAccessDesc, m_tileAccess.ReleaseAndGetAddressOf()));
+}
+
+void LightCulling::SetLights(const PointLight* lights, size_t count)
+{
+    m_lights.assign(lights, lights + count);
+
+    if (count > m_lightCapacity)
+    {
+        CreateLightBuffer(std::max(count, m_lightCapacity * 2));
+    }
+}
+
+void LightCulling::Cull(ID3D11DeviceContext* context, ID3D11ShaderResourceView* depth, FXMMATRIX view, CXMMATRIX projection)
+{
+    // Apply left the lists bound to the pixel shader for the last lit pass. They can't be
+    // read there while the compute shader writes them, so unbind them first.
+    ID3D11ShaderResourceView* nullViews[2] = {};
+    context->PSSetShaderResources(8, _countof(nullViews), nullViews);
+
+    // The lights are culled and shaded in view space.
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    DX::ThrowIfFailed(context->Map(m_lightBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped));
+
+    auto viewLights = static_cast<ViewLight*>(mapped.pData);
+    for (size_t i = 0; i < m_lights.size(); i++)
+    {
+        XMStoreFloat3(&viewLights[i].position, XMVector3TransformCoord(XMLoadFloat3(&m_lights[i].position), view));
+        viewLights[i].radius = m_lights[i].radius;
+        viewLights[i].color = m_lights[i].color;
+        viewLights[i].pad = 0.0f;
+    }
+
+    context->Unmap(m_lightBuffer.Get(), 0);
+
+    // _34 is +1 for left-handed projections and -1 for right-handed ones, which look down
+    // -z. The depth parameters invert the projection's depth mapping; see LinearDepth.
+    XMFLOAT4X4 p;
+    XMStoreFloat4x4(&p, projection);
+
+    m_constants.projectionScale = XMFLOAT2(p._11, p._22);
+    m_constants.forward = p._34;
+    m_constants.lightCount = static_cast<uint32_t>(m_lights.size());
+    m_constants.depthParameters = XMFLOAT3(p._34 * p._43, p._34, p._33);
+
+    context->UpdateSubresource(m_constantBuffer.Get(), 0, nullptr, &m_constants, 0, 0);
+
+    ID3D11ShaderResourceView* lightViews[] = { m_lightView.Get() };
+
+    context->CSSetShader(m_computeShader.Get(), nullptr, 0);
+    context->CSSetConstantBuffers(4, 1, m_constantBuffer.GetAddressOf());
+    context->CSSetShaderResources(0, 1, &depth);
+    context->CSSetShaderResources(8, _countof(lightViews), lightViews);
+    context->CSSetUnorderedAccessViews(0, 1, m_tileAccess.GetAddressOf(), nullptr);
+
+    context->Dispatch(m_constants.tileCount[0], m_constants.tileCount[1], 1);
+
+    // Unbind so the depth buffer can be bound for output and the lists read by Apply.
+    ID3D11ShaderResourceView* nullView = nullptr;
+    ID3D11UnorderedAccessView* nullAccess = nullptr;
+    context->CSSetShaderResources(0, 1, &nullView);
+    context->CSSetUnorderedAccessViews(0, 1, &nullAccess, nullptr);
+    context->CSSetShader(nullptr, nullptr, 0);
+}
+
+void LightCulling::Apply(ID3D11DeviceContext* context)
+{
+    // Cull isn't called without lights, so the lists it last built would still be read;
+    // a light count of zero tells the shader to ignore them.
+    if (m_lights.empty() && m_constants.lightCount != 0)
+    {
+        m_constants.lightCount = 0;
+        context->UpdateSubresource(m_constantBuffer.Get(), 0, nullptr, &m_constants, 0, 0);
+    }
+
+    ID3D11ShaderResourceView* views[] = { m_lightView.Get(), m_tileView.Get() };
+
+    context->PSSetConstantBuffers(4, 1, m_constantBuffer.GetAddressOf());
+    context->PSSetShaderResources(8, _countof(views), views);
+}
+
+void LightCulling::CreateLightBuffer(size_t capacity)
+{
+    UINT elementCount = static_cast<UINT>(capacity);
+
+    CD3D11_BUFFER_DESC lightBufferDesc(elementCount * sizeof(ViewLight), D3D11_BIND_SHADER_RESOURCE,
+        D3D11_USAGE_DYNAMIC, D3D11_CPU_ACCESS_WRITE, D3D11_RESOURCE_MISC_BUFFER_STRUCTURED, sizeof(ViewLight));
+    DX::ThrowIfFailed(m_device->CreateBuffer(&lightBufferDesc, nullptr, m_lightBuffer.ReleaseAndGetAddressOf()));
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC lightViewDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, elementCount);
+    DX::ThrowIfFailed(m_device->CreateShaderResourceView(m_lightBuffer.Get(), &lightViewDesc, m_lightView.ReleaseAndGetAddressOf()));
+
+    m_lightCapacity = capacity;
+}
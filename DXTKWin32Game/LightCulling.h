@@ -0,0 +1,93 @@
+//
+// LightCulling.h - Tiled light culling for forward+ shading
+//
+
+#pragma once
+
+#include "LightBinning.h"
+
+namespace DX
+{
+    // A point light in world space.
+    struct PointLight
+    {
+        DirectX::XMFLOAT3   position;
+        float               radius;
+        DirectX::XMFLOAT3   color;
+    };
+
+    // Builds the list of lights touching each screen tile on the GPU, bounding each tile by
+    // the depth buffer, so ForwardPlusPS.hlsl only shades a pixel with lights that can reach
+    // it rather than with a fixed number per object. Draw opaque geometry depth-only, call
+    // Cull, then Apply and draw it again with ForwardPlusVS.hlsl and ForwardPlusPS.hlsl.
+    // Needs feature level 11_0. LightBinning does the same binning on the CPU.
+    class LightCulling
+    {
+    public:
+        static const uint32_t TileSize = LightBinning::TileSize;
+
+        // Lights past this many in one tile are dropped from its list.
+        static const uint32_t MaxLightsPerTile = 255;
+
+        // A multisampled depth buffer needs its own shader, which bounds tiles by every sample.
+        LightCulling(_In_ ID3D11Device* device, bool multisampled);
+
+        LightCulling(LightCulling const&) = delete;
+        LightCulling& operator= (LightCulling const&) = delete;
+
+        // Sizes the tile lists for the part of the render target drawn to, from its top left.
+        // Cheap to call every frame; the lists only grow.
+        void SetWindow(uint32_t width, uint32_t height);
+
+        void SetLights(_In_reads_(count) const PointLight* lights, size_t count);
+        size_t GetLightCount() const        { return m_lights.size(); }
+
+        // Builds the tile lists. The depth buffer must not be bound for output meanwhile.
+        // Without lights there is nothing to cull, so this can be skipped.
+        void Cull(_In_ ID3D11DeviceContext* context, _In_ ID3D11ShaderResourceView* depth, DirectX::FXMMATRIX view, DirectX::CXMMATRIX projection);
+
+        // Binds the lights (t8), tile lists (t9) and constants (b4) for ForwardPlusPS.hlsl.
+        // Without lights, the shader sees every tile's list as empty whether or not Cull ran.
+        // They stay bound until the next Cull, which unbinds them before writing the lists.
+        void Apply(_In_ ID3D11DeviceContext* context);
+
+    private:
+        // Must match LightCulling.hlsli.
+        struct ViewLight
+        {
+            DirectX::XMFLOAT3   position;
+            float               radius;
+            DirectX::XMFLOAT3   color;
+            float               pad;
+        };
+
+        struct Constants
+        {
+            DirectX::XMFLOAT2   projectionScale;
+            float               forward;
+            uint32_t            lightCount;
+            DirectX::XMFLOAT3   depthParameters;
+            uint32_t            pad;
+            uint32_t            screenSize[2];
+            uint32_t            tileCount[2];
+        };
+
+        void CreateLightBuffer(size_t capacity);
+
+        Microsoft::WRL::ComPtr<ID3D11Device>                m_device;
+        Microsoft::WRL::ComPtr<ID3D11ComputeShader>         m_computeShader;
+        Microsoft::WRL::ComPtr<ID3D11Buffer>                m_constantBuffer;
+
+        Microsoft::WRL::ComPtr<ID3D11Buffer>                m_lightBuffer;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    m_lightView;
+        size_t                                              m_lightCapacity;
+
+        Microsoft::WRL::ComPtr<ID3D11Buffer>                m_tileBuffer;
+        Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>    m_tileView;
+        Microsoft::WRL::ComPtr<ID3D11UnorderedAccessView>   m_tileAccess;
+        uint32_t                                            m_tileCapacity;
+
+        std::vector<PointLight>                             m_lights;
+        Constants                                           m_constants;
+    };
+}
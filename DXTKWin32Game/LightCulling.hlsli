@@ -0,0 +1,69 @@
+//
+// LightCulling.hlsli - Layouts and tests shared by light culling and forward+ shading
+//
+
+// Must match DX::LightCulling.
+#define TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 255
+
+// Each tile's list is its light count followed by up to MAX_LIGHTS_PER_TILE light indices.
+#define TILE_LIST_STRIDE (MAX_LIGHTS_PER_TILE + 1)
+
+struct PointLight
+{
+    float3 position;    // View space.
+    float radius;
+    float3 color;
+    float pad;
+};
+
+cbuffer LightCullingConstants : register(b4)
+{
+    float2 ProjectionScale;     // The projection's _11 and _22.
+    float Forward;              // +1 if the view looks down +z, -1 if down -z.
+    uint LightCount;
+    float3 DepthParameters;     // Turns depth buffer values into view depth; see LinearDepth.
+    uint pad;
+    uint2 ScreenSize;
+    uint2 TileCount;
+};
+
+StructuredBuffer<PointLight> Lights : register(t8);
+
+// Distance along the view direction of a depth buffer value.
+float LinearDepth(float depth)
+{
+    return DepthParameters.x / (depth * DepthParameters.y - DepthParameters.z);
+}
+
+uint GetTileListStart(uint2 tile)
+{
+    return (tile.y * TileCount.x + tile.x) * TILE_LIST_STRIDE;
+}
+
+// Whether a light's sphere touches a tile's frustum, given the view depth range of its
+// geometry. Same test as DX::LightBinning::SphereInTile; center.z is view depth.
+bool SphereInTile(float3 center, float radius, uint2 tile, float minDepth, float maxDepth)
+{
+    float2 tileMin = float2(tile * TILE_SIZE);
+    float2 tileMax = float2((tile + 1) * TILE_SIZE);
+
+    // Edges as NDC x (left to right) and y (top to bottom).
+    float left = 2.0f * tileMin.x / ScreenSize.x - 1.0f;
+    float right = 2.0f * tileMax.x / ScreenSize.x - 1.0f;
+    float top = 1.0f - 2.0f * tileMin.y / ScreenSize.y;
+    float bottom = 1.0f - 2.0f * tileMax.y / ScreenSize.y;
+
+    // Planes through the eye, as normal components across the screen and along depth.
+    float2 leftPlane = float2(ProjectionScale.x, -left) * rsqrt(ProjectionScale.x * ProjectionScale.x + left * left);
+    float2 rightPlane = float2(ProjectionScale.x, -right) * rsqrt(ProjectionScale.x * ProjectionScale.x + right * right);
+    float2 topPlane = float2(-ProjectionScale.y, top) * rsqrt(ProjectionScale.y * ProjectionScale.y + top * top);
+    float2 bottomPlane = float2(-ProjectionScale.y, bottom) * rsqrt(ProjectionScale.y * ProjectionScale.y + bottom * bottom);
+
+    return dot(leftPlane, center.xz) >= -radius &&
+        -dot(rightPlane, center.xz) >= -radius &&
+        dot(topPlane, center.yz) >= -radius &&
+        -dot(bottomPlane, center.yz) >= -radius &&
+        center.z + radius >= minDepth &&
+        center.z - radius <= maxDepth;
+}
@@ -0,0 +1,101 @@
+//
+// LightCullingCS.hlsl - Builds a light list for each screen tile
+//
+// LightCullingMSCS.hlsl compiles this with MSAA defined, for multisampled depth buffers.
+
+#include "LightCulling.hlsli"
+
+#define THREADS_PER_TILE (TILE_SIZE * TILE_SIZE)
+
+#ifdef MSAA
+Texture2DMS<float> DepthBuffer : register(t0);
+#else
+Texture2D<float> DepthBuffer : register(t0);
+#endif
+RWStructuredBuffer<uint> TileLights : register(u0);
+
+groupshared uint s_minDepth;
+groupshared uint s_maxDepth;
+groupshared uint s_lightCount;
+groupshared uint s_lightIndices[MAX_LIGHTS_PER_TILE];
+
+// One group per tile, one thread per pixel.
+[numthreads(TILE_SIZE, TILE_SIZE, 1)]
+void main(uint3 groupId : SV_GroupID, uint3 dispatchThreadId : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
+{
+    if (groupIndex == 0)
+    {
+        s_minDepth = 0x7f7fffff;
+        s_maxDepth = 0;
+        s_lightCount = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Bound the tile's geometry. Depths are positive, so they order the same as their bits.
+    // Cleared pixels have nothing to light, so a tile without geometry gets no lights.
+    if (all(dispatchThreadId.xy < ScreenSize))
+    {
+#ifdef MSAA
+        uint width, height, sampleCount;
+        DepthBuffer.GetDimensions(width, height, sampleCount);
+
+        float minDepth = 1.0f;
+        float maxDepth = 0.0f;
+        for (uint s = 0; s < sampleCount; s++)
+        {
+            float sampleDepth = DepthBuffer.Load(int2(dispatchThreadId.xy), s);
+            if (sampleDepth < 1.0f)
+            {
+                minDepth = min(minDepth, sampleDepth);
+                maxDepth = max(maxDepth, sampleDepth);
+            }
+        }
+#else
+        float minDepth = DepthBuffer.Load(int3(dispatchThreadId.xy, 0));
+        float maxDepth = minDepth;
+#endif
+        if (minDepth <= maxDepth && minDepth < 1.0f)
+        {
+            InterlockedMin(s_minDepth, asuint(minDepth));
+            InterlockedMax(s_maxDepth, asuint(maxDepth));
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (s_minDepth <= s_maxDepth)
+    {
+        float minDepth = LinearDepth(asfloat(s_minDepth));
+        float maxDepth = LinearDepth(asfloat(s_maxDepth));
+
+        for (uint i = groupIndex; i < LightCount; i += THREADS_PER_TILE)
+        {
+            PointLight light = Lights[i];
+            float3 center = float3(light.position.xy, light.position.z * Forward);
+
+            if (SphereInTile(center, light.radius, groupId.xy, minDepth, maxDepth))
+            {
+                uint slot;
+                InterlockedAdd(s_lightCount, 1, slot);
+                if (slot < MAX_LIGHTS_PER_TILE)
+                {
+                    s_lightIndices[slot] = i;
+                }
+            }
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // Lights past the limit are dropped; which ones depends on thread timing.
+    uint count = min(s_lightCount, MAX_LIGHTS_PER_TILE);
+    uint start = GetTileListStart(groupId.xy);
+
+    if (groupIndex == 0)
+    {
+        TileLights[start] = count;
+    }
+
+    for (uint j = groupIndex; j < count; j += THREADS_PER_TILE)
+    {
+        TileLights[start + 1 + j] = s_lightIndices[j];
+    }
+}
@@ -0,0 +1,6 @@
+//
+// LightCullingMSCS.hlsl - Builds a light list for each screen tile of a multisampled depth buffer
+//
+
+#define MSAA
+#include "LightCullingCS.hlsl"
@@ -0,0 +1,64 @@
+//
+// LoopPolicy.cpp
+//
+
+#include "pch.h"
+#include "LoopPolicy.h"
+
+using namespace DX;
+
+LoopPolicy::LoopPolicy() :
+    m_activeMode(LoopMode::VSyncPaced),
+    m_activeInterval(TicksPerSecond / 60),
+    m_inactiveInterval(TicksPerSecond / 20),
+    m_active(true),
+    m_suspended(false),
+    m_nextDeadline(0)
+{
+}
+
+LoopMode LoopPolicy::GetMode() const
+{
+    if (m_suspended)
+        return LoopMode::Suspended;
+
+    return m_active ? m_activeMode : LoopMode::Deadline;
+}
+
+LoopAction LoopPolicy::Next(uint64_t now)
+{
+    LoopAction action = { false, WaitForever };
+
+    switch (GetMode())
+    {
+    case LoopMode::Busy:
+    case LoopMode::VSyncPaced:
+        action.tick = true;
+        m_nextDeadline = 0;
+        break;
+
+    case LoopMode::Deadline:
+        if (now >= m_nextDeadline)
+        {
+            action.tick = true;
+
+            // Keep a steady cadence, but don't try to catch up after a long stall.
+            uint64_t interval = GetInterval();
+            m_nextDeadline = (m_nextDeadline != 0 && now < m_nextDeadline + interval) ? m_nextDeadline + interval : now + interval;
+        }
+        else
+        {
+            // Round up so the wait never returns just before the deadline.
+            uint64_t ticksPerMillisecond = TicksPerSecond / 1000;
+            action.waitMilliseconds = static_cast<uint32_t>((m_nextDeadline - now + ticksPerMillisecond - 1) / ticksPerMillisecond);
+        }
+        break;
+
+    case LoopMode::Suspended:
+        // Waking up goes through OnResuming, which may restart ticking right away.
+        m_nextDeadline = 0;
+        break;
+    }
+
+    return action;
+}
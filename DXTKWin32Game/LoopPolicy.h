@@ -0,0 +1,69 @@
+//
+// LoopPolicy.h - Decides when the message loop ticks the game and when it sleeps
+//
+
+#pragma once
+
+#include <stdint.h>
+
+namespace DX
+{
+    enum class LoopMode
+    {
+        Busy,           // Tick whenever no messages are pending.
+        VSyncPaced,     // Tick whenever no messages are pending; Present blocks until vsync.
+        Deadline,       // Tick at a fixed interval, and wait for messages in between.
+        Suspended,      // Never tick; wait for messages only.
+    };
+
+    // What the message loop should do when no messages are pending.
+    struct LoopAction
+    {
+        bool        tick;
+        uint32_t    waitMilliseconds;   // When not ticking, how long to wait for messages.
+    };
+
+    // Chooses the loop mode from the game's state: the active mode while the window has focus,
+    // a slow deadline while in the background, and no ticks at all while suspended or
+    // minimized. Times are in ticks of TicksPerSecond from any steady clock, so the policy can
+    // be driven by QueryPerformanceCounter or by a fake clock.
+    class LoopPolicy
+    {
+    public:
+        static const uint64_t TicksPerSecond = 10000000;
+        static const uint32_t WaitForever = 0xFFFFFFFF;
+
+        LoopPolicy();
+
+        // The mode used while active. VSyncPaced only avoids spinning if Present syncs to
+        // vblank; Deadline paces by itself.
+        void SetActiveMode(LoopMode mode)               { m_activeMode = mode; }
+        void SetActiveInterval(uint64_t ticks)          { m_activeInterval = ticks; }
+
+        // Background windows keep animating, at a lower rate.
+        void SetInactiveInterval(uint64_t ticks)        { m_inactiveInterval = ticks; }
+
+        void OnActivated()                              { m_active = true; }
+        void OnDeactivated()                            { m_active = false; }
+        void OnSuspending()                             { m_suspended = true; }
+        void OnResuming()                               { m_suspended = false; }
+
+        LoopMode GetMode() const;
+
+        // Call when no messages are pending. When the action is to tick, the game is assumed
+        // to tick right away.
+        LoopAction Next(uint64_t now);
+
+    private:
+        uint64_t GetInterval() const                    { return m_active ? m_activeInterval : m_inactiveInterval; }
+
+        LoopMode    m_activeMode;
+        uint64_t    m_activeInterval;
+        uint64_t    m_inactiveInterval;
+        bool        m_active;
+        bool        m_suspended;
+
+        // When the next tick is due in Deadline mode. Zero until the first tick.
+        uint64_t    m_nextDeadline;
+    };
+}
@@ -25,16 +25,24 @@ extern "C"
 int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _In_ LPWSTR lpCmdLine, _In_ int nCmdShow)
 {
     UNREFERENCED_PARAMETER(hPrevInstance);
-    UNREFERENCED_PARAMETER(lpCmdLine);
 
     if (!XMVerifyCPUSupport())
         return 1;
 
+    // e.g. -swap flipdiscard -buffers 3 -tearing -benchmark -simthread
+    DX::LaunchOptions options;
+    std::wstring error;
+    if (!options.Parse(lpCmdLine, error))
+    {
+        MessageBoxW(nullptr, error.c_str(), L"DXTKWin32Game", MB_OK | MB_ICONERROR);
+        return 1;
+    }
+
     HRESULT hr = CoInitializeEx(nullptr, COINITBASE_MULTITHREADED);
     if (FAILED(hr))
         return 1;
 
-    g_game = std::make_unique<Game>();
+    g_game = std::make_unique<Game>(options);
 
     // Register class and create window
     {
@@ -86,7 +94,9 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         g_game->Initialize(hwnd, rc.right - rc.left, rc.bottom - rc.top);
     }
 
-    // Main message loop
+    // Main message loop. When there are no messages, the loop policy decides whether to tick
+    // or to sleep until the next message or frame deadline, so a minimized or background game
+    // doesn't spin a core.
     MSG msg = { 0 };
     while (WM_QUIT != msg.message)
     {
@@ -97,7 +107,15 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
         }
         else
         {
-            g_game->Tick();
+            DX::LoopAction action = g_game->GetLoopPolicy().Next(DX::StepTimer::GetCurrentTicks());
+            if (action.tick)
+            {
+                g_game->Tick();
+            }
+            else
+            {
+                MsgWaitForMultipleObjects(0, nullptr, FALSE, action.waitMilliseconds, QS_ALLINPUT);
+            }
         }
     }
 
@@ -179,6 +197,8 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_ACTIVATEAPP:
         if (game)
         {
+            game->OnInputMessage(message, wParam, lParam);
+
             if (wParam)
             {
                 game->OnActivated();
@@ -214,7 +234,29 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         PostQuitMessage(0);
         break;
 
+    case WM_INPUT:
+    case WM_MOUSEMOVE:
+    case WM_LBUTTONDOWN:
+    case WM_LBUTTONUP:
+    case WM_RBUTTONDOWN:
+    case WM_RBUTTONUP:
+    case WM_MBUTTONDOWN:
+    case WM_MBUTTONUP:
+    case WM_MOUSEWHEEL:
+    case WM_XBUTTONDOWN:
+    case WM_XBUTTONUP:
+    case WM_MOUSEHOVER:
+    case WM_KEYDOWN:
+    case WM_KEYUP:
+    case WM_SYSKEYUP:
+        if (game)
+            game->OnInputMessage(message, wParam, lParam);
+        break;
+
     case WM_SYSKEYDOWN:
+        if (game)
+            game->OnInputMessage(message, wParam, lParam);
+
         if (wParam == VK_RETURN && (lParam & 0x60000000) == 0x20000000)
         {
             // Implements the classic ALT+ENTER fullscreen toggle
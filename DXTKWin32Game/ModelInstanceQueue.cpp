@@ -0,0 +1,139 @@
+//
+// ModelInstanceQueue.cpp
+//
+
+#include "pch.h"
+#include "ModelInstanceQueue.h"
+
+#include <cmath>
+
+using namespace DX;
+
+ModelInstanceQueue::ModelInstanceQueue() :
+    m_planes{},
+    m_hasFrustum(false),
+    m_batchCount(0),
+    m_culledCount(0)
+{
+}
+
+void ModelInstanceQueue::SetFrustum(const float (&viewProjection)[4][4])
+{
+    // With row vectors, clip = v * M, so the planes combine M's columns: x >= -w, x <= w,
+    // y >= -w, y <= w, z >= 0 and z <= w.
+    for (int i = 0; i < 4; i++)
+    {
+        float x = viewProjection[i][0];
+        float y = viewProjection[i][1];
+        float z = viewProjection[i][2];
+        float w = viewProjection[i][3];
+
+        m_planes[0][i] = w + x;
+        m_planes[1][i] = w - x;
+        m_planes[2][i] = w + y;
+        m_planes[3][i] = w - y;
+        m_planes[4][i] = z;
+        m_planes[5][i] = w - z;
+    }
+
+    for (int p = 0; p < 6; p++)
+    {
+        float length = sqrtf(m_planes[p][0] * m_planes[p][0] + m_planes[p][1] * m_planes[p][1] + m_planes[p][2] * m_planes[p][2]);
+        if (length > 0.0f)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                m_planes[p][i] /= length;
+            }
+        }
+    }
+
+    m_hasFrustum = true;
+}
+
+bool ModelInstanceQueue::Add(uint32_t batch, const float (&world)[4][4], const InstanceSphere& bounds, const float (&color)[4])
+{
+    if (m_hasFrustum)
+    {
+        float center[3];
+        for (int i = 0; i < 3; i++)
+        {
+            center[i] = bounds.x * world[0][i] + bounds.y * world[1][i] + bounds.z * world[2][i] + world[3][i];
+        }
+
+        float scale = 0.0f;
+        for (int row = 0; row < 3; row++)
+        {
+            float rowScale = world[row][0] * world[row][0] + world[row][1] * world[row][1] + world[row][2] * world[row][2];
+            scale = (rowScale > scale) ? rowScale : scale;
+        }
+        float radius = bounds.radius * sqrtf(scale);
+
+        for (int p = 0; p < 6; p++)
+        {
+            const float* plane = m_planes[p];
+            if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+            {
+                m_culledCount++;
+                return false;
+            }
+        }
+    }
+
+    ModelInstance instance;
+    for (int column = 0; column < 3; column++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            instance.transform[column][row] = world[row][column];
+        }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        instance.color[i] = color[i];
+    }
+
+    m_instances.push_back(instance);
+    m_batches.push_back(batch);
+
+    if (batch >= m_batchCount)
+    {
+        m_batchCount = batch + 1;
+    }
+
+    return true;
+}
+
+void ModelInstanceQueue::Sort()
+{
+    // Batches are small indices, so a counting sort groups them in linear time and keeps
+    // each batch's instances in the order they were added.
+    m_batchStarts.assign(m_batchCount + 1, 0);
+    for (uint32_t batch : m_batches)
+    {
+        m_batchStarts[batch + 1]++;
+    }
+
+    for (uint32_t batch = 0; batch < m_batchCount; batch++)
+    {
+        m_batchStarts[batch + 1] += m_batchStarts[batch];
+    }
+
+    m_nextSlots.assign(m_batchStarts.begin(), m_batchStarts.end() - 1);
+
+    m_sorted.resize(m_instances.size());
+    for (size_t i = 0; i < m_instances.size(); i++)
+    {
+        m_sorted[m_nextSlots[m_batches[i]]++] = m_instances[i];
+    }
+}
+
+void ModelInstanceQueue::Clear()
+{
+    m_instances.clear();
+    m_batches.clear();
+    m_batchCount = 0;
+    m_culledCount = 0;
+    m_sorted.clear();
+    m_batchStarts.clear();
+}
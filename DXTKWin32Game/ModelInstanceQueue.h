@@ -0,0 +1,102 @@
+//
+// ModelInstanceQueue.h - Model instances gathered and grouped for instanced drawing
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+    // Per-instance vertex data, as InstancedModelVS.hlsl reads it: the first three columns
+    // of the world matrix, each stored as a row, and a color the mesh is tinted with.
+    struct ModelInstance
+    {
+        float transform[3][4];
+        float color[4];
+    };
+
+    // A bounding sphere in the mesh's own space.
+    struct InstanceSphere
+    {
+        float x;
+        float y;
+        float z;
+        float radius;
+    };
+
+    // Collects the visible instances of each batch, normally a mesh, so each can be drawn
+    // with one instanced draw per part rather than one draw and effect update per instance.
+    // Instances outside the view frustum are dropped as they are added. Sort then groups
+    // the rest by batch, keeping the order they were added within each batch, in one
+    // counting pass. Matrices use row vectors, as DirectXMath does. Not thread safe; add
+    // instances from the update thread.
+    class ModelInstanceQueue
+    {
+    public:
+        ModelInstanceQueue();
+
+        // The frustum instances are culled against, from the camera's view times projection
+        // matrix and the D3D depth range of 0 to 1. Set it before adding a frame's instances.
+        // Until then nothing is culled.
+        void SetFrustum(const float (&viewProjection)[4][4]);
+
+        // Adds an instance of a batch unless its bounds, moved by world, are outside the
+        // frustum. Returns whether it was added. The sphere's radius grows with the largest
+        // scale in world.
+        bool Add(uint32_t batch, const float (&world)[4][4], const InstanceSphere& bounds, const float (&color)[4]);
+
+        // Groups the instances added since Clear by batch.
+        void Sort();
+
+        // After Sort, hands each batch with instances to draw(batch, firstInstance, count),
+        // in batch order. Returns the number of calls.
+        template<typename TDraw>
+        uint32_t ForEachBatch(const TDraw& draw) const
+        {
+            uint32_t batchCount = 0;
+            for (size_t batch = 0; batch + 1 < m_batchStarts.size(); batch++)
+            {
+                uint32_t first = m_batchStarts[batch];
+                uint32_t count = m_batchStarts[batch + 1] - first;
+                if (count > 0)
+                {
+                    draw(static_cast<uint32_t>(batch), first, count);
+                    batchCount++;
+                }
+            }
+            return batchCount;
+        }
+
+        // The sorted instances, for uploading in one piece.
+        const ModelInstance* GetInstances() const   { return m_sorted.data(); }
+        size_t GetInstanceCount() const             { return m_sorted.size(); }
+
+        // Instances dropped by culling since Clear.
+        size_t GetCulledCount() const               { return m_culledCount; }
+
+        // Call before adding a new frame's instances. Kept until then, so frames without an
+        // update draw the last one again.
+        void Clear();
+
+    private:
+        // Planes as a, b, c, d with unit normals pointing into the frustum.
+        float                       m_planes[6][4];
+        bool                        m_hasFrustum;
+
+        // Instances in the order added, and the batch of each.
+        std::vector<ModelInstance>  m_instances;
+        std::vector<uint32_t>       m_batches;
+        uint32_t                    m_batchCount;
+        size_t                      m_culledCount;
+
+        // Instances grouped by batch; batch b's start at m_batchStarts[b].
+        std::vector<ModelInstance>  m_sorted;
+        std::vector<uint32_t>       m_batchStarts;
+
+        // Where Sort puts each batch's next instance.
+        std::vector<uint32_t>       m_nextSlots;
+    };
+}
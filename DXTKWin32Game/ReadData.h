@@ -0,0 +1,52 @@
+//
+// ReadData.h - Helper for loading binary data files such as compiled shaders
+//
+
+#pragma once
+
+#include <fstream>
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+    // Reads a whole file. Names are relative to the executable's directory, where compiled
+    // shaders are written, so loading doesn't depend on the working directory.
+    inline std::vector<uint8_t> ReadData(_In_z_ const wchar_t* name)
+    {
+        wchar_t path[MAX_PATH] = {};
+        DWORD length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+        if (length == 0 || length >= MAX_PATH)
+        {
+            throw std::exception("GetModuleFileNameW");
+        }
+
+        wchar_t* directoryEnd = wcsrchr(path, L'\\');
+        if (directoryEnd)
+        {
+            *(directoryEnd + 1) = L'\0';
+        }
+
+        if (wcscat_s(path, name) != 0)
+        {
+            throw std::exception("ReadData");
+        }
+
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            throw std::exception("ReadData");
+        }
+
+        std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+
+        file.seekg(0, std::ios::beg);
+        file.read(reinterpret_cast<char*>(data.data()), data.size());
+        if (!file)
+        {
+            throw std::exception("ReadData");
+        }
+
+        return data;
+    }
+}
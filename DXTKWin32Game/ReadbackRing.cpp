@@ -0,0 +1,70 @@
+//
+// ReadbackRing.cpp
+//
+
+#include "pch.h"
+#include "ReadbackRing.h"
+
+using namespace DX;
+
+ReadbackRing::ReadbackRing(uint32_t latency) :
+    m_latency(latency > 0 ? latency : 1)
+{
+    Slot slot = { false, 0 };
+    m_slots.assign(m_latency, slot);
+}
+
+int ReadbackRing::BeginCopy(uint64_t frame)
+{
+    for (uint32_t i = 0; i < GetSlotCount(); i++)
+    {
+        if (!m_slots[i].pending)
+        {
+            m_slots[i].pending = true;
+            m_slots[i].frame = frame;
+            return static_cast<int>(i);
+        }
+    }
+
+    return NoSlot;
+}
+
+int ReadbackRing::GetReadySlot(uint64_t frame) const
+{
+    int ready = NoSlot;
+    for (uint32_t i = 0; i < GetSlotCount(); i++)
+    {
+        const Slot& slot = m_slots[i];
+        if (slot.pending && slot.frame + m_latency <= frame && (ready == NoSlot || slot.frame < m_slots[ready].frame))
+        {
+            ready = static_cast<int>(i);
+        }
+    }
+
+    return ready;
+}
+
+void ReadbackRing::EndRead(int slot)
+{
+    m_slots[slot].pending = false;
+}
+
+uint32_t ReadbackRing::GetPendingCount() const
+{
+    uint32_t count = 0;
+    for (const Slot& slot : m_slots)
+    {
+        if (slot.pending)
+            count++;
+    }
+
+    return count;
+}
+
+void ReadbackRing::Reset()
+{
+    for (Slot& slot : m_slots)
+    {
+        slot.pending = false;
+    }
+}
@@ -0,0 +1,53 @@
+//
+// ReadbackRing.h - Tracks a ring of readback slots that are read some frames after copying
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace DX
+{
+    // Bookkeeping for GPU to CPU readback without stalls: each frame is copied into a free
+    // slot, and the slot is only read once the GPU has had latency frames to finish the copy.
+    // Holds no resources itself, so it works for staging textures and buffers alike.
+    class ReadbackRing
+    {
+    public:
+        static const int NoSlot = -1;
+
+        // With one copy per frame, latency slots are enough to never drop one.
+        explicit ReadbackRing(uint32_t latency);
+
+        uint32_t GetSlotCount() const               { return static_cast<uint32_t>(m_slots.size()); }
+        uint32_t GetLatency() const                 { return m_latency; }
+
+        // Claims a slot to copy the given frame into, or returns NoSlot if every slot is
+        // still waiting to be read, in which case the frame should be dropped.
+        int BeginCopy(uint64_t frame);
+
+        // The slot holding the oldest copy that is at least latency frames old, or NoSlot.
+        int GetReadySlot(uint64_t frame) const;
+
+        uint64_t GetSlotFrame(int slot) const       { return m_slots[slot].frame; }
+
+        // Frees a slot once it has been read.
+        void EndRead(int slot);
+
+        uint32_t GetPendingCount() const;
+
+        // Forgets every copy, e.g. when the resources behind the slots are released.
+        void Reset();
+
+    private:
+        struct Slot
+        {
+            bool        pending;
+            uint64_t    frame;
+        };
+
+        std::vector<Slot>   m_slots;
+        uint32_t            m_latency;
+    };
+}
@@ -46,6 +46,10 @@ namespace DX
         uint64_t GetTotalTicks() const						{ return m_totalTicks; }
         double GetTotalSeconds() const						{ return TicksToSeconds(m_totalTicks); }
 
+        // Get time accumulated towards the next fixed step. While Tick is running updates, the
+        // current step ends this long before the time Tick was called.
+        uint64_t GetLeftOverTicks() const					{ return m_leftOverTicks; }
+
         // Get total number of updates since start of the program.
         uint32_t GetFrameCount() const						{ return m_frameCount; }
 
@@ -65,6 +69,26 @@ namespace DX
         static double TicksToSeconds(uint64_t ticks)		{ return static_cast<double>(ticks) / TicksPerSecond; }
         static uint64_t SecondsToTicks(double seconds)		{ return static_cast<uint64_t>(seconds * TicksPerSecond); }
 
+        // Current QPC time in the canonical tick format, for timestamping events against steps.
+        static uint64_t GetCurrentTicks()
+        {
+            // Initialized once even when first called from two threads at the same time.
+            static const LARGE_INTEGER s_frequency = []()
+            {
+                LARGE_INTEGER frequency;
+                QueryPerformanceFrequency(&frequency);
+                return frequency;
+            }();
+
+            LARGE_INTEGER counter;
+            QueryPerformanceCounter(&counter);
+
+            // Split the conversion so the multiply can't overflow.
+            uint64_t seconds = counter.QuadPart / s_frequency.QuadPart;
+            uint64_t remainder = counter.QuadPart % s_frequency.QuadPart;
+            return seconds * TicksPerSecond + remainder * TicksPerSecond / s_frequency.QuadPart;
+        }
+
         // After an intentional timing discontinuity (for instance a blocking IO operation)
         // call this to avoid having the fixed timestep logic attempt a set of catch-up 
         // Update calls.
@@ -0,0 +1,137 @@
+//
+// SwapChainConfig.cpp
+//
+
+#include "pch.h"
+#include "SwapChainConfig.h"
+
+using namespace DX;
+
+SwapChainConfig::SwapChainConfig() :
+    swapEffect(SwapEffect::Blt),
+    format(BackBufferFormat::Bgra8),
+    backBufferCount(2),
+    allowTearing(false),
+    benchmark(false)
+{
+}
+
+bool SwapChainConfig::Parse(std::vector<std::wstring>& tokens, std::wstring& error)
+{
+    SwapChainConfig config = *this;
+    std::vector<std::wstring> others;
+
+    for (size_t i = 0; i < tokens.size(); i++)
+    {
+        const std::wstring& option = tokens[i];
+
+        if (option == L"-tearing")
+        {
+            config.allowTearing = true;
+            continue;
+        }
+
+        if (option == L"-benchmark")
+        {
+            config.benchmark = true;
+            continue;
+        }
+
+        if (option != L"-swap" && option != L"-buffers" && option != L"-format")
+        {
+            others.push_back(option);
+            continue;
+        }
+
+        if (i + 1 >= tokens.size())
+        {
+            error = L"Missing value for " + option;
+            return false;
+        }
+
+        const std::wstring& value = tokens[++i];
+
+        if (option == L"-swap")
+        {
+            if (value == L"blt")
+                config.swapEffect = SwapEffect::Blt;
+            else if (value == L"flipsequential")
+                config.swapEffect = SwapEffect::FlipSequential;
+            else if (value == L"flipdiscard")
+                config.swapEffect = SwapEffect::FlipDiscard;
+            else
+            {
+                error = L"-swap must be blt, flipsequential or flipdiscard, not " + value;
+                return false;
+            }
+        }
+        else if (option == L"-buffers")
+        {
+            wchar_t* end = nullptr;
+            unsigned long count = wcstoul(value.c_str(), &end, 10);
+            if (*end != 0 || count < MinBackBufferCount || count > MaxBackBufferCount)
+            {
+                error = L"-buffers must be 2, 3 or 4, not " + value;
+                return false;
+            }
+
+            config.backBufferCount = static_cast<uint32_t>(count);
+        }
+        else
+        {
+            if (value == L"bgra8")
+                config.format = BackBufferFormat::Bgra8;
+            else if (value == L"hdr10")
+                config.format = BackBufferFormat::Hdr10;
+            else if (value == L"scrgb")
+                config.format = BackBufferFormat::ScRgb;
+            else
+            {
+                error = L"-format must be bgra8, hdr10 or scrgb, not " + value;
+                return false;
+            }
+        }
+    }
+
+    *this = config;
+    tokens.swap(others);
+    return true;
+}
+
+SwapChainConfig SwapChainConfig::Resolve(const SwapChainSupport& support) const
+{
+    SwapChainConfig config = *this;
+
+    if (config.swapEffect == SwapEffect::FlipDiscard && !support.flipDiscard)
+    {
+        config.swapEffect = SwapEffect::FlipSequential;
+    }
+
+    if (config.swapEffect == SwapEffect::FlipSequential && !support.flipSequential)
+    {
+        config.swapEffect = SwapEffect::Blt;
+    }
+
+    if (!config.IsFlipModel())
+    {
+        config.format = BackBufferFormat::Bgra8;
+    }
+
+    // Presents only tear with sync interval 0, so the flag is only worth setting when
+    // benchmarking.
+    if (!config.IsFlipModel() || !support.tearing || !config.benchmark)
+    {
+        config.allowTearing = false;
+    }
+
+    if (config.backBufferCount < MinBackBufferCount)
+    {
+        config.backBufferCount = MinBackBufferCount;
+    }
+    else if (config.backBufferCount > MaxBackBufferCount)
+    {
+        config.backBufferCount = MaxBackBufferCount;
+    }
+
+    return config;
+}
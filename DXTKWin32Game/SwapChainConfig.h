@@ -0,0 +1,72 @@
+//
+// SwapChainConfig.h - Swap chain and render target settings chosen at startup
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+    enum class SwapEffect
+    {
+        Blt,                // DXGI_SWAP_EFFECT_DISCARD; works everywhere.
+        FlipSequential,     // Windows 8 and later.
+        FlipDiscard,        // Windows 10 and later.
+    };
+
+    enum class BackBufferFormat
+    {
+        Bgra8,              // DXGI_FORMAT_B8G8R8A8_UNORM, SDR.
+        Hdr10,              // DXGI_FORMAT_R10G10B10A2_UNORM, ST.2084 in BT.2020.
+        ScRgb,              // DXGI_FORMAT_R16G16B16A16_FLOAT, linear BT.709.
+    };
+
+    // What the system can do, queried from DXGI when the swap chain is created.
+    struct SwapChainSupport
+    {
+        bool        flipSequential;
+        bool        flipDiscard;
+        bool        tearing;
+    };
+
+    // The swap chain the game asks for. The defaults match what the template always created:
+    // a blt-model chain of two BGRA buffers, presented on vsync.
+    //
+    // Benchmark mode presents with sync interval 0 so frame throughput isn't capped by the
+    // refresh rate. Tearing lets those presents reach the screen immediately; without it, a
+    // flip-model chain still runs uncapped but only shows the newest frame at each vblank.
+    struct SwapChainConfig
+    {
+        static const uint32_t MinBackBufferCount = 2;
+        static const uint32_t MaxBackBufferCount = 4;
+
+        SwapChainConfig();
+
+        // Takes the swap chain's options out of lower-cased command line tokens, leaving any
+        // others for LaunchOptions:
+        //   -swap blt|flipsequential|flipdiscard
+        //   -buffers 2..4
+        //   -format bgra8|hdr10|scrgb
+        //   -tearing
+        //   -benchmark
+        // Returns false and describes the problem in error for a malformed option, leaving
+        // the config and tokens unchanged.
+        bool Parse(std::vector<std::wstring>& tokens, std::wstring& error);
+
+        // Falls back to what the system supports: an older swap effect, SDR on the blt model
+        // (HDR output needs flip), and no tearing unless flip-model benchmarking can use it.
+        SwapChainConfig Resolve(const SwapChainSupport& support) const;
+
+        bool IsFlipModel() const            { return swapEffect != SwapEffect::Blt; }
+        uint32_t GetSyncInterval() const    { return benchmark ? 0 : 1; }
+
+        SwapEffect          swapEffect;
+        BackBufferFormat    format;
+        uint32_t            backBufferCount;
+        bool                allowTearing;
+        bool                benchmark;
+    };
+}
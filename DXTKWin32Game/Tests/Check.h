@@ -0,0 +1,38 @@
+//
+// Check.h - Minimal checks for the portable tests
+//
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Reports a failed condition and fails the test, without stopping it, so one run shows every
+// failure. Tests return CheckResult() from main.
+#define CHECK(condition) \
+    ((condition) ? (void)0 : DX::CheckFailed(#condition, __FILE__, __LINE__))
+
+namespace DX
+{
+    inline int& CheckFailures()
+    {
+        static int failures = 0;
+        return failures;
+    }
+
+    inline void CheckFailed(const char* condition, const char* file, int line)
+    {
+        std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", file, line, condition);
+        CheckFailures()++;
+    }
+
+    inline int CheckResult()
+    {
+        if (CheckFailures() != 0)
+        {
+            std::fprintf(stderr, "%d check(s) failed\n", CheckFailures());
+            return EXIT_FAILURE;
+        }
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,303 @@
+//
+// DynamicResolutionTest.cpp
+//
+
+#include "DynamicResolution.h"
+#include "Check.h"
+
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    const double TargetMilliseconds = 1000.0 / 60.0;
+
+    // The frame cost of a scene at full scale, in milliseconds, frame by frame. Part of it
+    // is fixed and the rest scales with the pixel count.
+    struct Load
+    {
+        double  fixed;
+        double  perPixel;
+    };
+
+    // What the controller did over a replayed trace.
+    struct Replay
+    {
+        std::vector<float>  scales;         // Handed out after each frame.
+        std::vector<double> milliseconds;   // Each frame's time.
+    };
+
+    // Small deterministic noise, the same with every standard library.
+    class Noise
+    {
+    public:
+        Noise() : m_state(12345) {}
+
+        // Uniform in -amplitude to amplitude.
+        double Next(double amplitude)
+        {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return amplitude * (static_cast<double>(m_state >> 11) / static_cast<double>(1ull << 53) * 2.0 - 1.0);
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    // Feeds the controller the frame times a trace produces at the scales it picks. The GPU
+    // runs two frames behind, so a new scale shows up in the times two frames later. Under
+    // vsync a frame takes a whole number of refresh periods.
+    Replay Run(const std::vector<Load>& trace, bool vsync, double noise = 0.2)
+    {
+        DynamicResolution controller;
+        Noise random;
+        std::deque<float> queued(2, controller.GetScale());
+
+        Replay replay;
+        for (const Load& load : trace)
+        {
+            float scale = queued.front();
+            queued.pop_front();
+
+            double milliseconds = load.fixed + load.perPixel * scale * scale + random.Next(noise);
+            if (vsync)
+            {
+                milliseconds = std::max(1.0, std::ceil(milliseconds / TargetMilliseconds - 0.02)) * TargetMilliseconds;
+            }
+
+            float next = controller.Update(static_cast<uint64_t>(milliseconds * DynamicResolution::TicksPerSecond / 1000.0));
+            queued.push_back(next);
+
+            replay.scales.push_back(next);
+            replay.milliseconds.push_back(milliseconds);
+        }
+        return replay;
+    }
+
+    std::vector<Load> Constant(size_t frames, double fixed, double perPixel)
+    {
+        return std::vector<Load>(frames, Load{ fixed, perPixel });
+    }
+
+    std::vector<Load> Concatenate(std::vector<Load> first, const std::vector<Load>& second)
+    {
+        first.insert(first.end(), second.begin(), second.end());
+        return first;
+    }
+
+    // Summary of a stretch of frames.
+    struct Window
+    {
+        float   meanScale;
+        float   minScale;
+        float   maxScale;
+        double  meanMilliseconds;
+        double  missRate;       // Frames over the target by more than the deadband.
+        int     changes;        // Times the scale handed out moved.
+        int     reversals;      // Times it moved the other way from its last move.
+        size_t  first;
+        size_t  last;
+    };
+
+    Window Measure(const char* name, const Replay& replay, size_t first, size_t last)
+    {
+        Window window = { 0.0f, 1.0f, 0.0f, 0.0, 0.0, 0, 0, first, last };
+        int misses = 0;
+        int lastDirection = 0;
+
+        for (size_t i = first; i < last; i++)
+        {
+            float scale = replay.scales[i];
+            window.meanScale += scale;
+            window.minScale = std::min(window.minScale, scale);
+            window.maxScale = std::max(window.maxScale, scale);
+            window.meanMilliseconds += replay.milliseconds[i];
+
+            if (replay.milliseconds[i] > TargetMilliseconds * (1.0 + DynamicResolution::Deadband))
+            {
+                misses++;
+            }
+
+            if (i > first && scale != replay.scales[i - 1])
+            {
+                int direction = (scale > replay.scales[i - 1]) ? 1 : -1;
+                window.changes++;
+                if (lastDirection != 0 && direction != lastDirection)
+                {
+                    window.reversals++;
+                }
+                lastDirection = direction;
+            }
+        }
+
+        size_t count = last - first;
+        window.meanScale /= count;
+        window.meanMilliseconds /= count;
+        window.missRate = static_cast<double>(misses) / count;
+
+        std::printf("%-28s frames %5zu-%5zu: scale %.3f (%.2f-%.2f), %.2f ms, %4.1f%% missed, %d changes, %d reversals\n",
+            name, first, last, window.meanScale, window.minScale, window.maxScale, window.meanMilliseconds, window.missRate * 100.0, window.changes, window.reversals);
+
+        return window;
+    }
+
+    // Settled means holding one scale, apart from probes: under vsync, or right at the edge
+    // of the deadband, the controller tries a step up every so often, and backs off each
+    // time one misses. So the scale may move up to two steps above the lowest it holds, and
+    // turn around at most twice per probe, with probes at least four ProbeFrames apart on
+    // average.
+    const float SettledRange = 2.0f * DynamicResolution::ScaleStep + 0.005f;
+
+    bool IsSettled(const Window& window)
+    {
+        size_t frames = static_cast<size_t>(window.last - window.first);
+        return window.maxScale - window.minScale <= SettledRange
+            && window.reversals <= 2 * static_cast<int>(frames / (4 * DynamicResolution::ProbeFrames)) + 2;
+    }
+
+    // The first frame from which the scale stays within a step of the lowest it reaches by
+    // the end, give or take probes.
+    size_t FindSettled(const Replay& replay, size_t first, size_t last)
+    {
+        float floor = 1.0f;
+        for (size_t i = (first + last) / 2; i < last; i++)
+        {
+            floor = std::min(floor, replay.scales[i]);
+        }
+
+        size_t settled = last;
+        for (size_t i = last; i-- > first;)
+        {
+            float scale = replay.scales[i];
+            if (scale < floor - DynamicResolution::ScaleStep - 0.001f || scale > floor + DynamicResolution::ScaleStep + 0.005f)
+                break;
+            settled = i;
+        }
+        return settled;
+    }
+
+    // A scene that gets heavier and then light again. Uncapped, the controller should find
+    // the scale that fits the budget, sqrt((16.67 - 2) / 23) = 0.80, or just above within
+    // the deadband, settle there within a second or two and hold it; then go back to full
+    // scale once the load drops.
+    void TestStepLoad()
+    {
+        std::vector<Load> trace = Concatenate(Concatenate(Constant(600, 2.0, 8.0), Constant(3000, 2.0, 23.0)), Constant(1200, 2.0, 8.0));
+        Replay replay = Run(trace, false);
+
+        Window light = Measure("step: light", replay, 0, 600);
+        CHECK(light.minScale == 1.0f);
+        CHECK(light.changes == 0);
+
+        size_t settled = FindSettled(replay, 600, 3600);
+        std::printf("  settled %zu frames after the load rose\n", settled - 600);
+        CHECK(settled - 600 < 120);
+
+        Window heavy = Measure("step: heavy, settled", replay, settled, 3600);
+        CHECK(IsSettled(heavy));
+        CHECK(heavy.meanScale > 0.78f && heavy.meanScale < 0.84f);
+        CHECK(std::abs(heavy.meanMilliseconds - TargetMilliseconds) < TargetMilliseconds * DynamicResolution::Deadband);
+
+        Window after = Measure("step: light again", replay, 3600, 4800);
+        CHECK(after.reversals == 0);
+        CHECK(FindSettled(replay, 3600, 4800) - 3600 < 300);
+        CHECK(replay.scales.back() == 1.0f);
+    }
+
+    // The same under vsync, where headroom can't be measured and the controller has to
+    // probe: it should hold a scale that fits, sqrt((16.67 - 2) / 18) = 0.90, missing frames
+    // only rarely, and climb back to full scale after the load drops.
+    void TestStepLoadVsync()
+    {
+        std::vector<Load> trace = Concatenate(Constant(6000, 2.0, 18.0), Constant(6000, 2.0, 9.0));
+        Replay replay = Run(trace, true);
+
+        size_t settled = FindSettled(replay, 0, 6000);
+        std::printf("  settled %zu frames after the load rose\n", settled);
+        CHECK(settled < 300);
+
+        Window heavy = Measure("vsync step: heavy, settled", replay, settled, 6000);
+        CHECK(IsSettled(heavy));
+        CHECK(heavy.meanScale > 0.86f && heavy.meanScale <= 0.91f);
+        CHECK(heavy.missRate < 0.01);
+
+        Window light = Measure("vsync step: light", replay, 6000, 12000);
+        CHECK(light.reversals == 0);
+        CHECK(light.missRate == 0.0);
+        CHECK(replay.scales.back() == 1.0f);
+    }
+
+    // A scene with a hitch of three frame times every two seconds, e.g. streaming. A lower
+    // resolution wouldn't avoid the hitches, so they must not move the scale: not at full
+    // scale, and not once a heavier scene has settled lower.
+    void TestPeriodicSpike()
+    {
+        std::vector<Load> trace = Constant(6000, 2.0, 10.0);
+        for (size_t i = 60; i < trace.size(); i += 120)
+        {
+            trace[i].fixed += 3.0 * TargetMilliseconds;
+        }
+        Replay replay = Run(trace, false);
+
+        Window window = Measure("periodic spike", replay, 0, 6000);
+        CHECK(window.changes == 0);
+        CHECK(window.minScale == 1.0f);
+
+        std::vector<Load> heavyTrace = Constant(6000, 2.0, 23.0);
+        for (size_t i = 1200; i < heavyTrace.size(); i += 120)
+        {
+            heavyTrace[i].fixed += 3.0 * TargetMilliseconds;
+        }
+        Replay heavy = Run(heavyTrace, false);
+
+        Window before = Measure("periodic spike: heavy before", heavy, 600, 1200);
+        Window during = Measure("periodic spike: heavy during", heavy, 1200, 6000);
+        CHECK(IsSettled(during));
+        CHECK(during.minScale >= before.minScale - DynamicResolution::ScaleStep);
+    }
+
+    // Frame times that wander around the target but stay inside the deadband must not move
+    // the scale at all at full scale. Scaled down, frame times landing inside the deadband
+    // should only bring the occasional probe.
+    void TestIdleInDeadband()
+    {
+        const double band = TargetMilliseconds * DynamicResolution::Deadband * 0.8;
+
+        std::vector<Load> trace(6000);
+        for (size_t i = 0; i < trace.size(); i++)
+        {
+            // A slow swing across most of the band, plus noise.
+            trace[i] = Load{ TargetMilliseconds + band * 0.6 * std::sin(i * 0.05), 0.0 };
+        }
+        Replay replay = Run(trace, false, band * 0.4);
+
+        Window window = Measure("idle in deadband", replay, 0, 6000);
+        CHECK(window.changes == 0);
+        CHECK(window.minScale == 1.0f);
+
+        // Settle on a heavy scene, then drop the pixel cost so the frame time at the settled
+        // scale is the target.
+        std::vector<Load> settle = Constant(1200, 2.0, 23.0);
+        float scale = Run(settle, false).scales.back();
+        double perPixel = (TargetMilliseconds - 2.0) / (scale * scale);
+
+        std::vector<Load> holdTrace = Concatenate(settle, Constant(3000, 2.0, perPixel));
+        Replay hold = Run(holdTrace, false, band * 0.5);
+        Window held = Measure("idle in deadband: scaled", hold, 1200, 4200);
+        CHECK(IsSettled(held));
+        CHECK(held.minScale >= scale - DynamicResolution::ScaleStep - 0.001f);
+    }
+}
+
+int main()
+{
+    TestStepLoad();
+    TestStepLoadVsync();
+    TestPeriodicSpike();
+    TestIdleInDeadband();
+    return CheckResult();
+}
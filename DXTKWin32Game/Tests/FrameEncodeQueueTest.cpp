@@ -0,0 +1,268 @@
+//
+// FrameEncodeQueueTest.cpp
+//
+
+#include "FrameEncodeQueue.h"
+#include "ReadbackRing.h"
+#include "Check.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    const uint32_t Width = 64;
+    const uint32_t Height = 36;
+
+    // A synthetic frame whose every byte is the low byte of its frame number, so a frame
+    // that was mixed up with another, or moved from twice, shows up in its pixels.
+    CapturedFrame MakeFrame(uint64_t frame)
+    {
+        CapturedFrame captured;
+        captured.frame = frame;
+        captured.width = Width;
+        captured.height = Height;
+        captured.pixels.assign(Width * Height * 4, static_cast<uint8_t>(frame));
+        captured.format = CaptureFormat::Raw;
+        captured.path = L"Captures/frame.raw";
+        return captured;
+    }
+
+    bool IsIntact(const CapturedFrame& captured)
+    {
+        if (captured.pixels.size() != Width * Height * 4)
+            return false;
+
+        for (uint8_t pixel : captured.pixels)
+        {
+            if (pixel != static_cast<uint8_t>(captured.frame))
+                return false;
+        }
+        return true;
+    }
+
+    // Holds the encoder until released, so tests can fill the queue behind it.
+    class Gate
+    {
+    public:
+        Gate() : m_open(false) {}
+
+        void Wait()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_changed.wait(lock, [this]() { return m_open; });
+        }
+
+        void Open()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_open = true;
+            }
+            m_changed.notify_all();
+        }
+
+    private:
+        std::mutex              m_mutex;
+        std::condition_variable m_changed;
+        bool                    m_open;
+    };
+
+    // Frames are encoded in the order pushed, intact, and a failing encoder only loses its
+    // own frame.
+    void TestOrderAndFailures()
+    {
+        std::vector<uint64_t> encoded;
+        bool intact = true;
+
+        FrameEncodeQueue queue([&](const CapturedFrame& captured)
+        {
+            intact = intact && IsIntact(captured);
+            if (captured.frame % 5 == 3)
+                throw std::runtime_error("write failed");
+            encoded.push_back(captured.frame);
+        }, 4);
+
+        for (uint64_t frame = 0; frame < 20; frame++)
+        {
+            // Waiting each time keeps the queue from filling.
+            CHECK(queue.Push(MakeFrame(frame)));
+            queue.WaitIdle();
+        }
+
+        CHECK(intact);
+        CHECK(queue.GetEncodedCount() == 16);
+        CHECK(queue.GetFailedCount() == 4);
+        CHECK(queue.GetDroppedCount() == 0);
+        CHECK(encoded.size() == 16);
+        for (size_t i = 1; i < encoded.size(); i++)
+        {
+            CHECK(encoded[i] > encoded[i - 1]);
+        }
+    }
+
+    // With the encoder stuck, Push takes maxPending frames and then drops, without waiting.
+    void TestDropWhenFull()
+    {
+        Gate gate;
+        std::atomic<bool> started(false);
+        std::atomic<uint64_t> encoded(0);
+
+        FrameEncodeQueue queue([&](const CapturedFrame&)
+        {
+            started = true;
+            gate.Wait();
+            encoded++;
+        }, 3);
+
+        // The first frame goes straight to the encoder and blocks it.
+        CHECK(queue.Push(MakeFrame(0)));
+        while (!started)
+        {
+            std::this_thread::yield();
+        }
+
+        CHECK(queue.Push(MakeFrame(1)));
+        CHECK(queue.Push(MakeFrame(2)));
+        CHECK(queue.Push(MakeFrame(3)));
+
+        auto start = std::chrono::steady_clock::now();
+        CHECK(!queue.Push(MakeFrame(4)));
+        CHECK(!queue.Push(MakeFrame(5)));
+        CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(100));
+        CHECK(queue.GetDroppedCount() == 2);
+
+        gate.Open();
+        queue.WaitIdle();
+        CHECK(encoded == 4);
+        CHECK(queue.GetEncodedCount() == 4);
+
+        // Room again once the encoder catches up.
+        CHECK(queue.Push(MakeFrame(6)));
+        queue.WaitIdle();
+        CHECK(queue.GetEncodedCount() == 5);
+    }
+
+    // Destroying the queue finishes what was queued rather than losing it.
+    void TestDrainOnDestroy()
+    {
+        std::atomic<uint64_t> encoded(0);
+        {
+            FrameEncodeQueue queue([&](const CapturedFrame&)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                encoded++;
+            }, 8);
+
+            for (uint64_t frame = 0; frame < 8; frame++)
+            {
+                CHECK(queue.Push(MakeFrame(frame)));
+            }
+        }
+        CHECK(encoded == 8);
+    }
+
+    // The capture pipeline with synthetic frames: a frame is copied into a readback slot,
+    // read latency frames later unless the GPU is behind, and pushed to an encoder that is
+    // sometimes slow. Whatever is dropped along the way is counted, and what arrives is in
+    // order and holds the frame it was copied from.
+    void TestPipeline()
+    {
+        const uint32_t latency = 3;
+        const uint64_t frameCount = 300;
+
+        std::atomic<bool> ordered(true);
+        std::atomic<bool> intact(true);
+        std::atomic<uint64_t> lastEncoded(0);
+
+        uint64_t copied = 0;
+        uint64_t copyDropped = 0;
+        uint64_t pushed = 0;
+        uint64_t pushDropped = 0;
+
+        {
+            FrameEncodeQueue queue([&](const CapturedFrame& captured)
+            {
+                if (captured.frame < lastEncoded)
+                {
+                    ordered = false;
+                }
+                lastEncoded = captured.frame;
+
+                if (!IsIntact(captured))
+                {
+                    intact = false;
+                }
+
+                // Every tenth frame takes several frames' time to encode.
+                std::this_thread::sleep_for(std::chrono::microseconds(captured.frame % 10 == 0 ? 5000 : 100));
+            }, 4);
+
+            ReadbackRing ring(latency);
+            std::vector<std::vector<uint8_t>> staging(latency, std::vector<uint8_t>(Width * Height * 4));
+
+            for (uint64_t frame = 0; frame < frameCount; frame++)
+            {
+                bool gpuBusy = (frame % 13) < 2;
+
+                int slot;
+                while (!gpuBusy && (slot = ring.GetReadySlot(frame)) != ReadbackRing::NoSlot)
+                {
+                    CapturedFrame captured = MakeFrame(ring.GetSlotFrame(slot));
+                    captured.pixels = staging[slot];
+                    ring.EndRead(slot);
+
+                    if (queue.Push(std::move(captured)))
+                    {
+                        pushed++;
+                    }
+                    else
+                    {
+                        pushDropped++;
+                    }
+                }
+
+                slot = ring.BeginCopy(frame);
+                if (slot == ReadbackRing::NoSlot)
+                {
+                    copyDropped++;
+                    continue;
+                }
+
+                std::fill(staging[slot].begin(), staging[slot].end(), static_cast<uint8_t>(frame));
+                copied++;
+
+                std::this_thread::sleep_for(std::chrono::microseconds(500));
+            }
+
+            queue.WaitIdle();
+
+            CHECK(queue.GetEncodedCount() == pushed);
+            CHECK(queue.GetFailedCount() == 0);
+            CHECK(queue.GetDroppedCount() == pushDropped);
+            CHECK(pushed + pushDropped + ring.GetPendingCount() == copied);
+        }
+
+        CHECK(copied + copyDropped == frameCount);
+        CHECK(pushed > 0);
+        CHECK(ordered);
+        CHECK(intact);
+    }
+}
+
+int main()
+{
+    TestOrderAndFailures();
+    TestDropWhenFull();
+    TestDrainOnDestroy();
+    TestPipeline();
+    return CheckResult();
+}
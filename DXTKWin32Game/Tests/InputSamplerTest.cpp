@@ -0,0 +1,330 @@
+//
+// InputSamplerTest.cpp
+//
+
+#include "InputSampler.h"
+#include "Check.h"
+
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    const uint32_t Key = 'A';
+    const uint32_t OtherKey = 'B';
+
+    // The fixed timestep loop Game::Tick drives the simulation with: StepTimer's accumulator,
+    // and each step ending the time still left over before the frame's time.
+    class FixedStepLoop
+    {
+    public:
+        explicit FixedStepLoop(uint64_t stepTicks) : m_stepTicks(stepTicks), m_lastTime(0), m_leftOverTicks(0) {}
+
+        uint64_t GetLeftOverTicks() const { return m_leftOverTicks; }
+
+        template<typename TStep>
+        void Tick(uint64_t now, const TStep& step)
+        {
+            m_leftOverTicks += now - m_lastTime;
+            m_lastTime = now;
+
+            while (m_leftOverTicks >= m_stepTicks)
+            {
+                m_leftOverTicks -= m_stepTicks;
+                step(now - m_leftOverTicks);
+            }
+        }
+
+    private:
+        uint64_t m_stepTicks;
+        uint64_t m_lastTime;
+        uint64_t m_leftOverTicks;
+    };
+
+    // What Game does around the sampler: pad changes are found by comparing with the last
+    // poll, input is buffered until the next step, and deactivation asks the next step to
+    // reset the sampler.
+    class InputHarness
+    {
+    public:
+        InputHarness() : m_lastPadA(0.0f), m_resetPending(false) {}
+
+        void SamplePad(uint64_t time, float padA)
+        {
+            if (padA != m_lastPadA)
+            {
+                m_pending.push_back(Pending{ time, InputControl::PadA, padA });
+            }
+            m_lastPadA = padA;
+        }
+
+        void OnDeactivated()
+        {
+            m_pending.clear();
+            m_resetPending = true;
+            m_lastPadA = 0.0f;
+        }
+
+        void RunStep(uint64_t stepEnd)
+        {
+            if (m_resetPending)
+            {
+                sampler.Reset();
+                m_resetPending = false;
+            }
+
+            for (const Pending& input : m_pending)
+            {
+                sampler.Push(input.time, input.control, input.value);
+            }
+            m_pending.clear();
+
+            sampler.Step(stepEnd);
+        }
+
+        InputSampler sampler;
+
+    private:
+        struct Pending
+        {
+            uint64_t    time;
+            uint32_t    control;
+            float       value;
+        };
+
+        std::vector<Pending>    m_pending;
+        float                   m_lastPadA;
+        bool                    m_resetPending;
+    };
+
+    void TestEdgesAcrossSteps()
+    {
+        InputSampler sampler;
+
+        // Held across three steps: pressed in the first, released in the last.
+        sampler.Push(25, Key, 1.0f);
+        sampler.Push(47, Key, 0.0f);
+
+        sampler.Step(30);
+        CHECK(sampler.WasPressed(Key));
+        CHECK(!sampler.WasReleased(Key));
+        CHECK(sampler.IsDown(Key));
+        CHECK(sampler.GetHeldSteps(Key) == 1);
+
+        sampler.Step(40);
+        CHECK(!sampler.WasPressed(Key));
+        CHECK(!sampler.WasReleased(Key));
+        CHECK(sampler.IsDown(Key));
+        CHECK(sampler.GetHeldSteps(Key) == 2);
+
+        sampler.Step(50);
+        CHECK(!sampler.WasPressed(Key));
+        CHECK(sampler.WasReleased(Key));
+        CHECK(!sampler.IsDown(Key));
+        CHECK(sampler.GetHeldSteps(Key) == 0);
+
+        sampler.Step(60);
+        CHECK(!sampler.WasReleased(Key));
+
+        // A tap inside one step sets both edges, and the next step clears them.
+        sampler.Push(64, Key, 1.0f);
+        sampler.Push(66, Key, 0.0f);
+        sampler.Step(70);
+        CHECK(sampler.WasPressed(Key));
+        CHECK(sampler.WasReleased(Key));
+        CHECK(!sampler.IsDown(Key));
+        CHECK(sampler.GetHeldSteps(Key) == 0);
+
+        sampler.Step(80);
+        CHECK(!sampler.WasPressed(Key));
+        CHECK(!sampler.WasReleased(Key));
+
+        // Analog controls count as down past half way, and changes that stay on one side
+        // aren't edges.
+        sampler.Push(81, InputControl::PadLeftTrigger, 0.25f);
+        sampler.Step(90);
+        CHECK(!sampler.WasPressed(InputControl::PadLeftTrigger));
+        CHECK(sampler.GetValue(InputControl::PadLeftTrigger) == 0.25f);
+
+        sampler.Push(91, InputControl::PadLeftTrigger, 0.75f);
+        sampler.Push(92, InputControl::PadLeftTrigger, 1.0f);
+        sampler.Step(100);
+        CHECK(sampler.WasPressed(InputControl::PadLeftTrigger));
+        CHECK(sampler.GetValue(InputControl::PadLeftTrigger) == 1.0f);
+
+        // Controls out of range are ignored.
+        sampler.Push(101, InputControl::Count, 1.0f);
+        sampler.Step(110);
+    }
+
+    void TestEventOrder()
+    {
+        InputSampler sampler;
+
+        // Out of order between steps: applied by time, so the key ends up released.
+        sampler.Push(8, Key, 0.0f);
+        sampler.Push(5, Key, 1.0f);
+        sampler.Step(10);
+        CHECK(sampler.WasPressed(Key));
+        CHECK(sampler.WasReleased(Key));
+        CHECK(!sampler.IsDown(Key));
+
+        // Events at the same time keep the order they were pushed in.
+        sampler.Push(15, Key, 1.0f);
+        sampler.Push(15, Key, 0.0f);
+        sampler.Push(15, OtherKey, 0.0f);
+        sampler.Push(15, OtherKey, 1.0f);
+        sampler.Step(20);
+        CHECK(!sampler.IsDown(Key));
+        CHECK(sampler.WasPressed(Key));
+        CHECK(sampler.WasReleased(Key));
+        CHECK(sampler.IsDown(OtherKey));
+        CHECK(sampler.WasPressed(OtherKey));
+        CHECK(!sampler.WasReleased(OtherKey));
+
+        // Same again with later events pushed first, so the sort has to move them.
+        sampler.Push(29, OtherKey, 0.0f);
+        sampler.Push(25, Key, 1.0f);
+        sampler.Push(25, Key, 0.0f);
+        sampler.Push(25, Key, 1.0f);
+        sampler.Step(30);
+        CHECK(sampler.IsDown(Key));
+        CHECK(!sampler.IsDown(OtherKey));
+
+        // Latency averages over the events applied in the last step that had any.
+        CHECK(sampler.GetLastLatency() == (5 + 5 + 5 + 1) / 4);
+        sampler.Step(40);
+        CHECK(sampler.GetLastLatency() == (5 + 5 + 5 + 1) / 4);
+    }
+
+    void TestStepBoundaries()
+    {
+        const uint64_t stepTicks = 100;
+        FixedStepLoop loop(stepTicks);
+        InputSampler sampler;
+        std::vector<uint64_t> stepEnds;
+        std::vector<bool> pressed;
+
+        auto tick = [&](uint64_t now)
+        {
+            stepEnds.clear();
+            pressed.clear();
+            loop.Tick(now, [&](uint64_t stepEnd)
+            {
+                sampler.Step(stepEnd);
+                stepEnds.push_back(stepEnd);
+                pressed.push_back(sampler.WasPressed(Key));
+            });
+        };
+
+        // A long frame runs two steps. The press lands in the second, whose span contains it,
+        // rather than in the first step of the frame.
+        sampler.Push(150, Key, 1.0f);
+        tick(250);
+        CHECK(stepEnds.size() == 2);
+        CHECK(stepEnds[0] == 100 && stepEnds[1] == 200);
+        CHECK(!pressed[0] && pressed[1]);
+        CHECK(loop.GetLeftOverTicks() == 50);
+
+        // An event exactly on a step's end belongs to that step; one tick later waits for the
+        // next, even though the frame it arrived in has already passed it.
+        sampler.Push(300, Key, 0.0f);
+        sampler.Push(301, OtherKey, 1.0f);
+        tick(330);
+        CHECK(stepEnds.size() == 1 && stepEnds[0] == 300);
+        CHECK(sampler.WasReleased(Key));
+        CHECK(!sampler.IsDown(OtherKey));
+
+        // A short frame runs no step; the event stays buffered until one ends past it.
+        tick(390);
+        CHECK(stepEnds.empty());
+        CHECK(!sampler.IsDown(OtherKey));
+
+        tick(400);
+        CHECK(stepEnds.size() == 1 && stepEnds[0] == 400);
+        CHECK(sampler.WasPressed(OtherKey));
+        CHECK(sampler.GetLastLatency() == 99);
+
+        // A press and release between two steps still registers, and each step of a catch-up
+        // frame sees only its own events.
+        sampler.Push(420, Key, 1.0f);
+        sampler.Push(430, Key, 0.0f);
+        sampler.Push(610, Key, 1.0f);
+        tick(700);
+        CHECK(stepEnds.size() == 3);
+        CHECK(pressed[0] && !pressed[1] && pressed[2]);
+        CHECK(sampler.IsDown(Key));
+        CHECK(sampler.GetHeldSteps(Key) == 1);
+    }
+
+    void TestReset()
+    {
+        InputSampler sampler;
+
+        sampler.Push(5, Key, 1.0f);
+        sampler.Push(6, InputControl::PadRightTrigger, 0.5f);
+        sampler.Step(10);
+        sampler.Push(15, OtherKey, 1.0f);
+        sampler.Push(1000, Key, 0.0f);
+
+        // Every control is released and buffered events are dropped, future ones included;
+        // releasing isn't an edge.
+        sampler.Reset();
+        CHECK(!sampler.IsDown(Key));
+        CHECK(!sampler.WasPressed(Key));
+        CHECK(sampler.GetValue(InputControl::PadRightTrigger) == 0.0f);
+        CHECK(sampler.GetHeldSteps(Key) == 0);
+
+        sampler.Step(2000);
+        CHECK(!sampler.IsDown(OtherKey));
+        CHECK(!sampler.WasReleased(Key));
+        CHECK(!sampler.WasPressed(OtherKey));
+    }
+
+    // A pad button held through losing focus must read as held again afterwards. The reset
+    // releases it in the sampler, so the next poll has to report it even though the pad
+    // itself didn't change.
+    void TestResetOnFocusLoss()
+    {
+        InputHarness harness;
+
+        harness.SamplePad(5, 1.0f);
+        harness.RunStep(10);
+        CHECK(harness.sampler.IsDown(InputControl::PadA));
+
+        harness.OnDeactivated();
+        harness.SamplePad(15, 1.0f);
+        harness.RunStep(20);
+        CHECK(harness.sampler.IsDown(InputControl::PadA));
+        CHECK(harness.sampler.WasPressed(InputControl::PadA));
+        CHECK(harness.sampler.GetHeldSteps(InputControl::PadA) == 1);
+
+        // Released while in the background: the reset releases it and nothing follows.
+        harness.OnDeactivated();
+        harness.SamplePad(25, 0.0f);
+        harness.RunStep(30);
+        CHECK(!harness.sampler.IsDown(InputControl::PadA));
+        CHECK(!harness.sampler.WasReleased(InputControl::PadA));
+
+        // Input buffered before deactivating is dropped with the reset.
+        harness.SamplePad(32, 1.0f);
+        harness.OnDeactivated();
+        harness.RunStep(40);
+        CHECK(!harness.sampler.IsDown(InputControl::PadA));
+
+        harness.SamplePad(45, 1.0f);
+        harness.RunStep(50);
+        CHECK(harness.sampler.WasPressed(InputControl::PadA));
+    }
+}
+
+int main()
+{
+    TestEdgesAcrossSteps();
+    TestEventOrder();
+    TestStepBoundaries();
+    TestReset();
+    TestResetOnFocusLoss();
+    return CheckResult();
+}
@@ -0,0 +1,181 @@
+//
+// LaunchOptionsTest.cpp
+//
+
+#include "LaunchOptions.h"
+#include "Check.h"
+
+#include <cstdio>
+
+using namespace DX;
+
+namespace
+{
+    struct ParseCase
+    {
+        const wchar_t*      commandLine;
+        bool                valid;
+        SwapEffect          swapEffect;
+        BackBufferFormat    format;
+        uint32_t            backBufferCount;
+        bool                allowTearing;
+        bool                benchmark;
+        uint32_t            sampleCount;
+        bool                dynamicResolution;
+        bool                simulationThread;
+        uint32_t            lightCount;
+    };
+
+    const SwapEffect Blt = SwapEffect::Blt;
+    const SwapEffect FlipSequential = SwapEffect::FlipSequential;
+    const SwapEffect FlipDiscard = SwapEffect::FlipDiscard;
+    const BackBufferFormat Bgra8 = BackBufferFormat::Bgra8;
+    const BackBufferFormat Hdr10 = BackBufferFormat::Hdr10;
+    const BackBufferFormat ScRgb = BackBufferFormat::ScRgb;
+
+    // Invalid cases list the defaults, since a failed parse leaves the options unchanged.
+    const ParseCase ParseCases[] =
+    {
+        // commandLine                                      valid   swap            format  buffers tearing benchmark msaa  dynres  simthread lights
+        { L"",                                              true,   Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { nullptr,                                          true,   Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"  \t ",                                         true,   Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-swap flipdiscard -buffers 3",                  true,   FlipDiscard,    Bgra8,  3,      false,  false,  1,      false,  false,  0     },
+        { L"-SWAP FlipSequential -Format HDR10",            true,   FlipSequential, Hdr10,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-format scrgb -tearing -benchmark",             true,   Blt,            ScRgb,  2,      true,   true,   1,      false,  false,  0     },
+        { L"-msaa 1",                                       true,   Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-msaa 2",                                       true,   Blt,            Bgra8,  2,      false,  false,  2,      false,  false,  0     },
+        { L"-msaa 4 -dynres",                               true,   Blt,            Bgra8,  2,      false,  false,  4,      true,   false,  0     },
+        { L"-simthread -msaa 8",                            true,   Blt,            Bgra8,  2,      false,  false,  8,      false,  true,   0     },
+        { L"-dynres -simthread",                            true,   Blt,            Bgra8,  2,      false,  false,  1,      true,   true,   0     },
+        { L"-simthread -swap flipdiscard -msaa 4 -buffers 4 -dynres",
+                                                            true,   FlipDiscard,    Bgra8,  4,      false,  false,  4,      true,   true,   0     },
+        { L"-lights 0",                                     true,   Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-lights 1024",                                  true,   Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  1024  },
+        { L"-dynres -lights 65536 -msaa 4",                 true,   Blt,            Bgra8,  2,      false,  false,  4,      true,   false,  65536 },
+        { L"-msaa",                                         false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-msaa 0",                                       false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-msaa 3",                                       false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-msaa 16",                                      false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-msaa 4x",                                      false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-msaa -dynres",                                 false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-dynres -msaa two",                             false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-lights",                                       false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-lights 65537",                                 false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-lights -1",                                    false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-lights many",                                  false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-swap",                                         false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-swap flip",                                    false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-buffers 1",                                    false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-buffers 5",                                    false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-buffers three",                                false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-format hdr",                                   false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-dynres -simthreads",                           false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"dynres",                                        false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+        { L"-swap flipdiscard -bogus",                      false,  Blt,            Bgra8,  2,      false,  false,  1,      false,  false,  0     },
+    };
+
+    void TestParse()
+    {
+        for (const ParseCase& test : ParseCases)
+        {
+            LaunchOptions options;
+            std::wstring error;
+            bool valid = options.Parse(test.commandLine, error);
+
+            bool matches = valid == test.valid
+                && error.empty() == test.valid
+                && options.swapChain.swapEffect == test.swapEffect
+                && options.swapChain.format == test.format
+                && options.swapChain.backBufferCount == test.backBufferCount
+                && options.swapChain.allowTearing == test.allowTearing
+                && options.swapChain.benchmark == test.benchmark
+                && options.sampleCount == test.sampleCount
+                && options.dynamicResolution == test.dynamicResolution
+                && options.simulationThread == test.simulationThread
+                && options.lightCount == test.lightCount;
+
+            if (!matches)
+            {
+                std::fprintf(stderr, "Parse(\"%ls\") gave valid %d, error \"%ls\"\n", test.commandLine ? test.commandLine : L"(null)", valid, error.c_str());
+            }
+            CHECK(matches);
+        }
+    }
+
+    struct ResolveCase
+    {
+        const char*         system;
+        SwapChainSupport    support;
+        const wchar_t*      commandLine;
+        SwapEffect          swapEffect;
+        BackBufferFormat    format;
+        bool                allowTearing;
+    };
+
+    // What Game::CreateResources reports for each system: Windows 8 has DXGI 1.2 but is
+    // treated like Windows 7, since the interfaces don't tell them apart.
+    const SwapChainSupport Windows8 = { false, false, false };
+    const SwapChainSupport Windows10 = { true, true, false };
+    const SwapChainSupport Windows10Tearing = { true, true, true };
+
+    const ResolveCase ResolveCases[] =
+    {
+        // system               support             commandLine                                         swap            format  tearing
+        { "Windows 8",          Windows8,           L"",                                                Blt,            Bgra8,  false },
+        { "Windows 8",          Windows8,           L"-swap flipdiscard",                               Blt,            Bgra8,  false },
+        { "Windows 8",          Windows8,           L"-swap flipsequential -buffers 3",                 Blt,            Bgra8,  false },
+        { "Windows 8",          Windows8,           L"-swap flipdiscard -format hdr10",                 Blt,            Bgra8,  false },
+        { "Windows 8",          Windows8,           L"-swap flipdiscard -format scrgb -tearing -benchmark",
+                                                                                                        Blt,            Bgra8,  false },
+        { "Windows 10",         Windows10,          L"-swap flipdiscard -format hdr10",                 FlipDiscard,    Hdr10,  false },
+        { "Windows 10",         Windows10,          L"-swap flipsequential -format scrgb",              FlipSequential, ScRgb,  false },
+        { "Windows 10",         Windows10,          L"-swap flipdiscard -tearing -benchmark",           FlipDiscard,    Bgra8,  false },
+        { "Windows 10",         Windows10,          L"-format hdr10",                                   Blt,            Bgra8,  false },
+        { "Windows 10 tearing", Windows10Tearing,   L"-swap flipdiscard -tearing -benchmark",           FlipDiscard,    Bgra8,  true  },
+        { "Windows 10 tearing", Windows10Tearing,   L"-swap flipdiscard -tearing",                      FlipDiscard,    Bgra8,  false },
+        { "Windows 10 tearing", Windows10Tearing,   L"-tearing -benchmark",                             Blt,            Bgra8,  false },
+    };
+
+    void TestResolve()
+    {
+        for (const ResolveCase& test : ResolveCases)
+        {
+            LaunchOptions options;
+            std::wstring error;
+            CHECK(options.Parse(test.commandLine, error));
+
+            SwapChainConfig config = options.swapChain.Resolve(test.support);
+
+            // Only the swap effect, format and tearing fall back; the rest is kept.
+            bool matches = config.swapEffect == test.swapEffect
+                && config.format == test.format
+                && config.allowTearing == test.allowTearing
+                && config.backBufferCount == options.swapChain.backBufferCount
+                && config.benchmark == options.swapChain.benchmark
+                && config.IsFlipModel() == (test.swapEffect != SwapEffect::Blt)
+                && config.GetSyncInterval() == (options.swapChain.benchmark ? 0u : 1u);
+
+            if (!matches)
+            {
+                std::fprintf(stderr, "Resolve(\"%ls\") on %s gave swap effect %d, format %d, tearing %d\n",
+                    test.commandLine, test.system, static_cast<int>(config.swapEffect), static_cast<int>(config.format), config.allowTearing);
+            }
+            CHECK(matches);
+        }
+
+        // Counts set directly rather than parsed are clamped.
+        SwapChainConfig config;
+        config.backBufferCount = 0;
+        CHECK(config.Resolve(Windows10).backBufferCount == SwapChainConfig::MinBackBufferCount);
+        config.backBufferCount = 16;
+        CHECK(config.Resolve(Windows10).backBufferCount == SwapChainConfig::MaxBackBufferCount);
+    }
+}
+
+int main()
+{
+    TestParse();
+    TestResolve();
+    return CheckResult();
+}
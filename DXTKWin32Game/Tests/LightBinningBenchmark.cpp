@@ -0,0 +1,111 @@
+//
+// LightBinningBenchmark.cpp
+//
+
+#include "LightBinning.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace DX;
+
+namespace
+{
+    const uint32_t Width = 1920;
+    const uint32_t Height = 1080;
+    const float NearZ = 0.1f;
+    const float FarZ = 100.0f;
+
+    // Small deterministic noise, so every run bins the same lights.
+    class Noise
+    {
+    public:
+        Noise() : m_state(12345) {}
+
+        // Uniform in low to high.
+        float Next(float low, float high)
+        {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return low + (high - low) * static_cast<float>(static_cast<double>(m_state >> 11) / static_cast<double>(1ull << 53));
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    // Lights spread through the view frustum, plus a little past its sides so some are only
+    // partly on screen.
+    std::vector<LightSphere> GenerateLights(uint32_t count, float xScale, float yScale)
+    {
+        Noise random;
+        std::vector<LightSphere> lights(count);
+        for (LightSphere& light : lights)
+        {
+            light.depth = random.Next(1.0f, FarZ);
+            light.x = random.Next(-1.2f, 1.2f) * light.depth / xScale;
+            light.y = random.Next(-1.2f, 1.2f) * light.depth / yScale;
+            light.radius = random.Next(0.2f, 2.0f);
+        }
+        return lights;
+    }
+
+    // Times Bin over a few repeats and reports the mean, with and without tile depth bounds
+    // like the ones the GPU reduces from the depth buffer.
+    void Run(uint32_t count)
+    {
+        const float yScale = 1.0f / std::tan(0.3926991f);
+        const float xScale = yScale * Height / Width;
+
+        LightBinning binning;
+        binning.SetView(Width, Height, xScale, yScale, NearZ, FarZ);
+
+        std::vector<LightSphere> lights = GenerateLights(count, xScale, yScale);
+
+        size_t tileCount = static_cast<size_t>(binning.GetTilesX()) * binning.GetTilesY();
+        std::vector<float> tileMin(tileCount);
+        std::vector<float> tileMax(tileCount);
+        for (size_t i = 0; i < tileCount; i++)
+        {
+            tileMin[i] = 5.0f + static_cast<float>(i % 7);
+            tileMax[i] = tileMin[i] + 20.0f + static_cast<float>(i % 13);
+        }
+
+        const int repeats = (count <= 4096) ? 50 : 10;
+        double milliseconds[2] = {};
+        uint32_t maxTileLights[2] = {};
+
+        for (int bounded = 0; bounded < 2; bounded++)
+        {
+            const float* minDepth = bounded ? tileMin.data() : nullptr;
+            const float* maxDepth = bounded ? tileMax.data() : nullptr;
+
+            // Once first, so the lists have grown to size before timing.
+            binning.Bin(lights.data(), count, minDepth, maxDepth);
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repeats; i++)
+            {
+                binning.Bin(lights.data(), count, minDepth, maxDepth);
+            }
+            milliseconds[bounded] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / repeats;
+            maxTileLights[bounded] = binning.GetMaxTileLightCount();
+        }
+
+        std::printf("%6u lights: %7.3f ms per Bin (max %4u per tile), %7.3f ms with depth bounds (max %4u per tile)\n",
+            count, milliseconds[0], maxTileLights[0], milliseconds[1], maxTileLights[1]);
+    }
+}
+
+// Bins 1k to 64k lights into 16x16 pixel tiles at 1920x1080.
+int main()
+{
+    std::printf("%ux%u, %ux%u tiles\n", Width, Height, (Width + LightBinning::TileSize - 1) / LightBinning::TileSize,
+        (Height + LightBinning::TileSize - 1) / LightBinning::TileSize);
+
+    for (uint32_t count : { 1024u, 4096u, 16384u, 65536u })
+    {
+        Run(count);
+    }
+    return 0;
+}
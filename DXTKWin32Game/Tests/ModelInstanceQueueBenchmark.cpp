@@ -0,0 +1,164 @@
+//
+// ModelInstanceQueueBenchmark.cpp
+//
+
+#include "ModelInstanceQueue.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+using namespace DX;
+
+namespace
+{
+    const uint32_t BatchCount = 64;
+
+    // Small deterministic noise, so every run gathers the same instances.
+    class Noise
+    {
+    public:
+        Noise() : m_state(12345) {}
+
+        // Uniform in low to high.
+        float Next(float low, float high)
+        {
+            m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+            return low + (high - low) * static_cast<float>(static_cast<double>(m_state >> 11) / static_cast<double>(1ull << 53));
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    struct Source
+    {
+        uint32_t    batch;
+        float       world[4][4];
+    };
+
+    // Instances scattered through a box around a camera at the origin looking down -z, so
+    // about one in nine is inside the frustum and the rest are culled, as in an open scene.
+    std::vector<Source> GenerateInstances(uint32_t count)
+    {
+        Noise random;
+        std::vector<Source> instances(count);
+        for (Source& instance : instances)
+        {
+            float scale = random.Next(0.5f, 2.0f);
+            instance = Source{ static_cast<uint32_t>(random.Next(0.0f, static_cast<float>(BatchCount))) % BatchCount,
+                {
+                    { scale, 0.0f, 0.0f, 0.0f },
+                    { 0.0f, scale, 0.0f, 0.0f },
+                    { 0.0f, 0.0f, scale, 0.0f },
+                    { random.Next(-100.0f, 100.0f), random.Next(-50.0f, 50.0f), random.Next(-100.0f, 100.0f), 1.0f },
+                } };
+        }
+        return instances;
+    }
+
+    // The identity view times a right-handed perspective projection, as
+    // XMMatrixPerspectiveFovRH builds it, with row vectors.
+    void GetViewProjection(float (&viewProjection)[4][4])
+    {
+        const float nearZ = 0.1f;
+        const float farZ = 100.0f;
+        const float yScale = 1.0f / std::tan(0.3926991f);
+        const float xScale = yScale * 9.0f / 16.0f;
+        const float range = farZ / (nearZ - farZ);
+
+        const float matrix[4][4] =
+        {
+            { xScale, 0.0f, 0.0f, 0.0f },
+            { 0.0f, yScale, 0.0f, 0.0f },
+            { 0.0f, 0.0f, range, -1.0f },
+            { 0.0f, 0.0f, range * nearZ, 0.0f },
+        };
+
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                viewProjection[row][column] = matrix[row][column];
+            }
+        }
+    }
+
+    double Milliseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // Times a frame's worth of gathering (Clear, SetFrustum and an Add per instance) and
+    // sorting (Sort and walking the batches, as InstancedModelRenderer draws them), each
+    // averaged over a few frames.
+    void Run(uint32_t count)
+    {
+        const InstanceSphere bounds = { 0.0f, 0.0f, 0.0f, 0.5f };
+        const float color[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+        std::vector<Source> instances = GenerateInstances(count);
+
+        float viewProjection[4][4];
+        GetViewProjection(viewProjection);
+
+        ModelInstanceQueue queue;
+        const int frames = (count <= 100000) ? 50 : 10;
+        double gatherMilliseconds = 0.0;
+        double sortMilliseconds = 0.0;
+        uint32_t drawCount = 0;
+
+        // One frame first, so the queue's lists have grown to size before timing.
+        for (int frame = -1; frame < frames; frame++)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            queue.Clear();
+            queue.SetFrustum(viewProjection);
+            for (const Source& instance : instances)
+            {
+                queue.Add(instance.batch, instance.world, bounds, color);
+            }
+
+            auto gathered = std::chrono::steady_clock::now();
+
+            queue.Sort();
+            size_t visited = 0;
+            drawCount = queue.ForEachBatch([&](uint32_t, uint32_t, uint32_t instanceCount)
+            {
+                visited += instanceCount;
+            });
+
+            auto sorted = std::chrono::steady_clock::now();
+
+            if (frame >= 0)
+            {
+                gatherMilliseconds += Milliseconds(start, gathered);
+                sortMilliseconds += Milliseconds(gathered, sorted);
+            }
+
+            if (visited != queue.GetInstanceCount())
+            {
+                std::printf("Batches cover %zu instances, not %zu\n", visited, queue.GetInstanceCount());
+                return;
+            }
+        }
+
+        gatherMilliseconds /= frames;
+        sortMilliseconds /= frames;
+
+        std::printf("%8u instances: %8.3f ms to gather (%5.1f ns each), %7.3f ms to sort; %zu kept, %zu culled, %u draws\n",
+            count, gatherMilliseconds, gatherMilliseconds * 1e6 / count, sortMilliseconds,
+            queue.GetInstanceCount(), queue.GetCulledCount(), drawCount);
+    }
+}
+
+// Gathers and sorts 10k to 1M instances of 64 batches, as one frame's worth each.
+int main()
+{
+    for (uint32_t count : { 10000u, 100000u, 1000000u })
+    {
+        Run(count);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+//
+// ReadbackRingTest.cpp
+//
+
+#include "ReadbackRing.h"
+#include "Check.h"
+
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    void TestSlots()
+    {
+        ReadbackRing ring(3);
+        CHECK(ring.GetSlotCount() == 3);
+        CHECK(ring.GetLatency() == 3);
+
+        // Every slot taken: the next frame has nowhere to go.
+        CHECK(ring.BeginCopy(0) == 0);
+        CHECK(ring.BeginCopy(1) == 1);
+        CHECK(ring.BeginCopy(2) == 2);
+        CHECK(ring.BeginCopy(3) == ReadbackRing::NoSlot);
+        CHECK(ring.GetPendingCount() == 3);
+
+        // Nothing is ready until the oldest copy is latency frames old.
+        CHECK(ring.GetReadySlot(2) == ReadbackRing::NoSlot);
+        CHECK(ring.GetReadySlot(3) == 0);
+        CHECK(ring.GetSlotFrame(0) == 0);
+
+        // A freed slot is reused, and the oldest copy is always read first.
+        ring.EndRead(0);
+        CHECK(ring.BeginCopy(3) == 0);
+        CHECK(ring.GetReadySlot(10) == 1);
+        ring.EndRead(1);
+        CHECK(ring.GetReadySlot(10) == 2);
+        ring.EndRead(2);
+        CHECK(ring.GetReadySlot(10) == 0);
+        CHECK(ring.GetSlotFrame(0) == 3);
+
+        ring.Reset();
+        CHECK(ring.GetPendingCount() == 0);
+        CHECK(ring.GetReadySlot(100) == ReadbackRing::NoSlot);
+
+        // A latency of zero still gets a slot.
+        ReadbackRing minimal(0);
+        CHECK(minimal.GetSlotCount() == 1);
+        CHECK(minimal.BeginCopy(0) == 0);
+        CHECK(minimal.GetReadySlot(0) == ReadbackRing::NoSlot);
+        CHECK(minimal.GetReadySlot(1) == 0);
+    }
+
+    // Reading what is ready and then copying, every frame, never drops a frame, and every
+    // frame is read exactly latency frames after its copy.
+    void TestSteadyState()
+    {
+        const uint32_t latency = 3;
+        ReadbackRing ring(latency);
+        std::vector<uint64_t> read;
+        uint32_t dropped = 0;
+        bool onTime = true;
+
+        for (uint64_t frame = 0; frame < 1000; frame++)
+        {
+            int slot;
+            while ((slot = ring.GetReadySlot(frame)) != ReadbackRing::NoSlot)
+            {
+                onTime = onTime && ring.GetSlotFrame(slot) + latency == frame;
+                read.push_back(ring.GetSlotFrame(slot));
+                ring.EndRead(slot);
+            }
+
+            if (ring.BeginCopy(frame) == ReadbackRing::NoSlot)
+            {
+                dropped++;
+            }
+        }
+
+        CHECK(dropped == 0);
+        CHECK(onTime);
+        CHECK(read.size() == 1000 - latency);
+        for (size_t i = 0; i < read.size(); i++)
+        {
+            CHECK(read[i] == i);
+        }
+    }
+
+    // A GPU that sometimes hasn't finished a copy when it is due, so the read waits a frame.
+    // Frames are dropped while every slot is waiting, but the ones read stay in order, and
+    // every copy is either read or still pending.
+    void TestLateReads()
+    {
+        ReadbackRing ring(3);
+        uint64_t copied = 0;
+        uint64_t dropped = 0;
+        uint64_t read = 0;
+        uint64_t lastRead = 0;
+        bool ordered = true;
+
+        for (uint64_t frame = 0; frame < 1000; frame++)
+        {
+            // Busy for runs of frames, like a GPU that is a frame or two behind.
+            bool gpuBusy = (frame / 7) % 3 == 0;
+
+            int slot;
+            while (!gpuBusy && (slot = ring.GetReadySlot(frame)) != ReadbackRing::NoSlot)
+            {
+                uint64_t slotFrame = ring.GetSlotFrame(slot);
+                ordered = ordered && (read == 0 || slotFrame > lastRead);
+                lastRead = slotFrame;
+                read++;
+                ring.EndRead(slot);
+            }
+
+            if (ring.BeginCopy(frame) == ReadbackRing::NoSlot)
+            {
+                dropped++;
+            }
+            else
+            {
+                copied++;
+            }
+        }
+
+        CHECK(ordered);
+        CHECK(dropped > 0);
+        CHECK(copied + dropped == 1000);
+        CHECK(read + ring.GetPendingCount() == copied);
+    }
+}
+
+int main()
+{
+    TestSlots();
+    TestSteadyState();
+    TestLateReads();
+    return CheckResult();
+}
@@ -0,0 +1,163 @@
+//
+// TripleBufferTest.cpp
+//
+
+#include "TripleBuffer.h"
+#include "Check.h"
+
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Shaped like Game's snapshots: a step's end time, and a list the simulation fills each
+    // step and swaps in rather than copying.
+    struct Snapshot
+    {
+        uint64_t                stepEnd;
+        std::vector<uint64_t>   items;
+    };
+
+    // Each step writes a different number of items, all holding the step's end time, so a
+    // torn snapshot shows up as a wrong count or a stray value.
+    size_t GetItemCount(uint64_t stepEnd)
+    {
+        return static_cast<size_t>(stepEnd % 61) + 1;
+    }
+
+    void RunStep(uint64_t stepEnd, std::vector<uint64_t>& items)
+    {
+        items.clear();
+        items.resize(GetItemCount(stepEnd), stepEnd);
+    }
+
+    void Publish(TripleBuffer<Snapshot>& snapshots, uint64_t stepEnd, std::vector<uint64_t>& items)
+    {
+        Snapshot& snapshot = snapshots.GetWriteBuffer();
+        snapshot.stepEnd = stepEnd;
+        std::swap(snapshot.items, items);
+        snapshots.Publish();
+    }
+
+    bool IsWhole(const Snapshot& snapshot)
+    {
+        if (snapshot.items.size() != GetItemCount(snapshot.stepEnd))
+            return false;
+
+        for (uint64_t item : snapshot.items)
+        {
+            if (item != snapshot.stepEnd)
+                return false;
+        }
+        return true;
+    }
+
+    void TestHandoff()
+    {
+        TripleBuffer<Snapshot> snapshots;
+        std::vector<uint64_t> items;
+
+        // Nothing to take until something is published.
+        CHECK(!snapshots.Acquire());
+
+        RunStep(1, items);
+        Publish(snapshots, 1, items);
+        CHECK(snapshots.Acquire());
+        CHECK(snapshots.GetReadBuffer().stepEnd == 1);
+        CHECK(IsWhole(snapshots.GetReadBuffer()));
+
+        // Taken once; the reader keeps it until something newer is published.
+        CHECK(!snapshots.Acquire());
+        CHECK(snapshots.GetReadBuffer().stepEnd == 1);
+
+        // Only the newest of several publishes is taken.
+        for (uint64_t stepEnd = 2; stepEnd <= 4; stepEnd++)
+        {
+            RunStep(stepEnd, items);
+            Publish(snapshots, stepEnd, items);
+        }
+        CHECK(snapshots.Acquire());
+        CHECK(snapshots.GetReadBuffer().stepEnd == 4);
+        CHECK(IsWhole(snapshots.GetReadBuffer()));
+        CHECK(!snapshots.Acquire());
+
+        // The writer never gets the copy the reader holds.
+        for (uint64_t stepEnd = 5; stepEnd <= 10; stepEnd++)
+        {
+            CHECK(&snapshots.GetWriteBuffer() != &snapshots.GetReadBuffer());
+            RunStep(stepEnd, items);
+            Publish(snapshots, stepEnd, items);
+            CHECK(snapshots.GetReadBuffer().stepEnd == 4);
+        }
+    }
+
+    // One simulation thread publishing as fast as it can and one render thread acquiring.
+    // Every snapshot the reader holds must be whole and never older than one it held before.
+    // Built with the thread sanitizer where available, which also catches unordered access
+    // to the copies.
+    void TestConcurrentHandoff()
+    {
+        const uint64_t lastStep = 200000;
+
+        TripleBuffer<Snapshot> snapshots;
+        std::atomic<bool> done(false);
+
+        std::thread simulation([&]()
+        {
+            std::vector<uint64_t> items;
+            for (uint64_t stepEnd = 1; stepEnd <= lastStep; stepEnd++)
+            {
+                RunStep(stepEnd, items);
+                Publish(snapshots, stepEnd, items);
+            }
+            done = true;
+        });
+
+        uint64_t heldStepEnd = 0;
+        uint64_t acquired = 0;
+        bool whole = true;
+        bool ordered = true;
+
+        for (;;)
+        {
+            // Read before acquiring, so the last publish is always picked up below.
+            bool finished = done;
+
+            if (snapshots.Acquire())
+            {
+                const Snapshot& snapshot = snapshots.GetReadBuffer();
+                whole = whole && IsWhole(snapshot);
+                ordered = ordered && snapshot.stepEnd > heldStepEnd;
+                heldStepEnd = snapshot.stepEnd;
+                acquired++;
+            }
+            else if (heldStepEnd != 0)
+            {
+                // Holding on to a snapshot must not let the writer touch it.
+                whole = whole && IsWhole(snapshots.GetReadBuffer());
+                ordered = ordered && snapshots.GetReadBuffer().stepEnd == heldStepEnd;
+            }
+
+            if (finished)
+                break;
+        }
+
+        simulation.join();
+
+        CHECK(whole);
+        CHECK(ordered);
+        CHECK(acquired > 0);
+        CHECK(heldStepEnd == lastStep);
+    }
+}
+
+int main()
+{
+    TestHandoff();
+    TestConcurrentHandoff();
+    return CheckResult();
+}
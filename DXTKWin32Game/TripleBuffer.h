@@ -0,0 +1,71 @@
+//
+// TripleBuffer.h - Hands the latest value from one thread to another without locking
+//
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace DX
+{
+    // Three copies of a value: one the writer fills, one the reader holds, and the latest
+    // published one in between. Publish swaps the writer's copy into the middle and Acquire
+    // swaps the middle out to the reader, each with one atomic exchange, so neither thread
+    // ever waits for the other. A value the reader didn't get to before the next Publish is
+    // dropped, which suits state where only the newest matters, such as snapshots of a
+    // simulation for drawing.
+    //
+    // Exactly one thread may use the writer's side and one the reader's. Each copy is only
+    // touched by the side that holds it, so values can be any type, and copies handed back
+    // keep their old contents, allocations included.
+    template<typename T>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer() :
+            m_write(0),
+            m_middle(1),
+            m_read(2)
+        {
+        }
+
+        TripleBuffer(TripleBuffer const&) = delete;
+        TripleBuffer& operator= (TripleBuffer const&) = delete;
+
+        // Writer: the copy to fill, then Publish it.
+        T& GetWriteBuffer()                 { return m_buffers[m_write]; }
+
+        void Publish()
+        {
+            // Release makes the writes visible to the reader's exchange; acquire orders the
+            // reader's last use of the copy handed back before the writer reuses it.
+            m_write = m_middle.exchange(m_write | Fresh, std::memory_order_acq_rel) & IndexMask;
+        }
+
+        // Reader: takes the latest published copy if there is a newer one than it holds.
+        // Returns whether it did; either way GetReadBuffer is the newest the reader has.
+        bool Acquire()
+        {
+            if ((m_middle.load(std::memory_order_relaxed) & Fresh) == 0)
+                return false;
+
+            m_read = m_middle.exchange(m_read, std::memory_order_acq_rel) & IndexMask;
+            return true;
+        }
+
+        T& GetReadBuffer()                  { return m_buffers[m_read]; }
+        const T& GetReadBuffer() const      { return m_buffers[m_read]; }
+
+    private:
+        // The middle holds a copy's index and whether it was published since the reader last
+        // took one.
+        static const uint32_t IndexMask = 3;
+        static const uint32_t Fresh = 4;
+
+        T                       m_buffers[3];
+        uint32_t                m_write;
+        std::atomic<uint32_t>   m_middle;
+        uint32_t                m_read;
+    };
+}
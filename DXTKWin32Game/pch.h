@@ -5,6 +5,17 @@
 
 #pragma once
 
+#ifdef DX_PORTABLE_TESTS
+
+// The portable tests (see Tests/CMakeLists.txt) build the platform-independent sources with
+// only the standard library.
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
+#else
+
 #include <WinSDKVer.h>
 #define _WIN32_WINNT 0x0600
 #include <SDKDDKVer.h>
@@ -28,10 +39,12 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#include <mmsystem.h>
 
 #include <wrl/client.h>
 
 #include <d3d11_1.h>
+#include <dxgi1_5.h>
 #include <DirectXMath.h>
 #include <DirectXColors.h>
 
@@ -68,4 +81,6 @@ namespace DX
             throw std::exception();
         }
     }
-}
\ No newline at end of file
+}
+
+#endif
\ No newline at end of file
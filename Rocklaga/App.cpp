@@ -1,7 +1,9 @@
 ﻿#include "pch.h"
 #include "App.h"
+#include "Common\DirectXHelper.h"
 
 #include <ppltasks.h>
+#include <thread>
 
 using namespace Rocklaga;
 
@@ -15,21 +17,116 @@ using namespace Windows::System;
 using namespace Windows::Foundation;
 using namespace Windows::Graphics::Display;
 
-// The main function is only used to initialize our IFrameworkView class.
+namespace
+{
+	// Frames rendered by a headless run, at a fixed 60 Hz pace so asynchronous loading has
+	// finished well before the last frame is measured. The last second is profiled.
+	static const uint32 HeadlessFrameCount = 300;
+	static const uint32 HeadlessProfiledFrameCount = 60;
+	static const std::chrono::milliseconds HeadlessFrameInterval(16);
+
+	// Renders on the null device without a window, then writes the device statistics to the
+	// debugger and to HeadlessStatistics.txt in the app's local folder, and a trace of the
+	// profiled frames to HeadlessTrace.json. Given an input log from the local folder, as
+	// written by -record, the run first replays it and renders the state it ends in.
+	int RunHeadless(Platform::String^ replayFile)
+	{
+		auto deviceResources = std::make_shared<DX::DeviceResources>(DX::DeviceType::Null);
+		deviceResources->SetHeadless(Size(1280.0f, 720.0f));
+
+		RocklagaMain main(deviceResources);
+		main.CreateWindowSizeDependentResources();
+
+		if (replayFile != nullptr)
+		{
+			std::vector<byte> data = DX::ReadLocalDataAsync(replayFile->Data()).get();
+
+			DX::InputLog log;
+			if (!log.Deserialize(data.data(), data.size()) || !main.Replay(log))
+			{
+				OutputDebugStringW(L"Not a valid input log: ");
+				OutputDebugStringW(replayFile->Data());
+				OutputDebugStringW(L"\n");
+				return 1;
+			}
+		}
+
+		for (uint32 frame = 0; frame < HeadlessFrameCount; frame++)
+		{
+			if (frame == HeadlessFrameCount - HeadlessProfiledFrameCount)
+			{
+				main.StartProfileCapture();
+			}
+
+			main.Update();
+
+			if (main.Render())
+			{
+				deviceResources->Present();
+			}
+
+			std::this_thread::sleep_for(HeadlessFrameInterval);
+		}
+
+		std::string report = deviceResources->GetStatistics()->Format();
+		OutputDebugStringA(report.c_str());
+		DX::WriteLocalDataAsync(L"HeadlessStatistics.txt", std::vector<byte>(report.begin(), report.end())).wait();
+
+		std::string trace = main.StopProfileCapture();
+		DX::WriteLocalDataAsync(L"HeadlessTrace.json", std::vector<byte>(trace.begin(), trace.end())).wait();
+		return 0;
+	}
+}
+
+// The main function is only used to initialize our IFrameworkView class, or to run headless
+// when started with -headless or -replay <file>. -record <file> records the input of a
+// windowed run to the app's local folder.
 [Platform::MTAThread]
-int main(Platform::Array<Platform::String^>^)
+int main(Platform::Array<Platform::String^>^ args)
 {
-	auto direct3DApplicationSource = ref new Direct3DApplicationSource();
+	bool headless = false;
+	Platform::String^ replayFile = nullptr;
+	Platform::String^ recordFile = nullptr;
+
+	for (unsigned int i = 0; i < args->Length; i++)
+	{
+		if (Platform::String::CompareOrdinal(args[i], L"-headless") == 0)
+		{
+			headless = true;
+		}
+		else if (Platform::String::CompareOrdinal(args[i], L"-replay") == 0 && i + 1 < args->Length)
+		{
+			replayFile = args[++i];
+			headless = true;
+		}
+		else if (Platform::String::CompareOrdinal(args[i], L"-record") == 0 && i + 1 < args->Length)
+		{
+			recordFile = args[++i];
+		}
+	}
+
+	if (headless)
+	{
+		return RunHeadless(replayFile);
+	}
+
+	auto direct3DApplicationSource = ref new Direct3DApplicationSource(recordFile);
 	CoreApplication::Run(direct3DApplicationSource);
 	return 0;
 }
 
+Direct3DApplicationSource::Direct3DApplicationSource(Platform::String^ recordFile) :
+	m_recordFile(recordFile)
+{
+}
+
 IFrameworkView^ Direct3DApplicationSource::CreateView()
 {
-	return ref new App();
+	return ref new App(m_recordFile);
 }
 
-App::App() :
+App::App(Platform::String^ recordFile) :
+	m_recordFile(recordFile),
 	m_windowClosed(false),
 	m_windowVisible(true)
 {
@@ -66,6 +163,15 @@ void App::SetWindow(CoreWindow^ window)
 	window->Closed += 
 		ref new TypedEventHandler<CoreWindow^, CoreWindowEventArgs^>(this, &App::OnWindowClosed);
 
+	window->PointerPressed +=
+		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerPressed);
+
+	window->PointerMoved +=
+		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerMoved);
+
+	window->PointerReleased +=
+		ref new TypedEventHandler<CoreWindow^, PointerEventArgs^>(this, &App::OnPointerReleased);
+
 	DisplayInformation^ currentDisplayInformation = DisplayInformation::GetForCurrentView();
 
 	currentDisplayInformation->DpiChanged +=
@@ -86,6 +192,11 @@ void App::Load(Platform::String^ entryPoint)
 	if (m_main == nullptr)
 	{
 		m_main = std::unique_ptr<RocklagaMain>(new RocklagaMain(m_deviceResources));
+
+		if (m_recordFile != nullptr)
+		{
+			m_main->StartRecording();
+		}
 	}
 }
 
@@ -135,11 +246,21 @@ void App::OnSuspending(Platform::Object^ sender, SuspendingEventArgs^ args)
 	// the app will be forced to exit.
 	SuspendingDeferral^ deferral = args->SuspendingOperation->GetDeferral();
 
-	create_task([this, deferral]()
+	// A recording ends when the app is suspended, which includes it being closed.
+	std::vector<byte> recording;
+	if (m_main->IsRecording())
+	{
+		recording = m_main->StopRecording().Serialize();
+	}
+
+	create_task([this, deferral, recording]()
 	{
         m_deviceResources->Trim();
 
-		// Insert your code here.
+		if (!recording.empty())
+		{
+			DX::WriteLocalDataAsync(m_recordFile->Data(), recording).wait();
+		}
 
 		deferral->Complete();
 	});
@@ -172,6 +293,30 @@ void App::OnWindowClosed(CoreWindow^ sender, CoreWindowEventArgs^ args)
 	m_windowClosed = true;
 }
 
+// Pointer event handlers. Positions are converted from DIPs to the pixels the scene works in.
+
+void App::OnPointerPressed(CoreWindow^ sender, PointerEventArgs^ args)
+{
+	m_main->StartTracking();
+}
+
+void App::OnPointerMoved(CoreWindow^ sender, PointerEventArgs^ args)
+{
+	// Only moves while pressed affect the scene; skipping the rest keeps input recordings small.
+	if (!args->CurrentPoint->IsInContact)
+	{
+		return;
+	}
+
+	float positionX = DX::ConvertDipsToPixels(args->CurrentPoint->Position.X, m_deviceResources->GetDpi());
+	m_main->TrackingUpdate(positionX);
+}
+
+void App::OnPointerReleased(CoreWindow^ sender, PointerEventArgs^ args)
+{
+	m_main->StopTracking();
+}
+
 // DisplayInformation event handlers.
 
 void App::OnDpiChanged(DisplayInformation^ sender, Object^ args)
@@ -0,0 +1,238 @@
+﻿#include "pch.h"
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include "Hash.h"
+#include "Lz4.h"
+
+using namespace DX;
+
+namespace
+{
+	// File layout: ArchiveHeader, asset blobs each starting on a multiple of the alignment, then
+	// entryCount AssetArchiveEntry records. Structures are copied as-is, so the format is
+	// little-endian like every platform we ship on.
+	static const uint32_t ArchiveMagic = 0x52414B52; // "RKAR"
+	static const uint32_t ArchiveVersion = 1;
+
+	struct ArchiveHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t alignment;
+		uint32_t entryCount;
+		uint64_t tocOffset;
+		uint64_t reserved;
+	};
+
+	static_assert(sizeof(ArchiveHeader) == 32, "ArchiveHeader must not contain padding");
+	static_assert(sizeof(AssetArchiveEntry) == 40, "AssetArchiveEntry must not contain padding");
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+AssetArchive::AssetArchive() :
+	m_data(nullptr),
+	m_size(0),
+	m_entries(nullptr),
+	m_entryCount(0)
+{
+}
+
+bool AssetArchive::Open(const uint8_t* data, size_t size)
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_entries = nullptr;
+	m_entryCount = 0;
+
+	ArchiveHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (header.magic != ArchiveMagic || header.version != ArchiveVersion)
+	{
+		return false;
+	}
+
+	// The table is read in place, so it must be aligned for its 64-bit fields.
+	uint64_t tocSize = static_cast<uint64_t>(header.entryCount) * sizeof(AssetArchiveEntry);
+	if (header.tocOffset > size || tocSize > size - header.tocOffset || header.tocOffset % alignof(AssetArchiveEntry) != 0)
+	{
+		return false;
+	}
+
+	const AssetArchiveEntry* entries = reinterpret_cast<const AssetArchiveEntry*>(data + header.tocOffset);
+	for (uint32_t i = 0; i < header.entryCount; i++)
+	{
+		const AssetArchiveEntry& entry = entries[i];
+		if (entry.offset > header.tocOffset || entry.storedSize > header.tocOffset - entry.offset)
+		{
+			return false;
+		}
+		if ((entry.flags & AssetCompressedLz4) == 0 && entry.storedSize != entry.size)
+		{
+			return false;
+		}
+		if (i > 0 && entries[i - 1].nameHash >= entry.nameHash)
+		{
+			return false;
+		}
+	}
+
+	m_data = data;
+	m_size = size;
+	m_entries = entries;
+	m_entryCount = header.entryCount;
+	return true;
+}
+
+const AssetArchiveEntry* AssetArchive::Find(const std::wstring& name) const
+{
+	return Find(HashName(name));
+}
+
+const AssetArchiveEntry* AssetArchive::Find(uint64_t nameHash) const
+{
+	const AssetArchiveEntry* end = m_entries + m_entryCount;
+	const AssetArchiveEntry* entry = std::lower_bound(m_entries, end, nameHash, [](const AssetArchiveEntry& a, uint64_t hash)
+	{
+		return a.nameHash < hash;
+	});
+
+	return (entry != end && entry->nameHash == nameHash) ? entry : nullptr;
+}
+
+bool AssetArchive::GetView(const AssetArchiveEntry& entry, AssetSpan& view) const
+{
+	if ((entry.flags & AssetCompressedLz4) != 0)
+	{
+		return false;
+	}
+
+	view.data = m_data + entry.offset;
+	view.size = static_cast<size_t>(entry.size);
+	return true;
+}
+
+bool AssetArchive::Read(const AssetArchiveEntry& entry, std::vector<uint8_t>& out) const
+{
+	const uint8_t* stored = m_data + entry.offset;
+
+	if ((entry.flags & AssetCompressedLz4) == 0)
+	{
+		out.assign(stored, stored + entry.size);
+		return true;
+	}
+
+	out.resize(static_cast<size_t>(entry.size));
+	return Lz4Decompress(stored, static_cast<size_t>(entry.storedSize), out.data(), out.size());
+}
+
+uint64_t AssetArchive::HashName(const std::wstring& name)
+{
+	uint64_t hash = HashSeed;
+	for (wchar_t c : name)
+	{
+		hash = HashValue(static_cast<uint16_t>(c), hash);
+	}
+	return hash;
+}
+
+AssetArchiveBuilder::AssetArchiveBuilder(uint32_t alignment) :
+	m_alignment(alignment)
+{
+}
+
+void AssetArchiveBuilder::Add(const std::wstring& name, const uint8_t* data, size_t size, bool compress)
+{
+	PendingAsset asset;
+	asset.nameHash = AssetArchive::HashName(name);
+	asset.size = size;
+	asset.flags = 0;
+
+	if (compress)
+	{
+		asset.data.resize(Lz4CompressBound(size));
+		size_t compressedSize = Lz4Compress(data, size, asset.data.data());
+		if (compressedSize < size - size / 8)
+		{
+			asset.data.resize(compressedSize);
+			asset.flags = AssetCompressedLz4;
+		}
+	}
+
+	if (asset.flags == 0)
+	{
+		asset.data.assign(data, data + size);
+	}
+
+	m_assets.push_back(std::move(asset));
+}
+
+bool AssetArchiveBuilder::Build(std::vector<uint8_t>& out) const
+{
+	std::vector<AssetArchiveEntry> entries(m_assets.size());
+
+	// Blobs keep the order they were added in, so assets loaded together stay together on disk.
+	uint64_t offset = AlignUp(sizeof(ArchiveHeader), m_alignment);
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		AssetArchiveEntry& entry = entries[i];
+		entry.nameHash = m_assets[i].nameHash;
+		entry.offset = offset;
+		entry.storedSize = m_assets[i].data.size();
+		entry.size = m_assets[i].size;
+		entry.flags = m_assets[i].flags;
+		entry.reserved = 0;
+
+		offset = AlignUp(offset + entry.storedSize, m_alignment);
+	}
+
+	uint64_t tocOffset = AlignUp(offset, alignof(AssetArchiveEntry));
+
+	out.assign(static_cast<size_t>(tocOffset + entries.size() * sizeof(AssetArchiveEntry)), 0);
+	for (size_t i = 0; i < m_assets.size(); i++)
+	{
+		if (!m_assets[i].data.empty())
+		{
+			memcpy(&out[static_cast<size_t>(entries[i].offset)], m_assets[i].data.data(), m_assets[i].data.size());
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const AssetArchiveEntry& a, const AssetArchiveEntry& b)
+	{
+		return a.nameHash < b.nameHash;
+	});
+
+	for (size_t i = 1; i < entries.size(); i++)
+	{
+		if (entries[i - 1].nameHash == entries[i].nameHash)
+		{
+			out.clear();
+			return false;
+		}
+	}
+
+	if (!entries.empty())
+	{
+		memcpy(&out[static_cast<size_t>(tocOffset)], entries.data(), entries.size() * sizeof(AssetArchiveEntry));
+	}
+
+	ArchiveHeader header = {};
+	header.magic = ArchiveMagic;
+	header.version = ArchiveVersion;
+	header.alignment = m_alignment;
+	header.entryCount = static_cast<uint32_t>(entries.size());
+	header.tocOffset = tocOffset;
+	memcpy(out.data(), &header, sizeof(header));
+
+	return true;
+}
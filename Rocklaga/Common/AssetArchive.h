@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// A view of bytes owned by something else, such as a mapped archive.
+	struct AssetSpan
+	{
+		const uint8_t*	data;
+		size_t			size;
+	};
+
+	// Table of contents record for one asset.
+	struct AssetArchiveEntry
+	{
+		uint64_t	nameHash;
+		uint64_t	offset;			// From the start of the archive. Always a multiple of the archive alignment.
+		uint64_t	storedSize;		// Bytes in the archive.
+		uint64_t	size;			// Bytes once decompressed.
+		uint32_t	flags;
+		uint32_t	reserved;
+	};
+
+	static const uint32_t AssetCompressedLz4 = 0x1;
+
+	// Reads a packed archive: a header, aligned asset blobs, then a table of contents sorted by
+	// name hash. The archive is read in place, so when it is memory-mapped uncompressed assets
+	// are handed out without copying.
+	class AssetArchive
+	{
+	public:
+		AssetArchive();
+
+		// Validates the header and table of contents. data must outlive the archive.
+		bool Open(const uint8_t* data, size_t size);
+
+		// Returns nullptr if the archive has no such asset.
+		const AssetArchiveEntry* Find(const std::wstring& name) const;
+		const AssetArchiveEntry* Find(uint64_t nameHash) const;
+
+		// Returns the asset's bytes in the archive. Only valid for uncompressed assets.
+		bool GetView(const AssetArchiveEntry& entry, AssetSpan& view) const;
+
+		// Copies out the asset, decompressing it if needed. Returns false if the data is corrupt.
+		bool Read(const AssetArchiveEntry& entry, std::vector<uint8_t>& out) const;
+
+		size_t GetEntryCount() const	{ return m_entryCount; }
+
+		// Names hash as UTF-16 so archives built on any platform match the names used at run time.
+		static uint64_t HashName(const std::wstring& name);
+
+	private:
+		const uint8_t*				m_data;
+		size_t						m_size;
+		const AssetArchiveEntry*	m_entries;
+		size_t						m_entryCount;
+	};
+
+	// Collects assets and writes them out in the AssetArchive format.
+	class AssetArchiveBuilder
+	{
+	public:
+		// Asset blobs start on multiples of alignment, which must be a power of two.
+		AssetArchiveBuilder(uint32_t alignment = 16);
+
+		// Compressed assets are stored with LZ4, unless that would save less than an eighth of their size.
+		void Add(const std::wstring& name, const uint8_t* data, size_t size, bool compress);
+
+		// Returns false if two asset names hash to the same value.
+		bool Build(std::vector<uint8_t>& out) const;
+
+	private:
+		struct PendingAsset
+		{
+			uint64_t				nameHash;
+			uint64_t				size;
+			uint32_t				flags;
+			std::vector<uint8_t>	data;
+		};
+
+		uint32_t					m_alignment;
+		std::vector<PendingAsset>	m_assets;
+	};
+}
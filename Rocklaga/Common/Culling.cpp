@@ -0,0 +1,270 @@
+﻿#include "pch.h"
+#include "Culling.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace DX;
+using namespace DirectX;
+
+Frustum::Frustum()
+{
+	for (size_t i = 0; i < PlaneCount; i++)
+	{
+		m_planes[i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+void Frustum::SetFromViewProjection(FXMMATRIX viewProjection)
+{
+	// With row vectors, clip = v * M, so each clip coordinate is v dotted with a column of M.
+	// The rows of the transpose are those columns.
+	XMMATRIX columns = XMMatrixTranspose(viewProjection);
+
+	XMVECTOR planes[PlaneCount] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),		// Left:   -w <= x
+		XMVectorSubtract(columns.r[3], columns.r[0]),	// Right:   x <= w
+		XMVectorAdd(columns.r[3], columns.r[1]),		// Bottom: -w <= y
+		XMVectorSubtract(columns.r[3], columns.r[1]),	// Top:     y <= w
+		columns.r[2],									// Near:    0 <= z
+		XMVectorSubtract(columns.r[3], columns.r[2]),	// Far:     z <= w
+	};
+
+	for (size_t i = 0; i < PlaneCount; i++)
+	{
+		XMStoreFloat4(&m_planes[i], XMPlaneNormalize(planes[i]));
+	}
+}
+
+CullingBvh::CullingBvh() :
+	m_objectCount(0)
+{
+}
+
+void CullingBvh::Build(const std::vector<XMFLOAT4>& spheres)
+{
+	m_nodes.clear();
+	m_centerX.clear();
+	m_centerY.clear();
+	m_centerZ.clear();
+	m_radius.clear();
+	m_objectIndex.clear();
+	m_objectCount = spheres.size();
+
+	if (spheres.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> objects(spheres.size());
+	for (size_t i = 0; i < objects.size(); i++)
+	{
+		objects[i] = static_cast<uint32_t>(i);
+	}
+
+	// A balanced binary tree over n objects has fewer than 2n / LeafSize nodes.
+	m_nodes.reserve(2 * (spheres.size() / LeafSize + 1));
+	BuildNode(objects, 0, objects.size(), spheres);
+}
+
+// Splits the objects at the median of the longest axis of their centers, until they fit in one leaf.
+uint32_t CullingBvh::BuildNode(std::vector<uint32_t>& objects, size_t begin, size_t end, const std::vector<XMFLOAT4>& spheres)
+{
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+	XMVECTOR centerMin = boundsMin;
+	XMVECTOR centerMax = boundsMax;
+
+	for (size_t i = begin; i < end; i++)
+	{
+		XMVECTOR sphere = XMLoadFloat4(&spheres[objects[i]]);
+		XMVECTOR radius = XMVectorSplatW(sphere);
+		boundsMin = XMVectorMin(boundsMin, XMVectorSubtract(sphere, radius));
+		boundsMax = XMVectorMax(boundsMax, XMVectorAdd(sphere, radius));
+		centerMin = XMVectorMin(centerMin, sphere);
+		centerMax = XMVectorMax(centerMax, sphere);
+	}
+
+	uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+	Node node = {};
+	XMStoreFloat3(&node.boundsMin, boundsMin);
+	XMStoreFloat3(&node.boundsMax, boundsMax);
+	node.firstGroup = static_cast<uint32_t>(m_objectIndex.size() / LeafSize);
+	m_nodes.push_back(node);
+
+	if (end - begin <= LeafSize)
+	{
+		for (size_t slot = 0; slot < LeafSize; slot++)
+		{
+			if (begin + slot < end)
+			{
+				const XMFLOAT4& sphere = spheres[objects[begin + slot]];
+				m_centerX.push_back(sphere.x);
+				m_centerY.push_back(sphere.y);
+				m_centerZ.push_back(sphere.z);
+				m_radius.push_back(sphere.w);
+				m_objectIndex.push_back(objects[begin + slot]);
+			}
+			else
+			{
+				// Unused slots can never pass the plane test.
+				m_centerX.push_back(0.0f);
+				m_centerY.push_back(0.0f);
+				m_centerZ.push_back(0.0f);
+				m_radius.push_back(-FLT_MAX);
+				m_objectIndex.push_back(UINT32_MAX);
+			}
+		}
+
+		m_nodes[nodeIndex].groupCount = 1;
+		return nodeIndex;
+	}
+
+	XMFLOAT3 extent;
+	XMStoreFloat3(&extent, XMVectorSubtract(centerMax, centerMin));
+
+	size_t axis = 0;
+	if (extent.y > extent.x && extent.y >= extent.z)
+	{
+		axis = 1;
+	}
+	else if (extent.z > extent.x && extent.z > extent.y)
+	{
+		axis = 2;
+	}
+
+	size_t middle = begin + (end - begin) / 2;
+	std::nth_element(objects.begin() + begin, objects.begin() + middle, objects.begin() + end, [&spheres, axis](uint32_t a, uint32_t b)
+	{
+		return (&spheres[a].x)[axis] < (&spheres[b].x)[axis];
+	});
+
+	BuildNode(objects, begin, middle, spheres);
+	uint32_t right = BuildNode(objects, middle, end, spheres);
+
+	m_nodes[nodeIndex].right = right;
+	m_nodes[nodeIndex].groupCount = static_cast<uint32_t>(m_objectIndex.size() / LeafSize) - m_nodes[nodeIndex].firstGroup;
+	return nodeIndex;
+}
+
+void CullingBvh::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	// Transpose the planes so node bounds are tested against four planes at once. The last two
+	// lanes of the second group hold a plane that everything is in front of.
+	XMVECTOR planeX[2], planeY[2], planeZ[2], planeW[2];
+	for (size_t group = 0; group < 2; group++)
+	{
+		XMFLOAT4 lanes[4];
+		for (size_t lane = 0; lane < 4; lane++)
+		{
+			size_t index = group * 4 + lane;
+			lanes[lane] = index < Frustum::PlaneCount ? frustum.GetPlane(index) : XMFLOAT4(0.0f, 0.0f, 0.0f, FLT_MAX);
+		}
+
+		planeX[group] = XMVectorSet(lanes[0].x, lanes[1].x, lanes[2].x, lanes[3].x);
+		planeY[group] = XMVectorSet(lanes[0].y, lanes[1].y, lanes[2].y, lanes[3].y);
+		planeZ[group] = XMVectorSet(lanes[0].z, lanes[1].z, lanes[2].z, lanes[3].z);
+		planeW[group] = XMVectorSet(lanes[0].w, lanes[1].w, lanes[2].w, lanes[3].w);
+	}
+
+	uint32_t stack[64];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		uint32_t nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+
+		// Test the box as a center and half extents: its distance from a plane, plus or minus the
+		// extents projected onto the plane normal, gives the nearest and farthest corners.
+		XMVECTOR boundsMin = XMLoadFloat3(&node.boundsMin);
+		XMVECTOR boundsMax = XMLoadFloat3(&node.boundsMax);
+		XMVECTOR center = XMVectorMultiply(XMVectorAdd(boundsMin, boundsMax), g_XMOneHalf);
+		XMVECTOR extents = XMVectorMultiply(XMVectorSubtract(boundsMax, boundsMin), g_XMOneHalf);
+
+		bool outside = false;
+		bool inside = true;
+		for (size_t group = 0; group < 2; group++)
+		{
+			XMVECTOR distance = XMVectorMultiplyAdd(planeX[group], XMVectorSplatX(center), planeW[group]);
+			distance = XMVectorMultiplyAdd(planeY[group], XMVectorSplatY(center), distance);
+			distance = XMVectorMultiplyAdd(planeZ[group], XMVectorSplatZ(center), distance);
+
+			XMVECTOR radius = XMVectorMultiply(XMVectorAbs(planeX[group]), XMVectorSplatX(extents));
+			radius = XMVectorMultiplyAdd(XMVectorAbs(planeY[group]), XMVectorSplatY(extents), radius);
+			radius = XMVectorMultiplyAdd(XMVectorAbs(planeZ[group]), XMVectorSplatZ(extents), radius);
+
+			outside = outside || !XMVector4GreaterOrEqual(XMVectorAdd(distance, radius), XMVectorZero());
+			inside = inside && XMVector4GreaterOrEqual(XMVectorSubtract(distance, radius), XMVectorZero());
+		}
+
+		if (outside)
+		{
+			continue;
+		}
+
+		if (inside)
+		{
+			AddSubtree(node, visible);
+			continue;
+		}
+
+		if (node.right == 0)
+		{
+			// Partially visible leaf: test its four spheres against every plane at once.
+			size_t slot = node.firstGroup * LeafSize;
+			XMVECTOR centerX = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_centerX[slot]));
+			XMVECTOR centerY = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_centerY[slot]));
+			XMVECTOR centerZ = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_centerZ[slot]));
+			XMVECTOR negativeRadius = XMVectorNegate(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&m_radius[slot])));
+
+			XMVECTOR visibleMask = XMVectorTrueInt();
+			for (size_t i = 0; i < Frustum::PlaneCount; i++)
+			{
+				const XMFLOAT4& plane = frustum.GetPlane(i);
+				XMVECTOR distance = XMVectorMultiplyAdd(XMVectorReplicate(plane.x), centerX, XMVectorReplicate(plane.w));
+				distance = XMVectorMultiplyAdd(XMVectorReplicate(plane.y), centerY, distance);
+				distance = XMVectorMultiplyAdd(XMVectorReplicate(plane.z), centerZ, distance);
+				visibleMask = XMVectorAndInt(visibleMask, XMVectorGreater(distance, negativeRadius));
+			}
+
+			XMUINT4 lanes;
+			XMStoreUInt4(&lanes, visibleMask);
+			const uint32_t* laneMasks = &lanes.x;
+			for (size_t lane = 0; lane < LeafSize; lane++)
+			{
+				if (laneMasks[lane] != 0)
+				{
+					visible.push_back(m_objectIndex[slot + lane]);
+				}
+			}
+		}
+		else
+		{
+			stack[stackSize++] = node.right;
+			stack[stackSize++] = nodeIndex + 1;
+		}
+	}
+}
+
+// Adds every object under a node that is entirely inside the frustum.
+void CullingBvh::AddSubtree(const Node& node, std::vector<uint32_t>& visible) const
+{
+	size_t begin = node.firstGroup * LeafSize;
+	size_t end = (node.firstGroup + node.groupCount) * LeafSize;
+	for (size_t slot = begin; slot < end; slot++)
+	{
+		if (m_objectIndex[slot] != UINT32_MAX)
+		{
+			visible.push_back(m_objectIndex[slot]);
+		}
+	}
+}
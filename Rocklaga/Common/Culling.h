@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+namespace DX
+{
+	// The six planes of a view frustum, with normals pointing inwards.
+	class Frustum
+	{
+	public:
+		Frustum();
+
+		// Extracts the planes from a combined view * projection matrix (row vector convention,
+		// with clip-space depth in [0, 1] as produced by the XMMatrixPerspective functions).
+		void SetFromViewProjection(DirectX::FXMMATRIX viewProjection);
+
+		const DirectX::XMFLOAT4& GetPlane(size_t index) const { return m_planes[index]; }
+
+		static const size_t PlaneCount = 6;
+
+	private:
+		DirectX::XMFLOAT4 m_planes[PlaneCount];
+	};
+
+	// A bounding volume hierarchy over object bounding spheres. Every leaf holds up to four
+	// objects laid out so a single SIMD pass tests all of them against each frustum plane,
+	// and subtrees entirely inside the frustum are accepted without testing their objects.
+	class CullingBvh
+	{
+	public:
+		CullingBvh();
+
+		// Builds the hierarchy. Each sphere is (center.x, center.y, center.z, radius), and
+		// object indices in the visible list refer to positions in this array.
+		void Build(const std::vector<DirectX::XMFLOAT4>& spheres);
+
+		// Replaces the visible list with the indices of every object that intersects the frustum.
+		void Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+		size_t GetObjectCount() const { return m_objectCount; }
+
+	private:
+		static const uint32_t LeafSize = 4;
+
+		// Nodes are stored depth first, so an interior node's left child always follows it and
+		// the leaf groups under any node are contiguous.
+		struct Node
+		{
+			DirectX::XMFLOAT3	boundsMin;
+			uint32_t			right;		// Index of the right child, or 0 for leaves.
+			DirectX::XMFLOAT3	boundsMax;
+			uint32_t			firstGroup;	// Range of leaf groups in this subtree.
+			uint32_t			groupCount;
+		};
+
+		uint32_t BuildNode(std::vector<uint32_t>& objects, size_t begin, size_t end, const std::vector<DirectX::XMFLOAT4>& spheres);
+		void AddSubtree(const Node& node, std::vector<uint32_t>& visible) const;
+
+		std::vector<Node>		m_nodes;
+
+		// Leaf objects in groups of four, structure-of-arrays. Unused slots have a huge negative radius.
+		std::vector<float>		m_centerX;
+		std::vector<float>		m_centerY;
+		std::vector<float>		m_centerZ;
+		std::vector<float>		m_radius;
+		std::vector<uint32_t>	m_objectIndex;	// UINT32_MAX for unused slots.
+
+		size_t					m_objectCount;
+	};
+}
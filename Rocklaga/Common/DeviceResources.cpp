@@ -1,6 +1,7 @@
 ﻿#include "pch.h"
 #include "DeviceResources.h"
 #include "DirectXHelper.h"
+#include "Profiler.h"
 
 using namespace D2D1;
 using namespace DirectX;
@@ -64,9 +65,20 @@ namespace ScreenRotation
 		);
 };
 
+namespace
+{
+	// Transient render data allowed per frame before the frame arena falls back to the heap.
+	static const size_t FrameArenaBytes = 1024 * 1024;
+}
+
 // Constructor for DeviceResources.
-DX::DeviceResources::DeviceResources() :
+DX::DeviceResources::DeviceResources(DeviceType deviceType) :
 	m_screenViewport(),
+	m_offscreenTargetBytes(0),
+	m_depthStencilBytes(0),
+	m_deviceType(deviceType),
+	m_frameArena(FrameArenaBytes),
+	m_lastDeviceRestoreSeconds(0.0),
 	m_d3dFeatureLevel(D3D_FEATURE_LEVEL_9_1),
 	m_d3dRenderTargetSize(),
 	m_outputSize(),
@@ -159,9 +171,14 @@ void DX::DeviceResources::CreateDeviceResources()
 	ComPtr<ID3D11Device> device;
 	ComPtr<ID3D11DeviceContext> context;
 
+	// Everything created on the previous device is gone.
+	m_statistics.ResetResources();
+	m_offscreenTargetBytes = 0;
+	m_depthStencilBytes = 0;
+
 	HRESULT hr = D3D11CreateDevice(
 		nullptr,					// Specify nullptr to use the default adapter.
-		D3D_DRIVER_TYPE_HARDWARE,	// Create a device using the hardware graphics driver.
+		IsHeadless() ? D3D_DRIVER_TYPE_NULL : D3D_DRIVER_TYPE_HARDWARE,	// Use the hardware graphics driver, or the null driver when headless.
 		0,							// Should be 0 unless the driver is D3D_DRIVER_TYPE_SOFTWARE.
 		creationFlags,				// Set debug and Direct2D compatibility flags.
 		featureLevels,				// List of feature levels this app can support.
@@ -172,7 +189,7 @@ void DX::DeviceResources::CreateDeviceResources()
 		&context					// Returns the device immediate context.
 		);
 
-	if (FAILED(hr))
+	if (FAILED(hr) && !IsHeadless())
 	{
 		// If the initialization fails, fall back to the WARP device.
 		// For more information on WARP, see: 
@@ -192,6 +209,10 @@ void DX::DeviceResources::CreateDeviceResources()
 				)
 			);
 	}
+	else
+	{
+		DX::ThrowIfFailed(hr);
+	}
 
 	// Store pointers to the Direct3D 11.3 API device and immediate context.
 	DX::ThrowIfFailed(
@@ -202,22 +223,32 @@ void DX::DeviceResources::CreateDeviceResources()
 		context.As(&m_d3dContext)
 		);
 
-	// Create the Direct2D device object and a corresponding context.
-	ComPtr<IDXGIDevice3> dxgiDevice;
-	DX::ThrowIfFailed(
-		m_d3dDevice.As(&dxgiDevice)
-		);
+	// The null driver can't back Direct2D, so headless devices have no 2D content.
+	if (!IsHeadless())
+	{
+		// Create the Direct2D device object and a corresponding context.
+		ComPtr<IDXGIDevice3> dxgiDevice;
+		DX::ThrowIfFailed(
+			m_d3dDevice.As(&dxgiDevice)
+			);
 
-	DX::ThrowIfFailed(
-		m_d2dFactory->CreateDevice(dxgiDevice.Get(), &m_d2dDevice)
-		);
+		DX::ThrowIfFailed(
+			m_d2dFactory->CreateDevice(dxgiDevice.Get(), &m_d2dDevice)
+			);
 
-	DX::ThrowIfFailed(
-		m_d2dDevice->CreateDeviceContext(
-			D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
-			&m_d2dContext
-			)
-		);
+		DX::ThrowIfFailed(
+			m_d2dDevice->CreateDeviceContext(
+				D2D1_DEVICE_CONTEXT_OPTIONS_NONE,
+				&m_d2dContext
+				)
+			);
+	}
+
+	// Recreate any shaders that were in use before the device was lost.
+	m_shaderCache.CreateDeviceObjects(m_d3dDevice.Get(), &m_statistics);
+
+	// Registered buffers are queued, and recreated by ResourceRegistry::Update over the next frames.
+	m_resourceRegistry.CreateDeviceObjects(m_d3dDevice.Get(), &m_statistics);
 }
 
 // These resources need to be recreated every time the window size is changed.
@@ -227,11 +258,26 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 	ID3D11RenderTargetView* nullViews[] = {nullptr};
 	m_d3dContext->OMSetRenderTargets(ARRAYSIZE(nullViews), nullViews, nullptr);
 	m_d3dRenderTargetView = nullptr;
-	m_d2dContext->SetTarget(nullptr);
+	if (m_d2dContext != nullptr)
+	{
+		m_d2dContext->SetTarget(nullptr);
+	}
 	m_d2dTargetBitmap = nullptr;
 	m_d3dDepthStencilView = nullptr;
 	m_d3dContext->Flush1(D3D11_CONTEXT_TYPE_ALL, nullptr);
 
+	// The views held the last size's textures, which go with them.
+	if (m_offscreenTargetBytes != 0)
+	{
+		m_statistics.ReleaseTexture(m_offscreenTargetBytes);
+		m_offscreenTargetBytes = 0;
+	}
+	if (m_depthStencilBytes != 0)
+	{
+		m_statistics.ReleaseTexture(m_depthStencilBytes);
+		m_depthStencilBytes = 0;
+	}
+
 	UpdateRenderTargetSize();
 
 	// The width and height of the swap chain must be based on the window's
@@ -268,7 +314,7 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 			DX::ThrowIfFailed(hr);
 		}
 	}
-	else
+	else if (!IsHeadless())
 	{
 		// Otherwise, create a new one using the same adapter as the existing Direct3D device.
 		DXGI_SCALING scaling = DisplayMetrics::SupportHighResolutions ? DXGI_SCALING_NONE : DXGI_SCALING_STRETCH;
@@ -362,15 +408,42 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 		throw ref new FailureException();
 	}
 
-	DX::ThrowIfFailed(
-		m_swapChain->SetRotation(displayRotation)
-		);
-
-	// Create a render target view of the swap chain back buffer.
+	// Create a render target view of the swap chain back buffer. Headless devices render to a
+	// texture of the same format instead.
 	ComPtr<ID3D11Texture2D1> backBuffer;
-	DX::ThrowIfFailed(
-		m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer))
-		);
+	if (m_swapChain != nullptr)
+	{
+		DX::ThrowIfFailed(
+			m_swapChain->SetRotation(displayRotation)
+			);
+
+		DX::ThrowIfFailed(
+			m_swapChain->GetBuffer(0, IID_PPV_ARGS(&backBuffer))
+			);
+	}
+	else
+	{
+		CD3D11_TEXTURE2D_DESC1 backBufferDesc(
+			DXGI_FORMAT_B8G8R8A8_UNORM,
+			lround(m_d3dRenderTargetSize.Width),
+			lround(m_d3dRenderTargetSize.Height),
+			1,
+			1,
+			D3D11_BIND_RENDER_TARGET
+			);
+
+		DX::ThrowIfFailed(
+			m_d3dDevice->CreateTexture2D1(
+				&backBufferDesc,
+				nullptr,
+				&backBuffer
+				)
+			);
+
+		// Four bytes per pixel.
+		m_offscreenTargetBytes = 4ull * backBufferDesc.Width * backBufferDesc.Height;
+		m_statistics.RecordTexture(m_offscreenTargetBytes);
+	}
 
 	DX::ThrowIfFailed(
 		m_d3dDevice->CreateRenderTargetView1(
@@ -399,6 +472,10 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 			)
 		);
 
+	// D24_UNORM_S8_UINT is four bytes per pixel.
+	m_depthStencilBytes = 4ull * depthStencilDesc.Width * depthStencilDesc.Height;
+	m_statistics.RecordTexture(m_depthStencilBytes);
+
 	CD3D11_DEPTH_STENCIL_VIEW_DESC depthStencilViewDesc(D3D11_DSV_DIMENSION_TEXTURE2D);
 	DX::ThrowIfFailed(
 		m_d3dDevice->CreateDepthStencilView(
@@ -418,6 +495,11 @@ void DX::DeviceResources::CreateWindowSizeDependentResources()
 
 	m_d3dContext->RSSetViewports(1, &m_screenViewport);
 
+	if (m_d2dContext == nullptr)
+	{
+		return;
+	}
+
 	// Create a Direct2D target bitmap associated with the
 	// swap chain back buffer and set it as the current target.
 	D2D1_BITMAP_PROPERTIES1 bitmapProperties = 
@@ -494,6 +576,17 @@ void DX::DeviceResources::SetWindow(CoreWindow^ window)
 	CreateWindowSizeDependentResources();
 }
 
+// Sets up an offscreen render target for a headless device, in place of SetWindow.
+void DX::DeviceResources::SetHeadless(Windows::Foundation::Size outputSize)
+{
+	m_logicalSize = outputSize;
+	m_nativeOrientation = DisplayOrientations::Landscape;
+	m_currentOrientation = DisplayOrientations::Landscape;
+	m_dpi = 96.0f;
+
+	CreateWindowSizeDependentResources();
+}
+
 // This method is called in the event handler for the SizeChanged event.
 void DX::DeviceResources::SetLogicalSize(Windows::Foundation::Size logicalSize)
 {
@@ -535,6 +628,16 @@ void DX::DeviceResources::ValidateDevice()
 	// The D3D Device is no longer valid if the default adapter changed since the device
 	// was created or if the device has been removed.
 
+	// The null driver has no adapter to change.
+	if (IsHeadless())
+	{
+		if (FAILED(m_d3dDevice->GetDeviceRemovedReason()))
+		{
+			HandleDeviceLost();
+		}
+		return;
+	}
+
 	// First, get the information for the default adapter from when the device was created.
 
 	ComPtr<IDXGIDevice3> dxgiDevice;
@@ -584,6 +687,9 @@ void DX::DeviceResources::ValidateDevice()
 // Recreate all device resources and set them back to the current state.
 void DX::DeviceResources::HandleDeviceLost()
 {
+	CpuScope scope("HandleDeviceLost");
+	uint64_t start = GetProfilerTime();
+
 	m_swapChain = nullptr;
 
 	if (m_deviceNotify != nullptr)
@@ -591,14 +697,22 @@ void DX::DeviceResources::HandleDeviceLost()
 		m_deviceNotify->OnDeviceLost();
 	}
 
+	m_shaderCache.ReleaseDeviceObjects();
+	m_resourceRegistry.ReleaseDeviceObjects();
+
 	CreateDeviceResources();
-	m_d2dContext->SetDpi(m_dpi, m_dpi);
+	if (m_d2dContext != nullptr)
+	{
+		m_d2dContext->SetDpi(m_dpi, m_dpi);
+	}
 	CreateWindowSizeDependentResources();
 
 	if (m_deviceNotify != nullptr)
 	{
 		m_deviceNotify->OnDeviceRestored();
 	}
+
+	m_lastDeviceRestoreSeconds = (GetProfilerTime() - start) * 1e-9;
 }
 
 // Register our DeviceNotify to be informed on device lost and creation.
@@ -623,8 +737,12 @@ void DX::DeviceResources::Present()
 	// The first argument instructs DXGI to block until VSync, putting the application
 	// to sleep until the next VSync. This ensures we don't waste any cycles rendering
 	// frames that will never be displayed to the screen.
+	// Headless devices have no swap chain, but can still be removed.
 	DXGI_PRESENT_PARAMETERS parameters = { 0 };
-	HRESULT hr = m_swapChain->Present1(1, 0, &parameters);
+	HRESULT hr = m_swapChain != nullptr ? m_swapChain->Present1(1, 0, &parameters) : m_d3dDevice->GetDeviceRemovedReason();
+
+	// Everything drawn this frame has been submitted.
+	m_statistics.EndFrame();
 
 	// Discard the contents of the render target.
 	// This is a valid operation only when the existing contents will be entirely
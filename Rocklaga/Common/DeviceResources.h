@@ -1,5 +1,10 @@
 ﻿#pragma once
 
+#include "ShaderCache.h"
+#include "DeviceStatistics.h"
+#include "FrameArena.h"
+#include "ResourceRegistry.h"
+
 namespace DX
 {
 	// Provides an interface for an application that owns DeviceResources to be notified of the device being lost or created.
@@ -9,12 +14,22 @@ namespace DX
 		virtual void OnDeviceRestored() = 0;
 	};
 
+	// Hardware renders to a CoreWindow. Null creates D3D_DRIVER_TYPE_NULL, which accepts every
+	// call but executes nothing, and renders to an offscreen target without Direct2D, so the app
+	// can run headless in automation and report DeviceStatistics.
+	enum class DeviceType
+	{
+		Hardware,
+		Null,
+	};
+
 	// Controls all the DirectX device resources.
 	class DeviceResources
 	{
 	public:
-		DeviceResources();
+		DeviceResources(DeviceType deviceType = DeviceType::Hardware);
 		void SetWindow(Windows::UI::Core::CoreWindow^ window);
+		void SetHeadless(Windows::Foundation::Size outputSize);
 		void SetLogicalSize(Windows::Foundation::Size logicalSize);
 		void SetCurrentOrientation(Windows::Graphics::Display::DisplayOrientations currentOrientation);
 		void SetDpi(float dpi);
@@ -40,6 +55,15 @@ namespace DX
 		ID3D11DepthStencilView*		GetDepthStencilView() const				{ return m_d3dDepthStencilView.Get(); }
 		D3D11_VIEWPORT				GetScreenViewport() const				{ return m_screenViewport; }
 		DirectX::XMFLOAT4X4			GetOrientationTransform3D() const		{ return m_orientationTransform3D; }
+		ShaderCache*				GetShaderCache()						{ return &m_shaderCache; }
+		DeviceStatistics*			GetStatistics()							{ return &m_statistics; }
+		FrameArena*					GetFrameArena()							{ return &m_frameArena; }
+		ResourceRegistry*			GetResourceRegistry()					{ return &m_resourceRegistry; }
+
+		// Seconds the last device loss blocked in HandleDeviceLost. Buffers in the resource
+		// registry are recreated over the following frames.
+		double						GetLastDeviceRestoreSeconds() const		{ return m_lastDeviceRestoreSeconds; }
+		bool						IsHeadless() const						{ return m_deviceType == DeviceType::Null; }
 
 		// D2D Accessors.
 		ID2D1Factory3*				GetD2DFactory() const					{ return m_d2dFactory.Get(); }
@@ -67,6 +91,25 @@ namespace DX
 		Microsoft::WRL::ComPtr<ID3D11DepthStencilView>	m_d3dDepthStencilView;
 		D3D11_VIEWPORT									m_screenViewport;
 
+		// Sizes recorded in m_statistics for the headless target and the depth buffer, released
+		// when they are recreated; 0 when not recorded.
+		uint64_t										m_offscreenTargetBytes;
+		uint64_t										m_depthStencilBytes;
+
+		// Shaders and input layouts shared by all renderers.
+		ShaderCache										m_shaderCache;
+
+		// Buffers recreated from memory after device loss.
+		ResourceRegistry								m_resourceRegistry;
+		double											m_lastDeviceRestoreSeconds;
+
+		// API work counted for the current and last frame.
+		DeviceStatistics								m_statistics;
+		DeviceType										m_deviceType;
+
+		// Scratch memory for render data that only lives for a few frames.
+		FrameArena										m_frameArena;
+
 		// Direct2D drawing components.
 		Microsoft::WRL::ComPtr<ID2D1Factory3>		m_d2dFactory;
 		Microsoft::WRL::ComPtr<ID2D1Device2>		m_d2dDevice;
@@ -0,0 +1,108 @@
+﻿#include "pch.h"
+#include "DeviceStatistics.h"
+
+#include <sstream>
+
+using namespace DX;
+
+DeviceStatistics::DeviceStatistics() :
+	m_drawCalls(0),
+	m_vertices(0),
+	m_bufferUpdates(0),
+	m_bufferUpdateBytes(0),
+	m_buffers(0),
+	m_textures(0),
+	m_shaders(0),
+	m_bufferBytes(0),
+	m_textureBytes(0),
+	m_shaderBytes(0),
+	m_lastFrame(),
+	m_frameCount(0)
+{
+}
+
+void DeviceStatistics::RecordDraw(uint32_t vertexCount, uint32_t instanceCount)
+{
+	m_drawCalls++;
+	m_vertices += static_cast<uint64_t>(vertexCount) * instanceCount;
+}
+
+void DeviceStatistics::RecordBufferUpdate(uint64_t bytes)
+{
+	m_bufferUpdates++;
+	m_bufferUpdateBytes += bytes;
+}
+
+void DeviceStatistics::RecordBuffer(uint64_t bytes)
+{
+	m_buffers++;
+	m_bufferBytes += bytes;
+}
+
+void DeviceStatistics::RecordTexture(uint64_t bytes)
+{
+	m_textures++;
+	m_textureBytes += bytes;
+}
+
+void DeviceStatistics::ReleaseTexture(uint64_t bytes)
+{
+	m_textures--;
+	m_textureBytes -= bytes;
+}
+
+void DeviceStatistics::RecordShader(uint64_t bytes)
+{
+	m_shaders++;
+	m_shaderBytes += bytes;
+}
+
+void DeviceStatistics::EndFrame()
+{
+	m_lastFrame.drawCalls = m_drawCalls.exchange(0);
+	m_lastFrame.vertices = m_vertices.exchange(0);
+	m_lastFrame.bufferUpdates = m_bufferUpdates.exchange(0);
+	m_lastFrame.bufferUpdateBytes = m_bufferUpdateBytes.exchange(0);
+	m_frameCount++;
+}
+
+void DeviceStatistics::ResetResources()
+{
+	m_buffers = 0;
+	m_textures = 0;
+	m_shaders = 0;
+	m_bufferBytes = 0;
+	m_textureBytes = 0;
+	m_shaderBytes = 0;
+}
+
+ResourceStatistics DeviceStatistics::GetResources() const
+{
+	ResourceStatistics resources;
+	resources.buffers = m_buffers;
+	resources.textures = m_textures;
+	resources.shaders = m_shaders;
+	resources.bufferBytes = m_bufferBytes;
+	resources.textureBytes = m_textureBytes;
+	resources.shaderBytes = m_shaderBytes;
+	return resources;
+}
+
+std::string DeviceStatistics::Format() const
+{
+	ResourceStatistics resources = GetResources();
+
+	std::ostringstream out;
+	out << "frames=" << m_frameCount << "\n";
+	out << "draw_calls=" << m_lastFrame.drawCalls << "\n";
+	out << "vertices=" << m_lastFrame.vertices << "\n";
+	out << "buffer_updates=" << m_lastFrame.bufferUpdates << "\n";
+	out << "buffer_update_bytes=" << m_lastFrame.bufferUpdateBytes << "\n";
+	out << "buffers=" << resources.buffers << "\n";
+	out << "buffer_bytes=" << resources.bufferBytes << "\n";
+	out << "textures=" << resources.textures << "\n";
+	out << "texture_bytes=" << resources.textureBytes << "\n";
+	out << "shaders=" << resources.shaders << "\n";
+	out << "shader_bytes=" << resources.shaderBytes << "\n";
+	return out.str();
+}
@@ -0,0 +1,76 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace DX
+{
+	// API work submitted during one frame.
+	struct FrameStatistics
+	{
+		uint32_t	drawCalls;
+		uint64_t	vertices;		// Vertices or indices drawn, times instances.
+		uint32_t	bufferUpdates;
+		uint64_t	bufferUpdateBytes;
+	};
+
+	// Device objects created since the device was, and the memory they were created with.
+	// Renderers only release objects on device loss, so this is also what is alive.
+	struct ResourceStatistics
+	{
+		uint32_t	buffers;
+		uint32_t	textures;
+		uint32_t	shaders;
+		uint64_t	bufferBytes;
+		uint64_t	textureBytes;
+		uint64_t	shaderBytes;
+	};
+
+	// Counts the draws, updates and device objects renderers submit, so frames can be compared
+	// without a GPU. Resources are often created on loading threads, so every counter is atomic.
+	class DeviceStatistics
+	{
+	public:
+		DeviceStatistics();
+
+		void RecordDraw(uint32_t vertexCount, uint32_t instanceCount = 1);
+		void RecordBufferUpdate(uint64_t bytes);
+		void RecordBuffer(uint64_t bytes);
+		void RecordTexture(uint64_t bytes);
+		void RecordShader(uint64_t bytes);
+
+		// For the few textures released while the device lives, such as the size-dependent
+		// targets when the window resizes.
+		void ReleaseTexture(uint64_t bytes);
+
+		// Called once per frame, after the last draw. The frame's counters become GetLastFrame.
+		void EndFrame();
+
+		// Called when the device is recreated, which releases every resource.
+		void ResetResources();
+
+		FrameStatistics GetLastFrame() const		{ return m_lastFrame; }
+		ResourceStatistics GetResources() const;
+		uint64_t GetFrameCount() const				{ return m_frameCount; }
+
+		// One "name=value" pair per line, for build logs and CI metrics.
+		std::string Format() const;
+
+	private:
+		std::atomic<uint32_t>	m_drawCalls;
+		std::atomic<uint64_t>	m_vertices;
+		std::atomic<uint32_t>	m_bufferUpdates;
+		std::atomic<uint64_t>	m_bufferUpdateBytes;
+
+		std::atomic<uint32_t>	m_buffers;
+		std::atomic<uint32_t>	m_textures;
+		std::atomic<uint32_t>	m_shaders;
+		std::atomic<uint64_t>	m_bufferBytes;
+		std::atomic<uint64_t>	m_textureBytes;
+		std::atomic<uint64_t>	m_shaderBytes;
+
+		FrameStatistics			m_lastFrame;
+		uint64_t				m_frameCount;
+	};
+}
@@ -33,6 +33,51 @@ namespace DX
 		});
 	}
 
+	// Function that reads a file from the app's local folder asynchronously.
+	// Returns an empty buffer if the file does not exist, e.g. a cache that has not been written yet.
+	inline Concurrency::task<std::vector<byte>> ReadLocalDataAsync(const std::wstring& filename)
+	{
+		using namespace Windows::Storage;
+		using namespace Concurrency;
+
+		auto folder = ApplicationData::Current->LocalFolder;
+
+		return create_task(folder->TryGetItemAsync(Platform::StringReference(filename.c_str()))).then([] (IStorageItem^ item)
+		{
+			auto file = dynamic_cast<StorageFile^>(item);
+			if (file == nullptr)
+			{
+				return task_from_result(std::vector<byte>());
+			}
+
+			return create_task(FileIO::ReadBufferAsync(file)).then([] (Streams::IBuffer^ fileBuffer) -> std::vector<byte>
+			{
+				std::vector<byte> returnBuffer;
+				returnBuffer.resize(fileBuffer->Length);
+				Streams::DataReader::FromBuffer(fileBuffer)->ReadBytes(Platform::ArrayReference<byte>(returnBuffer.data(), fileBuffer->Length));
+				return returnBuffer;
+			});
+		});
+	}
+
+	// Function that writes a file to the app's local folder asynchronously, replacing any existing file.
+	inline Concurrency::task<void> WriteLocalDataAsync(const std::wstring& filename, const std::vector<byte>& data)
+	{
+		using namespace Windows::Storage;
+		using namespace Concurrency;
+
+		auto folder = ApplicationData::Current->LocalFolder;
+		auto buffer = std::make_shared<std::vector<byte>>(data);
+
+		return create_task(folder->CreateFileAsync(Platform::StringReference(filename.c_str()), CreationCollisionOption::ReplaceExisting)).then([buffer] (StorageFile^ file)
+		{
+			return FileIO::WriteBytesAsync(file, Platform::ArrayReference<byte>(buffer->data(), static_cast<unsigned int>(buffer->size())));
+		}).then([buffer] ()
+		{
+			// Keeps the copied data alive until the write has completed.
+		});
+	}
+
 	// Converts a length in device-independent pixels (DIPs) to a length in physical pixels.
 	inline float ConvertDipsToPixels(float dips, float dpi)
 	{
@@ -0,0 +1,99 @@
+﻿#include "pch.h"
+#include "FrameArena.h"
+
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	// Debug builds fill fresh allocations and reset frames with these, so reads of
+	// uninitialized or expired frame data stand out.
+	static const uint8_t AllocatedPattern = 0xCD;
+	static const uint8_t ExpiredPattern = 0xDD;
+
+	inline uintptr_t AlignUp(uintptr_t address, size_t alignment)
+	{
+		return (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	}
+}
+
+FrameArena::FrameArena(size_t bytesPerFrame) :
+	m_bytesPerFrame(bytesPerFrame),
+	m_current(0),
+	m_frame(0),
+	m_peakUsed(0)
+{
+	for (auto& block : m_frames)
+	{
+		block.memory.reset(new uint8_t[bytesPerFrame]);
+		block.used = 0;
+	}
+}
+
+FrameArena::~FrameArena()
+{
+	for (auto& block : m_frames)
+	{
+		Reset(block);
+	}
+}
+
+void FrameArena::BeginFrame(uint64_t frame)
+{
+	if (frame == m_frame)
+	{
+		return;
+	}
+
+	m_frame = frame;
+	m_current = (m_current + 1) % FrameCount;
+	Reset(m_frames[m_current]);
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	FrameBlock& block = m_frames[m_current];
+
+	uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+	uintptr_t address = AlignUp(base + block.used, alignment);
+	void* result;
+
+	if (address + bytes <= base + m_bytesPerFrame)
+	{
+		block.used = address + bytes - base;
+		if (block.used > m_peakUsed)
+		{
+			m_peakUsed = block.used;
+		}
+		result = reinterpret_cast<void*>(address);
+	}
+	else
+	{
+		// Over-allocate so any alignment can be met; the original pointer is what gets freed.
+		void* memory = ::operator new(bytes + alignment);
+		block.overflow.push_back(memory);
+		result = reinterpret_cast<void*>(AlignUp(reinterpret_cast<uintptr_t>(memory), alignment));
+	}
+
+#if defined(_DEBUG)
+	memset(result, AllocatedPattern, bytes);
+#endif
+
+	return result;
+}
+
+void FrameArena::Reset(FrameBlock& block)
+{
+#if defined(_DEBUG)
+	memset(block.memory.get(), ExpiredPattern, block.used);
+#endif
+
+	block.used = 0;
+
+	for (void* memory : block.overflow)
+	{
+		::operator delete(memory);
+	}
+	block.overflow.clear();
+}
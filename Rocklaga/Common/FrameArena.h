@@ -0,0 +1,94 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace DX
+{
+	// Linear allocator for data that only lives for a few frames, such as culling lists and
+	// sprite batches. Allocating is a pointer bump, nothing is freed individually, and each
+	// frame's memory is reset in one go FrameCount frames later, so anything allocated stays
+	// valid while the GPU or a worker may still be reading it. Allocations that don't fit
+	// fall back to the heap until the frame is reset, and are counted so the size can be tuned.
+	// Not thread safe; allocate from the thread that calls BeginFrame.
+	class FrameArena
+	{
+	public:
+		// Frames whose allocations are kept at once.
+		static const uint32_t FrameCount = 3;
+
+		explicit FrameArena(size_t bytesPerFrame);
+		~FrameArena();
+
+		// Starts allocating for the given frame, normally StepTimer::GetFrameCount, and resets
+		// what was allocated FrameCount frames before it. Calling again for the same frame
+		// does nothing, so frames that render without a new update keep their allocations.
+		void BeginFrame(uint64_t frame);
+
+		// Alignment must be a power of two. Never returns null.
+		void* Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+		template <typename T>
+		T* Allocate(size_t count)				{ return static_cast<T*>(Allocate(count * sizeof(T), alignof(T))); }
+
+		// Statistics for the current frame, and the most any frame has used.
+		size_t GetUsed() const					{ return m_frames[m_current].used; }
+		size_t GetCapacity() const				{ return m_bytesPerFrame; }
+		size_t GetPeakUsed() const				{ return m_peakUsed; }
+		uint32_t GetOverflowCount() const		{ return static_cast<uint32_t>(m_frames[m_current].overflow.size()); }
+
+	private:
+		struct FrameBlock
+		{
+			std::unique_ptr<uint8_t[]>	memory;
+			size_t						used;
+
+			// Allocations that didn't fit, released when the frame is reset.
+			std::vector<void*>			overflow;
+		};
+
+		void Reset(FrameBlock& block);
+
+		size_t			m_bytesPerFrame;
+		FrameBlock		m_frames[FrameCount];
+		uint32_t		m_current;
+		uint64_t		m_frame;
+		size_t			m_peakUsed;
+
+		FrameArena(const FrameArena&);
+		FrameArena& operator=(const FrameArena&);
+	};
+
+	// Adapts a FrameArena for standard containers. Deallocation does nothing, so reserve
+	// containers up front rather than letting them grow.
+	template <typename T>
+	class FrameAllocator
+	{
+	public:
+		typedef T value_type;
+
+		explicit FrameAllocator(FrameArena& arena) : m_arena(&arena) {}
+
+		template <typename U>
+		FrameAllocator(const FrameAllocator<U>& other) : m_arena(other.GetArena()) {}
+
+		T* allocate(size_t count)				{ return m_arena->Allocate<T>(count); }
+		void deallocate(T*, size_t)				{}
+
+		FrameArena* GetArena() const			{ return m_arena; }
+
+		template <typename U>
+		bool operator==(const FrameAllocator<U>& other) const	{ return m_arena == other.GetArena(); }
+
+		template <typename U>
+		bool operator!=(const FrameAllocator<U>& other) const	{ return m_arena != other.GetArena(); }
+
+	private:
+		FrameArena* m_arena;
+	};
+
+	template <typename T>
+	using FrameVector = std::vector<T, FrameAllocator<T>>;
+}
@@ -0,0 +1,201 @@
+﻿#include "pch.h"
+#include "GpuProfiler.h"
+#include "DirectXHelper.h"
+
+using namespace DX;
+using namespace Microsoft::WRL;
+
+GpuProfiler::GpuProfiler(const std::shared_ptr<DeviceResources>& deviceResources) :
+	m_deviceResources(deviceResources),
+	m_frameIndex(0),
+	m_inFrame(false),
+	m_depth(0),
+	m_lastFrameCollected(true),
+	m_droppedFrameCount(0)
+{
+	CreateDeviceDependentResources();
+}
+
+void GpuProfiler::CreateDeviceDependentResources()
+{
+	auto device = m_deviceResources->GetD3DDevice();
+
+	CD3D11_QUERY_DESC disjointDesc(D3D11_QUERY_TIMESTAMP_DISJOINT);
+	CD3D11_QUERY_DESC timestampDesc(D3D11_QUERY_TIMESTAMP);
+
+	for (auto& frame : m_frames)
+	{
+		DX::ThrowIfFailed(device->CreateQuery(&disjointDesc, &frame.disjoint));
+		DX::ThrowIfFailed(device->CreateQuery(&timestampDesc, &frame.start));
+
+		for (auto& scope : frame.scopes)
+		{
+			DX::ThrowIfFailed(device->CreateQuery(&timestampDesc, &scope.begin));
+			DX::ThrowIfFailed(device->CreateQuery(&timestampDesc, &scope.end));
+		}
+
+		frame.cpuStart = 0;
+		frame.scopeCount = 0;
+		frame.pending = false;
+	}
+
+	m_frameIndex = 0;
+	m_inFrame = false;
+	m_depth = 0;
+}
+
+void GpuProfiler::ReleaseDeviceDependentResources()
+{
+	for (auto& frame : m_frames)
+	{
+		frame.disjoint.Reset();
+		frame.start.Reset();
+
+		for (auto& scope : frame.scopes)
+		{
+			scope.begin.Reset();
+			scope.end.Reset();
+		}
+	}
+}
+
+void GpuProfiler::BeginFrame()
+{
+	Frame& frame = m_frames[m_frameIndex];
+	if (frame.disjoint == nullptr)
+	{
+		return;
+	}
+
+	if (frame.pending)
+	{
+		ReadBack(frame);
+	}
+
+	auto context = m_deviceResources->GetD3DDeviceContext();
+	context->Begin(frame.disjoint.Get());
+	context->End(frame.start.Get());
+
+	frame.cpuStart = GetProfilerTime();
+	frame.scopeCount = 0;
+	m_depth = 0;
+	m_inFrame = true;
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (!m_inFrame)
+	{
+		return;
+	}
+
+	Frame& frame = m_frames[m_frameIndex];
+	m_deviceResources->GetD3DDeviceContext()->End(frame.disjoint.Get());
+	frame.pending = true;
+
+	m_frameIndex = (m_frameIndex + 1) % FrameLatency;
+	m_inFrame = false;
+}
+
+void GpuProfiler::BeginScope(const char* name)
+{
+	if (!m_inFrame)
+	{
+		return;
+	}
+
+	// Scopes past the limit still count, so their ends pair up with the right begins.
+	Frame& frame = m_frames[m_frameIndex];
+	if (frame.scopeCount < MaxScopes && m_depth < MaxScopes)
+	{
+		Scope& scope = frame.scopes[frame.scopeCount];
+		scope.name = name;
+		scope.depth = m_depth;
+		m_deviceResources->GetD3DDeviceContext()->End(scope.begin.Get());
+
+		m_openScopes[m_depth] = frame.scopeCount++;
+	}
+	else if (m_depth < MaxScopes)
+	{
+		m_openScopes[m_depth] = MaxScopes;
+	}
+	m_depth++;
+}
+
+void GpuProfiler::EndScope()
+{
+	if (!m_inFrame || m_depth == 0)
+	{
+		return;
+	}
+
+	m_depth--;
+	if (m_depth >= MaxScopes || m_openScopes[m_depth] == MaxScopes)
+	{
+		return;
+	}
+
+	Frame& frame = m_frames[m_frameIndex];
+	m_deviceResources->GetD3DDeviceContext()->End(frame.scopes[m_openScopes[m_depth]].end.Get());
+}
+
+// Converts a frame's timestamps to events, or drops the frame if its results can't be used.
+void GpuProfiler::ReadBack(Frame& frame)
+{
+	frame.pending = false;
+
+	auto context = m_deviceResources->GetD3DDeviceContext();
+
+	// Without the flush a frame that isn't finished by now is dropped rather than waited for.
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+	uint64_t start;
+	if (context->GetData(frame.disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+		context->GetData(frame.start.Get(), &start, sizeof(start), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+		disjoint.Disjoint ||
+		disjoint.Frequency == 0)
+	{
+		m_droppedFrameCount++;
+		return;
+	}
+
+	std::vector<ProfileEvent> events;
+	events.reserve(frame.scopeCount);
+
+	for (uint32_t i = 0; i < frame.scopeCount; i++)
+	{
+		const Scope& scope = frame.scopes[i];
+
+		uint64_t begin;
+		uint64_t end;
+		if (context->GetData(scope.begin.Get(), &begin, sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+			context->GetData(scope.end.Get(), &end, sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		{
+			m_droppedFrameCount++;
+			return;
+		}
+
+		// Timestamps can be slightly out of order between engines; clamp rather than wrap.
+		begin = begin > start ? begin - start : 0;
+		end = end > start ? end - start : 0;
+
+		ProfileEvent profileEvent;
+		profileEvent.name = scope.name;
+		profileEvent.start = frame.cpuStart + static_cast<uint64_t>(begin * 1e9 / disjoint.Frequency);
+		profileEvent.duration = end > begin ? static_cast<uint64_t>((end - begin) * 1e9 / disjoint.Frequency) : 0;
+		profileEvent.threadId = GpuThreadId;
+		profileEvent.depth = scope.depth;
+		events.push_back(profileEvent);
+	}
+
+	m_lastFrame.swap(events);
+	m_lastFrameCollected = false;
+}
+
+void GpuProfiler::CollectEvents(std::vector<ProfileEvent>& events)
+{
+	if (!m_lastFrameCollected)
+	{
+		events.insert(events.end(), m_lastFrame.begin(), m_lastFrame.end());
+		m_lastFrameCollected = true;
+	}
+}
@@ -0,0 +1,101 @@
+﻿#pragma once
+
+#include "DeviceResources.h"
+#include "Profiler.h"
+
+namespace DX
+{
+	// Times scopes of GPU work with timestamp queries inside a disjoint query per frame. Results
+	// are read FrameLatency frames later, when the GPU has long finished them, so reading never
+	// stalls the CPU. GPU times are placed on the profiler clock by lining the frame's first
+	// timestamp up with the CPU time of BeginFrame, so they sit next to the CPU scopes in a trace.
+	class GpuProfiler
+	{
+	public:
+		// Frames in flight before a frame is read back.
+		static const uint32_t FrameLatency = 3;
+
+		// Scopes timed per frame. Further scopes are ignored.
+		static const uint32_t MaxScopes = 32;
+
+		GpuProfiler(const std::shared_ptr<DeviceResources>& deviceResources);
+		void CreateDeviceDependentResources();
+		void ReleaseDeviceDependentResources();
+
+		// Bracket everything rendered in a frame. BeginFrame reads back the frame issued
+		// FrameLatency frames ago before its queries are reused.
+		void BeginFrame();
+		void EndFrame();
+
+		// Scopes nest, and must begin and end within one frame.
+		void BeginScope(const char* name);
+		void EndScope();
+
+		// Scopes of the most recent frame read back, with GpuThreadId as the thread.
+		const std::vector<ProfileEvent>& GetLastFrame() const	{ return m_lastFrame; }
+
+		// Appends the scopes of the frame last read back, unless they were collected already.
+		void CollectEvents(std::vector<ProfileEvent>& events);
+
+		// Frames with no timings because the GPU clock was unreliable or results weren't ready.
+		uint64_t GetDroppedFrameCount() const					{ return m_droppedFrameCount; }
+
+	private:
+		struct Scope
+		{
+			const char*									name;
+			uint32_t									depth;
+			Microsoft::WRL::ComPtr<ID3D11Query>			begin;
+			Microsoft::WRL::ComPtr<ID3D11Query>			end;
+		};
+
+		struct Frame
+		{
+			Microsoft::WRL::ComPtr<ID3D11Query>			disjoint;
+			Microsoft::WRL::ComPtr<ID3D11Query>			start;
+			uint64_t									cpuStart;
+			uint32_t									scopeCount;
+			bool										pending;
+			Scope										scopes[MaxScopes];
+		};
+
+		void ReadBack(Frame& frame);
+
+		// Cached pointer to device resources.
+		std::shared_ptr<DeviceResources>	m_deviceResources;
+
+		Frame								m_frames[FrameLatency];
+		uint32_t							m_frameIndex;
+		bool								m_inFrame;
+
+		// Scopes begun but not ended this frame, as indices into the frame's scopes.
+		uint32_t							m_openScopes[MaxScopes];
+		uint32_t							m_depth;
+
+		std::vector<ProfileEvent>			m_lastFrame;
+		bool								m_lastFrameCollected;
+		uint64_t							m_droppedFrameCount;
+	};
+
+	// Times the enclosing block on the GPU.
+	class GpuScope
+	{
+	public:
+		GpuScope(GpuProfiler& profiler, const char* name) :
+			m_profiler(profiler)
+		{
+			m_profiler.BeginScope(name);
+		}
+
+		~GpuScope()
+		{
+			m_profiler.EndScope();
+		}
+
+	private:
+		GpuScope(const GpuScope&);
+		GpuScope& operator=(const GpuScope&);
+
+		GpuProfiler& m_profiler;
+	};
+}
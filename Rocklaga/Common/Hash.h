@@ -0,0 +1,28 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+	// 64-bit FNV-1a. Used to key cached assets and pipeline objects by their contents.
+	static const uint64_t HashSeed = 0xCBF29CE484222325ull;
+
+	inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = HashSeed)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	// Folds a value into a running hash. T must not contain padding bytes.
+	template<typename T>
+	inline uint64_t HashValue(const T& value, uint64_t hash = HashSeed)
+	{
+		return HashBytes(&value, sizeof(value), hash);
+	}
+}
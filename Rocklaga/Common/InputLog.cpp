@@ -0,0 +1,201 @@
+﻿#include "pch.h"
+#include "InputLog.h"
+
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	// File layout:
+	//   header   magic, version, step ticks, frame count, event count
+	//   events   varint frame delta from the previous event, type byte, float positionX (TrackingUpdate only)
+	// All multi-byte values are little-endian.
+	static const uint32_t InputLogMagic = 0x4C494B52; // "RKIL"
+	static const uint16_t InputLogVersion = 1;
+	static const size_t InputLogHeaderSize = 24;
+
+	void WriteBytes(std::vector<uint8_t>& out, uint64_t value, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+		}
+	}
+
+	uint64_t ReadBytes(const uint8_t* data, size_t count)
+	{
+		uint64_t value = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			value |= static_cast<uint64_t>(data[i]) << (i * 8);
+		}
+		return value;
+	}
+
+	void WriteVarint(std::vector<uint8_t>& out, uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back(static_cast<uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	bool ReadVarint(const uint8_t*& cursor, const uint8_t* end, uint32_t& value)
+	{
+		value = 0;
+		for (uint32_t shift = 0; shift < 35; shift += 7)
+		{
+			if (cursor == end)
+			{
+				return false;
+			}
+
+			uint8_t byte = *cursor++;
+			value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+InputLog::InputLog() :
+	m_stepTicks(0),
+	m_frameCount(0)
+{
+}
+
+// Back to an empty log with no step length, so a cleared log can't be replayed by mistake.
+void InputLog::Clear()
+{
+	m_stepTicks = 0;
+	m_frameCount = 0;
+	m_events.clear();
+}
+
+// Events must be recorded in frame order.
+void InputLog::Record(uint32_t frame, InputEventType type, float positionX)
+{
+	InputEvent inputEvent = { frame, type, positionX };
+	m_events.push_back(inputEvent);
+
+	if (frame > m_frameCount)
+	{
+		m_frameCount = frame;
+	}
+}
+
+std::vector<uint8_t> InputLog::Serialize() const
+{
+	std::vector<uint8_t> out;
+	out.reserve(InputLogHeaderSize + m_events.size() * 6);
+
+	WriteBytes(out, InputLogMagic, 4);
+	WriteBytes(out, InputLogVersion, 2);
+	WriteBytes(out, 0, 2);
+	WriteBytes(out, m_stepTicks, 8);
+	WriteBytes(out, m_frameCount, 4);
+	WriteBytes(out, m_events.size(), 4);
+
+	uint32_t previousFrame = 0;
+	for (const auto& inputEvent : m_events)
+	{
+		WriteVarint(out, inputEvent.frame - previousFrame);
+		out.push_back(static_cast<uint8_t>(inputEvent.type));
+
+		if (inputEvent.type == InputEventType::TrackingUpdate)
+		{
+			uint32_t bits;
+			memcpy(&bits, &inputEvent.positionX, sizeof(bits));
+			WriteBytes(out, bits, 4);
+		}
+
+		previousFrame = inputEvent.frame;
+	}
+
+	return out;
+}
+
+bool InputLog::Deserialize(const uint8_t* data, size_t size)
+{
+	Clear();
+
+	if (size < InputLogHeaderSize ||
+		ReadBytes(data, 4) != InputLogMagic ||
+		ReadBytes(data + 4, 2) != InputLogVersion)
+	{
+		return false;
+	}
+
+	uint64_t stepTicks = ReadBytes(data + 8, 8);
+	uint32_t frameCount = static_cast<uint32_t>(ReadBytes(data + 16, 4));
+	uint32_t eventCount = static_cast<uint32_t>(ReadBytes(data + 20, 4));
+
+	// A log without a step length can't be replayed.
+	if (stepTicks == 0)
+	{
+		return false;
+	}
+
+	// Every event takes at least two bytes, which bounds the reservation for corrupt counts.
+	const uint8_t* cursor = data + InputLogHeaderSize;
+	const uint8_t* end = data + size;
+	if (eventCount > static_cast<size_t>(end - cursor) / 2)
+	{
+		return false;
+	}
+	m_events.reserve(eventCount);
+
+	uint32_t frame = 0;
+	for (uint32_t i = 0; i < eventCount; i++)
+	{
+		uint32_t frameDelta;
+		if (!ReadVarint(cursor, end, frameDelta) || cursor == end || frameDelta > UINT32_MAX - frame)
+		{
+			Clear();
+			return false;
+		}
+
+		frame += frameDelta;
+		uint8_t type = *cursor++;
+		float positionX = 0.0f;
+
+		if (type > static_cast<uint8_t>(InputEventType::StopTracking))
+		{
+			Clear();
+			return false;
+		}
+
+		if (type == static_cast<uint8_t>(InputEventType::TrackingUpdate))
+		{
+			if (end - cursor < 4)
+			{
+				Clear();
+				return false;
+			}
+
+			uint32_t bits = static_cast<uint32_t>(ReadBytes(cursor, 4));
+			memcpy(&positionX, &bits, sizeof(positionX));
+			cursor += 4;
+		}
+
+		Record(frame, static_cast<InputEventType>(type), positionX);
+	}
+
+	// The recording may have continued past the last event, but can't end before it, and
+	// nothing follows the events.
+	if (frameCount < m_frameCount || cursor != end)
+	{
+		Clear();
+		return false;
+	}
+
+	m_stepTicks = stepTicks;
+	m_frameCount = frameCount;
+	return true;
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Kinds of pointer input the scene reacts to.
+	enum class InputEventType : uint8_t
+	{
+		StartTracking,
+		TrackingUpdate,
+		StopTracking,
+	};
+
+	// A single input event, keyed by the fixed-step frame it was applied on.
+	struct InputEvent
+	{
+		uint32_t		frame;
+		InputEventType	type;
+		float			positionX;	// Normalized to the output width. Only meaningful for TrackingUpdate.
+	};
+
+	// Records input events against fixed-step frame numbers and stores them in a compact binary form.
+	// The log contains no platform types so it can be written on one machine and replayed on another.
+	class InputLog
+	{
+	public:
+		InputLog();
+
+		void Clear();
+		void SetStepTicks(uint64_t stepTicks)		{ m_stepTicks = stepTicks; }
+		void SetFrameCount(uint32_t frameCount)		{ m_frameCount = frameCount; }
+		void Record(uint32_t frame, InputEventType type, float positionX);
+
+		// The duration of one simulation step, in StepTimer ticks.
+		uint64_t GetStepTicks() const					{ return m_stepTicks; }
+
+		// The number of simulation steps covered by the log.
+		uint32_t GetFrameCount() const					{ return m_frameCount; }
+
+		const std::vector<InputEvent>& GetEvents() const	{ return m_events; }
+
+		// Binary serialization. Deserialize returns false, leaving no events, if the data is not a
+		// valid input log: one with a step length, whose frame count covers its events.
+		std::vector<uint8_t> Serialize() const;
+		bool Deserialize(const uint8_t* data, size_t size);
+
+	private:
+		uint64_t				m_stepTicks;
+		uint32_t				m_frameCount;
+		std::vector<InputEvent>	m_events;
+	};
+}
@@ -0,0 +1,206 @@
+﻿#include "pch.h"
+#include "Lz4.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+	static const size_t MinMatch = 4;
+
+	// The format requires the last five bytes to be literals, and the last match to start at
+	// least twelve bytes before the end of the block.
+	static const size_t LastLiterals = 5;
+	static const size_t MatchFindLimit = 12;
+
+	static const size_t MaxOffset = 65535;
+	static const uint32_t HashBits = 14;
+
+	uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	uint32_t HashSequence(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	// Lengths of 15 or more spill into extra bytes of 255, ending with a byte below 255.
+	uint8_t* WriteLength(uint8_t* out, size_t length)
+	{
+		while (length >= 255)
+		{
+			*out++ = 255;
+			length -= 255;
+		}
+		*out++ = static_cast<uint8_t>(length);
+		return out;
+	}
+
+	bool ReadLength(const uint8_t*& in, const uint8_t* end, size_t& length)
+	{
+		uint8_t value;
+		do
+		{
+			if (in == end)
+			{
+				return false;
+			}
+			value = *in++;
+			length += value;
+		} while (value == 255);
+
+		return true;
+	}
+
+	uint8_t* WriteSequence(uint8_t* out, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength)
+	{
+		uint8_t* token = out++;
+		*token = static_cast<uint8_t>((literalLength < 15 ? literalLength : 15) << 4);
+		if (literalLength >= 15)
+		{
+			out = WriteLength(out, literalLength - 15);
+		}
+
+		if (literalLength > 0)
+		{
+			memcpy(out, literals, literalLength);
+			out += literalLength;
+		}
+
+		// A sequence without a match ends the block.
+		if (matchLength == 0)
+		{
+			return out;
+		}
+
+		*out++ = static_cast<uint8_t>(offset);
+		*out++ = static_cast<uint8_t>(offset >> 8);
+
+		size_t extraLength = matchLength - MinMatch;
+		*token |= static_cast<uint8_t>(extraLength < 15 ? extraLength : 15);
+		if (extraLength >= 15)
+		{
+			out = WriteLength(out, extraLength - 15);
+		}
+
+		return out;
+	}
+}
+
+size_t DX::Lz4Compress(const uint8_t* source, size_t size, uint8_t* dest)
+{
+	uint8_t* out = dest;
+	size_t anchor = 0;
+
+	if (size > MatchFindLimit)
+	{
+		std::vector<uint32_t> table(static_cast<size_t>(1) << HashBits, UINT32_MAX);
+		size_t matchStartLimit = size - MatchFindLimit;
+		size_t matchEndLimit = size - LastLiterals;
+
+		size_t position = 0;
+		while (position < matchStartLimit)
+		{
+			uint32_t sequence = Read32(source + position);
+			uint32_t hash = HashSequence(sequence);
+			uint32_t candidate = table[hash];
+			table[hash] = static_cast<uint32_t>(position);
+
+			if (candidate == UINT32_MAX || position - candidate > MaxOffset || Read32(source + candidate) != sequence)
+			{
+				position++;
+				continue;
+			}
+
+			size_t matchLength = MinMatch;
+			while (position + matchLength < matchEndLimit && source[candidate + matchLength] == source[position + matchLength])
+			{
+				matchLength++;
+			}
+
+			out = WriteSequence(out, source + anchor, position - anchor, position - candidate, matchLength);
+			position += matchLength;
+			anchor = position;
+		}
+	}
+
+	out = WriteSequence(out, source + anchor, size - anchor, 0, 0);
+	return out - dest;
+}
+
+bool DX::Lz4Decompress(const uint8_t* source, size_t sourceSize, uint8_t* dest, size_t destSize)
+{
+	const uint8_t* in = source;
+	const uint8_t* inEnd = source + sourceSize;
+	uint8_t* out = dest;
+	uint8_t* outEnd = dest + destSize;
+
+	while (in < inEnd)
+	{
+		uint8_t token = *in++;
+
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !ReadLength(in, inEnd, literalLength))
+		{
+			return false;
+		}
+
+		if (literalLength > static_cast<size_t>(inEnd - in) || literalLength > static_cast<size_t>(outEnd - out))
+		{
+			return false;
+		}
+
+		if (literalLength > 0)
+		{
+			memcpy(out, in, literalLength);
+			in += literalLength;
+			out += literalLength;
+		}
+
+		// The last sequence has no match.
+		if (in == inEnd)
+		{
+			break;
+		}
+
+		if (inEnd - in < 2)
+		{
+			return false;
+		}
+
+		size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > static_cast<size_t>(out - dest))
+		{
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(in, inEnd, matchLength))
+		{
+			return false;
+		}
+		matchLength += MinMatch;
+
+		if (matchLength > static_cast<size_t>(outEnd - out))
+		{
+			return false;
+		}
+
+		// Matches may overlap the bytes they produce, so copy forwards one byte at a time.
+		const uint8_t* match = out - offset;
+		for (size_t i = 0; i < matchLength; i++)
+		{
+			out[i] = match[i];
+		}
+		out += matchLength;
+	}
+
+	return out == outEnd;
+}
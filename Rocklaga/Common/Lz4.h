@@ -0,0 +1,22 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace DX
+{
+	// LZ4 block format. Compression is a single greedy pass with a small hash table, which
+	// favours decompression speed over ratio; the output is readable by any LZ4 block decoder.
+
+	// Largest compressed size for an input of the given size.
+	inline size_t Lz4CompressBound(size_t size)
+	{
+		return size + size / 255 + 16;
+	}
+
+	// Returns the compressed size. dest must hold at least Lz4CompressBound(size) bytes.
+	size_t Lz4Compress(const uint8_t* source, size_t size, uint8_t* dest);
+
+	// Returns false if the data is malformed or does not decompress to exactly destSize bytes.
+	bool Lz4Decompress(const uint8_t* source, size_t sourceSize, uint8_t* dest, size_t destSize);
+}
@@ -0,0 +1,94 @@
+﻿#include "pch.h"
+#include "MappedFile.h"
+#include "DirectXHelper.h"
+
+using namespace DX;
+
+MappedFile::MappedFile() :
+	m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr),
+	m_view(nullptr),
+	m_size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+// Maps a file from the package's installed location.
+void MappedFile::Open(const std::wstring& filename)
+{
+	Close();
+
+	std::wstring path = Windows::ApplicationModel::Package::Current->InstalledLocation->Path->Data();
+	path += L"\\";
+	path += filename;
+
+	CREATEFILE2_EXTENDED_PARAMETERS parameters = {0};
+	parameters.dwSize = sizeof(parameters);
+	parameters.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+	parameters.dwFileFlags = FILE_FLAG_RANDOM_ACCESS;
+
+	m_file = CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &parameters);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		DX::ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+	}
+
+	FILE_STANDARD_INFO info;
+	if (!GetFileInformationByHandleEx(m_file, FileStandardInfo, &info, sizeof(info)))
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		DX::ThrowIfFailed(hr);
+	}
+
+	m_size = static_cast<size_t>(info.EndOfFile.QuadPart);
+
+	// Empty files cannot be mapped, and have nothing to map anyway.
+	if (m_size == 0)
+	{
+		return;
+	}
+
+	m_mapping = CreateFileMappingFromApp(m_file, nullptr, PAGE_READONLY, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		DX::ThrowIfFailed(hr);
+	}
+
+	m_view = MapViewOfFileFromApp(m_mapping, FILE_MAP_READ, 0, 0);
+	if (m_view == nullptr)
+	{
+		HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+		Close();
+		DX::ThrowIfFailed(hr);
+	}
+}
+
+void MappedFile::Close()
+{
+	if (m_view != nullptr)
+	{
+		UnmapViewOfFile(m_view);
+		m_view = nullptr;
+	}
+
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+
+	m_size = 0;
+}
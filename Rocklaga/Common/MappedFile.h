@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include <string>
+
+namespace DX
+{
+	// A read-only view of a file in the app package, mapped into memory. Pages are read from
+	// disk as they are touched, and nothing is copied into the heap.
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		void Open(const std::wstring& filename);
+		void Close();
+
+		const uint8* GetData() const	{ return static_cast<const uint8*>(m_view); }
+		size_t GetSize() const			{ return m_size; }
+
+	private:
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+
+		HANDLE		m_file;
+		HANDLE		m_mapping;
+		const void*	m_view;
+		size_t		m_size;
+	};
+}
@@ -0,0 +1,269 @@
+﻿#include "pch.h"
+#include "MeshFormat.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include "MeshOptimizer.h"
+
+using namespace DX;
+using namespace DirectX;
+
+namespace
+{
+	// File layout: MeshHeader, lodCount MeshLod entries, vertexCount vertices of vertexStride
+	// bytes, then indexCount 16 or 32-bit indices holding every level back to back. Structures
+	// are copied as-is, so the format is little-endian like every platform we ship on.
+	static const uint32_t MeshMagic = 0x534D4B52; // "RKMS"
+	static const uint32_t MeshVersion = 2;
+
+	struct MeshHeader
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint32_t	flags;
+		uint32_t	vertexStride;
+		uint32_t	vertexCount;
+		uint32_t	indexCount;
+		uint32_t	lodCount;
+		float		scale;
+		float		offset[3];
+		uint32_t	reserved;
+	};
+
+	static_assert(sizeof(MeshHeader) == 48, "MeshHeader must not contain padding");
+	static_assert(sizeof(MeshLod) == 12, "MeshLod must not contain padding");
+
+	// Position and color only; the normal is dropped from the end of QuantizedVertex.
+	static const uint32_t CompactVertexStride = 12;
+
+	// Triangles are ordered for a typical 16-entry FIFO cache, and overdraw clusters may cost
+	// 5% more vertex shading than that order.
+	static const size_t VertexCacheSize = 16;
+	static const float OverdrawThreshold = 1.05f;
+
+	int16_t QuantizeSnorm16(float value)
+	{
+		value = std::max(-1.0f, std::min(1.0f, value));
+		return static_cast<int16_t>(floorf(value * 32767.0f + 0.5f));
+	}
+
+	uint8_t QuantizeUnorm8(float value)
+	{
+		value = std::max(0.0f, std::min(1.0f, value));
+		return static_cast<uint8_t>(value * 255.0f + 0.5f);
+	}
+
+	uint8_t QuantizeSnorm8(float value)
+	{
+		value = std::max(-1.0f, std::min(1.0f, value));
+		return static_cast<uint8_t>(static_cast<int8_t>(floorf(value * 127.0f + 0.5f)));
+	}
+}
+
+std::vector<uint8_t> DX::EncodeMesh(const std::vector<MeshSourceVertex>& vertices, const std::vector<MeshLodSource>& lods, bool includeNormals)
+{
+	// Quantize relative to the center of the bounds, scaled by the largest half extent.
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+	for (const auto& vertex : vertices)
+	{
+		XMVECTOR position = XMLoadFloat3(&vertex.position);
+		boundsMin = XMVectorMin(boundsMin, position);
+		boundsMax = XMVectorMax(boundsMax, position);
+	}
+
+	XMFLOAT3 center(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 halfExtent(0.0f, 0.0f, 0.0f);
+	if (!vertices.empty())
+	{
+		XMStoreFloat3(&center, XMVectorScale(XMVectorAdd(boundsMin, boundsMax), 0.5f));
+		XMStoreFloat3(&halfExtent, XMVectorScale(XMVectorSubtract(boundsMax, boundsMin), 0.5f));
+	}
+
+	float scale = std::max(halfExtent.x, std::max(halfExtent.y, halfExtent.z));
+	if (scale <= 0.0f)
+	{
+		scale = 1.0f;
+	}
+
+	// Order each level's triangles for the vertex cache, then cluster them for overdraw. The
+	// vertices are then laid out in the order the levels read them, most detailed first.
+	std::vector<XMFLOAT3> positions(vertices.size());
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		positions[i] = vertices[i].position;
+	}
+
+	std::vector<MeshLod> lodTable(lods.size());
+	std::vector<uint32_t> optimized;
+	for (size_t lod = 0; lod < lods.size(); lod++)
+	{
+		const std::vector<uint32_t>& indices = lods[lod].indices;
+		std::vector<uint32_t> ordered = OptimizeOverdraw(
+			OptimizeVertexCacheTipsify(std::vector<uint32_t>(indices.begin(), indices.end() - indices.size() % 3), vertices.size(), VertexCacheSize),
+			positions,
+			VertexCacheSize,
+			OverdrawThreshold
+			);
+
+		lodTable[lod].indexOffset = static_cast<uint32_t>(optimized.size());
+		lodTable[lod].indexCount = static_cast<uint32_t>(ordered.size());
+		lodTable[lod].error = lods[lod].error;
+		optimized.insert(optimized.end(), ordered.begin(), ordered.end());
+	}
+
+	std::vector<uint32_t> remap = OptimizeVertexFetch(optimized, vertices.size());
+
+	MeshHeader header = {};
+	header.magic = MeshMagic;
+	header.version = MeshVersion;
+	header.flags = (includeNormals ? MeshHasNormals : 0) | (vertices.size() > UINT16_MAX ? MeshIndex32 : 0);
+	header.vertexStride = includeNormals ? sizeof(QuantizedVertex) : CompactVertexStride;
+	header.vertexCount = static_cast<uint32_t>(vertices.size());
+	header.indexCount = static_cast<uint32_t>(optimized.size());
+	header.lodCount = static_cast<uint32_t>(lodTable.size());
+	header.scale = scale;
+	header.offset[0] = center.x;
+	header.offset[1] = center.y;
+	header.offset[2] = center.z;
+
+	size_t indexSize = (header.flags & MeshIndex32) != 0 ? sizeof(uint32_t) : sizeof(uint16_t);
+	size_t verticesSize = static_cast<size_t>(header.vertexCount) * header.vertexStride;
+	size_t lodTableSize = lodTable.size() * sizeof(MeshLod);
+
+	std::vector<uint8_t> out(sizeof(header) + lodTableSize + verticesSize + header.indexCount * indexSize);
+	memcpy(out.data(), &header, sizeof(header));
+	if (lodTableSize > 0)
+	{
+		memcpy(out.data() + sizeof(header), lodTable.data(), lodTableSize);
+	}
+
+	uint8_t* vertexData = out.data() + sizeof(header) + lodTableSize;
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		const MeshSourceVertex& source = vertices[i];
+		QuantizedVertex vertex;
+		vertex.position[0] = QuantizeSnorm16((source.position.x - center.x) / scale);
+		vertex.position[1] = QuantizeSnorm16((source.position.y - center.y) / scale);
+		vertex.position[2] = QuantizeSnorm16((source.position.z - center.z) / scale);
+		vertex.position[3] = 32767;
+		vertex.color =
+			QuantizeUnorm8(source.color.x) |
+			(QuantizeUnorm8(source.color.y) << 8) |
+			(QuantizeUnorm8(source.color.z) << 16) |
+			(255u << 24);
+		vertex.normal =
+			QuantizeSnorm8(source.normal.x) |
+			(QuantizeSnorm8(source.normal.y) << 8) |
+			(QuantizeSnorm8(source.normal.z) << 16);
+
+		memcpy(vertexData + static_cast<size_t>(remap[i]) * header.vertexStride, &vertex, header.vertexStride);
+	}
+
+	uint8_t* indexData = vertexData + verticesSize;
+	for (uint32_t index : optimized)
+	{
+		if (indexSize == sizeof(uint32_t))
+		{
+			memcpy(indexData, &index, sizeof(index));
+		}
+		else
+		{
+			uint16_t shortIndex = static_cast<uint16_t>(index);
+			memcpy(indexData, &shortIndex, sizeof(shortIndex));
+		}
+		indexData += indexSize;
+	}
+
+	return out;
+}
+
+std::vector<uint8_t> DX::EncodeMesh(const std::vector<MeshSourceVertex>& vertices, const std::vector<uint32_t>& indices, bool includeNormals)
+{
+	std::vector<MeshLodSource> lods(1);
+	lods[0].indices = indices;
+	lods[0].error = 0.0f;
+	return EncodeMesh(vertices, lods, includeNormals);
+}
+
+MeshView::MeshView() :
+	m_vertices(nullptr),
+	m_indices(nullptr),
+	m_lods(nullptr),
+	m_vertexCount(0),
+	m_indexCount(0),
+	m_vertexStride(0),
+	m_lodCount(0),
+	m_flags(0),
+	m_scale(1.0f)
+{
+	m_offset[0] = m_offset[1] = m_offset[2] = 0.0f;
+}
+
+bool MeshView::Open(const uint8_t* data, size_t size)
+{
+	MeshHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (header.magic != MeshMagic || header.version != MeshVersion)
+	{
+		return false;
+	}
+
+	uint32_t expectedStride = (header.flags & MeshHasNormals) != 0 ? sizeof(QuantizedVertex) : CompactVertexStride;
+	if (header.vertexStride != expectedStride || header.indexCount % 3 != 0)
+	{
+		return false;
+	}
+
+	uint64_t indexSize = (header.flags & MeshIndex32) != 0 ? sizeof(uint32_t) : sizeof(uint16_t);
+	uint64_t lodTableSize = static_cast<uint64_t>(header.lodCount) * sizeof(MeshLod);
+	uint64_t verticesSize = static_cast<uint64_t>(header.vertexCount) * header.vertexStride;
+	if (size != sizeof(header) + lodTableSize + verticesSize + header.indexCount * indexSize)
+	{
+		return false;
+	}
+
+	// Every level must be whole triangles inside the index data.
+	for (uint32_t i = 0; i < header.lodCount; i++)
+	{
+		MeshLod lod;
+		memcpy(&lod, data + sizeof(header) + i * sizeof(MeshLod), sizeof(lod));
+		if (lod.indexCount % 3 != 0 || static_cast<uint64_t>(lod.indexOffset) + lod.indexCount > header.indexCount)
+		{
+			return false;
+		}
+	}
+
+	m_lods = data + sizeof(header);
+	m_vertices = m_lods + lodTableSize;
+	m_indices = m_vertices + verticesSize;
+	m_vertexCount = header.vertexCount;
+	m_indexCount = header.indexCount;
+	m_vertexStride = header.vertexStride;
+	m_lodCount = header.lodCount;
+	m_flags = header.flags;
+	m_scale = header.scale;
+	m_offset[0] = header.offset[0];
+	m_offset[1] = header.offset[1];
+	m_offset[2] = header.offset[2];
+	return true;
+}
+
+XMMATRIX MeshView::GetDequantizeTransform() const
+{
+	return XMMatrixMultiply(XMMatrixScaling(m_scale, m_scale, m_scale), XMMatrixTranslation(m_offset[0], m_offset[1], m_offset[2]));
+}
+
+MeshLod MeshView::GetLod(uint32_t lod) const
+{
+	MeshLod result;
+	memcpy(&result, m_lods + lod * sizeof(MeshLod), sizeof(result));
+	return result;
+}
@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+namespace DX
+{
+	// A vertex as authored, before quantization.
+	struct MeshSourceVertex
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT3 color;
+		DirectX::XMFLOAT3 normal;
+	};
+
+	// A vertex as stored in mesh files and vertex buffers: 12 bytes, or 16 with normals, instead
+	// of the 24 of VertexPositionColor. Positions are R16G16B16A16_SNORM relative to the mesh
+	// bounds, colors R8G8B8A8_UNORM and normals R8G8B8A8_SNORM.
+	struct QuantizedVertex
+	{
+		int16_t		position[4];
+		uint32_t	color;
+		uint32_t	normal;		// Only present when the mesh has normals.
+	};
+
+	static const uint32_t MeshHasNormals = 0x1;
+	static const uint32_t MeshIndex32 = 0x2;
+
+	// One level of detail: a range of the index buffer, drawn over the shared vertex buffer.
+	struct MeshLod
+	{
+		uint32_t	indexOffset;
+		uint32_t	indexCount;
+		float		error;		// Deviation from the full mesh, in model units.
+	};
+
+	// Triangles for one level of detail, as produced by GenerateMeshLods.
+	struct MeshLodSource
+	{
+		std::vector<uint32_t>	indices;
+		float					error;
+	};
+
+	// Converts a mesh to the binary mesh format: a header, the level of detail table, the
+	// quantized vertices in fetch order, then each level's indices in vertex cache and overdraw
+	// order. Levels go from the most detailed to the least, and all share the vertices.
+	// 16-bit indices are used whenever the vertex count allows.
+	// The output is meant to be written to disk by the asset build and loaded with MeshView.
+	std::vector<uint8_t> EncodeMesh(const std::vector<MeshSourceVertex>& vertices, const std::vector<MeshLodSource>& lods, bool includeNormals);
+
+	// Converts a mesh with a single level of detail.
+	std::vector<uint8_t> EncodeMesh(const std::vector<MeshSourceVertex>& vertices, const std::vector<uint32_t>& indices, bool includeNormals);
+
+	// Reads a mesh in place, so vertex and index data can be uploaded straight from a mapped file.
+	class MeshView
+	{
+	public:
+		MeshView();
+
+		// Validates the header and sizes. data must outlive the view.
+		bool Open(const uint8_t* data, size_t size);
+
+		const uint8_t* GetVertexData() const	{ return m_vertices; }
+		const uint8_t* GetIndexData() const		{ return m_indices; }
+		uint32_t GetVertexCount() const			{ return m_vertexCount; }
+		uint32_t GetIndexCount() const			{ return m_indexCount; }
+		uint32_t GetVertexStride() const		{ return m_vertexStride; }
+		uint32_t GetLodCount() const			{ return m_lodCount; }
+		MeshLod GetLod(uint32_t lod) const;
+		bool HasNormals() const					{ return (m_flags & MeshHasNormals) != 0; }
+		bool Uses32BitIndices() const			{ return (m_flags & MeshIndex32) != 0; }
+
+		// Maps decoded SNORM positions back to model space: position * scale + offset. Fold it
+		// into the model matrix rather than decoding vertices. The scale is uniform, so normals
+		// stay valid under the combined matrix.
+		DirectX::XMMATRIX GetDequantizeTransform() const;
+
+	private:
+		const uint8_t*	m_vertices;
+		const uint8_t*	m_indices;
+		const uint8_t*	m_lods;
+		uint32_t		m_vertexCount;
+		uint32_t		m_indexCount;
+		uint32_t		m_vertexStride;
+		uint32_t		m_lodCount;
+		uint32_t		m_flags;
+		float			m_scale;
+		float			m_offset[3];
+	};
+}
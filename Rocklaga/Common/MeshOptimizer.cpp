@@ -0,0 +1,522 @@
+﻿#include "pch.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace DX;
+using namespace DirectX;
+
+namespace
+{
+	// Size of the modelled LRU cache. Larger than any real post-transform cache, which makes the
+	// ordering good across hardware rather than tuned to one cache size.
+	static const size_t CacheSize = 32;
+
+	static const float LastTriangleScore = 0.75f;
+	static const float CacheDecayPower = 1.5f;
+	static const float ValenceBoostScale = 2.0f;
+	static const float ValenceBoostPower = 0.5f;
+
+	// Vertices used by the last triangle get a fixed score, so the next triangle doesn't simply
+	// reuse the same edge; the rest of the cache decays with age. Vertices with few remaining
+	// triangles are boosted so they are finished off rather than left stranded.
+	float VertexScore(int cachePosition, uint32_t remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				score = LastTriangleScore;
+			}
+			else
+			{
+				float scaler = 1.0f / (CacheSize - 3);
+				score = powf(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+			}
+		}
+
+		score += ValenceBoostScale * powf(static_cast<float>(remainingTriangles), -ValenceBoostPower);
+		return score;
+	}
+
+	// Triangles adjacent to each vertex, as offsets into one flat array.
+	struct TriangleAdjacency
+	{
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+	};
+
+	void BuildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount, TriangleAdjacency& adjacency)
+	{
+		size_t triangleCount = indices.size() / 3;
+
+		adjacency.counts.assign(vertexCount, 0);
+		for (size_t i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency.counts[indices[i]]++;
+		}
+
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			adjacency.offsets[v + 1] = adjacency.offsets[v] + adjacency.counts[v];
+		}
+
+		adjacency.triangles.resize(triangleCount * 3);
+		std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			for (size_t k = 0; k < 3; k++)
+			{
+				adjacency.triangles[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+			}
+		}
+	}
+
+	// A FIFO cache tracked with timestamps: a vertex is cached while fewer than cacheSize
+	// others have entered after it. Hits don't refresh the timestamp, as in hardware.
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, size_t cacheSize) :
+			m_timestamps(vertexCount, 0),
+			m_cacheSize(static_cast<uint32_t>(cacheSize)),
+			m_time(static_cast<uint32_t>(cacheSize) + 1)
+		{
+		}
+
+		// Returns true on a miss.
+		bool Access(uint32_t vertex)
+		{
+			if (m_time - m_timestamps[vertex] > m_cacheSize)
+			{
+				m_timestamps[vertex] = m_time++;
+				return true;
+			}
+			return false;
+		}
+
+		void Flush()
+		{
+			m_time += m_cacheSize + 1;
+		}
+
+	private:
+		std::vector<uint32_t>	m_timestamps;
+		uint32_t				m_cacheSize;
+		uint32_t				m_time;
+	};
+}
+
+std::vector<uint32_t> DX::OptimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+
+	// Adjacency lists shrink as triangles are emitted, so counts doubles as the remaining valence.
+	TriangleAdjacency triangleAdjacency;
+	BuildAdjacency(indices, vertexCount, triangleAdjacency);
+	std::vector<uint32_t>& remaining = triangleAdjacency.counts;
+	const std::vector<uint32_t>& adjacencyOffset = triangleAdjacency.offsets;
+	std::vector<uint32_t>& adjacency = triangleAdjacency.triangles;
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+	}
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+
+	// One slot per vertex of the incoming triangle beyond the cache, so evicted vertices can be rescored.
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> newCache;
+	cache.reserve(CacheSize + 3);
+	newCache.reserve(CacheSize + 3);
+
+	size_t scanCursor = 0;
+	size_t bestTriangle = triangleCount;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		// When the cache offers nothing, fall back to the next unemitted triangle in input order.
+		if (bestTriangle == triangleCount)
+		{
+			while (emitted[scanCursor])
+			{
+				scanCursor++;
+			}
+			bestTriangle = scanCursor;
+		}
+
+		size_t t = bestTriangle;
+		emitted[t] = true;
+
+		newCache.clear();
+		for (size_t k = 0; k < 3; k++)
+		{
+			uint32_t v = indices[t * 3 + k];
+			result.push_back(v);
+			if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+			{
+				newCache.push_back(v);
+			}
+
+			// Remove the triangle from the vertex's adjacency.
+			uint32_t* begin = &adjacency[adjacencyOffset[v]];
+			uint32_t* end = begin + remaining[v];
+			for (uint32_t* a = begin; a != end; a++)
+			{
+				if (*a == t)
+				{
+					*a = *(end - 1);
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		size_t triangleVertices = newCache.size();
+		for (uint32_t v : cache)
+		{
+			if (std::find(newCache.begin(), newCache.begin() + triangleVertices, v) == newCache.begin() + triangleVertices)
+			{
+				newCache.push_back(v);
+			}
+		}
+		cache.swap(newCache);
+
+		// Rescore everything that moved in or out of the cache, and the triangles that use them.
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			uint32_t v = cache[i];
+			cachePosition[v] = i < CacheSize ? static_cast<int>(i) : -1;
+
+			float score = VertexScore(cachePosition[v], remaining[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			for (uint32_t a = 0; a < remaining[v]; a++)
+			{
+				triangleScore[adjacency[adjacencyOffset[v] + a]] += delta;
+			}
+		}
+
+		if (cache.size() > CacheSize)
+		{
+			cache.resize(CacheSize);
+		}
+
+		// The next triangle is the best one touching the cache.
+		bestTriangle = triangleCount;
+		float bestScore = -1.0f;
+		for (uint32_t v : cache)
+		{
+			for (uint32_t a = 0; a < remaining[v]; a++)
+			{
+				uint32_t candidate = adjacency[adjacencyOffset[v] + a];
+				if (triangleScore[candidate] > bestScore)
+				{
+					bestScore = triangleScore[candidate];
+					bestTriangle = candidate;
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+std::vector<uint32_t> DX::OptimizeVertexCacheTipsify(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize)
+{
+	size_t triangleCount = indices.size() / 3;
+
+	TriangleAdjacency adjacency;
+	BuildAdjacency(indices, vertexCount, adjacency);
+	std::vector<uint32_t>& live = adjacency.counts;
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> cacheTime(vertexCount, 0);
+	uint32_t time = static_cast<uint32_t>(cacheSize) + 1;
+
+	// Vertices recently emitted, to resume from when a fan leaves no candidates.
+	std::vector<uint32_t> deadEndStack;
+	std::vector<uint32_t> candidates;
+	size_t scanCursor = 0;
+
+	int64_t fanning = vertexCount > 0 ? 0 : -1;
+	while (fanning >= 0)
+	{
+		uint32_t f = static_cast<uint32_t>(fanning);
+		candidates.clear();
+
+		for (uint32_t a = adjacency.offsets[f]; a < adjacency.offsets[f + 1]; a++)
+		{
+			uint32_t t = adjacency.triangles[a];
+			if (emitted[t])
+			{
+				continue;
+			}
+			emitted[t] = true;
+
+			for (size_t k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[t * 3 + k];
+				result.push_back(v);
+				deadEndStack.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+
+				if (time - cacheTime[v] > cacheSize)
+				{
+					cacheTime[v] = time++;
+				}
+			}
+		}
+
+		// Fan next around the oldest candidate that will still be cached once its own
+		// remaining triangles are emitted.
+		fanning = -1;
+		uint32_t bestAge = 0;
+		for (uint32_t v : candidates)
+		{
+			if (live[v] == 0)
+			{
+				continue;
+			}
+
+			uint32_t age = time - cacheTime[v];
+			uint32_t priority = age + 2 * live[v] <= cacheSize ? age : 0;
+			if (fanning < 0 || priority > bestAge)
+			{
+				bestAge = priority;
+				fanning = v;
+			}
+		}
+
+		if (fanning < 0)
+		{
+			while (!deadEndStack.empty())
+			{
+				uint32_t v = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (live[v] > 0)
+				{
+					fanning = v;
+					break;
+				}
+			}
+		}
+
+		if (fanning < 0)
+		{
+			while (scanCursor < vertexCount && live[scanCursor] == 0)
+			{
+				scanCursor++;
+			}
+			if (scanCursor < vertexCount)
+			{
+				fanning = scanCursor;
+			}
+		}
+	}
+
+	return result;
+}
+
+std::vector<uint32_t> DX::OptimizeOverdraw(const std::vector<uint32_t>& indices, const std::vector<XMFLOAT3>& positions, size_t cacheSize, float threshold)
+{
+	size_t triangleCount = indices.size() / 3;
+	size_t vertexCount = positions.size();
+
+	if (triangleCount == 0)
+	{
+		return indices;
+	}
+
+	// Hard boundaries: triangles that miss on all three vertices start with a cold cache,
+	// so nothing is lost by starting a cluster there. The first triangle always starts one,
+	// even if it is degenerate and hits on a repeated vertex.
+	std::vector<size_t> hardBoundaries(1, 0);
+	{
+		FifoCache cache(vertexCount, cacheSize);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			uint32_t misses =
+				cache.Access(indices[t * 3]) +
+				cache.Access(indices[t * 3 + 1]) +
+				cache.Access(indices[t * 3 + 2]);
+
+			if (misses == 3 && t > 0)
+			{
+				hardBoundaries.push_back(t);
+			}
+		}
+		hardBoundaries.push_back(triangleCount);
+	}
+
+	// Soft boundaries: within a hard cluster, cut as soon as the triangles since the last cut
+	// have amortized a cold cache down to the cluster's own ACMR times the threshold.
+	std::vector<size_t> boundaries;
+	FifoCache cache(vertexCount, cacheSize);
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+	{
+		size_t begin = hardBoundaries[h];
+		size_t end = hardBoundaries[h + 1];
+
+		uint32_t clusterMisses = 0;
+		cache.Flush();
+		for (size_t t = begin; t < end; t++)
+		{
+			clusterMisses += cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+		}
+		float limit = threshold * clusterMisses / (end - begin);
+
+		boundaries.push_back(begin);
+		uint32_t misses = 0;
+		size_t start = begin;
+		cache.Flush();
+		for (size_t t = begin; t < end; t++)
+		{
+			misses += cache.Access(indices[t * 3]) + cache.Access(indices[t * 3 + 1]) + cache.Access(indices[t * 3 + 2]);
+
+			if (t + 1 < end && static_cast<float>(misses) / (t + 1 - start) <= limit)
+			{
+				boundaries.push_back(t + 1);
+				misses = 0;
+				start = t + 1;
+				cache.Flush();
+			}
+		}
+	}
+	boundaries.push_back(triangleCount);
+
+	// Area-weighted centroid and normal of each cluster, and of the whole mesh.
+	size_t clusterCount = boundaries.size() - 1;
+	std::vector<XMFLOAT3> clusterCentroids(clusterCount);
+	std::vector<XMFLOAT3> clusterNormals(clusterCount);
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+
+		for (size_t t = boundaries[c]; t < boundaries[c + 1]; t++)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&positions[indices[t * 3]]);
+			XMVECTOR p1 = XMLoadFloat3(&positions[indices[t * 3 + 1]]);
+			XMVECTOR p2 = XMLoadFloat3(&positions[indices[t * 3 + 2]]);
+
+			// Twice the area, in the direction of the face normal.
+			XMVECTOR faceNormal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+			float faceArea = XMVectorGetX(XMVector3Length(faceNormal));
+
+			centroid = XMVectorAdd(centroid, XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), faceArea / 3.0f));
+			normal = XMVectorAdd(normal, faceNormal);
+			area += faceArea;
+		}
+
+		meshCentroid = XMVectorAdd(meshCentroid, centroid);
+		meshArea += area;
+
+		XMStoreFloat3(&clusterCentroids[c], area > 0.0f ? XMVectorScale(centroid, 1.0f / area) : centroid);
+		XMStoreFloat3(&clusterNormals[c], XMVector3Normalize(normal));
+	}
+
+	if (meshArea > 0.0f)
+	{
+		meshCentroid = XMVectorScale(meshCentroid, 1.0f / meshArea);
+	}
+
+	// Draw the clusters that face away from the center the most first.
+	std::vector<float> sortKeys(clusterCount);
+	std::vector<uint32_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		XMVECTOR outward = XMVectorSubtract(XMLoadFloat3(&clusterCentroids[c]), meshCentroid);
+		sortKeys[c] = XMVectorGetX(XMVector3Dot(outward, XMLoadFloat3(&clusterNormals[c])));
+		order[c] = static_cast<uint32_t>(c);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b)
+	{
+		return sortKeys[a] > sortKeys[b];
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(triangleCount * 3);
+	for (uint32_t c : order)
+	{
+		result.insert(result.end(), indices.begin() + boundaries[c] * 3, indices.begin() + boundaries[c + 1] * 3);
+	}
+
+	// Every triangle is in exactly one cluster.
+	assert(result.size() == indices.size());
+	return result;
+}
+
+std::vector<uint32_t> DX::OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	static const uint32_t Unassigned = UINT32_MAX;
+
+	std::vector<uint32_t> remap(vertexCount, Unassigned);
+	uint32_t next = 0;
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == Unassigned)
+		{
+			remap[index] = next++;
+		}
+		index = remap[index];
+	}
+
+	for (uint32_t& newIndex : remap)
+	{
+		if (newIndex == Unassigned)
+		{
+			newIndex = next++;
+		}
+	}
+
+	return remap;
+}
+
+VertexCacheStatistics DX::AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize)
+{
+	FifoCache cache(vertexCount, cacheSize);
+
+	VertexCacheStatistics statistics = {};
+	for (uint32_t index : indices)
+	{
+		statistics.verticesTransformed += cache.Access(index);
+	}
+
+	size_t triangleCount = indices.size() / 3;
+	statistics.acmr = triangleCount > 0 ? static_cast<float>(statistics.verticesTransformed) / triangleCount : 0.0f;
+	statistics.atvr = vertexCount > 0 ? static_cast<float>(statistics.verticesTransformed) / vertexCount : 0.0f;
+	return statistics;
+}
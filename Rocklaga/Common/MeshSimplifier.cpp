@@ -0,0 +1,434 @@
+﻿#include "pch.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DX;
+using namespace DirectX;
+
+namespace
+{
+	static const uint32_t InvalidVertex = UINT32_MAX;
+
+	// Border planes are weighted well above the surface, so borders keep their shape.
+	static const double BorderWeight = 10.0;
+
+	// Surviving triangles may turn by at most about 75 degrees in one collapse.
+	static const float MinimumNormalCosine = 0.25f;
+
+	// Nor may they collapse to slivers.
+	static const float MinimumAreaRatio = 1.0e-3f;
+
+	// The symmetric matrix [A b; b^T c] summing the squared distances to a set of planes. Only
+	// surface planes add to the weight, which turns the sum into a mean squared distance.
+	struct Quadric
+	{
+		double a00, a11, a22, a01, a02, a12;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+
+	void AddPlane(Quadric& q, XMVECTOR normal, XMVECTOR point, double weight)
+	{
+		XMFLOAT3 n;
+		XMStoreFloat3(&n, normal);
+		double d = -XMVectorGetX(XMVector3Dot(normal, point));
+
+		q.a00 += weight * n.x * n.x;
+		q.a11 += weight * n.y * n.y;
+		q.a22 += weight * n.z * n.z;
+		q.a01 += weight * n.x * n.y;
+		q.a02 += weight * n.x * n.z;
+		q.a12 += weight * n.y * n.z;
+		q.b0 += weight * n.x * d;
+		q.b1 += weight * n.y * d;
+		q.b2 += weight * n.z * d;
+		q.c += weight * d * d;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a00 += other.a00;
+		q.a11 += other.a11;
+		q.a22 += other.a22;
+		q.a01 += other.a01;
+		q.a02 += other.a02;
+		q.a12 += other.a12;
+		q.b0 += other.b0;
+		q.b1 += other.b1;
+		q.b2 += other.b2;
+		q.c += other.c;
+		q.weight += other.weight;
+	}
+
+	// Mean squared distance from p to the quadric's planes.
+	double Evaluate(const Quadric& q, const XMFLOAT3& p)
+	{
+		double x = p.x;
+		double y = p.y;
+		double z = p.z;
+		double error =
+			q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+			2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+			2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) +
+			q.c;
+
+		return q.weight > 0.0 ? std::max(error, 0.0) / q.weight : std::max(error, 0.0);
+	}
+
+	struct Collapse
+	{
+		uint32_t	from;
+		uint32_t	to;
+		double		error;
+	};
+
+	// Number of triangles around vertex a that also use vertex b.
+	uint32_t SharedTriangles(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& triangles, uint32_t a, uint32_t b)
+	{
+		uint32_t shared = 0;
+		for (uint32_t i = offsets[a]; i < offsets[a + 1]; i++)
+		{
+			uint32_t t = triangles[i];
+			if (indices[t * 3] == b || indices[t * 3 + 1] == b || indices[t * 3 + 2] == b)
+			{
+				shared++;
+			}
+		}
+		return shared;
+	}
+}
+
+std::vector<uint32_t> DX::SimplifyMesh(const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float* resultError)
+{
+	size_t vertexCount = positions.size();
+	std::vector<uint32_t> result(indices.begin(), indices.end() - indices.size() % 3);
+
+	// Weld vertices that share a position. Topology and quadrics work on the welded vertices,
+	// named by the first vertex at each position.
+	std::vector<uint32_t> sorted(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		sorted[v] = static_cast<uint32_t>(v);
+	}
+
+	auto lessPosition = [&positions](uint32_t a, uint32_t b)
+	{
+		const XMFLOAT3& pa = positions[a];
+		const XMFLOAT3& pb = positions[b];
+		return pa.x != pb.x ? pa.x < pb.x : (pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z);
+	};
+	std::stable_sort(sorted.begin(), sorted.end(), lessPosition);
+
+	std::vector<uint32_t> welded(vertexCount);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		bool samePosition = i > 0 && !lessPosition(sorted[i - 1], sorted[i]);
+		welded[sorted[i]] = samePosition ? welded[sorted[i - 1]] : sorted[i];
+	}
+
+	std::vector<uint32_t> weldedIndices(result.size());
+	for (size_t i = 0; i < result.size(); i++)
+	{
+		weldedIndices[i] = welded[result[i]];
+	}
+
+	// Vertex to triangle adjacency over the welded indices, rebuilt after each pass.
+	std::vector<uint32_t> offsets(vertexCount + 1);
+	std::vector<uint32_t> triangles;
+	auto buildAdjacency = [&]()
+	{
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (uint32_t v : weldedIndices)
+		{
+			offsets[v + 1]++;
+		}
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			offsets[v + 1] += offsets[v];
+		}
+
+		triangles.resize(weldedIndices.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < weldedIndices.size(); i++)
+		{
+			triangles[fill[weldedIndices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	};
+	buildAdjacency();
+
+	// Surface quadrics are weighted by triangle area. Border edges add a plane through the edge,
+	// perpendicular to the triangle, so collapses along the border don't pull it inwards.
+	std::vector<Quadric> quadrics(vertexCount, Quadric());
+	for (size_t t = 0; t < weldedIndices.size() / 3; t++)
+	{
+		uint32_t v[3] = { weldedIndices[t * 3], weldedIndices[t * 3 + 1], weldedIndices[t * 3 + 2] };
+		XMVECTOR p[3] = { XMLoadFloat3(&positions[v[0]]), XMLoadFloat3(&positions[v[1]]), XMLoadFloat3(&positions[v[2]]) };
+
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p[1], p[0]), XMVectorSubtract(p[2], p[0]));
+		double area = 0.5 * XMVectorGetX(XMVector3Length(normal));
+		if (area <= 0.0)
+		{
+			continue;
+		}
+		normal = XMVector3Normalize(normal);
+
+		for (size_t k = 0; k < 3; k++)
+		{
+			AddPlane(quadrics[v[k]], normal, p[0], area);
+			quadrics[v[k]].weight += area;
+		}
+
+		for (size_t k = 0; k < 3; k++)
+		{
+			uint32_t a = v[k];
+			uint32_t b = v[(k + 1) % 3];
+			if (SharedTriangles(weldedIndices, offsets, triangles, a, b) != 1)
+			{
+				continue;
+			}
+
+			XMVECTOR edge = XMVectorSubtract(p[(k + 1) % 3], p[k]);
+			XMVECTOR borderNormal = XMVector3Normalize(XMVector3Cross(edge, normal));
+			double length = XMVectorGetX(XMVector3Length(edge));
+
+			Quadric border = Quadric();
+			AddPlane(border, borderNormal, p[k], BorderWeight * length * length);
+			AddQuadric(quadrics[a], border);
+			AddQuadric(quadrics[b], border);
+		}
+	}
+
+	double maxSquaredError = static_cast<double>(maxError) * maxError;
+	double reachedError = 0.0;
+
+	std::vector<Collapse> collapses;
+	std::vector<bool> border(vertexCount);
+	std::vector<bool> locked(vertexCount);
+	std::vector<uint32_t> collapseTarget(vertexCount, InvalidVertex);
+	std::vector<uint32_t> seamTarget(vertexCount, InvalidVertex);
+
+	// Each pass collapses the cheapest edges that don't touch each other, then rebuilds.
+	while (result.size() > targetIndexCount)
+	{
+		size_t triangleCount = weldedIndices.size() / 3;
+
+		std::fill(border.begin(), border.end(), false);
+		for (size_t i = 0; i < weldedIndices.size(); i++)
+		{
+			uint32_t a = weldedIndices[i];
+			uint32_t b = weldedIndices[i - i % 3 + (i + 1) % 3];
+			if (SharedTriangles(weldedIndices, offsets, triangles, a, b) == 1)
+			{
+				border[a] = true;
+				border[b] = true;
+			}
+		}
+
+		// The cheaper direction of each edge. A border vertex may only slide along a border edge.
+		collapses.clear();
+		for (size_t i = 0; i < weldedIndices.size(); i++)
+		{
+			uint32_t a = weldedIndices[i];
+			uint32_t b = weldedIndices[i - i % 3 + (i + 1) % 3];
+			if (a == b)
+			{
+				continue;
+			}
+
+			bool borderEdge = (border[a] || border[b]) && SharedTriangles(weldedIndices, offsets, triangles, a, b) == 1;
+
+			Quadric combined = quadrics[a];
+			AddQuadric(combined, quadrics[b]);
+
+			Collapse collapse = { 0, 0, 0.0 };
+			bool valid = false;
+			if (!border[a] || borderEdge)
+			{
+				collapse.from = a;
+				collapse.to = b;
+				collapse.error = Evaluate(combined, positions[b]);
+				valid = true;
+			}
+			if (!border[b] || borderEdge)
+			{
+				double error = Evaluate(combined, positions[a]);
+				if (!valid || error < collapse.error)
+				{
+					collapse.from = b;
+					collapse.to = a;
+					collapse.error = error;
+					valid = true;
+				}
+			}
+
+			if (valid)
+			{
+				collapses.push_back(collapse);
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+		{
+			return a.error < b.error;
+		});
+
+		// An interior collapse removes two triangles.
+		size_t goal = (result.size() - targetIndexCount) / 6 + 1;
+		size_t applied = 0;
+		std::fill(locked.begin(), locked.end(), false);
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (applied >= goal || collapse.error > maxSquaredError)
+			{
+				break;
+			}
+			if (locked[collapse.from] || locked[collapse.to])
+			{
+				continue;
+			}
+
+			// Reject the collapse if it would flip, sharply turn or flatten any triangle that survives it.
+			XMVECTOR from = XMLoadFloat3(&positions[collapse.from]);
+			XMVECTOR to = XMLoadFloat3(&positions[collapse.to]);
+			bool flips = false;
+			for (uint32_t i = offsets[collapse.from]; i < offsets[collapse.from + 1] && !flips; i++)
+			{
+				const uint32_t* triangle = &weldedIndices[triangles[i] * 3];
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					continue;
+				}
+
+				size_t k = triangle[0] == collapse.from ? 0 : (triangle[1] == collapse.from ? 1 : 2);
+				XMVECTOR p1 = XMLoadFloat3(&positions[triangle[(k + 1) % 3]]);
+				XMVECTOR p2 = XMLoadFloat3(&positions[triangle[(k + 2) % 3]]);
+
+				XMVECTOR before = XMVector3Cross(XMVectorSubtract(p1, from), XMVectorSubtract(p2, from));
+				XMVECTOR after = XMVector3Cross(XMVectorSubtract(p1, to), XMVectorSubtract(p2, to));
+				float beforeLength = XMVectorGetX(XMVector3Length(before));
+				float afterLength = XMVectorGetX(XMVector3Length(after));
+				flips =
+					XMVectorGetX(XMVector3Dot(before, after)) <= MinimumNormalCosine * beforeLength * afterLength ||
+					afterLength <= MinimumAreaRatio * beforeLength;
+			}
+			if (flips)
+			{
+				continue;
+			}
+
+			collapseTarget[collapse.from] = collapse.to;
+			AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+			reachedError = std::max(reachedError, collapse.error);
+			applied++;
+
+			// Triangles around the collapsed vertex change, so nothing else touching them may move.
+			for (uint32_t i = offsets[collapse.from]; i < offsets[collapse.from + 1]; i++)
+			{
+				const uint32_t* triangle = &weldedIndices[triangles[i] * 3];
+				locked[triangle[0]] = true;
+				locked[triangle[1]] = true;
+				locked[triangle[2]] = true;
+			}
+		}
+
+		if (applied == 0)
+		{
+			break;
+		}
+
+		// A collapsed vertex moves to a vertex it shares an edge with where possible, so the
+		// attributes on either side of a seam stay apart. Otherwise it takes the welded vertex.
+		for (size_t i = 0; i < result.size(); i++)
+		{
+			uint32_t a = result[i];
+			uint32_t b = result[i - i % 3 + (i + 1) % 3];
+			uint32_t c = result[i - i % 3 + (i + 2) % 3];
+			uint32_t target = collapseTarget[welded[a]];
+			if (target != InvalidVertex)
+			{
+				if (welded[b] == target)
+				{
+					seamTarget[a] = b;
+				}
+				else if (welded[c] == target)
+				{
+					seamTarget[a] = c;
+				}
+			}
+		}
+
+		size_t write = 0;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			uint32_t triangle[3];
+			uint32_t weldedTriangle[3];
+			for (size_t k = 0; k < 3; k++)
+			{
+				uint32_t v = result[t * 3 + k];
+				uint32_t target = collapseTarget[welded[v]];
+				if (target != InvalidVertex)
+				{
+					v = seamTarget[v] != InvalidVertex ? seamTarget[v] : target;
+				}
+				triangle[k] = v;
+				weldedTriangle[k] = welded[v];
+			}
+
+			if (weldedTriangle[0] == weldedTriangle[1] || weldedTriangle[1] == weldedTriangle[2] || weldedTriangle[0] == weldedTriangle[2])
+			{
+				continue;
+			}
+
+			for (size_t k = 0; k < 3; k++)
+			{
+				result[write] = triangle[k];
+				weldedIndices[write] = weldedTriangle[k];
+				write++;
+			}
+		}
+		result.resize(write);
+		weldedIndices.resize(write);
+
+		std::fill(collapseTarget.begin(), collapseTarget.end(), InvalidVertex);
+		std::fill(seamTarget.begin(), seamTarget.end(), InvalidVertex);
+		buildAdjacency();
+	}
+
+	if (resultError != nullptr)
+	{
+		*resultError = static_cast<float>(sqrt(reachedError));
+	}
+
+	return result;
+}
+
+std::vector<MeshLodSource> DX::GenerateMeshLods(const std::vector<XMFLOAT3>& positions, const std::vector<uint32_t>& indices, size_t maxLods, float reduction, float maxError)
+{
+	// Levels that keep more than this share of the previous level's triangles aren't worth a slot.
+	static const float MinimumReduction = 0.9f;
+
+	std::vector<MeshLodSource> lods(1);
+	lods[0].indices = indices;
+	lods[0].error = 0.0f;
+
+	while (lods.size() < maxLods)
+	{
+		size_t previousTriangles = lods.back().indices.size() / 3;
+		size_t targetTriangles = static_cast<size_t>(previousTriangles * reduction);
+
+		MeshLodSource lod;
+		lod.indices = SimplifyMesh(positions, indices, targetTriangles * 3, maxError, &lod.error);
+		if (lod.indices.empty() || lod.indices.size() / 3 > previousTriangles * MinimumReduction)
+		{
+			break;
+		}
+
+		lods.push_back(std::move(lod));
+	}
+
+	return lods;
+}
@@ -0,0 +1,24 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+#include "MeshFormat.h"
+
+namespace DX
+{
+	// Simplifies a triangle list by quadric error metric edge collapse (Garland and Heckbert).
+	// Each edge collapses onto one of its own vertices, so every level can draw from the
+	// original vertex buffer. Vertices at the same position are welded, so attribute seams don't
+	// stop simplification, and open borders only collapse along themselves. Stops once the
+	// result has at most targetIndexCount indices, or when the next collapse would move the
+	// surface more than maxError model units. The error reached is returned in resultError.
+	std::vector<uint32_t> SimplifyMesh(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount, float maxError, float* resultError);
+
+	// Builds up to maxLods levels of detail for EncodeMesh, starting with the mesh itself. Each
+	// level aims for reduction times the triangles of the one before and is simplified from the
+	// full mesh, so its error is measured against the original. Stops early once a level can't
+	// get within maxError or hardly removes anything.
+	std::vector<MeshLodSource> GenerateMeshLods(const std::vector<DirectX::XMFLOAT3>& positions, const std::vector<uint32_t>& indices, size_t maxLods, float reduction, float maxError);
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include "DirectXHelper.h"
+#include "StreamingLoader.h"
+
+namespace DX
+{
+	// Feeds the streaming loader from files in the app package.
+	class PackageFileSystem : public IStreamingFileSystem
+	{
+	public:
+		virtual void ReadAsync(const std::wstring& filename, const ReadCompletion& completion)
+		{
+			DX::ReadDataAsync(filename).then([completion](Concurrency::task<std::vector<byte>> readTask)
+			{
+				std::vector<byte> data;
+				bool succeeded = true;
+				try
+				{
+					data = readTask.get();
+				}
+				catch (Platform::Exception^)
+				{
+					succeeded = false;
+				}
+				completion(succeeded, data);
+			});
+		}
+	};
+}
@@ -0,0 +1,276 @@
+﻿#include "pch.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+
+using namespace DX;
+
+namespace
+{
+	// Finished scopes kept per thread: a few seconds of a few dozen scopes per frame.
+	static const uint32_t RingCapacity = 8192;
+
+	// Scopes nested deeper than this are not recorded.
+	static const uint32_t MaxDepth = 32;
+
+	// A ring slot guarded by a sequence number, so the collector can copy it while the owner
+	// may be overwriting it. The sequence is odd while the slot is being written, and
+	// index * 2 + 2 once it holds the scope with that index. Every field is atomic; relaxed
+	// accesses compile to plain loads and stores.
+	struct EventSlot
+	{
+		std::atomic<uint64_t>		sequence;
+		std::atomic<const char*>	name;
+		std::atomic<uint64_t>		start;
+		std::atomic<uint64_t>		duration;
+		std::atomic<uint32_t>		depth;
+	};
+
+	struct ThreadBuffer
+	{
+		uint32_t				threadId;
+
+		// Finished scopes. Only the owning thread writes, and it publishes each one by
+		// bumping the count.
+		EventSlot				events[RingCapacity];
+		std::atomic<uint64_t>	written;
+
+		// How far CollectCpuEvents has read. Guarded by the registry mutex.
+		uint64_t				collected;
+
+		// Scopes that have begun but not ended. Only the owning thread touches these.
+		const char*				openNames[MaxDepth];
+		uint64_t				openStarts[MaxDepth];
+		uint32_t				depth;
+	};
+
+	// Every buffer ever created. Buffers are never freed, so scopes from threads that have
+	// exited can still be collected, and a thread's lookup is just a thread_local pointer.
+	struct Registry
+	{
+		std::mutex									mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>>	buffers;
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry registry;
+		return registry;
+	}
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		static thread_local ThreadBuffer* threadBuffer = nullptr;
+
+		if (threadBuffer == nullptr)
+		{
+			// Value-initialized, so every slot's sequence starts at zero, which matches no scope.
+			std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+			buffer->written = 0;
+			buffer->collected = 0;
+			buffer->depth = 0;
+
+			Registry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			buffer->threadId = static_cast<uint32_t>(registry.buffers.size()) + 1;
+			threadBuffer = buffer.get();
+			registry.buffers.push_back(std::move(buffer));
+		}
+
+		return *threadBuffer;
+	}
+
+	// Writes nanoseconds as microseconds with three decimals, the unit trace events use.
+	void WriteMicroseconds(std::ostringstream& out, uint64_t nanoseconds)
+	{
+		out << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000 << std::setfill(' ');
+	}
+
+	void WriteString(std::ostringstream& out, const char* text)
+	{
+		out << '"';
+		for (const char* c = text; *c != '\0'; c++)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				out << '\\' << *c;
+			}
+			else if (static_cast<unsigned char>(*c) < 0x20)
+			{
+				out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(*c) << std::dec << std::setfill(' ');
+			}
+			else
+			{
+				out << *c;
+			}
+		}
+		out << '"';
+	}
+}
+
+uint64_t DX::GetProfilerTime()
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void DX::BeginCpuScope(const char* name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+
+	// Deeper scopes still count, so their ends pair up with the right begins.
+	if (buffer.depth < MaxDepth)
+	{
+		buffer.openNames[buffer.depth] = name;
+		buffer.openStarts[buffer.depth] = GetProfilerTime();
+	}
+	buffer.depth++;
+}
+
+void DX::EndCpuScope()
+{
+	uint64_t end = GetProfilerTime();
+	ThreadBuffer& buffer = GetThreadBuffer();
+
+	if (buffer.depth == 0)
+	{
+		return;
+	}
+
+	buffer.depth--;
+	if (buffer.depth >= MaxDepth)
+	{
+		return;
+	}
+
+	// Mark the slot as being written before touching the fields; the fence keeps the field
+	// stores from becoming visible ahead of the mark.
+	uint64_t index = buffer.written.load(std::memory_order_relaxed);
+	EventSlot& slot = buffer.events[index % RingCapacity];
+	slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	uint64_t start = buffer.openStarts[buffer.depth];
+	slot.name.store(buffer.openNames[buffer.depth], std::memory_order_relaxed);
+	slot.start.store(start, std::memory_order_relaxed);
+	slot.duration.store(end - start, std::memory_order_relaxed);
+	slot.depth.store(buffer.depth, std::memory_order_relaxed);
+
+	slot.sequence.store(index * 2 + 2, std::memory_order_release);
+	buffer.written.store(index + 1, std::memory_order_release);
+}
+
+size_t DX::CollectCpuEvents(std::vector<ProfileEvent>& events)
+{
+	size_t lost = 0;
+
+	Registry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	for (auto& buffer : registry.buffers)
+	{
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t first = buffer->collected;
+		if (written - first > RingCapacity)
+		{
+			lost += static_cast<size_t>(written - first - RingCapacity);
+			first = written - RingCapacity;
+		}
+
+		// The owner may keep writing while we copy. A slot whose sequence doesn't show the
+		// scope we want, before and after the copy, has been overwritten since; drop it.
+		for (uint64_t index = first; index < written; index++)
+		{
+			const EventSlot& slot = buffer->events[index % RingCapacity];
+			uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+			ProfileEvent profileEvent;
+			profileEvent.name = slot.name.load(std::memory_order_relaxed);
+			profileEvent.start = slot.start.load(std::memory_order_relaxed);
+			profileEvent.duration = slot.duration.load(std::memory_order_relaxed);
+			profileEvent.threadId = buffer->threadId;
+			profileEvent.depth = slot.depth.load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence != index * 2 + 2 || slot.sequence.load(std::memory_order_relaxed) != sequence)
+			{
+				lost++;
+				continue;
+			}
+
+			events.push_back(profileEvent);
+		}
+
+		buffer->collected = written;
+	}
+
+	return lost;
+}
+
+std::string DX::ExportChromeTrace(const std::vector<ProfileEvent>& events)
+{
+	// Sorted by thread and start time, so each track reads in order and parents precede children.
+	std::vector<ProfileEvent> sorted(events);
+	std::sort(sorted.begin(), sorted.end(), [] (const ProfileEvent& a, const ProfileEvent& b)
+	{
+		if (a.threadId != b.threadId)
+		{
+			return a.threadId < b.threadId;
+		}
+		if (a.start != b.start)
+		{
+			return a.start < b.start;
+		}
+		return a.depth < b.depth;
+	});
+
+	std::set<uint32_t> threadIds;
+	for (const auto& profileEvent : sorted)
+	{
+		threadIds.insert(profileEvent.threadId);
+	}
+
+	std::ostringstream out;
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first = true;
+	for (uint32_t threadId : threadIds)
+	{
+		out << (first ? "\n" : ",\n");
+		out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":";
+		if (threadId == GpuThreadId)
+		{
+			out << "\"GPU\"";
+		}
+		else
+		{
+			out << "\"CPU " << threadId << "\"";
+		}
+		out << "}}";
+		first = false;
+	}
+
+	for (const auto& profileEvent : sorted)
+	{
+		out << (first ? "\n" : ",\n");
+		out << "{\"name\":";
+		WriteString(out, profileEvent.name);
+		out << ",\"cat\":\"" << (profileEvent.threadId == GpuThreadId ? "gpu" : "cpu") << "\"";
+		out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << profileEvent.threadId << ",\"ts\":";
+		WriteMicroseconds(out, profileEvent.start);
+		out << ",\"dur\":";
+		WriteMicroseconds(out, profileEvent.duration);
+		out << "}";
+		first = false;
+	}
+
+	out << "\n]}\n";
+	return out.str();
+}
@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DX
+{
+	// One timed scope. Times are nanoseconds on the profiler clock.
+	struct ProfileEvent
+	{
+		const char*	name;		// Scope names are string literals, so events can be kept indefinitely.
+		uint64_t	start;
+		uint64_t	duration;
+		uint32_t	threadId;	// Numbered from 1 in the order threads first record a scope, or GpuThreadId.
+		uint32_t	depth;		// Nesting level within the thread, or within the frame on the GPU.
+	};
+
+	static const uint32_t GpuThreadId = 0;
+
+	// Nanoseconds since the profiler clock started. Steady and shared by every thread.
+	uint64_t GetProfilerTime();
+
+	// CPU scope markers. Each thread writes finished scopes into its own fixed-size ring buffer
+	// without locking, so a marker costs two clock reads and a few stores. Only the most recent
+	// scopes are kept; older ones are overwritten if they aren't collected in time.
+	void BeginCpuScope(const char* name);
+	void EndCpuScope();
+
+	// Appends the scopes finished on every thread since the last call. Returns the number of
+	// scopes lost because a ring buffer wrapped in between. Safe to call from any thread while
+	// others record scopes: every event returned was completely written, and a scope that is
+	// overwritten while being copied is counted as lost rather than returned torn.
+	size_t CollectCpuEvents(std::vector<ProfileEvent>& events);
+
+	// Times the enclosing block.
+	class CpuScope
+	{
+	public:
+		explicit CpuScope(const char* name)		{ BeginCpuScope(name); }
+		~CpuScope()								{ EndCpuScope(); }
+
+	private:
+		CpuScope(const CpuScope&);
+		CpuScope& operator=(const CpuScope&);
+	};
+
+	// Chrome trace event JSON, for chrome://tracing or Perfetto. Each scope is a complete ("X")
+	// event, and every thread is named so the GPU shows up as its own track.
+	std::string ExportChromeTrace(const std::vector<ProfileEvent>& events);
+}
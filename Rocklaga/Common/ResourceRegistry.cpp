@@ -0,0 +1,187 @@
+﻿#include "pch.h"
+#include "ResourceRegistry.h"
+#include "DirectXHelper.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+using namespace DX;
+
+ResourceRegistry::ResourceRegistry() :
+	m_nextResource(InvalidResource + 1),
+	m_statistics(nullptr),
+	m_pendingSorted(true),
+	m_lostTime(0),
+	m_recovering(false),
+	m_createSeconds(0.0),
+	m_lastRecoverySeconds(0.0),
+	m_lastCreateSeconds(0.0)
+{
+}
+
+ResourceId ResourceRegistry::RegisterBuffer(const D3D11_BUFFER_DESC& desc, const void* initialData, int32_t priority)
+{
+	std::shared_ptr<const void> data;
+	if (initialData != nullptr)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(initialData);
+		auto copy = std::make_shared<std::vector<uint8_t>>(bytes, bytes + desc.ByteWidth);
+		data = std::shared_ptr<const void>(copy, copy->data());
+	}
+
+	return Register(desc, data, priority);
+}
+
+ResourceId ResourceRegistry::RegisterBuffer(const D3D11_BUFFER_DESC& desc, const void* initialData, const std::shared_ptr<const void>& dataOwner, int32_t priority)
+{
+	std::shared_ptr<const void> data;
+	if (initialData != nullptr)
+	{
+		data = std::shared_ptr<const void>(dataOwner, initialData);
+	}
+
+	return Register(desc, data, priority);
+}
+
+ResourceId ResourceRegistry::Register(const D3D11_BUFFER_DESC& desc, const std::shared_ptr<const void>& initialData, int32_t priority)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	ResourceId resource = m_nextResource++;
+	Entry& entry = m_entries[resource];
+	entry.desc = desc;
+	entry.initialData = initialData;
+	entry.priority = priority;
+
+	if (m_device != nullptr)
+	{
+		Create(entry);
+	}
+
+	return resource;
+}
+
+void ResourceRegistry::Unregister(ResourceId resource)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Stale pending entries are skipped by Update.
+	m_entries.erase(resource);
+}
+
+ID3D11Buffer* ResourceRegistry::GetBuffer(ResourceId resource) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto entry = m_entries.find(resource);
+	return entry != m_entries.end() ? entry->second.buffer.Get() : nullptr;
+}
+
+void ResourceRegistry::CreateDeviceObjects(ID3D11Device* device, DeviceStatistics* statistics)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_device = device;
+	m_statistics = statistics;
+
+	m_pending.clear();
+	for (const auto& entry : m_entries)
+	{
+		m_pending.push_back(entry.first);
+	}
+	m_pendingSorted = false;
+}
+
+void ResourceRegistry::ReleaseDeviceObjects()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (auto& entry : m_entries)
+	{
+		entry.second.buffer.Reset();
+	}
+
+	m_device.Reset();
+	m_pending.clear();
+
+	m_lostTime = GetProfilerTime();
+	m_recovering = true;
+	m_createSeconds = 0.0;
+}
+
+void ResourceRegistry::Update(double budgetSeconds)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_device == nullptr)
+	{
+		return;
+	}
+
+	if (!m_pendingSorted)
+	{
+		std::sort(m_pending.begin(), m_pending.end(), [this] (ResourceId a, ResourceId b)
+		{
+			int32_t priorityA = m_entries.count(a) != 0 ? m_entries[a].priority : 0;
+			int32_t priorityB = m_entries.count(b) != 0 ? m_entries[b].priority : 0;
+			return priorityA != priorityB ? priorityA < priorityB : a > b;
+		});
+		m_pendingSorted = true;
+	}
+
+	uint64_t start = GetProfilerTime();
+	uint64_t budget = static_cast<uint64_t>(budgetSeconds * 1e9);
+
+	while (!m_pending.empty())
+	{
+		auto entry = m_entries.find(m_pending.back());
+		m_pending.pop_back();
+
+		// Unregistered since, or registered after the device came back.
+		if (entry == m_entries.end() || entry->second.buffer != nullptr)
+		{
+			continue;
+		}
+
+		Create(entry->second);
+
+		if (GetProfilerTime() - start >= budget)
+		{
+			break;
+		}
+	}
+
+	m_createSeconds += (GetProfilerTime() - start) * 1e-9;
+
+	if (m_pending.empty() && m_recovering)
+	{
+		m_lastRecoverySeconds = (GetProfilerTime() - m_lostTime) * 1e-9;
+		m_lastCreateSeconds = m_createSeconds;
+		m_recovering = false;
+	}
+}
+
+size_t ResourceRegistry::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pending.size();
+}
+
+void ResourceRegistry::Create(Entry& entry)
+{
+	D3D11_SUBRESOURCE_DATA data = {0};
+	data.pSysMem = entry.initialData.get();
+
+	DX::ThrowIfFailed(
+		m_device->CreateBuffer(
+			&entry.desc,
+			entry.initialData != nullptr ? &data : nullptr,
+			&entry.buffer
+			)
+		);
+
+	if (m_statistics != nullptr)
+	{
+		m_statistics->RecordBuffer(entry.desc.ByteWidth);
+	}
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "DeviceStatistics.h"
+
+namespace DX
+{
+	typedef uint32_t ResourceId;
+	static const ResourceId InvalidResource = 0;
+
+	// Buffers whose description and initial data are kept available, so that after device loss
+	// they are recreated with nothing but Create calls: no file reads, no decoding, no mesh
+	// processing. Recreation is spread over frames, highest priority first, and renderers skip
+	// drawing until the buffers they need are back.
+	class ResourceRegistry
+	{
+	public:
+		ResourceRegistry();
+
+		// Keeps a copy of the initial data, if any, and creates the buffer right away when
+		// there is a device. May be called from loading threads.
+		ResourceId RegisterBuffer(const D3D11_BUFFER_DESC& desc, const void* initialData, int32_t priority);
+
+		// Uses the initial data in place instead of copying it, holding on to dataOwner, such as
+		// a mapped file the data points into, until the buffer is unregistered.
+		ResourceId RegisterBuffer(const D3D11_BUFFER_DESC& desc, const void* initialData, const std::shared_ptr<const void>& dataOwner, int32_t priority);
+		void Unregister(ResourceId resource);
+
+		// Null while the buffer is waiting to be recreated.
+		ID3D11Buffer* GetBuffer(ResourceId resource) const;
+
+		// Called by DeviceResources around device loss. Creating device objects only queues
+		// every buffer; Update creates them.
+		void CreateDeviceObjects(ID3D11Device* device, DeviceStatistics* statistics);
+		void ReleaseDeviceObjects();
+
+		// Call once per frame. Recreates queued buffers until budgetSeconds have passed, at
+		// least one per call so recovery always makes progress.
+		void Update(double budgetSeconds);
+
+		size_t GetPendingCount() const;
+
+		// Seconds from ReleaseDeviceObjects until the last buffer was recreated, for the most
+		// recent device loss, and the part of it spent in Create calls.
+		double GetLastRecoverySeconds() const		{ return m_lastRecoverySeconds; }
+		double GetLastCreateSeconds() const			{ return m_lastCreateSeconds; }
+
+	private:
+		struct Entry
+		{
+			D3D11_BUFFER_DESC						desc;
+			std::shared_ptr<const void>				initialData;	// Points at the data and keeps its owner alive.
+			int32_t									priority;
+			Microsoft::WRL::ComPtr<ID3D11Buffer>	buffer;
+		};
+
+		ResourceId Register(const D3D11_BUFFER_DESC& desc, const std::shared_ptr<const void>& initialData, int32_t priority);
+		void Create(Entry& entry);
+
+		mutable std::mutex								m_mutex;
+		std::unordered_map<ResourceId, Entry>			m_entries;
+		ResourceId										m_nextResource;
+		Microsoft::WRL::ComPtr<ID3D11Device>			m_device;
+		DeviceStatistics*								m_statistics;
+
+		// Buffers still to be recreated, highest priority last so they pop off the back.
+		std::vector<ResourceId>							m_pending;
+		bool											m_pendingSorted;
+
+		// Recovery timing, on the profiler clock.
+		uint64_t										m_lostTime;
+		bool											m_recovering;
+		double											m_createSeconds;
+		double											m_lastRecoverySeconds;
+		double											m_lastCreateSeconds;
+	};
+}
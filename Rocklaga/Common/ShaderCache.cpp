@@ -0,0 +1,189 @@
+﻿#include "pch.h"
+#include "ShaderCache.h"
+#include "DirectXHelper.h"
+
+using namespace DX;
+
+using namespace Concurrency;
+using namespace Microsoft::WRL;
+
+ShaderCache::ShaderCache() :
+	m_statistics(nullptr)
+{
+}
+
+task<void> ShaderCache::LoadAsync(const std::wstring& filename)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_library.FindName(filename) != ShaderLibrary::InvalidId)
+		{
+			return task_from_result();
+		}
+	}
+
+	return DX::ReadDataAsync(filename).then([this, filename](const std::vector<byte>& fileData) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_library.SetName(filename, m_library.AddBytecode(fileData.data(), fileData.size()));
+	});
+}
+
+uint32 ShaderCache::FindBytecode(const std::wstring& filename) const
+{
+	uint32 bytecodeId = m_library.FindName(filename);
+	if (bytecodeId == ShaderLibrary::InvalidId)
+	{
+		// The shader was not loaded with LoadAsync first.
+		DX::ThrowIfFailed(E_INVALIDARG);
+	}
+	return bytecodeId;
+}
+
+ID3D11VertexShader* ShaderCache::GetVertexShader(const std::wstring& filename)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32 bytecodeId = FindBytecode(filename);
+	m_library.SetStage(bytecodeId, ShaderStage::Vertex);
+	CreateShader(bytecodeId);
+
+	return m_vertexShaders[bytecodeId].Get();
+}
+
+ID3D11PixelShader* ShaderCache::GetPixelShader(const std::wstring& filename)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32 bytecodeId = FindBytecode(filename);
+	m_library.SetStage(bytecodeId, ShaderStage::Pixel);
+	CreateShader(bytecodeId);
+
+	return m_pixelShaders[bytecodeId].Get();
+}
+
+ID3D11InputLayout* ShaderCache::GetInputLayout(const std::wstring& vertexShaderFilename, const D3D11_INPUT_ELEMENT_DESC* elements, UINT elementCount)
+{
+	std::vector<InputLayoutElement> layout(elementCount);
+	for (UINT i = 0; i < elementCount; i++)
+	{
+		layout[i].semanticName = elements[i].SemanticName;
+		layout[i].semanticIndex = elements[i].SemanticIndex;
+		layout[i].format = elements[i].Format;
+		layout[i].inputSlot = elements[i].InputSlot;
+		layout[i].alignedByteOffset = elements[i].AlignedByteOffset;
+		layout[i].inputSlotClass = elements[i].InputSlotClass;
+		layout[i].instanceDataStepRate = elements[i].InstanceDataStepRate;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32 layoutId = m_library.AddInputLayout(FindBytecode(vertexShaderFilename), layout);
+	CreateInputLayout(layoutId);
+
+	return m_inputLayouts[layoutId].Get();
+}
+
+// Creates the shader for the bytecode if it does not exist yet. The lock must be held.
+void ShaderCache::CreateShader(uint32 bytecodeId)
+{
+	const ShaderLibrary::Bytecode& bytecode = m_library.GetBytecode(bytecodeId);
+	if (m_vertexShaders.size() <= bytecodeId)
+	{
+		m_vertexShaders.resize(m_library.GetBytecodeCount());
+		m_pixelShaders.resize(m_library.GetBytecodeCount());
+	}
+
+	if (bytecode.stage == ShaderStage::Vertex && m_vertexShaders[bytecodeId] == nullptr)
+	{
+		DX::ThrowIfFailed(
+			m_device->CreateVertexShader(
+				bytecode.data.data(),
+				bytecode.data.size(),
+				nullptr,
+				&m_vertexShaders[bytecodeId]
+				)
+			);
+		m_statistics->RecordShader(bytecode.data.size());
+	}
+	else if (bytecode.stage == ShaderStage::Pixel && m_pixelShaders[bytecodeId] == nullptr)
+	{
+		DX::ThrowIfFailed(
+			m_device->CreatePixelShader(
+				bytecode.data.data(),
+				bytecode.data.size(),
+				nullptr,
+				&m_pixelShaders[bytecodeId]
+				)
+			);
+		m_statistics->RecordShader(bytecode.data.size());
+	}
+}
+
+// Creates the input layout if it does not exist yet. The lock must be held.
+void ShaderCache::CreateInputLayout(uint32 layoutId)
+{
+	if (m_inputLayouts.size() <= layoutId)
+	{
+		m_inputLayouts.resize(m_library.GetInputLayoutCount());
+	}
+
+	if (m_inputLayouts[layoutId] != nullptr)
+	{
+		return;
+	}
+
+	const ShaderLibrary::InputLayout& layout = m_library.GetInputLayout(layoutId);
+	const ShaderLibrary::Bytecode& bytecode = m_library.GetBytecode(layout.bytecodeId);
+
+	std::vector<D3D11_INPUT_ELEMENT_DESC> elements(layout.elements.size());
+	for (size_t i = 0; i < elements.size(); i++)
+	{
+		const InputLayoutElement& element = layout.elements[i];
+		elements[i].SemanticName = element.semanticName.c_str();
+		elements[i].SemanticIndex = element.semanticIndex;
+		elements[i].Format = static_cast<DXGI_FORMAT>(element.format);
+		elements[i].InputSlot = element.inputSlot;
+		elements[i].AlignedByteOffset = element.alignedByteOffset;
+		elements[i].InputSlotClass = static_cast<D3D11_INPUT_CLASSIFICATION>(element.inputSlotClass);
+		elements[i].InstanceDataStepRate = element.instanceDataStepRate;
+	}
+
+	DX::ThrowIfFailed(
+		m_device->CreateInputLayout(
+			elements.data(),
+			static_cast<UINT>(elements.size()),
+			bytecode.data.data(),
+			bytecode.data.size(),
+			&m_inputLayouts[layoutId]
+			)
+		);
+}
+
+// Recreates every shader and input layout that was in use, from the bytecode kept in memory.
+void ShaderCache::CreateDeviceObjects(ID3D11Device* device, DeviceStatistics* statistics)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_device = device;
+	m_statistics = statistics;
+
+	for (uint32 i = 0; i < m_library.GetBytecodeCount(); i++)
+	{
+		CreateShader(i);
+	}
+
+	for (uint32 i = 0; i < m_library.GetInputLayoutCount(); i++)
+	{
+		CreateInputLayout(i);
+	}
+}
+
+void ShaderCache::ReleaseDeviceObjects()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_vertexShaders.clear();
+	m_pixelShaders.clear();
+	m_inputLayouts.clear();
+	m_device.Reset();
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <mutex>
+#include <ppltasks.h>
+#include "ShaderLibrary.h"
+#include "DeviceStatistics.h"
+
+namespace DX
+{
+	// Shared vertex shaders, pixel shaders and input layouts for every renderer. Shader files are
+	// read once and their bytecode kept, identical shaders and layouts map to a single device
+	// object, and after device loss every object is recreated in one pass from the kept bytecode.
+	class ShaderCache
+	{
+	public:
+		ShaderCache();
+
+		// Reads a compiled shader from the package. Completes immediately if it was read before.
+		Concurrency::task<void> LoadAsync(const std::wstring& filename);
+
+		// Return the device object for a shader file loaded with LoadAsync, creating it on first use.
+		ID3D11VertexShader* GetVertexShader(const std::wstring& filename);
+		ID3D11PixelShader* GetPixelShader(const std::wstring& filename);
+		ID3D11InputLayout* GetInputLayout(const std::wstring& vertexShaderFilename, const D3D11_INPUT_ELEMENT_DESC* elements, UINT elementCount);
+
+		// Called by DeviceResources around device loss. Shaders created are counted in statistics.
+		void CreateDeviceObjects(ID3D11Device* device, DeviceStatistics* statistics);
+		void ReleaseDeviceObjects();
+
+	private:
+		uint32 FindBytecode(const std::wstring& filename) const;
+		void CreateShader(uint32 bytecodeId);
+		void CreateInputLayout(uint32 layoutId);
+
+		std::mutex											m_mutex;
+		ShaderLibrary										m_library;
+		Microsoft::WRL::ComPtr<ID3D11Device>				m_device;
+		DeviceStatistics*									m_statistics;
+
+		// Device objects, indexed by library id.
+		std::vector<Microsoft::WRL::ComPtr<ID3D11VertexShader>>	m_vertexShaders;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11PixelShader>>	m_pixelShaders;
+		std::vector<Microsoft::WRL::ComPtr<ID3D11InputLayout>>	m_inputLayouts;
+	};
+}
@@ -0,0 +1,105 @@
+﻿#include "pch.h"
+#include "ShaderLibrary.h"
+
+#include <cstring>
+#include "Hash.h"
+
+using namespace DX;
+
+bool InputLayoutElement::operator==(const InputLayoutElement& other) const
+{
+	return
+		semanticName == other.semanticName &&
+		semanticIndex == other.semanticIndex &&
+		format == other.format &&
+		inputSlot == other.inputSlot &&
+		alignedByteOffset == other.alignedByteOffset &&
+		inputSlotClass == other.inputSlotClass &&
+		instanceDataStepRate == other.instanceDataStepRate;
+}
+
+uint32_t ShaderLibrary::AddBytecode(const uint8_t* data, size_t size)
+{
+	uint64_t hash = HashBytes(data, size);
+
+	auto range = m_bytecodeByHash.equal_range(hash);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const Bytecode& existing = m_bytecode[it->second];
+		if (existing.data.size() == size && memcmp(existing.data.data(), data, size) == 0)
+		{
+			return it->second;
+		}
+	}
+
+	uint32_t bytecodeId = static_cast<uint32_t>(m_bytecode.size());
+
+	Bytecode bytecode;
+	bytecode.hash = hash;
+	bytecode.stage = ShaderStage::Unknown;
+	bytecode.data.assign(data, data + size);
+	m_bytecode.push_back(std::move(bytecode));
+
+	m_bytecodeByHash.emplace(hash, bytecodeId);
+	return bytecodeId;
+}
+
+void ShaderLibrary::SetName(const std::wstring& name, uint32_t bytecodeId)
+{
+	m_bytecodeByName[name] = bytecodeId;
+}
+
+uint32_t ShaderLibrary::FindName(const std::wstring& name) const
+{
+	auto it = m_bytecodeByName.find(name);
+	return it != m_bytecodeByName.end() ? it->second : InvalidId;
+}
+
+void ShaderLibrary::SetStage(uint32_t bytecodeId, ShaderStage stage)
+{
+	m_bytecode[bytecodeId].stage = stage;
+}
+
+uint32_t ShaderLibrary::AddInputLayout(uint32_t bytecodeId, const std::vector<InputLayoutElement>& elements)
+{
+	uint64_t key = HashInputLayout(m_bytecode[bytecodeId].hash, elements);
+
+	auto range = m_inputLayoutsByKey.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const InputLayout& existing = m_inputLayouts[it->second];
+		if (existing.bytecodeId == bytecodeId && existing.elements == elements)
+		{
+			return it->second;
+		}
+	}
+
+	uint32_t layoutId = static_cast<uint32_t>(m_inputLayouts.size());
+
+	InputLayout layout;
+	layout.key = key;
+	layout.bytecodeId = bytecodeId;
+	layout.elements = elements;
+	m_inputLayouts.push_back(std::move(layout));
+
+	m_inputLayoutsByKey.emplace(key, layoutId);
+	return layoutId;
+}
+
+// The layout signature covers every field of every element, including the semantic name's
+// characters rather than its address.
+uint64_t ShaderLibrary::HashInputLayout(uint64_t bytecodeHash, const std::vector<InputLayoutElement>& elements)
+{
+	uint64_t hash = HashValue(bytecodeHash);
+	for (const auto& element : elements)
+	{
+		hash = HashBytes(element.semanticName.data(), element.semanticName.size() + 1, hash);
+		hash = HashValue(element.semanticIndex, hash);
+		hash = HashValue(element.format, hash);
+		hash = HashValue(element.inputSlot, hash);
+		hash = HashValue(element.alignedByteOffset, hash);
+		hash = HashValue(element.inputSlotClass, hash);
+		hash = HashValue(element.instanceDataStepRate, hash);
+	}
+	return hash;
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DX
+{
+	enum class ShaderStage : uint8_t
+	{
+		Unknown,
+		Vertex,
+		Pixel,
+	};
+
+	// One element of an input layout. Mirrors D3D11_INPUT_ELEMENT_DESC, but owns its semantic
+	// name so the layout can be recreated after the renderer that described it is gone.
+	struct InputLayoutElement
+	{
+		std::string	semanticName;
+		uint32_t	semanticIndex;
+		uint32_t	format;
+		uint32_t	inputSlot;
+		uint32_t	alignedByteOffset;
+		uint32_t	inputSlotClass;
+		uint32_t	instanceDataStepRate;
+
+		bool operator==(const InputLayoutElement& other) const;
+	};
+
+	// Keeps one copy of every distinct shader bytecode and input layout, keyed by a hash of
+	// their contents. The ids it hands out index the device objects created from them, so two
+	// renderers loading identical shaders, or describing the same layout for the same vertex
+	// shader, share one object. Holds no device objects itself, so it survives device loss.
+	class ShaderLibrary
+	{
+	public:
+		static const uint32_t InvalidId = UINT32_MAX;
+
+		struct Bytecode
+		{
+			uint64_t				hash;
+			ShaderStage				stage;
+			std::vector<uint8_t>	data;
+		};
+
+		struct InputLayout
+		{
+			uint64_t						key;
+			uint32_t						bytecodeId;
+			std::vector<InputLayoutElement>	elements;
+		};
+
+		// Returns the id of the bytecode, adding it if no identical bytecode is stored yet.
+		uint32_t AddBytecode(const uint8_t* data, size_t size);
+
+		// Associates a file name with stored bytecode, so the file never needs to be read again.
+		void SetName(const std::wstring& name, uint32_t bytecodeId);
+		uint32_t FindName(const std::wstring& name) const;
+
+		// Records which stage the bytecode is used for, so its shader can be recreated in bulk.
+		void SetStage(uint32_t bytecodeId, ShaderStage stage);
+
+		// Returns the id of the layout for the given vertex shader, adding it if it is new.
+		uint32_t AddInputLayout(uint32_t bytecodeId, const std::vector<InputLayoutElement>& elements);
+
+		const Bytecode& GetBytecode(uint32_t bytecodeId) const			{ return m_bytecode[bytecodeId]; }
+		const InputLayout& GetInputLayout(uint32_t layoutId) const		{ return m_inputLayouts[layoutId]; }
+		size_t GetBytecodeCount() const									{ return m_bytecode.size(); }
+		size_t GetInputLayoutCount() const								{ return m_inputLayouts.size(); }
+
+		static uint64_t HashInputLayout(uint64_t bytecodeHash, const std::vector<InputLayoutElement>& elements);
+
+	private:
+		std::vector<Bytecode>						m_bytecode;
+		std::vector<InputLayout>					m_inputLayouts;
+
+		// Hash to id. Several ids can share a hash; contents are compared to tell them apart.
+		std::unordered_multimap<uint64_t, uint32_t>	m_bytecodeByHash;
+		std::unordered_multimap<uint64_t, uint32_t>	m_inputLayoutsByKey;
+		std::unordered_map<std::wstring, uint32_t>	m_bytecodeByName;
+	};
+}
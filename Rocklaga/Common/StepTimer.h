@@ -106,6 +106,35 @@ namespace DX
 
 			uint32 lastFrameCount = m_frameCount;
 
+			Advance(timeDelta, update);
+
+			// Track the current framerate.
+			if (m_frameCount != lastFrameCount)
+			{
+				m_framesThisSecond++;
+			}
+
+			if (m_qpcSecondCounter >= static_cast<uint64>(m_qpcFrequency.QuadPart))
+			{
+				m_framesPerSecond = m_framesThisSecond;
+				m_framesThisSecond = 0;
+				m_qpcSecondCounter %= m_qpcFrequency.QuadPart;
+			}
+		}
+
+		// Update timer state by an explicit amount of time instead of querying the performance counter.
+		// This acts as a fake clock, e.g. to replay recorded input as fast as possible without rendering.
+		template<typename TUpdate>
+		void TickFake(uint64 elapsedTicks, const TUpdate& update)
+		{
+			Advance(elapsedTicks, update);
+		}
+
+	private:
+		// Runs the fixed or variable timestep logic for a time delta already converted to ticks.
+		template<typename TUpdate>
+		void Advance(uint64 timeDelta, const TUpdate& update)
+		{
 			if (m_isFixedTimeStep)
 			{
 				// Fixed timestep update logic
@@ -144,22 +173,8 @@ namespace DX
 
 				update();
 			}
-
-			// Track the current framerate.
-			if (m_frameCount != lastFrameCount)
-			{
-				m_framesThisSecond++;
-			}
-
-			if (m_qpcSecondCounter >= static_cast<uint64>(m_qpcFrequency.QuadPart))
-			{
-				m_framesPerSecond = m_framesThisSecond;
-				m_framesThisSecond = 0;
-				m_qpcSecondCounter %= m_qpcFrequency.QuadPart;
-			}
 		}
 
-	private:
 		// Source timing data uses QPC units.
 		LARGE_INTEGER m_qpcFrequency;
 		LARGE_INTEGER m_qpcLastTime;
@@ -0,0 +1,187 @@
+﻿#include "pch.h"
+#include "StreamingLoader.h"
+
+#include <chrono>
+
+using namespace DX;
+
+StreamingLoader::StreamingLoader(IStreamingFileSystem& fileSystem, uint32_t maxReadsInFlight) :
+	m_fileSystem(fileSystem),
+	m_maxReadsInFlight(maxReadsInFlight),
+	m_readsInFlight(0),
+	m_nextRequest(1),
+	m_nextSequence(0),
+	m_completedReads(std::make_shared<CompletedReads>())
+{
+}
+
+StreamingLoader::RequestId StreamingLoader::Request(const std::wstring& filename, int32_t priority, const FinalizeCallback& finalize, const FailureCallback& failure)
+{
+	RequestId request = m_nextRequest++;
+	if (m_nextRequest == InvalidRequest)
+	{
+		m_nextRequest++;
+	}
+
+	PendingRequest& pending = m_requests[request];
+	pending.filename = filename;
+	pending.priority = priority;
+	pending.generation = 0;
+	pending.state = StreamRequestState::Queued;
+	pending.finalize = finalize;
+	pending.failure = failure;
+
+	Push(m_readQueue, request, pending);
+	return request;
+}
+
+bool StreamingLoader::Cancel(RequestId request)
+{
+	// A read in flight still completes, but its data is dropped because the request is gone.
+	return m_requests.erase(request) > 0;
+}
+
+void StreamingLoader::CancelAll()
+{
+	m_requests.clear();
+	m_readQueue = std::priority_queue<QueueEntry>();
+	m_finalizeQueue = std::priority_queue<QueueEntry>();
+}
+
+void StreamingLoader::SetPriority(RequestId request, int32_t priority)
+{
+	auto it = m_requests.find(request);
+	if (it == m_requests.end() || it->second.priority == priority)
+	{
+		return;
+	}
+
+	PendingRequest& pending = it->second;
+	pending.priority = priority;
+	pending.generation++;
+
+	if (pending.state == StreamRequestState::Queued)
+	{
+		Push(m_readQueue, request, pending);
+	}
+	else if (pending.state == StreamRequestState::Finalizing)
+	{
+		Push(m_finalizeQueue, request, pending);
+	}
+}
+
+void StreamingLoader::Update(double budgetSeconds)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	CollectCompletedReads();
+	StartReads();
+
+	RequestId request;
+	while (Pop(m_finalizeQueue, StreamRequestState::Finalizing, request))
+	{
+		// Take the request out first, so the callback can make or cancel other requests.
+		auto it = m_requests.find(request);
+		PendingRequest pending = std::move(it->second);
+		m_requests.erase(it);
+
+		pending.finalize(pending.data);
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= budgetSeconds)
+		{
+			break;
+		}
+	}
+}
+
+StreamRequestState StreamingLoader::GetState(RequestId request) const
+{
+	auto it = m_requests.find(request);
+	return it != m_requests.end() ? it->second.state : StreamRequestState::None;
+}
+
+void StreamingLoader::Push(std::priority_queue<QueueEntry>& queue, RequestId request, const PendingRequest& pending)
+{
+	QueueEntry entry = { pending.priority, m_nextSequence++, request, pending.generation };
+	queue.push(entry);
+}
+
+// Pops the highest priority entry that still refers to a live request in the given state.
+bool StreamingLoader::Pop(std::priority_queue<QueueEntry>& queue, StreamRequestState state, RequestId& request)
+{
+	while (!queue.empty())
+	{
+		QueueEntry entry = queue.top();
+		queue.pop();
+
+		auto it = m_requests.find(entry.request);
+		if (it != m_requests.end() && it->second.generation == entry.generation && it->second.state == state)
+		{
+			request = entry.request;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void StreamingLoader::StartReads()
+{
+	RequestId request;
+	while (m_readsInFlight < m_maxReadsInFlight && Pop(m_readQueue, StreamRequestState::Queued, request))
+	{
+		PendingRequest& pending = m_requests[request];
+		pending.state = StreamRequestState::Reading;
+		m_readsInFlight++;
+
+		std::shared_ptr<CompletedReads> completedReads = m_completedReads;
+		m_fileSystem.ReadAsync(pending.filename, [completedReads, request](bool succeeded, std::vector<uint8_t>& data)
+		{
+			CompletedRead read;
+			read.request = request;
+			read.succeeded = succeeded;
+			read.data.swap(data);
+
+			std::lock_guard<std::mutex> lock(completedReads->mutex);
+			completedReads->reads.push_back(std::move(read));
+		});
+	}
+}
+
+void StreamingLoader::CollectCompletedReads()
+{
+	std::vector<CompletedRead> reads;
+	{
+		std::lock_guard<std::mutex> lock(m_completedReads->mutex);
+		reads.swap(m_completedReads->reads);
+	}
+
+	for (auto& read : reads)
+	{
+		m_readsInFlight--;
+
+		auto it = m_requests.find(read.request);
+		if (it == m_requests.end())
+		{
+			// Cancelled while reading.
+			continue;
+		}
+
+		if (!read.succeeded)
+		{
+			FailureCallback failure = std::move(it->second.failure);
+			m_requests.erase(it);
+			if (failure)
+			{
+				failure();
+			}
+			continue;
+		}
+
+		PendingRequest& pending = it->second;
+		pending.state = StreamRequestState::Finalizing;
+		pending.data.swap(read.data);
+		Push(m_finalizeQueue, read.request, pending);
+	}
+}
@@ -0,0 +1,128 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DX
+{
+	// Where the streaming loader gets its bytes from. ReadAsync may complete on any thread,
+	// and may call completion before it returns.
+	class IStreamingFileSystem
+	{
+	public:
+		typedef std::function<void(bool succeeded, std::vector<uint8_t>& data)> ReadCompletion;
+
+		virtual ~IStreamingFileSystem() {}
+		virtual void ReadAsync(const std::wstring& filename, const ReadCompletion& completion) = 0;
+	};
+
+	enum class StreamRequestState : uint8_t
+	{
+		None,			// Finished, cancelled or never requested.
+		Queued,			// Waiting for an I/O slot.
+		Reading,		// I/O in flight.
+		Finalizing,		// Read, waiting for frame time to be finalized.
+	};
+
+	// Streams files in priority order. At most a fixed number of reads are in flight at once,
+	// and finished reads are handed to their finalize callbacks (which typically create device
+	// resources) from Update, only until that frame's time budget is spent. Requests with a
+	// higher priority are read and finalized first.
+	class StreamingLoader
+	{
+	public:
+		typedef uint32_t RequestId;
+		typedef std::function<void(const std::vector<uint8_t>& data)> FinalizeCallback;
+		typedef std::function<void()> FailureCallback;
+
+		static const RequestId InvalidRequest = 0;
+
+		StreamingLoader(IStreamingFileSystem& fileSystem, uint32_t maxReadsInFlight);
+
+		RequestId Request(const std::wstring& filename, int32_t priority, const FinalizeCallback& finalize, const FailureCallback& failure = nullptr);
+
+		// Returns false if the request already finished. Callbacks of cancelled requests never run.
+		bool Cancel(RequestId request);
+		void CancelAll();
+
+		// Changes the order in which a request that hasn't been finalized yet is served.
+		void SetPriority(RequestId request, int32_t priority);
+
+		// Call once per frame from the thread that owns the finalized resources. Starts reads for
+		// free I/O slots, then finalizes completed reads until budgetSeconds have passed. At least
+		// one read is finalized per call, so loading always makes progress.
+		void Update(double budgetSeconds);
+
+		StreamRequestState GetState(RequestId request) const;
+		size_t GetPendingCount() const		{ return m_requests.size(); }
+		uint32_t GetReadsInFlight() const	{ return m_readsInFlight; }
+
+	private:
+		struct PendingRequest
+		{
+			std::wstring		filename;
+			int32_t				priority;
+			uint32_t			generation;		// Bumped when the priority changes, to invalidate queue entries.
+			StreamRequestState	state;
+			bool				failed;
+			std::vector<uint8_t> data;
+			FinalizeCallback	finalize;
+			FailureCallback		failure;
+		};
+
+		// Queue entries are never removed early; stale ones are skipped when they reach the top.
+		struct QueueEntry
+		{
+			int32_t		priority;
+			uint64_t	sequence;	// Requests of equal priority are served first come, first served.
+			RequestId	request;
+			uint32_t	generation;
+
+			bool operator<(const QueueEntry& other) const
+			{
+				if (priority != other.priority)
+				{
+					return priority < other.priority;
+				}
+				return sequence > other.sequence;
+			}
+		};
+
+		struct CompletedRead
+		{
+			RequestId				request;
+			bool					succeeded;
+			std::vector<uint8_t>	data;
+		};
+
+		// Filled by I/O completions, which may arrive on other threads. Shared with the reads in
+		// flight so a completion arriving after the loader is destroyed has somewhere to go.
+		struct CompletedReads
+		{
+			std::mutex					mutex;
+			std::vector<CompletedRead>	reads;
+		};
+
+		void Push(std::priority_queue<QueueEntry>& queue, RequestId request, const PendingRequest& pending);
+		bool Pop(std::priority_queue<QueueEntry>& queue, StreamRequestState state, RequestId& request);
+		void StartReads();
+		void CollectCompletedReads();
+
+		IStreamingFileSystem&					m_fileSystem;
+		uint32_t								m_maxReadsInFlight;
+		uint32_t								m_readsInFlight;
+		RequestId								m_nextRequest;
+		uint64_t								m_nextSequence;
+
+		std::unordered_map<RequestId, PendingRequest>	m_requests;
+		std::priority_queue<QueueEntry>			m_readQueue;
+		std::priority_queue<QueueEntry>			m_finalizeQueue;
+		std::shared_ptr<CompletedReads>			m_completedReads;
+	};
+}
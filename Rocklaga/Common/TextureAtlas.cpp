@@ -0,0 +1,349 @@
+﻿#include "pch.h"
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace DX;
+
+namespace
+{
+	// File layout: AtlasHeader, entryCount AtlasEntry records, then width * height RGBA8 pixels.
+	// Structures are copied as-is, so the format is little-endian like every platform we ship on.
+	static const uint32_t AtlasMagic = 0x54414B52; // "RKAT"
+	static const uint32_t AtlasVersion = 1;
+
+	struct AtlasHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t width;
+		uint32_t height;
+		uint32_t entryCount;
+		uint32_t reserved;
+		uint64_t sourceHash;
+	};
+
+	static_assert(sizeof(AtlasHeader) == 32, "AtlasHeader must not contain padding");
+	static_assert(sizeof(AtlasEntry) == 40, "AtlasEntry must not contain padding");
+
+	// Doubles the shorter side, so atlases stay square or twice as wide as they are tall.
+	void GrowAtlas(uint32_t& width, uint32_t& height)
+	{
+		if (width == height)
+		{
+			width *= 2;
+		}
+		else
+		{
+			height *= 2;
+		}
+	}
+}
+
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height) :
+	m_width(width),
+	m_height(height)
+{
+	Segment floor = { 0, 0, width };
+	m_skyline.push_back(floor);
+}
+
+// Finds the height at which a rectangle starting at the given segment would rest.
+bool SkylinePacker::Fits(size_t segmentIndex, uint32_t width, uint32_t height, uint32_t& y) const
+{
+	uint32_t x = m_skyline[segmentIndex].x;
+	if (x + width > m_width)
+	{
+		return false;
+	}
+
+	y = 0;
+	int64_t widthLeft = width;
+	for (size_t i = segmentIndex; widthLeft > 0; i++)
+	{
+		y = std::max(y, m_skyline[i].y);
+		if (y + height > m_height)
+		{
+			return false;
+		}
+		widthLeft -= m_skyline[i].width;
+	}
+
+	return true;
+}
+
+bool SkylinePacker::Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+{
+	size_t bestIndex = m_skyline.size();
+	uint32_t bestTop = UINT32_MAX;
+
+	for (size_t i = 0; i < m_skyline.size(); i++)
+	{
+		uint32_t restY;
+		if (Fits(i, width, height, restY) && restY + height < bestTop)
+		{
+			bestIndex = i;
+			bestTop = restY + height;
+			y = restY;
+		}
+	}
+
+	if (bestIndex == m_skyline.size())
+	{
+		return false;
+	}
+
+	x = m_skyline[bestIndex].x;
+
+	// Raise the skyline under the new rectangle.
+	Segment segment = { x, y + height, width };
+	m_skyline.insert(m_skyline.begin() + bestIndex, segment);
+
+	// Trim or remove the segments it now covers.
+	for (size_t i = bestIndex + 1; i < m_skyline.size(); )
+	{
+		uint32_t previousRight = m_skyline[i - 1].x + m_skyline[i - 1].width;
+		if (m_skyline[i].x >= previousRight)
+		{
+			break;
+		}
+
+		uint32_t overlap = previousRight - m_skyline[i].x;
+		if (overlap >= m_skyline[i].width)
+		{
+			m_skyline.erase(m_skyline.begin() + i);
+		}
+		else
+		{
+			m_skyline[i].x += overlap;
+			m_skyline[i].width -= overlap;
+			break;
+		}
+	}
+
+	// Merge neighbouring segments at the same height.
+	for (size_t i = 1; i < m_skyline.size(); )
+	{
+		if (m_skyline[i - 1].y == m_skyline[i].y)
+		{
+			m_skyline[i - 1].width += m_skyline[i].width;
+			m_skyline.erase(m_skyline.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	return true;
+}
+
+TextureAtlas::TextureAtlas() :
+	m_width(0),
+	m_height(0),
+	m_sourceHash(0)
+{
+}
+
+bool TextureAtlas::Build(const std::vector<AtlasSourceImage>& images, uint64_t sourceHash, uint32_t maxSize, uint32_t padding)
+{
+	// Packing tall images first gives the skyline heuristic much flatter results.
+	std::vector<size_t> order(images.size());
+	uint64_t totalArea = 0;
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		order[i] = i;
+		totalArea += static_cast<uint64_t>(images[i].width + padding * 2) * (images[i].height + padding * 2);
+	}
+
+	std::sort(order.begin(), order.end(), [&images](size_t a, size_t b)
+	{
+		if (images[a].height != images[b].height)
+		{
+			return images[a].height > images[b].height;
+		}
+		return images[a].width > images[b].width;
+	});
+
+	// Grow the atlas one power of two at a time, alternating width and height, starting from
+	// the smallest size that could possibly hold everything.
+	uint32_t width = 1;
+	uint32_t height = 1;
+	while (static_cast<uint64_t>(width) * height < totalArea)
+	{
+		GrowAtlas(width, height);
+	}
+
+	std::vector<AtlasEntry> entries(images.size());
+	bool packed = false;
+	while (!packed && width <= maxSize)
+	{
+		SkylinePacker packer(width, height);
+		packed = true;
+
+		for (size_t i : order)
+		{
+			uint32_t x, y;
+			if (!packer.Insert(images[i].width + padding * 2, images[i].height + padding * 2, x, y))
+			{
+				packed = false;
+				break;
+			}
+
+			AtlasEntry& entry = entries[i];
+			entry.nameHash = images[i].nameHash;
+			entry.x = x + padding;
+			entry.y = y + padding;
+			entry.width = images[i].width;
+			entry.height = images[i].height;
+		}
+
+		if (!packed)
+		{
+			GrowAtlas(width, height);
+		}
+	}
+
+	if (!packed)
+	{
+		return false;
+	}
+
+	m_width = width;
+	m_height = height;
+	m_sourceHash = sourceHash;
+	m_pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		AtlasEntry& entry = entries[i];
+		entry.u0 = static_cast<float>(entry.x) / width;
+		entry.v0 = static_cast<float>(entry.y) / height;
+		entry.u1 = static_cast<float>(entry.x + entry.width) / width;
+		entry.v1 = static_cast<float>(entry.y + entry.height) / height;
+
+		for (uint32_t row = 0; row < entry.height; row++)
+		{
+			memcpy(
+				&m_pixels[(static_cast<size_t>(entry.y + row) * width + entry.x) * 4],
+				&images[i].pixels[static_cast<size_t>(row) * entry.width * 4],
+				entry.width * 4
+				);
+		}
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const AtlasEntry& a, const AtlasEntry& b)
+	{
+		return a.nameHash < b.nameHash;
+	});
+	m_entries = std::move(entries);
+
+	return true;
+}
+
+std::vector<uint8_t> TextureAtlas::Serialize() const
+{
+	AtlasHeader header = {};
+	header.magic = AtlasMagic;
+	header.version = AtlasVersion;
+	header.width = m_width;
+	header.height = m_height;
+	header.entryCount = static_cast<uint32_t>(m_entries.size());
+	header.sourceHash = m_sourceHash;
+
+	size_t entriesSize = m_entries.size() * sizeof(AtlasEntry);
+	std::vector<uint8_t> out(sizeof(header) + entriesSize + m_pixels.size());
+
+	memcpy(out.data(), &header, sizeof(header));
+	if (entriesSize > 0)
+	{
+		memcpy(out.data() + sizeof(header), m_entries.data(), entriesSize);
+	}
+	if (!m_pixels.empty())
+	{
+		memcpy(out.data() + sizeof(header) + entriesSize, m_pixels.data(), m_pixels.size());
+	}
+
+	return out;
+}
+
+bool TextureAtlas::Deserialize(const uint8_t* data, size_t size)
+{
+	AtlasHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (header.magic != AtlasMagic || header.version != AtlasVersion)
+	{
+		return false;
+	}
+
+	uint64_t entriesSize = static_cast<uint64_t>(header.entryCount) * sizeof(AtlasEntry);
+	uint64_t pixelsSize = static_cast<uint64_t>(header.width) * header.height * 4;
+	if (size != sizeof(header) + entriesSize + pixelsSize)
+	{
+		return false;
+	}
+
+	m_width = header.width;
+	m_height = header.height;
+	m_sourceHash = header.sourceHash;
+
+	m_entries.resize(header.entryCount);
+	if (entriesSize > 0)
+	{
+		memcpy(m_entries.data(), data + sizeof(header), static_cast<size_t>(entriesSize));
+	}
+
+	m_pixels.assign(data + sizeof(header) + entriesSize, data + size);
+
+	return true;
+}
+
+bool TextureAtlas::ReadSourceHash(const uint8_t* data, size_t size, uint64_t& sourceHash)
+{
+	AtlasHeader header;
+	if (size < sizeof(header))
+	{
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if (header.magic != AtlasMagic || header.version != AtlasVersion)
+	{
+		return false;
+	}
+
+	sourceHash = header.sourceHash;
+	return true;
+}
+
+const AtlasEntry* TextureAtlas::Find(uint64_t nameHash) const
+{
+	auto entry = std::lower_bound(m_entries.begin(), m_entries.end(), nameHash, [](const AtlasEntry& a, uint64_t hash)
+	{
+		return a.nameHash < hash;
+	});
+
+	return (entry != m_entries.end() && entry->nameHash == nameHash) ? &*entry : nullptr;
+}
+
+float TextureAtlas::GetPackingEfficiency() const
+{
+	if (m_width == 0 || m_height == 0)
+	{
+		return 0.0f;
+	}
+
+	uint64_t usedArea = 0;
+	for (const auto& entry : m_entries)
+	{
+		usedArea += static_cast<uint64_t>(entry.width) * entry.height;
+	}
+
+	return static_cast<float>(usedArea) / (static_cast<float>(m_width) * m_height);
+}
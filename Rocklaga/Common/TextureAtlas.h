@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace DX
+{
+	// Packs rectangles into a fixed size area using the skyline bottom-left heuristic:
+	// each rectangle goes wherever its top edge ends up lowest.
+	class SkylinePacker
+	{
+	public:
+		SkylinePacker(uint32_t width, uint32_t height);
+
+		// Returns false if the rectangle does not fit.
+		bool Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+
+		uint32_t GetWidth() const	{ return m_width; }
+		uint32_t GetHeight() const	{ return m_height; }
+
+	private:
+		struct Segment
+		{
+			uint32_t x;
+			uint32_t y;
+			uint32_t width;
+		};
+
+		bool Fits(size_t segmentIndex, uint32_t width, uint32_t height, uint32_t& y) const;
+
+		uint32_t				m_width;
+		uint32_t				m_height;
+		std::vector<Segment>	m_skyline;
+	};
+
+	// A decoded source image, in RGBA8.
+	struct AtlasSourceImage
+	{
+		uint64_t				nameHash;
+		uint32_t				width;
+		uint32_t				height;
+		std::vector<uint8_t>	pixels;
+	};
+
+	// Where one source image ended up in the atlas.
+	struct AtlasEntry
+	{
+		uint64_t	nameHash;
+		uint32_t	x;
+		uint32_t	y;
+		uint32_t	width;
+		uint32_t	height;
+		float		u0;
+		float		v0;
+		float		u1;
+		float		v1;
+	};
+
+	// A single RGBA8 image containing every sprite, plus the UV lookup table for finding them.
+	// The binary form is one contiguous blob (header, entries, pixels), so a cached atlas loads
+	// with a single read. It records a hash of the source files so stale caches can be detected
+	// without decoding any images.
+	class TextureAtlas
+	{
+	public:
+		TextureAtlas();
+
+		// Packs the images into the smallest power-of-two atlas, no larger than maxSize on a side, that holds them all.
+		// Returns false if they don't fit. padding is the gap in pixels left around each image.
+		bool Build(const std::vector<AtlasSourceImage>& images, uint64_t sourceHash, uint32_t maxSize, uint32_t padding);
+
+		std::vector<uint8_t> Serialize() const;
+		bool Deserialize(const uint8_t* data, size_t size);
+
+		// Reads just the source hash from serialized atlas data. Returns false if the data is not an atlas.
+		static bool ReadSourceHash(const uint8_t* data, size_t size, uint64_t& sourceHash);
+
+		// Returns nullptr if there is no entry with the given name hash.
+		const AtlasEntry* Find(uint64_t nameHash) const;
+
+		uint32_t GetWidth() const								{ return m_width; }
+		uint32_t GetHeight() const								{ return m_height; }
+		uint64_t GetSourceHash() const							{ return m_sourceHash; }
+		const std::vector<AtlasEntry>& GetEntries() const		{ return m_entries; }
+		const std::vector<uint8_t>& GetPixels() const			{ return m_pixels; }
+
+		// Fraction of the atlas area covered by source images.
+		float GetPackingEfficiency() const;
+
+	private:
+		uint32_t				m_width;
+		uint32_t				m_height;
+		uint64_t				m_sourceHash;
+		std::vector<AtlasEntry>	m_entries;		// Sorted by name hash.
+		std::vector<uint8_t>	m_pixels;
+	};
+}
@@ -0,0 +1,142 @@
+﻿#include "pch.h"
+#include "Mesh.h"
+
+#include "..\Common\DirectXHelper.h"
+#include "..\Common\MappedFile.h"
+
+using namespace Rocklaga;
+
+using namespace DirectX;
+
+const D3D11_INPUT_ELEMENT_DESC Mesh::InputElements[2] =
+{
+	{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+Mesh::Mesh() :
+	m_registry(nullptr),
+	m_vertexBuffer(DX::InvalidResource),
+	m_indexBuffer(DX::InvalidResource),
+	m_indexFormat(DXGI_FORMAT_R16_UINT),
+	m_vertexStride(0)
+{
+	XMStoreFloat4x4(&m_dequantizeTransform, XMMatrixIdentity());
+}
+
+Mesh::~Mesh()
+{
+	Release();
+}
+
+void Mesh::Create(DX::ResourceRegistry* registry, const DX::MeshView& view, int32 priority)
+{
+	Create(registry, view, nullptr, priority);
+}
+
+void Mesh::Create(DX::ResourceRegistry* registry, const DX::MeshView& view, const std::shared_ptr<const void>& dataOwner, int32 priority)
+{
+	Release();
+
+	m_registry = registry;
+	m_indexFormat = view.Uses32BitIndices() ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+	m_lods.resize(view.GetLodCount());
+	for (uint32 lod = 0; lod < view.GetLodCount(); lod++)
+	{
+		m_lods[lod] = view.GetLod(lod);
+	}
+	m_vertexStride = view.GetVertexStride();
+	XMStoreFloat4x4(&m_dequantizeTransform, view.GetDequantizeTransform());
+
+	CD3D11_BUFFER_DESC vertexBufferDesc(
+		view.GetVertexCount() * m_vertexStride,
+		D3D11_BIND_VERTEX_BUFFER,
+		D3D11_USAGE_IMMUTABLE
+		);
+	m_vertexBuffer = dataOwner != nullptr ?
+		registry->RegisterBuffer(vertexBufferDesc, view.GetVertexData(), dataOwner, priority) :
+		registry->RegisterBuffer(vertexBufferDesc, view.GetVertexData(), priority);
+
+	CD3D11_BUFFER_DESC indexBufferDesc(
+		view.GetIndexCount() * (view.Uses32BitIndices() ? 4 : 2),
+		D3D11_BIND_INDEX_BUFFER,
+		D3D11_USAGE_IMMUTABLE
+		);
+	m_indexBuffer = dataOwner != nullptr ?
+		registry->RegisterBuffer(indexBufferDesc, view.GetIndexData(), dataOwner, priority) :
+		registry->RegisterBuffer(indexBufferDesc, view.GetIndexData(), priority);
+}
+
+// Maps a mesh file from the package and uploads it without an intermediate copy. The registry
+// keeps the mapping open until the buffers are unregistered.
+void Mesh::CreateFromFile(DX::ResourceRegistry* registry, const std::wstring& filename, int32 priority)
+{
+	auto file = std::make_shared<DX::MappedFile>();
+	file->Open(filename);
+
+	DX::MeshView view;
+	if (!view.Open(file->GetData(), file->GetSize()))
+	{
+		DX::ThrowIfFailed(E_INVALIDARG);
+	}
+
+	Create(registry, view, file, priority);
+}
+
+void Mesh::Release()
+{
+	if (m_registry != nullptr)
+	{
+		m_registry->Unregister(m_vertexBuffer);
+		m_registry->Unregister(m_indexBuffer);
+		m_registry = nullptr;
+	}
+
+	m_vertexBuffer = DX::InvalidResource;
+	m_indexBuffer = DX::InvalidResource;
+}
+
+bool Mesh::Bind(ID3D11DeviceContext* context) const
+{
+	if (m_registry == nullptr)
+	{
+		return false;
+	}
+
+	ID3D11Buffer* vertexBuffer = m_registry->GetBuffer(m_vertexBuffer);
+	ID3D11Buffer* indexBuffer = m_registry->GetBuffer(m_indexBuffer);
+	if (vertexBuffer == nullptr || indexBuffer == nullptr)
+	{
+		return false;
+	}
+
+	UINT stride = m_vertexStride;
+	UINT offset = 0;
+	context->IASetVertexBuffers(
+		0,
+		1,
+		&vertexBuffer,
+		&stride,
+		&offset
+		);
+
+	context->IASetIndexBuffer(
+		indexBuffer,
+		m_indexFormat,
+		0
+		);
+
+	return true;
+}
+
+uint32 Mesh::SelectLod(float distance, float pixelsPerUnit, float maxPixelError) const
+{
+	// Levels are ordered by increasing error, so stop at the first one that is too coarse.
+	float maxError = maxPixelError * distance / pixelsPerUnit;
+	uint32 selected = 0;
+	for (uint32 lod = 1; lod < m_lods.size() && m_lods[lod].error <= maxError; lod++)
+	{
+		selected = lod;
+	}
+	return selected;
+}
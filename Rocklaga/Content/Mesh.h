@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include "..\Common\ResourceRegistry.h"
+#include "..\Common\MeshFormat.h"
+
+namespace Rocklaga
+{
+	// Vertex and index buffers for a mesh in the quantized mesh format. Buffers are created
+	// straight from the mesh data, with no decoding. They live in the resource registry, so the
+	// mesh outlives device loss and only needs to be created once. Create has the registry copy
+	// the data to recreate them from; CreateFromFile instead keeps the mesh file mapped while
+	// the buffers are registered, so they are uploaded, and recreated, from the mapping in place.
+	class Mesh
+	{
+	public:
+		Mesh();
+		~Mesh();
+
+		// Higher priority meshes are recreated first after device loss.
+		void Create(DX::ResourceRegistry* registry, const DX::MeshView& view, int32 priority);
+
+		// As Create, reading the data in place while holding on to dataOwner, which the view's
+		// data must belong to.
+		void Create(DX::ResourceRegistry* registry, const DX::MeshView& view, const std::shared_ptr<const void>& dataOwner, int32 priority);
+		void CreateFromFile(DX::ResourceRegistry* registry, const std::wstring& filename, int32 priority);
+		void Release();
+		bool IsCreated() const								{ return m_registry != nullptr; }
+
+		// Sets the vertex and index buffers. Draw a level of detail with
+		// DrawIndexed(lod.indexCount, lod.indexOffset, 0). Returns false, and binds nothing,
+		// while the buffers are still being recreated after device loss.
+		bool Bind(ID3D11DeviceContext* context) const;
+
+		uint32 GetLodCount() const							{ return static_cast<uint32>(m_lods.size()); }
+		const DX::MeshLod& GetLod(uint32 lod) const			{ return m_lods[lod]; }
+
+		// Picks the least detailed level whose error stays within maxPixelError pixels on screen
+		// at the given view distance. pixelsPerUnit is the projection's y scale times half the
+		// viewport height: the on-screen size of one unit at distance one.
+		uint32 SelectLod(float distance, float pixelsPerUnit, float maxPixelError) const;
+
+		// Multiply this in front of the model matrix to turn quantized positions back into model space.
+		DirectX::XMFLOAT4X4 GetDequantizeTransform() const	{ return m_dequantizeTransform; }
+
+		// Input layout for QuantizedVertex. The normal is left out; shaders that need it add a
+		// third element at offset 12.
+		static const D3D11_INPUT_ELEMENT_DESC InputElements[2];
+
+	private:
+		DX::ResourceRegistry*					m_registry;
+		DX::ResourceId							m_vertexBuffer;
+		DX::ResourceId							m_indexBuffer;
+		DXGI_FORMAT								m_indexFormat;
+		std::vector<DX::MeshLod>				m_lods;
+		uint32									m_vertexStride;
+		DirectX::XMFLOAT4X4						m_dequantizeTransform;
+	};
+}
@@ -0,0 +1,15 @@
+// Per-pixel data passed through the pixel shader.
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 corner : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+// Draws a soft round particle. The output is premultiplied for additive blending.
+float4 main(PixelShaderInput input) : SV_TARGET
+{
+	float falloff = saturate(1.0f - dot(input.corner, input.corner));
+	float alpha = input.color.a * falloff;
+	return float4(input.color.rgb * alpha, alpha);
+}
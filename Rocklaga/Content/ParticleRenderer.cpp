@@ -0,0 +1,187 @@
+﻿#include "pch.h"
+#include "ParticleRenderer.h"
+
+#include "..\Common\DirectXHelper.h"
+
+using namespace Rocklaga;
+
+using namespace DirectX;
+
+// Loads the particle shaders and sizes the instance buffer for the full particle capacity.
+ParticleRenderer::ParticleRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources, uint32 capacity) :
+	m_loadingComplete(false),
+	m_particleSystem(capacity),
+	m_deviceResources(deviceResources)
+{
+	CreateDeviceDependentResources();
+}
+
+// Advances the simulation.
+void ParticleRenderer::Update(DX::StepTimer const& timer)
+{
+	m_particleSystem.Update(static_cast<float>(timer.GetElapsedSeconds()));
+}
+
+// Uploads every live particle with one discard map and draws them in one instanced call.
+void ParticleRenderer::Render(XMFLOAT4X4 const& view, XMFLOAT4X4 const& projection)
+{
+	// Loading is asynchronous. Only draw particles after the shaders are loaded.
+	if (!m_loadingComplete || m_particleSystem.GetLiveCount() == 0)
+	{
+		return;
+	}
+
+	auto context = m_deviceResources->GetD3DDeviceContext();
+
+	// The simulation writes straight into the mapped buffer, so there is no intermediate copy.
+	D3D11_MAPPED_SUBRESOURCE mapped;
+	DX::ThrowIfFailed(
+		context->Map(m_instanceBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)
+		);
+
+	uint32 instanceCount = m_particleSystem.WriteInstances(static_cast<ParticleInstance*>(mapped.pData));
+
+	context->Unmap(m_instanceBuffer.Get(), 0);
+
+	auto statistics = m_deviceResources->GetStatistics();
+	statistics->RecordBufferUpdate(instanceCount * sizeof(ParticleInstance));
+
+	m_constantBufferData.view = view;
+	m_constantBufferData.projection = projection;
+	context->UpdateSubresource1(
+		m_constantBuffer.Get(),
+		0,
+		NULL,
+		&m_constantBufferData,
+		0,
+		0,
+		0
+		);
+	statistics->RecordBufferUpdate(sizeof(m_constantBufferData));
+
+	// Each instance is one ParticleInstance; the quad corners come from SV_VertexID.
+	UINT stride = sizeof(ParticleInstance);
+	UINT offset = 0;
+	context->IASetVertexBuffers(
+		0,
+		1,
+		m_instanceBuffer.GetAddressOf(),
+		&stride,
+		&offset
+		);
+
+	context->IASetIndexBuffer(nullptr, DXGI_FORMAT_UNKNOWN, 0);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	context->IASetInputLayout(m_inputLayout.Get());
+
+	context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+	context->VSSetConstantBuffers1(0, 1, m_constantBuffer.GetAddressOf(), nullptr, nullptr);
+	context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+
+	// Additive blending with depth testing but no depth writes, so particle order does not matter.
+	context->OMSetBlendState(m_blendState.Get(), nullptr, 0xffffffff);
+	context->OMSetDepthStencilState(m_depthStencilState.Get(), 0);
+	context->RSSetState(m_rasterizerState.Get());
+
+	context->DrawInstanced(4, instanceCount, 0, 0);
+	statistics->RecordDraw(4, instanceCount);
+
+	// Restore default state for the renderers that follow.
+	context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+	context->OMSetDepthStencilState(nullptr, 0);
+	context->RSSetState(nullptr);
+}
+
+void ParticleRenderer::CreateDeviceDependentResources()
+{
+	// Load shaders asynchronously. The shader cache only reads each file once, so this is
+	// immediate when the device is restored.
+	auto shaderCache = m_deviceResources->GetShaderCache();
+	auto loadVSTask = shaderCache->LoadAsync(L"ParticleVertexShader.cso");
+	auto loadPSTask = shaderCache->LoadAsync(L"ParticlePixelShader.cso");
+
+	// After the vertex shader file is loaded, create the shader and per-instance input layout.
+	auto createVSTask = loadVSTask.then([this, shaderCache] () {
+		m_vertexShader = shaderCache->GetVertexShader(L"ParticleVertexShader.cso");
+
+		static const D3D11_INPUT_ELEMENT_DESC instanceDesc [] =
+		{
+			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "PSIZE", 0, DXGI_FORMAT_R32_FLOAT, 0, 12, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		};
+
+		m_inputLayout = shaderCache->GetInputLayout(L"ParticleVertexShader.cso", instanceDesc, ARRAYSIZE(instanceDesc));
+	});
+
+	// After the pixel shader file is loaded, create the shader and constant buffer.
+	auto createPSTask = loadPSTask.then([this, shaderCache] () {
+		m_pixelShader = shaderCache->GetPixelShader(L"ParticlePixelShader.cso");
+
+		CD3D11_BUFFER_DESC constantBufferDesc(sizeof(ParticleConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
+		DX::ThrowIfFailed(
+			m_deviceResources->GetD3DDevice()->CreateBuffer(
+				&constantBufferDesc,
+				nullptr,
+				&m_constantBuffer
+				)
+			);
+		m_deviceResources->GetStatistics()->RecordBuffer(constantBufferDesc.ByteWidth);
+	});
+
+	// Once both shaders are loaded, create the instance buffer and pipeline state.
+	auto createStateTask = (createPSTask && createVSTask).then([this] () {
+		auto device = m_deviceResources->GetD3DDevice();
+
+		CD3D11_BUFFER_DESC instanceBufferDesc(
+			m_particleSystem.GetCapacity() * sizeof(ParticleInstance),
+			D3D11_BIND_VERTEX_BUFFER,
+			D3D11_USAGE_DYNAMIC,
+			D3D11_CPU_ACCESS_WRITE
+			);
+		DX::ThrowIfFailed(
+			device->CreateBuffer(
+				&instanceBufferDesc,
+				nullptr,
+				&m_instanceBuffer
+				)
+			);
+		m_deviceResources->GetStatistics()->RecordBuffer(instanceBufferDesc.ByteWidth);
+
+		// Premultiplied additive blending.
+		CD3D11_BLEND_DESC blendDesc(D3D11_DEFAULT);
+		blendDesc.RenderTarget[0].BlendEnable = TRUE;
+		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+		blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+		DX::ThrowIfFailed(device->CreateBlendState(&blendDesc, &m_blendState));
+
+		CD3D11_DEPTH_STENCIL_DESC depthStencilDesc(D3D11_DEFAULT);
+		depthStencilDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+		DX::ThrowIfFailed(device->CreateDepthStencilState(&depthStencilDesc, &m_depthStencilState));
+
+		// Billboards are generated without a consistent winding, so don't cull them.
+		CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+		rasterizerDesc.CullMode = D3D11_CULL_NONE;
+		DX::ThrowIfFailed(device->CreateRasterizerState(&rasterizerDesc, &m_rasterizerState));
+	});
+
+	// Once the buffers are created, particles are ready to be rendered.
+	createStateTask.then([this] () {
+		m_loadingComplete = true;
+	});
+}
+
+void ParticleRenderer::ReleaseDeviceDependentResources()
+{
+	m_loadingComplete = false;
+	m_vertexShader.Reset();
+	m_inputLayout.Reset();
+	m_pixelShader.Reset();
+	m_constantBuffer.Reset();
+	m_instanceBuffer.Reset();
+	m_blendState.Reset();
+	m_depthStencilState.Reset();
+	m_rasterizerState.Reset();
+}
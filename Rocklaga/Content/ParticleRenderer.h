@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#include "..\Common\DeviceResources.h"
+#include "ShaderStructures.h"
+#include "ParticleSystem.h"
+#include "..\Common\StepTimer.h"
+
+namespace Rocklaga
+{
+	// Simulates particles on the CPU and draws all of them with a single instanced draw call.
+	class ParticleRenderer
+	{
+	public:
+		ParticleRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources, uint32 capacity);
+		void CreateDeviceDependentResources();
+		void ReleaseDeviceDependentResources();
+		void Update(DX::StepTimer const& timer);
+		void Render(DirectX::XMFLOAT4X4 const& view, DirectX::XMFLOAT4X4 const& projection);
+
+		ParticleSystem& GetParticleSystem() { return m_particleSystem; }
+
+	private:
+		// Cached pointer to device resources.
+		std::shared_ptr<DX::DeviceResources> m_deviceResources;
+
+		// Direct3D resources for particle geometry. The instance buffer is rewritten every frame.
+		Microsoft::WRL::ComPtr<ID3D11InputLayout>		m_inputLayout;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>			m_instanceBuffer;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader>		m_vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader>		m_pixelShader;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>			m_constantBuffer;
+		Microsoft::WRL::ComPtr<ID3D11BlendState>		m_blendState;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState>	m_depthStencilState;
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState>	m_rasterizerState;
+
+		// System resources for particle simulation.
+		ParticleSystem			m_particleSystem;
+		ParticleConstantBuffer	m_constantBufferData;
+
+		// Variables used with the rendering loop.
+		bool	m_loadingComplete;
+	};
+}
@@ -0,0 +1,204 @@
+﻿#include "pch.h"
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Rocklaga;
+using namespace DirectX;
+
+namespace
+{
+	inline XMVECTOR LoadGroup(const std::vector<float>& values, size_t index)
+	{
+		return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&values[index]));
+	}
+
+	inline void StoreGroup(std::vector<float>& values, size_t index, FXMVECTOR v)
+	{
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&values[index]), v);
+	}
+}
+
+ParticleSystem::ParticleSystem(uint32_t capacity) :
+	m_capacity(capacity),
+	m_liveCount(0),
+	m_gravity(0.0f, -1.0f, 0.0f),
+	m_randomState(0)
+{
+	// Pad storage to whole SIMD groups; padding slots stay dead forever.
+	size_t paddedCapacity = (static_cast<size_t>(capacity) + 3) & ~static_cast<size_t>(3);
+
+	m_positionX.resize(paddedCapacity);
+	m_positionY.resize(paddedCapacity);
+	m_positionZ.resize(paddedCapacity);
+	m_velocityX.resize(paddedCapacity);
+	m_velocityY.resize(paddedCapacity);
+	m_velocityZ.resize(paddedCapacity);
+	m_age.resize(paddedCapacity);
+	m_lifetime.resize(paddedCapacity);
+	m_size.resize(paddedCapacity);
+	m_color.resize(paddedCapacity);
+	m_freeList.reserve(capacity);
+
+	Clear();
+}
+
+// Kills every particle and rebuilds the free list. The random sequence restarts too, so a
+// cleared system emits the same particles again, as input replays rely on.
+void ParticleSystem::Clear()
+{
+	m_randomState = 0x9E3779B9;
+
+	// A slot is dead whenever its age has reached its lifetime.
+	std::fill(m_age.begin(), m_age.end(), 0.0f);
+	std::fill(m_lifetime.begin(), m_lifetime.end(), 0.0f);
+
+	// Lowest indices are popped first, keeping live particles packed towards the front.
+	m_freeList.clear();
+	for (uint32_t i = m_capacity; i > 0; i--)
+	{
+		m_freeList.push_back(i - 1);
+	}
+
+	m_liveCount = 0;
+}
+
+uint32_t ParticleSystem::Emit(const ParticleEmitDesc& desc, uint32_t count)
+{
+	if (desc.lifetime <= 0.0f)
+	{
+		return 0;
+	}
+
+	uint32_t emitted = std::min(count, static_cast<uint32_t>(m_freeList.size()));
+
+	for (uint32_t n = 0; n < emitted; n++)
+	{
+		uint32_t i = m_freeList.back();
+		m_freeList.pop_back();
+
+		// Pick a uniformly distributed direction and a random fraction of the burst speed.
+		float z = NextRandom() * 2.0f - 1.0f;
+		float sinPhi, cosPhi;
+		XMScalarSinCos(&sinPhi, &cosPhi, NextRandom() * XM_2PI);
+		float radius = sqrtf(1.0f - z * z);
+		float speed = desc.speed * NextRandom();
+
+		m_positionX[i] = desc.position.x;
+		m_positionY[i] = desc.position.y;
+		m_positionZ[i] = desc.position.z;
+		m_velocityX[i] = desc.velocity.x + radius * cosPhi * speed;
+		m_velocityY[i] = desc.velocity.y + radius * sinPhi * speed;
+		m_velocityZ[i] = desc.velocity.z + z * speed;
+		m_age[i] = 0.0f;
+		m_lifetime[i] = desc.lifetime * (0.75f + 0.5f * NextRandom());
+		m_size[i] = desc.size;
+		m_color[i] = desc.color;
+	}
+
+	m_liveCount += emitted;
+	return emitted;
+}
+
+// Integrates every particle four at a time and returns expired slots to the free list.
+void ParticleSystem::Update(float elapsedSeconds)
+{
+	if (m_liveCount == 0)
+	{
+		return;
+	}
+
+	const XMVECTOR dt = XMVectorReplicate(elapsedSeconds);
+	const XMVECTOR gravityX = XMVectorReplicate(m_gravity.x * elapsedSeconds);
+	const XMVECTOR gravityY = XMVectorReplicate(m_gravity.y * elapsedSeconds);
+	const XMVECTOR gravityZ = XMVectorReplicate(m_gravity.z * elapsedSeconds);
+
+	const size_t size = m_age.size();
+	for (size_t i = 0; i < size; i += 4)
+	{
+		XMVECTOR age = LoadGroup(m_age, i);
+		XMVECTOR lifetime = LoadGroup(m_lifetime, i);
+		XMVECTOR alive = XMVectorLess(age, lifetime);
+
+		// Skip groups with no live particles; common once a burst has partly expired.
+		if (XMVector4EqualInt(alive, XMVectorFalseInt()))
+		{
+			continue;
+		}
+
+		XMVECTOR vx = LoadGroup(m_velocityX, i);
+		XMVECTOR vy = LoadGroup(m_velocityY, i);
+		XMVECTOR vz = LoadGroup(m_velocityZ, i);
+		XMVECTOR px = LoadGroup(m_positionX, i);
+		XMVECTOR py = LoadGroup(m_positionY, i);
+		XMVECTOR pz = LoadGroup(m_positionZ, i);
+
+		// Semi-implicit Euler: update velocity first, then position with the new velocity.
+		XMVECTOR newVx = XMVectorAdd(vx, gravityX);
+		XMVECTOR newVy = XMVectorAdd(vy, gravityY);
+		XMVECTOR newVz = XMVectorAdd(vz, gravityZ);
+
+		// Dead lanes keep their previous state.
+		StoreGroup(m_velocityX, i, XMVectorSelect(vx, newVx, alive));
+		StoreGroup(m_velocityY, i, XMVectorSelect(vy, newVy, alive));
+		StoreGroup(m_velocityZ, i, XMVectorSelect(vz, newVz, alive));
+		StoreGroup(m_positionX, i, XMVectorSelect(px, XMVectorMultiplyAdd(newVx, dt, px), alive));
+		StoreGroup(m_positionY, i, XMVectorSelect(py, XMVectorMultiplyAdd(newVy, dt, py), alive));
+		StoreGroup(m_positionZ, i, XMVectorSelect(pz, XMVectorMultiplyAdd(newVz, dt, pz), alive));
+
+		XMVECTOR newAge = XMVectorAdd(age, dt);
+		StoreGroup(m_age, i, XMVectorSelect(age, newAge, alive));
+
+		// Particles that were alive before this step but are not any more.
+		XMVECTOR died = XMVectorAndCInt(alive, XMVectorLess(newAge, lifetime));
+		if (!XMVector4EqualInt(died, XMVectorFalseInt()))
+		{
+			XMUINT4 diedMask;
+			XMStoreUInt4(&diedMask, died);
+
+			const uint32_t lanes[4] = { diedMask.x, diedMask.y, diedMask.z, diedMask.w };
+			for (uint32_t lane = 0; lane < 4; lane++)
+			{
+				if (lanes[lane] != 0)
+				{
+					m_freeList.push_back(static_cast<uint32_t>(i) + lane);
+					m_liveCount--;
+				}
+			}
+		}
+	}
+}
+
+uint32_t ParticleSystem::WriteInstances(ParticleInstance* dest) const
+{
+	uint32_t written = 0;
+
+	for (uint32_t i = 0; i < m_capacity && written < m_liveCount; i++)
+	{
+		if (m_age[i] >= m_lifetime[i])
+		{
+			continue;
+		}
+
+		// Fade out linearly over the particle's lifetime.
+		float fade = 1.0f - m_age[i] / m_lifetime[i];
+		uint32_t alpha = static_cast<uint32_t>((m_color[i] >> 24) * fade);
+
+		ParticleInstance& instance = dest[written++];
+		instance.pos = XMFLOAT3(m_positionX[i], m_positionY[i], m_positionZ[i]);
+		instance.size = m_size[i];
+		instance.color = (m_color[i] & 0x00FFFFFF) | (alpha << 24);
+	}
+
+	return written;
+}
+
+// xorshift32; deterministic so that replays produce identical particle effects.
+float ParticleSystem::NextRandom()
+{
+	m_randomState ^= m_randomState << 13;
+	m_randomState ^= m_randomState >> 17;
+	m_randomState ^= m_randomState << 5;
+	return (m_randomState >> 8) * (1.0f / 16777216.0f);
+}
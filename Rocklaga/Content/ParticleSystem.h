@@ -0,0 +1,73 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+namespace Rocklaga
+{
+	// Per-instance data written for each live particle; consumed by ParticleVertexShader.hlsl.
+	struct ParticleInstance
+	{
+		DirectX::XMFLOAT3 pos;
+		float size;
+		uint32_t color; // RGBA8, alpha faded by age.
+	};
+
+	// Describes a burst of particles, e.g. an explosion or one frame of an engine trail.
+	struct ParticleEmitDesc
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT3 velocity;		// Base velocity shared by every particle in the burst.
+		float speed;					// Magnitude of the random per-particle velocity added to the base.
+		float lifetime;					// Seconds.
+		float size;
+		uint32_t color;					// RGBA8.
+	};
+
+	// CPU particle simulation. Particles are stored as structure-of-arrays so integration runs four
+	// particles per SIMD operation, and dead slots are recycled through a free list so emission never
+	// moves other particles. Contains no Direct3D code.
+	class ParticleSystem
+	{
+	public:
+		ParticleSystem(uint32_t capacity);
+
+		// Spawns up to count particles; returns how many were actually emitted.
+		uint32_t Emit(const ParticleEmitDesc& desc, uint32_t count);
+		void Update(float elapsedSeconds);
+		void Clear();
+
+		// Writes one instance per live particle and returns the number written.
+		// dest must have room for GetLiveCount() instances.
+		uint32_t WriteInstances(ParticleInstance* dest) const;
+
+		uint32_t GetCapacity() const					{ return m_capacity; }
+		uint32_t GetLiveCount() const					{ return m_liveCount; }
+		void SetGravity(DirectX::XMFLOAT3 gravity)		{ m_gravity = gravity; }
+
+	private:
+		float NextRandom();
+
+		uint32_t m_capacity;
+		uint32_t m_liveCount;
+
+		// Structure-of-arrays particle state. Sizes are rounded up to a multiple of four.
+		std::vector<float> m_positionX;
+		std::vector<float> m_positionY;
+		std::vector<float> m_positionZ;
+		std::vector<float> m_velocityX;
+		std::vector<float> m_velocityY;
+		std::vector<float> m_velocityZ;
+		std::vector<float> m_age;
+		std::vector<float> m_lifetime;
+		std::vector<float> m_size;
+		std::vector<uint32_t> m_color;
+
+		// Indices of dead slots available for emission.
+		std::vector<uint32_t> m_freeList;
+
+		DirectX::XMFLOAT3 m_gravity;
+		uint32_t m_randomState;
+	};
+}
@@ -0,0 +1,42 @@
+// A constant buffer that stores the camera matrices used to billboard particles.
+cbuffer ParticleConstantBuffer : register(b0)
+{
+	matrix view;
+	matrix projection;
+};
+
+// Per-instance particle data, plus the vertex index used to pick a quad corner.
+struct VertexShaderInput
+{
+	float3 pos : POSITION;
+	float size : PSIZE;
+	float4 color : COLOR0;
+	uint vertexId : SV_VertexID;
+};
+
+// Per-pixel data passed through the pixel shader.
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 corner : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+// Expands each particle into a camera-facing quad drawn as a four vertex triangle strip.
+PixelShaderInput main(VertexShaderInput input)
+{
+	PixelShaderInput output;
+
+	// Vertex ids 0-3 map to the corners (-1,-1), (1,-1), (-1,1), (1,1).
+	float2 corner = float2(input.vertexId & 1, input.vertexId >> 1) * 2.0f - 1.0f;
+
+	// Offset in view space so the quad always faces the camera.
+	float4 pos = mul(float4(input.pos, 1.0f), view);
+	pos.xy += corner * input.size;
+	output.pos = mul(pos, projection);
+
+	output.corner = corner;
+	output.color = input.color;
+
+	return output;
+}
@@ -2,20 +2,30 @@
 #include "Sample3DSceneRenderer.h"
 
 #include "..\Common\DirectXHelper.h"
+#include "..\Common\MeshSimplifier.h"
 
 using namespace Rocklaga;
 
 using namespace DirectX;
 using namespace Windows::Foundation;
 
+// Levels of detail may move the surface by up to this many pixels on screen.
+static const float MaxLodPixelError = 1.0f;
+
+// The scene is what the player looks at, so it comes back before sprites after device loss.
+static const int32 MeshPriority = 1;
+
 // Loads vertex and pixel shaders from files and instantiates the cube geometry.
 Sample3DSceneRenderer::Sample3DSceneRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
 	m_loadingComplete(false),
 	m_degreesPerSecond(45),
-	m_indexCount(0),
+	m_rotation(0.0f),
+	m_lodPixelsPerUnit(1.0f),
 	m_tracking(false),
 	m_deviceResources(deviceResources)
 {
+	SetObjectPositions(std::vector<XMFLOAT3>(1, XMFLOAT3(0.0f, 0.0f, 0.0f)));
+
 	CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
 }
@@ -62,7 +72,38 @@ void Sample3DSceneRenderer::CreateWindowSizeDependentResources()
 	static const XMVECTORF32 at = { 0.0f, -0.1f, 0.0f, 0.0f };
 	static const XMVECTORF32 up = { 0.0f, 1.0f, 0.0f, 0.0f };
 
-	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(XMMatrixLookAtRH(eye, at, up)));
+	XMMATRIX viewMatrix = XMMatrixLookAtRH(eye, at, up);
+
+	XMStoreFloat4x4(&m_constantBufferData.view, XMMatrixTranspose(viewMatrix));
+
+	// A unit at distance one covers the projection's y scale in normalized device coordinates,
+	// which span the output height twice over.
+	XMFLOAT4X4 perspective;
+	XMStoreFloat4x4(&perspective, perspectiveMatrix);
+	m_lodPixelsPerUnit = perspective._22 * outputSize.Height * 0.5f;
+	XMStoreFloat3(&m_cameraPosition, eye);
+
+	// The orientation transform only rotates clip space, so the frustum planes can be taken
+	// from the same projection the shaders use.
+	m_frustum.SetFromViewProjection(viewMatrix * perspectiveMatrix * orientationMatrix);
+}
+
+// Builds the culling hierarchy over the cubes' bounding spheres. The cubes only rotate in
+// place, so the hierarchy stays valid until the positions change.
+void Sample3DSceneRenderer::SetObjectPositions(const std::vector<XMFLOAT3>& positions)
+{
+	// Radius of the sphere around a unit cube, which holds it at any rotation.
+	static const float cubeRadius = 0.8660254f;
+
+	std::vector<XMFLOAT4> spheres(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		spheres[i] = XMFLOAT4(positions[i].x, positions[i].y, positions[i].z, cubeRadius);
+	}
+
+	m_objectPositions = positions;
+	m_cullingBvh.Build(spheres);
+	m_visibleObjects.clear();
 }
 
 // Called once per frame, rotates the cube and calculates the model and view matrices.
@@ -77,13 +118,15 @@ void Sample3DSceneRenderer::Update(DX::StepTimer const& timer)
 
 		Rotate(radians);
 	}
+
+	m_cullingBvh.Cull(m_frustum, m_visibleObjects);
 }
 
 // Rotate the 3D cube model a set amount of radians.
 void Sample3DSceneRenderer::Rotate(float radians)
 {
-	// Prepare to pass the updated model matrix to the shader
-	XMStoreFloat4x4(&m_constantBufferData.model, XMMatrixTranspose(XMMatrixRotationY(radians)));
+	// The model matrix of each cube is built from this when it is drawn.
+	m_rotation = radians;
 }
 
 void Sample3DSceneRenderer::StartTracking()
@@ -110,40 +153,20 @@ void Sample3DSceneRenderer::StopTracking()
 void Sample3DSceneRenderer::Render()
 {
 	// Loading is asynchronous. Only draw geometry after it's loaded.
-	if (!m_loadingComplete)
+	if (!m_loadingComplete || m_visibleObjects.empty())
 	{
 		return;
 	}
 
 	auto context = m_deviceResources->GetD3DDeviceContext();
+	auto statistics = m_deviceResources->GetStatistics();
 
-	// Prepare the constant buffer to send it to the graphics device.
-	context->UpdateSubresource1(
-		m_constantBuffer.Get(),
-		0,
-		NULL,
-		&m_constantBufferData,
-		0,
-		0,
-		0
-		);
-
-	// Each vertex is one instance of the VertexPositionColor struct.
-	UINT stride = sizeof(VertexPositionColor);
-	UINT offset = 0;
-	context->IASetVertexBuffers(
-		0,
-		1,
-		m_vertexBuffer.GetAddressOf(),
-		&stride,
-		&offset
-		);
-
-	context->IASetIndexBuffer(
-		m_indexBuffer.Get(),
-		DXGI_FORMAT_R16_UINT, // Each index is one 16-bit unsigned integer (short).
-		0
-		);
+	// Each vertex is one instance of the QuantizedVertex struct. After device loss the mesh
+	// buffers take a few frames to come back.
+	if (!m_cubeMesh.Bind(context))
+	{
+		return;
+	}
 
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
@@ -172,58 +195,60 @@ void Sample3DSceneRenderer::Render()
 		0
 		);
 
-	// Draw the objects.
-	context->DrawIndexed(
-		m_indexCount,
-		0,
-		0
-		);
+	// Draw the objects that survived culling. The mesh's dequantization is folded into each model matrix.
+	XMFLOAT4X4 dequantize = m_cubeMesh.GetDequantizeTransform();
+	XMMATRIX rotation = XMLoadFloat4x4(&dequantize) * XMMatrixRotationY(m_rotation);
+	XMVECTOR cameraPosition = XMLoadFloat3(&m_cameraPosition);
+	for (uint32_t object : m_visibleObjects)
+	{
+		const XMFLOAT3& position = m_objectPositions[object];
+		float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&position) - cameraPosition));
+		const DX::MeshLod& lod = m_cubeMesh.GetLod(m_cubeMesh.SelectLod(distance, m_lodPixelsPerUnit, MaxLodPixelError));
+		XMStoreFloat4x4(
+			&m_constantBufferData.model,
+			XMMatrixTranspose(rotation * XMMatrixTranslation(position.x, position.y, position.z))
+			);
+
+		// Prepare the constant buffer to send it to the graphics device.
+		context->UpdateSubresource1(
+			m_constantBuffer.Get(),
+			0,
+			NULL,
+			&m_constantBufferData,
+			0,
+			0,
+			0
+			);
+		statistics->RecordBufferUpdate(sizeof(m_constantBufferData));
+
+		context->DrawIndexed(
+			lod.indexCount,
+			lod.indexOffset,
+			0
+			);
+		statistics->RecordDraw(lod.indexCount);
+	}
 }
 
 void Sample3DSceneRenderer::CreateDeviceDependentResources()
 {
-	// Load shaders asynchronously.
-	auto loadVSTask = DX::ReadDataAsync(L"SampleVertexShader.cso");
-	auto loadPSTask = DX::ReadDataAsync(L"SamplePixelShader.cso");
+	// Load shaders asynchronously. The shader cache only reads each file once, so this is
+	// immediate when the device is restored.
+	auto shaderCache = m_deviceResources->GetShaderCache();
+	auto loadVSTask = shaderCache->LoadAsync(L"SampleVertexShader.cso");
+	auto loadPSTask = shaderCache->LoadAsync(L"SamplePixelShader.cso");
 
 	// After the vertex shader file is loaded, create the shader and input layout.
-	auto createVSTask = loadVSTask.then([this](const std::vector<byte>& fileData) {
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateVertexShader(
-				&fileData[0],
-				fileData.size(),
-				nullptr,
-				&m_vertexShader
-				)
-			);
-
-		static const D3D11_INPUT_ELEMENT_DESC vertexDesc [] =
-		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		};
+	auto createVSTask = loadVSTask.then([this, shaderCache] () {
+		m_vertexShader = shaderCache->GetVertexShader(L"SampleVertexShader.cso");
 
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateInputLayout(
-				vertexDesc,
-				ARRAYSIZE(vertexDesc),
-				&fileData[0],
-				fileData.size(),
-				&m_inputLayout
-				)
-			);
+		// The input assembler expands quantized positions and colors to floats, so the shader is unchanged.
+		m_inputLayout = shaderCache->GetInputLayout(L"SampleVertexShader.cso", Mesh::InputElements, ARRAYSIZE(Mesh::InputElements));
 	});
 
 	// After the pixel shader file is loaded, create the shader and constant buffer.
-	auto createPSTask = loadPSTask.then([this](const std::vector<byte>& fileData) {
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreatePixelShader(
-				&fileData[0],
-				fileData.size(),
-				nullptr,
-				&m_pixelShader
-				)
-			);
+	auto createPSTask = loadPSTask.then([this, shaderCache] () {
+		m_pixelShader = shaderCache->GetPixelShader(L"SamplePixelShader.cso");
 
 		CD3D11_BUFFER_DESC constantBufferDesc(sizeof(ModelViewProjectionConstantBuffer) , D3D11_BIND_CONSTANT_BUFFER);
 		DX::ThrowIfFailed(
@@ -233,10 +258,16 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 				&m_constantBuffer
 				)
 			);
+		m_deviceResources->GetStatistics()->RecordBuffer(constantBufferDesc.ByteWidth);
 	});
 
-	// Once both shaders are loaded, create the mesh.
+	// Once both shaders are loaded, create the mesh. It survives device loss in the resource
+	// registry, so this only runs once.
 	auto createCubeTask = (createPSTask && createVSTask).then([this] () {
+		if (m_cubeMesh.IsCreated())
+		{
+			return;
+		}
 
 		// Load mesh vertices. Each vertex has a position and a color.
 		static const VertexPositionColor cubeVertices[] = 
@@ -251,19 +282,6 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 			{XMFLOAT3( 0.5f,  0.5f,  0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f)},
 		};
 
-		D3D11_SUBRESOURCE_DATA vertexBufferData = {0};
-		vertexBufferData.pSysMem = cubeVertices;
-		vertexBufferData.SysMemPitch = 0;
-		vertexBufferData.SysMemSlicePitch = 0;
-		CD3D11_BUFFER_DESC vertexBufferDesc(sizeof(cubeVertices), D3D11_BIND_VERTEX_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-				&vertexBufferDesc,
-				&vertexBufferData,
-				&m_vertexBuffer
-				)
-			);
-
 		// Load mesh indices. Each trio of indices represents
 		// a triangle to be rendered on the screen.
 		// For example: 0,2,1 means that the vertices with indexes
@@ -290,20 +308,33 @@ void Sample3DSceneRenderer::CreateDeviceDependentResources()
 			1,7,5,
 		};
 
-		m_indexCount = ARRAYSIZE(cubeIndices);
-
-		D3D11_SUBRESOURCE_DATA indexBufferData = {0};
-		indexBufferData.pSysMem = cubeIndices;
-		indexBufferData.SysMemPitch = 0;
-		indexBufferData.SysMemSlicePitch = 0;
-		CD3D11_BUFFER_DESC indexBufferDesc(sizeof(cubeIndices), D3D11_BIND_INDEX_BUFFER);
-		DX::ThrowIfFailed(
-			m_deviceResources->GetD3DDevice()->CreateBuffer(
-				&indexBufferDesc,
-				&indexBufferData,
-				&m_indexBuffer
-				)
+		// Convert the cube to the quantized mesh format, as the asset build does for mesh files,
+		// and upload it from there.
+		std::vector<DX::MeshSourceVertex> vertices(ARRAYSIZE(cubeVertices));
+		std::vector<XMFLOAT3> positions(ARRAYSIZE(cubeVertices));
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			vertices[i].position = cubeVertices[i].pos;
+			vertices[i].color = cubeVertices[i].color;
+			vertices[i].normal = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			positions[i] = cubeVertices[i].pos;
+		}
+
+		// Levels of detail halve the triangle count each step while staying within 1% of the
+		// cube's size. A cube has nothing to spare, so in practice it keeps the one level.
+		std::vector<DX::MeshLodSource> lods = DX::GenerateMeshLods(
+			positions,
+			std::vector<uint32_t>(std::begin(cubeIndices), std::end(cubeIndices)),
+			4,
+			0.5f,
+			0.01f
 			);
+
+		std::vector<uint8_t> meshData = DX::EncodeMesh(vertices, lods, false);
+
+		DX::MeshView meshView;
+		meshView.Open(meshData.data(), meshData.size());
+		m_cubeMesh.Create(m_deviceResources->GetResourceRegistry(), meshView, MeshPriority);
 	});
 
 	// Once the cube is loaded, the object is ready to be rendered.
@@ -319,6 +350,4 @@ void Sample3DSceneRenderer::ReleaseDeviceDependentResources()
 	m_inputLayout.Reset();
 	m_pixelShader.Reset();
 	m_constantBuffer.Reset();
-	m_vertexBuffer.Reset();
-	m_indexBuffer.Reset();
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "..\Common\DeviceResources.h"
 #include "ShaderStructures.h"
 #include "..\Common\StepTimer.h"
+#include "..\Common\Culling.h"
+#include "Mesh.h"
 
 namespace Rocklaga
 {
@@ -21,6 +23,14 @@ namespace Rocklaga
 		void StopTracking();
 		bool IsTracking() { return m_tracking; }
 
+		// Places a cube at each position. Only cubes inside the view frustum are drawn.
+		void SetObjectPositions(const std::vector<DirectX::XMFLOAT3>& positions);
+		size_t GetVisibleObjectCount() const { return m_visibleObjects.size(); }
+
+		// Camera matrices, already transposed for use in shader constant buffers.
+		DirectX::XMFLOAT4X4 GetViewMatrix() const { return m_constantBufferData.view; }
+		DirectX::XMFLOAT4X4 GetProjectionMatrix() const { return m_constantBufferData.projection; }
+
 
 	private:
 		void Rotate(float radians);
@@ -31,15 +41,24 @@ namespace Rocklaga
 
 		// Direct3D resources for cube geometry.
 		Microsoft::WRL::ComPtr<ID3D11InputLayout>	m_inputLayout;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_vertexBuffer;
-		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_indexBuffer;
 		Microsoft::WRL::ComPtr<ID3D11VertexShader>	m_vertexShader;
 		Microsoft::WRL::ComPtr<ID3D11PixelShader>	m_pixelShader;
 		Microsoft::WRL::ComPtr<ID3D11Buffer>		m_constantBuffer;
 
 		// System resources for cube geometry.
+		Mesh								m_cubeMesh;
 		ModelViewProjectionConstantBuffer	m_constantBufferData;
-		uint32	m_indexCount;
+		float	m_rotation;
+
+		// Camera values used to pick each object's level of detail.
+		DirectX::XMFLOAT3	m_cameraPosition;
+		float				m_lodPixelsPerUnit;
+
+		// Scene objects and the hierarchy used to cull them against the camera.
+		std::vector<DirectX::XMFLOAT3>	m_objectPositions;
+		DX::CullingBvh					m_cullingBvh;
+		DX::Frustum						m_frustum;
+		std::vector<uint32_t>			m_visibleObjects;
 
 		// Variables used with the rendering loop.
 		bool	m_loadingComplete;
@@ -75,7 +75,13 @@ void SampleFpsTextRenderer::Update(DX::StepTimer const& timer)
 // Renders a frame to the screen.
 void SampleFpsTextRenderer::Render()
 {
+	// Headless devices have no Direct2D.
 	ID2D1DeviceContext* context = m_deviceResources->GetD2DDeviceContext();
+	if (context == nullptr)
+	{
+		return;
+	}
+
 	Windows::Foundation::Size logicalSize = m_deviceResources->GetLogicalSize();
 
 	context->SaveDrawingState(m_stateBlock.Get());
@@ -112,6 +118,11 @@ void SampleFpsTextRenderer::Render()
 
 void SampleFpsTextRenderer::CreateDeviceDependentResources()
 {
+	if (m_deviceResources->GetD2DDeviceContext() == nullptr)
+	{
+		return;
+	}
+
 	DX::ThrowIfFailed(
 		m_deviceResources->GetD2DDeviceContext()->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::White), &m_whiteBrush)
 		);
@@ -10,6 +10,19 @@ namespace Rocklaga
 		DirectX::XMFLOAT4X4 projection;
 	};
 
+	// Constant buffer used to send camera matrices to the particle vertex shader.
+	struct ParticleConstantBuffer
+	{
+		DirectX::XMFLOAT4X4 view;
+		DirectX::XMFLOAT4X4 projection;
+	};
+
+	// Constant buffer used to send the pixel-to-clip-space transform to the sprite vertex shader.
+	struct SpriteConstantBuffer
+	{
+		DirectX::XMFLOAT4X4 transform;
+	};
+
 	// Used to send per-vertex data to the vertex shader.
 	struct VertexPositionColor
 	{
@@ -0,0 +1,186 @@
+﻿#include "pch.h"
+#include "SpriteAtlas.h"
+
+#include "..\Common\DirectXHelper.h"
+#include "..\Common\Hash.h"
+
+using namespace Rocklaga;
+
+using namespace Concurrency;
+using namespace Microsoft::WRL;
+
+namespace
+{
+	// Largest atlas side, in pixels. 4096 is supported from feature level 9_3 up.
+	static const uint32 MaxAtlasSize = 4096;
+
+	// Gap left around each sprite so filtering never samples a neighbour.
+	static const uint32 AtlasPadding = 1;
+}
+
+SpriteAtlas::SpriteAtlas(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
+	m_loadingComplete(false),
+	m_deviceResources(deviceResources)
+{
+}
+
+// Reads every source file, then either loads the cached atlas or rebuilds it if the sources changed.
+task<void> SpriteAtlas::LoadAsync(const std::vector<std::wstring>& sourceFiles, const std::wstring& cacheFileName)
+{
+	auto fileData = std::make_shared<std::vector<std::vector<byte>>>(sourceFiles.size());
+
+	std::vector<task<void>> readTasks;
+	for (size_t i = 0; i < sourceFiles.size(); i++)
+	{
+		readTasks.push_back(DX::ReadDataAsync(sourceFiles[i]).then([fileData, i](const std::vector<byte>& data) {
+			(*fileData)[i] = data;
+		}));
+	}
+
+	return when_all(readTasks.begin(), readTasks.end()).then([this, sourceFiles, cacheFileName, fileData] () {
+		// The cache key covers every source name and its encoded bytes, so any edit invalidates it.
+		uint64 sourceHash = DX::HashSeed;
+		for (size_t i = 0; i < sourceFiles.size(); i++)
+		{
+			sourceHash = DX::HashBytes(sourceFiles[i].c_str(), sourceFiles[i].size() * sizeof(wchar_t), sourceHash);
+			sourceHash = DX::HashBytes((*fileData)[i].data(), (*fileData)[i].size(), sourceHash);
+		}
+
+		return DX::ReadLocalDataAsync(cacheFileName).then([this, sourceFiles, cacheFileName, fileData, sourceHash](const std::vector<byte>& cacheData) {
+			uint64 cachedHash;
+			if (DX::TextureAtlas::ReadSourceHash(cacheData.data(), cacheData.size(), cachedHash) &&
+				cachedHash == sourceHash &&
+				m_atlas.Deserialize(cacheData.data(), cacheData.size()))
+			{
+				return task_from_result();
+			}
+
+			Rebuild(sourceFiles, *fileData, sourceHash);
+			return DX::WriteLocalDataAsync(cacheFileName, m_atlas.Serialize());
+		});
+	}).then([this] () {
+		CreateDeviceDependentResources();
+		m_loadingComplete = true;
+	});
+}
+
+// Decodes every source image with WIC and packs them into a new atlas.
+void SpriteAtlas::Rebuild(const std::vector<std::wstring>& sourceFiles, const std::vector<std::vector<byte>>& fileData, uint64 sourceHash)
+{
+	auto wicFactory = m_deviceResources->GetWicImagingFactory();
+
+	std::vector<DX::AtlasSourceImage> images(sourceFiles.size());
+	for (size_t i = 0; i < sourceFiles.size(); i++)
+	{
+		ComPtr<IWICStream> stream;
+		DX::ThrowIfFailed(wicFactory->CreateStream(&stream));
+		DX::ThrowIfFailed(
+			stream->InitializeFromMemory(
+				const_cast<byte*>(fileData[i].data()),
+				static_cast<DWORD>(fileData[i].size())
+				)
+			);
+
+		ComPtr<IWICBitmapDecoder> decoder;
+		DX::ThrowIfFailed(
+			wicFactory->CreateDecoderFromStream(
+				stream.Get(),
+				nullptr,
+				WICDecodeMetadataCacheOnDemand,
+				&decoder
+				)
+			);
+
+		ComPtr<IWICBitmapFrameDecode> frame;
+		DX::ThrowIfFailed(decoder->GetFrame(0, &frame));
+
+		ComPtr<IWICFormatConverter> converter;
+		DX::ThrowIfFailed(wicFactory->CreateFormatConverter(&converter));
+		DX::ThrowIfFailed(
+			converter->Initialize(
+				frame.Get(),
+				GUID_WICPixelFormat32bppRGBA,
+				WICBitmapDitherTypeNone,
+				nullptr,
+				0.0f,
+				WICBitmapPaletteTypeCustom
+				)
+			);
+
+		DX::AtlasSourceImage& image = images[i];
+		image.nameHash = HashName(sourceFiles[i]);
+		DX::ThrowIfFailed(converter->GetSize(&image.width, &image.height));
+
+		image.pixels.resize(image.width * image.height * 4);
+		DX::ThrowIfFailed(
+			converter->CopyPixels(
+				nullptr,
+				image.width * 4,
+				static_cast<UINT>(image.pixels.size()),
+				image.pixels.data()
+				)
+			);
+	}
+
+	if (!m_atlas.Build(images, sourceHash, MaxAtlasSize, AtlasPadding))
+	{
+		// The sprites don't fit in a single texture.
+		DX::ThrowIfFailed(E_OUTOFMEMORY);
+	}
+}
+
+// Creates the atlas texture from the pixels held in memory.
+void SpriteAtlas::CreateDeviceDependentResources()
+{
+	if (m_atlas.GetWidth() == 0)
+	{
+		return;
+	}
+
+	D3D11_SUBRESOURCE_DATA textureData = {0};
+	textureData.pSysMem = m_atlas.GetPixels().data();
+	textureData.SysMemPitch = m_atlas.GetWidth() * 4;
+
+	CD3D11_TEXTURE2D_DESC textureDesc(
+		DXGI_FORMAT_R8G8B8A8_UNORM,
+		m_atlas.GetWidth(),
+		m_atlas.GetHeight(),
+		1,
+		1,
+		D3D11_BIND_SHADER_RESOURCE,
+		D3D11_USAGE_IMMUTABLE
+		);
+
+	ComPtr<ID3D11Texture2D> texture;
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateTexture2D(
+			&textureDesc,
+			&textureData,
+			&texture
+			)
+		);
+	m_deviceResources->GetStatistics()->RecordTexture(textureData.SysMemPitch * m_atlas.GetHeight());
+
+	DX::ThrowIfFailed(
+		m_deviceResources->GetD3DDevice()->CreateShaderResourceView(
+			texture.Get(),
+			nullptr,
+			&m_texture
+			)
+		);
+}
+
+void SpriteAtlas::ReleaseDeviceDependentResources()
+{
+	m_texture.Reset();
+}
+
+const DX::AtlasEntry* SpriteAtlas::Find(const std::wstring& sourceFile) const
+{
+	return m_atlas.Find(HashName(sourceFile));
+}
+
+uint64 SpriteAtlas::HashName(const std::wstring& name)
+{
+	return DX::HashBytes(name.c_str(), name.size() * sizeof(wchar_t));
+}
@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <string>
+#include "..\Common\DeviceResources.h"
+#include "..\Common\TextureAtlas.h"
+
+namespace Rocklaga
+{
+	// Packs sprite images into one texture on first run and caches the result in the local folder.
+	// Later runs load the cache with a single read, and it is rebuilt only when a source file changes.
+	class SpriteAtlas
+	{
+	public:
+		SpriteAtlas(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+		Concurrency::task<void> LoadAsync(const std::vector<std::wstring>& sourceFiles, const std::wstring& cacheFileName);
+		void CreateDeviceDependentResources();
+		void ReleaseDeviceDependentResources();
+
+		// Returns the atlas placement of a source file, or nullptr if it is not in the atlas.
+		const DX::AtlasEntry* Find(const std::wstring& sourceFile) const;
+
+		ID3D11ShaderResourceView* GetTexture() const	{ return m_texture.Get(); }
+		bool IsLoaded() const							{ return m_loadingComplete; }
+
+	private:
+		void Rebuild(const std::vector<std::wstring>& sourceFiles, const std::vector<std::vector<byte>>& fileData, uint64 sourceHash);
+		static uint64 HashName(const std::wstring& name);
+
+		// Cached pointer to device resources.
+		std::shared_ptr<DX::DeviceResources> m_deviceResources;
+
+		// The packed atlas. Its pixels stay in memory so the texture can be recreated without I/O.
+		DX::TextureAtlas m_atlas;
+
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> m_texture;
+
+		bool m_loadingComplete;
+	};
+}
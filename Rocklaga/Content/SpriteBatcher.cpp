@@ -0,0 +1,123 @@
+﻿#include "pch.h"
+#include "SpriteBatcher.h"
+
+#include <algorithm>
+
+using namespace Rocklaga;
+using namespace DirectX;
+
+SpriteBatcher::SpriteBatcher()
+{
+}
+
+// Discards the sprites queued for the previous frame.
+void SpriteBatcher::Begin()
+{
+	m_sprites.clear();
+	m_sortKeys.clear();
+	m_order.clear();
+}
+
+void SpriteBatcher::Draw(const Sprite& sprite)
+{
+	m_sprites.push_back(sprite);
+}
+
+// Packs layer, blend mode and texture above the submission sequence number, so sorting plain
+// integers groups sprites by state while keeping the original order within each group.
+// Only the low 16 bits of the texture handle take part in sorting.
+uint64_t SpriteBatcher::SortKey(const Sprite& sprite, uint32_t sequence)
+{
+	return (static_cast<uint64_t>(sprite.layer) << 56) |
+		(static_cast<uint64_t>(sprite.blend) << 48) |
+		(static_cast<uint64_t>(sprite.texture & 0xFFFF) << 32) |
+		sequence;
+}
+
+void SpriteBatcher::Sort()
+{
+	uint32_t count = GetSpriteCount();
+
+	m_sortKeys.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_sortKeys[i] = SortKey(m_sprites[i], i);
+	}
+
+	std::sort(m_sortKeys.begin(), m_sortKeys.end());
+
+	m_order.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		m_order[i] = static_cast<uint32_t>(m_sortKeys[i]);
+	}
+}
+
+void SpriteBatcher::WriteVertices(uint32_t firstSprite, uint32_t count, SpriteVertex* dest) const
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const Sprite& sprite = m_sprites[m_order[firstSprite + i]];
+
+		float halfWidth = sprite.destination.z * 0.5f;
+		float halfHeight = sprite.destination.w * 0.5f;
+		float centerX = sprite.destination.x + halfWidth;
+		float centerY = sprite.destination.y + halfHeight;
+
+		// Half extents of the quad along its rotated x and y axes.
+		float axisXx = halfWidth;
+		float axisXy = 0.0f;
+		float axisYx = 0.0f;
+		float axisYy = halfHeight;
+
+		if (sprite.rotation != 0.0f)
+		{
+			float sinAngle, cosAngle;
+			XMScalarSinCos(&sinAngle, &cosAngle, sprite.rotation);
+			axisXx = cosAngle * halfWidth;
+			axisXy = sinAngle * halfWidth;
+			axisYx = -sinAngle * halfHeight;
+			axisYy = cosAngle * halfHeight;
+		}
+
+		// Corners in the order top-left, top-right, bottom-left, bottom-right.
+		SpriteVertex* quad = dest + i * 4;
+
+		quad[0].pos = XMFLOAT2(centerX - axisXx - axisYx, centerY - axisXy - axisYy);
+		quad[1].pos = XMFLOAT2(centerX + axisXx - axisYx, centerY + axisXy - axisYy);
+		quad[2].pos = XMFLOAT2(centerX - axisXx + axisYx, centerY - axisXy + axisYy);
+		quad[3].pos = XMFLOAT2(centerX + axisXx + axisYx, centerY + axisXy + axisYy);
+
+		quad[0].uv = XMFLOAT2(sprite.source.x, sprite.source.y);
+		quad[1].uv = XMFLOAT2(sprite.source.z, sprite.source.y);
+		quad[2].uv = XMFLOAT2(sprite.source.x, sprite.source.w);
+		quad[3].uv = XMFLOAT2(sprite.source.z, sprite.source.w);
+
+		quad[0].color = sprite.color;
+		quad[1].color = sprite.color;
+		quad[2].color = sprite.color;
+		quad[3].color = sprite.color;
+	}
+}
+
+void SpriteBatcher::BuildBatches(uint32_t firstSprite, uint32_t count, std::vector<SpriteBatch>& batches) const
+{
+	batches.clear();
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const Sprite& sprite = m_sprites[m_order[firstSprite + i]];
+
+		if (!batches.empty() &&
+			batches.back().texture == sprite.texture &&
+			batches.back().blend == sprite.blend)
+		{
+			batches.back().spriteCount++;
+		}
+		else
+		{
+			SpriteBatch batch = { sprite.texture, sprite.blend, i, 1 };
+			batches.push_back(batch);
+		}
+	}
+}
@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <DirectXMath.h>
+
+namespace Rocklaga
+{
+	// Blend modes a sprite can be drawn with. Sprites are grouped by blend mode before texture.
+	enum class SpriteBlend : uint8_t
+	{
+		Opaque,
+		AlphaBlend,
+		Additive,
+	};
+
+	// Per-vertex data for sprites, in pixels; consumed by SpriteVertexShader.hlsl.
+	struct SpriteVertex
+	{
+		DirectX::XMFLOAT2 pos;
+		DirectX::XMFLOAT2 uv;
+		uint32_t color; // RGBA8.
+	};
+
+	// A queued sprite. Textures are referred to by handle so the batcher stays independent of Direct3D.
+	struct Sprite
+	{
+		DirectX::XMFLOAT4 destination;	// Left, top, width, height in pixels.
+		DirectX::XMFLOAT4 source;		// Left, top, right, bottom in normalized texture coordinates.
+		uint32_t color;					// RGBA8 tint.
+		float rotation;					// Radians around the sprite center.
+		uint32_t texture;
+		SpriteBlend blend;
+		uint8_t layer;					// Lower layers are drawn first, regardless of texture.
+	};
+
+	// A run of consecutive sorted sprites that share texture and blend state and can be drawn with one call.
+	struct SpriteBatch
+	{
+		uint32_t texture;
+		SpriteBlend blend;
+		uint32_t firstSprite;
+		uint32_t spriteCount;
+	};
+
+	// Queues sprites for a frame, sorts them to minimize state changes and writes quad vertices.
+	// Sorting is stable, so sprites that share a layer, blend mode and texture keep their submission order.
+	class SpriteBatcher
+	{
+	public:
+		SpriteBatcher();
+
+		void Begin();
+		void Draw(const Sprite& sprite);
+
+		// Sorts the queued sprites by layer, blend mode and texture. Call once after the last Draw.
+		void Sort();
+
+		// Writes four vertices per sprite for sprites [firstSprite, firstSprite + count) in sorted order.
+		void WriteVertices(uint32_t firstSprite, uint32_t count, SpriteVertex* dest) const;
+
+		// Splits sprites [firstSprite, firstSprite + count) into batches. Sprite indices in the
+		// batches are relative to firstSprite.
+		void BuildBatches(uint32_t firstSprite, uint32_t count, std::vector<SpriteBatch>& batches) const;
+
+		uint32_t GetSpriteCount() const { return static_cast<uint32_t>(m_sprites.size()); }
+
+	private:
+		static uint64_t SortKey(const Sprite& sprite, uint32_t sequence);
+
+		std::vector<Sprite>		m_sprites;
+		std::vector<uint64_t>	m_sortKeys;
+		std::vector<uint32_t>	m_order;
+	};
+}
@@ -0,0 +1,16 @@
+Texture2D spriteTexture : register(t0);
+SamplerState spriteSampler : register(s0);
+
+// Per-pixel data passed through the pixel shader.
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+// Samples the sprite texture and applies the per-sprite tint.
+float4 main(PixelShaderInput input) : SV_TARGET
+{
+	return spriteTexture.Sample(spriteSampler, input.uv) * input.color;
+}
@@ -0,0 +1,309 @@
+﻿#include "pch.h"
+#include "SpriteRenderer.h"
+
+#include "..\Common\DirectXHelper.h"
+
+using namespace Rocklaga;
+
+using namespace DirectX;
+using namespace Windows::Foundation;
+
+// The index buffer never changes, so it is kept in the resource registry and recreated from
+// memory after device loss, after the scene.
+static const int32 IndexBufferPriority = 0;
+
+// Loads the sprite shaders and creates the vertex and index buffers.
+SpriteRenderer::SpriteRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
+	m_loadingComplete(false),
+	m_vertexBufferPosition(0),
+	m_indexBuffer(DX::InvalidResource),
+	m_drawCallCount(0),
+	m_deviceResources(deviceResources)
+{
+	CreateDeviceDependentResources();
+	CreateWindowSizeDependentResources();
+}
+
+// Sprites are positioned in pixels with the origin in the top left corner of the output.
+void SpriteRenderer::CreateWindowSizeDependentResources()
+{
+	Size outputSize = m_deviceResources->GetOutputSize();
+
+	XMMATRIX pixelsToClip = XMMatrixOrthographicOffCenterRH(
+		0.0f,
+		outputSize.Width,
+		outputSize.Height,
+		0.0f,
+		0.0f,
+		1.0f
+		);
+
+	// As in Sample3DSceneRenderer, the orientation transform is post-multiplied
+	// so sprites match the display orientation.
+	XMFLOAT4X4 orientation = m_deviceResources->GetOrientationTransform3D();
+	XMMATRIX orientationMatrix = XMLoadFloat4x4(&orientation);
+
+	XMStoreFloat4x4(
+		&m_constantBufferData.transform,
+		XMMatrixTranspose(pixelsToClip * orientationMatrix)
+		);
+}
+
+uint32 SpriteRenderer::RegisterTexture(ID3D11ShaderResourceView* texture)
+{
+	m_textures.push_back(texture);
+	return static_cast<uint32>(m_textures.size() - 1);
+}
+
+void SpriteRenderer::ReleaseTextures()
+{
+	m_textures.clear();
+}
+
+// Draws every sprite queued since the last frame, then clears the queue.
+void SpriteRenderer::Render()
+{
+	m_drawCallCount = 0;
+
+	// Loading is asynchronous. Only draw sprites after the shaders are loaded, and after device
+	// loss once the index buffer is back.
+	ID3D11Buffer* indexBuffer = m_deviceResources->GetResourceRegistry()->GetBuffer(m_indexBuffer);
+	if (!m_loadingComplete || indexBuffer == nullptr || m_batcher.GetSpriteCount() == 0)
+	{
+		m_batcher.Begin();
+		return;
+	}
+
+	auto context = m_deviceResources->GetD3DDeviceContext();
+
+	m_batcher.Sort();
+
+	auto statistics = m_deviceResources->GetStatistics();
+
+	context->UpdateSubresource1(
+		m_constantBuffer.Get(),
+		0,
+		NULL,
+		&m_constantBufferData,
+		0,
+		0,
+		0
+		);
+	statistics->RecordBufferUpdate(sizeof(m_constantBufferData));
+
+	// Each vertex is one instance of the SpriteVertex struct.
+	UINT stride = sizeof(SpriteVertex);
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, m_vertexBuffer.GetAddressOf(), &stride, &offset);
+	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R16_UINT, 0);
+	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context->IASetInputLayout(m_inputLayout.Get());
+
+	context->VSSetShader(m_vertexShader.Get(), nullptr, 0);
+	context->VSSetConstantBuffers1(0, 1, m_constantBuffer.GetAddressOf(), nullptr, nullptr);
+	context->PSSetShader(m_pixelShader.Get(), nullptr, 0);
+	context->PSSetSamplers(0, 1, m_samplerState.GetAddressOf());
+
+	// Sprites are drawn on top of the 3D scene in the order Sort left them: by layer, then
+	// blend mode, then texture, with sprites equal in all three kept in submission order.
+	context->OMSetDepthStencilState(m_depthStencilState.Get(), 0);
+	context->RSSetState(m_rasterizerState.Get());
+
+	uint32 spriteCount = m_batcher.GetSpriteCount();
+	for (uint32 firstSprite = 0; firstSprite < spriteCount; )
+	{
+		uint32 count = spriteCount - firstSprite;
+		if (count > MaxSprites)
+		{
+			count = MaxSprites;
+		}
+
+		// Append to the buffer while there is room so the GPU can keep reading earlier sprites,
+		// and only discard it once it is full.
+		D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+		if (m_vertexBufferPosition + count > MaxSprites)
+		{
+			mapType = D3D11_MAP_WRITE_DISCARD;
+			m_vertexBufferPosition = 0;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		DX::ThrowIfFailed(
+			context->Map(m_vertexBuffer.Get(), 0, mapType, 0, &mapped)
+			);
+
+		m_batcher.WriteVertices(firstSprite, count, static_cast<SpriteVertex*>(mapped.pData) + m_vertexBufferPosition * 4);
+
+		context->Unmap(m_vertexBuffer.Get(), 0);
+		statistics->RecordBufferUpdate(count * 4 * sizeof(SpriteVertex));
+
+		m_batcher.BuildBatches(firstSprite, count, m_batches);
+
+		for (const auto& batch : m_batches)
+		{
+			switch (batch.blend)
+			{
+			case SpriteBlend::Opaque:
+				context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+				break;
+
+			case SpriteBlend::AlphaBlend:
+				context->OMSetBlendState(m_alphaBlendState.Get(), nullptr, 0xffffffff);
+				break;
+
+			case SpriteBlend::Additive:
+				context->OMSetBlendState(m_additiveBlendState.Get(), nullptr, 0xffffffff);
+				break;
+			}
+
+			ID3D11ShaderResourceView* texture = batch.texture < m_textures.size() ? m_textures[batch.texture].Get() : nullptr;
+			context->PSSetShaderResources(0, 1, &texture);
+
+			// The index buffer repeats the same quad pattern, so each batch starts at index zero
+			// and selects its sprites with the base vertex.
+			context->DrawIndexed(
+				batch.spriteCount * 6,
+				0,
+				(m_vertexBufferPosition + batch.firstSprite) * 4
+				);
+
+			statistics->RecordDraw(batch.spriteCount * 6);
+			m_drawCallCount++;
+		}
+
+		m_vertexBufferPosition += count;
+		firstSprite += count;
+	}
+
+	// Restore default state for the renderers that follow.
+	ID3D11ShaderResourceView* nullTexture = nullptr;
+	context->PSSetShaderResources(0, 1, &nullTexture);
+	context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+	context->OMSetDepthStencilState(nullptr, 0);
+	context->RSSetState(nullptr);
+
+	m_batcher.Begin();
+}
+
+void SpriteRenderer::CreateDeviceDependentResources()
+{
+	// Load shaders asynchronously. The shader cache only reads each file once, so this is
+	// immediate when the device is restored.
+	auto shaderCache = m_deviceResources->GetShaderCache();
+	auto loadVSTask = shaderCache->LoadAsync(L"SpriteVertexShader.cso");
+	auto loadPSTask = shaderCache->LoadAsync(L"SpritePixelShader.cso");
+
+	// After the vertex shader file is loaded, create the shader and input layout.
+	auto createVSTask = loadVSTask.then([this, shaderCache] () {
+		m_vertexShader = shaderCache->GetVertexShader(L"SpriteVertexShader.cso");
+
+		static const D3D11_INPUT_ELEMENT_DESC vertexDesc [] =
+		{
+			{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+			{ "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		};
+
+		m_inputLayout = shaderCache->GetInputLayout(L"SpriteVertexShader.cso", vertexDesc, ARRAYSIZE(vertexDesc));
+	});
+
+	// After the pixel shader file is loaded, create the shader and constant buffer.
+	auto createPSTask = loadPSTask.then([this, shaderCache] () {
+		m_pixelShader = shaderCache->GetPixelShader(L"SpritePixelShader.cso");
+
+		CD3D11_BUFFER_DESC constantBufferDesc(sizeof(SpriteConstantBuffer), D3D11_BIND_CONSTANT_BUFFER);
+		DX::ThrowIfFailed(
+			m_deviceResources->GetD3DDevice()->CreateBuffer(
+				&constantBufferDesc,
+				nullptr,
+				&m_constantBuffer
+				)
+			);
+		m_deviceResources->GetStatistics()->RecordBuffer(constantBufferDesc.ByteWidth);
+	});
+
+	// Once both shaders are loaded, create the buffers and pipeline state.
+	auto createBuffersTask = (createPSTask && createVSTask).then([this] () {
+		auto device = m_deviceResources->GetD3DDevice();
+
+		CD3D11_BUFFER_DESC vertexBufferDesc(
+			MaxSprites * 4 * sizeof(SpriteVertex),
+			D3D11_BIND_VERTEX_BUFFER,
+			D3D11_USAGE_DYNAMIC,
+			D3D11_CPU_ACCESS_WRITE
+			);
+		DX::ThrowIfFailed(
+			device->CreateBuffer(
+				&vertexBufferDesc,
+				nullptr,
+				&m_vertexBuffer
+				)
+			);
+		m_deviceResources->GetStatistics()->RecordBuffer(vertexBufferDesc.ByteWidth);
+
+		// Every quad uses the same two triangles, so the index buffer never changes and is only
+		// built the first time.
+		if (m_indexBuffer == DX::InvalidResource)
+		{
+			std::vector<unsigned short> indices(MaxSprites * 6);
+			for (uint32 i = 0; i < MaxSprites; i++)
+			{
+				unsigned short vertex = static_cast<unsigned short>(i * 4);
+				indices[i * 6 + 0] = vertex + 0;
+				indices[i * 6 + 1] = vertex + 1;
+				indices[i * 6 + 2] = vertex + 2;
+				indices[i * 6 + 3] = vertex + 1;
+				indices[i * 6 + 4] = vertex + 3;
+				indices[i * 6 + 5] = vertex + 2;
+			}
+
+			CD3D11_BUFFER_DESC indexBufferDesc(static_cast<UINT>(indices.size() * sizeof(unsigned short)), D3D11_BIND_INDEX_BUFFER);
+			m_indexBuffer = m_deviceResources->GetResourceRegistry()->RegisterBuffer(indexBufferDesc, indices.data(), IndexBufferPriority);
+		}
+
+		CD3D11_SAMPLER_DESC samplerDesc(D3D11_DEFAULT);
+		samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
+		DX::ThrowIfFailed(device->CreateSamplerState(&samplerDesc, &m_samplerState));
+
+		CD3D11_BLEND_DESC blendDesc(D3D11_DEFAULT);
+		blendDesc.RenderTarget[0].BlendEnable = TRUE;
+		blendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+		DX::ThrowIfFailed(device->CreateBlendState(&blendDesc, &m_alphaBlendState));
+
+		blendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_ONE;
+		DX::ThrowIfFailed(device->CreateBlendState(&blendDesc, &m_additiveBlendState));
+
+		CD3D11_DEPTH_STENCIL_DESC depthStencilDesc(D3D11_DEFAULT);
+		depthStencilDesc.DepthEnable = FALSE;
+		DX::ThrowIfFailed(device->CreateDepthStencilState(&depthStencilDesc, &m_depthStencilState));
+
+		CD3D11_RASTERIZER_DESC rasterizerDesc(D3D11_DEFAULT);
+		rasterizerDesc.CullMode = D3D11_CULL_NONE;
+		DX::ThrowIfFailed(device->CreateRasterizerState(&rasterizerDesc, &m_rasterizerState));
+
+		m_vertexBufferPosition = 0;
+	});
+
+	// Once the buffers are created, sprites are ready to be rendered.
+	createBuffersTask.then([this] () {
+		m_loadingComplete = true;
+	});
+}
+
+// Registered textures belong to the lost device too, so they are released and must be registered again.
+void SpriteRenderer::ReleaseDeviceDependentResources()
+{
+	m_loadingComplete = false;
+	ReleaseTextures();
+	m_vertexShader.Reset();
+	m_inputLayout.Reset();
+	m_pixelShader.Reset();
+	m_constantBuffer.Reset();
+	m_vertexBuffer.Reset();
+	m_samplerState.Reset();
+	m_alphaBlendState.Reset();
+	m_additiveBlendState.Reset();
+	m_depthStencilState.Reset();
+	m_rasterizerState.Reset();
+}
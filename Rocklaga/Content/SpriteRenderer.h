@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include "..\Common\DeviceResources.h"
+#include "ShaderStructures.h"
+#include "SpriteBatcher.h"
+
+namespace Rocklaga
+{
+	// Draws the sprites queued in a SpriteBatcher through a large dynamic vertex buffer,
+	// issuing one DrawIndexed call per run of sprites that share a texture and blend mode.
+	class SpriteRenderer
+	{
+	public:
+		SpriteRenderer(const std::shared_ptr<DX::DeviceResources>& deviceResources);
+		void CreateDeviceDependentResources();
+		void CreateWindowSizeDependentResources();
+		void ReleaseDeviceDependentResources();
+		void Render();
+
+		// Textures are referred to from sprites by the returned handle. Ideally every sprite
+		// comes from one atlas, so a frame's sprites collapse into a batch per blend mode.
+		uint32 RegisterTexture(ID3D11ShaderResourceView* texture);
+		void ReleaseTextures();
+
+		SpriteBatcher& GetBatcher() { return m_batcher; }
+
+		// Statistics for the most recent frame.
+		uint32 GetDrawCallCount() const { return m_drawCallCount; }
+
+	private:
+		// Number of sprites that fit in the vertex buffer; keeps 16-bit indices valid.
+		static const uint32 MaxSprites = 16384;
+
+		// Cached pointer to device resources.
+		std::shared_ptr<DX::DeviceResources> m_deviceResources;
+
+		// Direct3D resources for sprite geometry.
+		Microsoft::WRL::ComPtr<ID3D11InputLayout>		m_inputLayout;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>			m_vertexBuffer;
+		DX::ResourceId									m_indexBuffer;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader>		m_vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader>		m_pixelShader;
+		Microsoft::WRL::ComPtr<ID3D11Buffer>			m_constantBuffer;
+		Microsoft::WRL::ComPtr<ID3D11SamplerState>		m_samplerState;
+		Microsoft::WRL::ComPtr<ID3D11BlendState>		m_alphaBlendState;
+		Microsoft::WRL::ComPtr<ID3D11BlendState>		m_additiveBlendState;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState>	m_depthStencilState;
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState>	m_rasterizerState;
+
+		std::vector<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> m_textures;
+
+		// System resources for sprite batching.
+		SpriteBatcher				m_batcher;
+		std::vector<SpriteBatch>	m_batches;
+		SpriteConstantBuffer		m_constantBufferData;
+
+		// Sprites already written to the vertex buffer since it was last discarded.
+		uint32	m_vertexBufferPosition;
+		uint32	m_drawCallCount;
+
+		// Variables used with the rendering loop.
+		bool	m_loadingComplete;
+	};
+}
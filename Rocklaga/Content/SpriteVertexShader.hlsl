@@ -0,0 +1,33 @@
+// A constant buffer that stores the transform from pixels to clip space, including display orientation.
+cbuffer SpriteConstantBuffer : register(b0)
+{
+	matrix transform;
+};
+
+// Per-vertex data used as input to the vertex shader.
+struct VertexShaderInput
+{
+	float2 pos : POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+// Per-pixel data passed through the pixel shader.
+struct PixelShaderInput
+{
+	float4 pos : SV_POSITION;
+	float2 uv : TEXCOORD0;
+	float4 color : COLOR0;
+};
+
+// Transforms sprite corners from pixels to clip space.
+PixelShaderInput main(VertexShaderInput input)
+{
+	PixelShaderInput output;
+
+	output.pos = mul(float4(input.pos, 0.0f, 1.0f), transform);
+	output.uv = input.uv;
+	output.color = input.color;
+
+	return output;
+}
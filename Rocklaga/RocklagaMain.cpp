@@ -7,9 +7,29 @@ using namespace Windows::Foundation;
 using namespace Windows::System::Threading;
 using namespace Concurrency;
 
+namespace
+{
+	// Reads the streaming loader keeps in flight at once.
+	static const uint32 MaxStreamingReads = 4;
+
+	// Frame time spent finalizing streamed assets, e.g. creating their buffers and textures.
+	static const double StreamingBudgetSeconds = 0.002;
+
+	// Frame time spent recreating registered buffers after device loss.
+	static const double RecoveryBudgetSeconds = 0.004;
+
+	// Particles thrown out of the cube each time the pointer lets go of it.
+	static const uint32 ReleaseBurstCount = 4096;
+}
+
 // Loads and initializes application assets when the application is loaded.
 RocklagaMain::RocklagaMain(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
-	m_deviceResources(deviceResources)
+	m_deviceResources(deviceResources),
+	m_streamingLoader(m_packageFileSystem, MaxStreamingReads),
+	m_recording(false),
+	m_gpuProfiler(deviceResources),
+	m_capturingProfile(false),
+	m_recovering(false)
 {
 	// Register to be notified if the Device is lost or recreated
 	m_deviceResources->RegisterDeviceNotify(this);
@@ -19,6 +39,11 @@ RocklagaMain::RocklagaMain(const std::shared_ptr<DX::DeviceResources>& deviceRes
 
 	m_fpsTextRenderer = std::unique_ptr<SampleFpsTextRenderer>(new SampleFpsTextRenderer(m_deviceResources));
 
+	// Room for several simultaneous explosions plus engine trails.
+	m_particleRenderer = std::unique_ptr<ParticleRenderer>(new ParticleRenderer(m_deviceResources, 65536));
+
+	m_spriteRenderer = std::unique_ptr<SpriteRenderer>(new SpriteRenderer(m_deviceResources));
+
 	// TODO: Change the timer settings if you want something other than the default variable timestep mode.
 	// e.g. for 60 FPS fixed timestep update logic, call:
 	/*
@@ -38,18 +63,180 @@ void RocklagaMain::CreateWindowSizeDependentResources()
 {
 	// TODO: Replace this with the size-dependent initialization of your app's content.
 	m_sceneRenderer->CreateWindowSizeDependentResources();
+	m_spriteRenderer->CreateWindowSizeDependentResources();
 }
 
 // Updates the application state once per frame.
 void RocklagaMain::Update() 
 {
+	DX::CpuScope updateScope("Update");
+
 	// Update scene objects.
 	m_timer.Tick([&]()
 	{ 
+		// Input is applied on the first step after it arrives, so a recording
+		// captures exactly which simulation step observed it.
+		for (auto& inputEvent : m_pendingInput)
+		{
+			inputEvent.frame = m_timer.GetFrameCount();
+			if (m_recording)
+			{
+				m_inputLog.Record(inputEvent.frame, inputEvent.type, inputEvent.positionX);
+			}
+			ApplyInput(inputEvent);
+		}
+		m_pendingInput.clear();
+
 		// TODO: Replace this with your app's content update functions.
 		m_sceneRenderer->Update(m_timer);
+		m_particleRenderer->Update(m_timer);
 		m_fpsTextRenderer->Update(m_timer);
 	});
+
+	if (m_recording)
+	{
+		m_inputLog.SetFrameCount(m_timer.GetFrameCount());
+	}
+
+	{
+		DX::CpuScope streamingScope("Streaming");
+		m_streamingLoader.Update(StreamingBudgetSeconds);
+	}
+
+	{
+		DX::CpuScope recoveryScope("ResourceRecovery");
+		auto registry = m_deviceResources->GetResourceRegistry();
+		registry->Update(RecoveryBudgetSeconds);
+
+		if (m_recovering && registry->GetPendingCount() == 0)
+		{
+			m_recovering = false;
+
+			// Blocking time is what HandleDeviceLost took; the rest was spread over frames.
+			wchar_t report[160];
+			swprintf_s(
+				report,
+				L"Device recovered: %.1f ms blocking, %.1f ms until every buffer was back, %.1f ms of it creating buffers\n",
+				m_deviceResources->GetLastDeviceRestoreSeconds() * 1000.0,
+				registry->GetLastRecoverySeconds() * 1000.0,
+				registry->GetLastCreateSeconds() * 1000.0
+				);
+			OutputDebugString(report);
+		}
+	}
+}
+
+void RocklagaMain::StartTracking()
+{
+	QueueInput(DX::InputEventType::StartTracking, 0.0f);
+}
+
+void RocklagaMain::TrackingUpdate(float positionX)
+{
+	// Store the position relative to the output width so recordings replay at any window size.
+	QueueInput(DX::InputEventType::TrackingUpdate, positionX / m_deviceResources->GetOutputSize().Width);
+}
+
+void RocklagaMain::StopTracking()
+{
+	QueueInput(DX::InputEventType::StopTracking, 0.0f);
+}
+
+void RocklagaMain::QueueInput(DX::InputEventType type, float positionX)
+{
+	DX::InputEvent inputEvent = { 0, type, positionX };
+	m_pendingInput.push_back(inputEvent);
+}
+
+void RocklagaMain::ApplyInput(const DX::InputEvent& inputEvent)
+{
+	switch (inputEvent.type)
+	{
+	case DX::InputEventType::StartTracking:
+		m_sceneRenderer->StartTracking();
+		break;
+
+	case DX::InputEventType::TrackingUpdate:
+		m_sceneRenderer->TrackingUpdate(inputEvent.positionX * m_deviceResources->GetOutputSize().Width);
+		break;
+
+	case DX::InputEventType::StopTracking:
+	{
+		m_sceneRenderer->StopTracking();
+
+		// Lets go of the cube with a burst of sparks, drifting up as they scatter.
+		ParticleEmitDesc burst = {};
+		burst.position = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+		burst.velocity = DirectX::XMFLOAT3(0.0f, 0.5f, 0.0f);
+		burst.speed = 2.0f;
+		burst.lifetime = 1.5f;
+		burst.size = 0.04f;
+		burst.color = 0xFF40A0FF;
+		m_particleRenderer->GetParticleSystem().Emit(burst, ReleaseBurstCount);
+		break;
+	}
+	}
+}
+
+// Begins recording input. Recording switches to a fixed 60 Hz timestep and restarts the
+// simulation clock so that a replay starts from exactly the same state.
+void RocklagaMain::StartRecording()
+{
+	m_timer = DX::StepTimer();
+	m_timer.SetFixedTimeStep(true);
+	m_timer.SetTargetElapsedSeconds(1.0 / 60);
+
+	m_sceneRenderer->StopTracking();
+	m_particleRenderer->GetParticleSystem().Clear();
+	m_pendingInput.clear();
+
+	m_inputLog.Clear();
+	m_inputLog.SetStepTicks(DX::StepTimer::SecondsToTicks(1.0 / 60));
+	m_recording = true;
+}
+
+DX::InputLog RocklagaMain::StopRecording()
+{
+	m_recording = false;
+	return m_inputLog;
+}
+
+// Runs the simulation for every step in the log as fast as possible, without rendering.
+// The timer is driven by a fake clock, so the result does not depend on wall-clock time.
+// Returns false, without running anything, for a log that has no step length.
+bool RocklagaMain::Replay(const DX::InputLog& log)
+{
+	if (log.GetStepTicks() == 0)
+	{
+		return false;
+	}
+
+	DX::StepTimer replayTimer;
+	replayTimer.SetFixedTimeStep(true);
+	replayTimer.SetTargetElapsedTicks(log.GetStepTicks());
+
+	m_sceneRenderer->StopTracking();
+	m_particleRenderer->GetParticleSystem().Clear();
+
+	const auto& events = log.GetEvents();
+	size_t nextEvent = 0;
+
+	while (replayTimer.GetFrameCount() < log.GetFrameCount())
+	{
+		replayTimer.TickFake(log.GetStepTicks(), [&]()
+		{
+			while (nextEvent < events.size() && events[nextEvent].frame <= replayTimer.GetFrameCount())
+			{
+				ApplyInput(events[nextEvent++]);
+			}
+
+			m_sceneRenderer->Update(replayTimer);
+			m_particleRenderer->Update(replayTimer);
+			m_fpsTextRenderer->Update(replayTimer);
+		});
+	}
+
+	return true;
 }
 
 // Renders the current frame according to the current application state.
@@ -62,6 +249,12 @@ bool RocklagaMain::Render()
 		return false;
 	}
 
+	DX::CpuScope renderScope("Render");
+	m_gpuProfiler.BeginFrame();
+
+	// Transient render data from FrameCount updates ago is no longer in use.
+	m_deviceResources->GetFrameArena()->BeginFrame(m_timer.GetFrameCount());
+
 	auto context = m_deviceResources->GetD3DDeviceContext();
 
 	// Reset the viewport to target the whole screen.
@@ -76,25 +269,84 @@ bool RocklagaMain::Render()
 	context->ClearRenderTargetView(m_deviceResources->GetBackBufferRenderTargetView(), DirectX::Colors::CornflowerBlue);
 	context->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
-	// Render the scene objects.
+	// Render the scene objects, timing each renderer on the CPU and the GPU.
 	// TODO: Replace this with your app's content rendering functions.
-	m_sceneRenderer->Render();
-	m_fpsTextRenderer->Render();
+	{
+		DX::CpuScope cpuScope("Scene");
+		DX::GpuScope gpuScope(m_gpuProfiler, "Scene");
+		m_sceneRenderer->Render();
+	}
+	{
+		DX::CpuScope cpuScope("Particles");
+		DX::GpuScope gpuScope(m_gpuProfiler, "Particles");
+		m_particleRenderer->Render(m_sceneRenderer->GetViewMatrix(), m_sceneRenderer->GetProjectionMatrix());
+	}
+	{
+		DX::CpuScope cpuScope("Sprites");
+		DX::GpuScope gpuScope(m_gpuProfiler, "Sprites");
+		m_spriteRenderer->Render();
+	}
+	{
+		DX::CpuScope cpuScope("FpsText");
+		DX::GpuScope gpuScope(m_gpuProfiler, "FpsText");
+		m_fpsTextRenderer->Render();
+	}
+
+	m_gpuProfiler.EndFrame();
+
+	if (m_capturingProfile)
+	{
+		DX::CollectCpuEvents(m_profileCapture);
+		m_gpuProfiler.CollectEvents(m_profileCapture);
+	}
 
 	return true;
 }
 
+void RocklagaMain::StartProfileCapture()
+{
+	// Throw away whatever was recorded before the capture started.
+	std::vector<DX::ProfileEvent> discarded;
+	DX::CollectCpuEvents(discarded);
+	m_gpuProfiler.CollectEvents(discarded);
+
+	m_profileCapture.clear();
+	m_capturingProfile = true;
+}
+
+std::string RocklagaMain::StopProfileCapture()
+{
+	DX::CollectCpuEvents(m_profileCapture);
+	m_capturingProfile = false;
+
+	std::string trace = DX::ExportChromeTrace(m_profileCapture);
+	m_profileCapture.clear();
+	return trace;
+}
+
 // Notifies renderers that device resources need to be released.
 void RocklagaMain::OnDeviceLost()
 {
+	// Renderers request their assets again when the device is restored.
+	m_streamingLoader.CancelAll();
+
 	m_sceneRenderer->ReleaseDeviceDependentResources();
+	m_particleRenderer->ReleaseDeviceDependentResources();
+	m_spriteRenderer->ReleaseDeviceDependentResources();
 	m_fpsTextRenderer->ReleaseDeviceDependentResources();
+	m_gpuProfiler.ReleaseDeviceDependentResources();
 }
 
 // Notifies renderers that device resources may now be recreated.
 void RocklagaMain::OnDeviceRestored()
 {
 	m_sceneRenderer->CreateDeviceDependentResources();
+	m_particleRenderer->CreateDeviceDependentResources();
+	m_spriteRenderer->CreateDeviceDependentResources();
 	m_fpsTextRenderer->CreateDeviceDependentResources();
+	m_gpuProfiler.CreateDeviceDependentResources();
 	CreateWindowSizeDependentResources();
+
+	// Registered buffers are recreated over the next few updates.
+	m_recovering = true;
 }
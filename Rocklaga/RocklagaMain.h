@@ -2,8 +2,14 @@
 
 #include "Common\StepTimer.h"
 #include "Common\DeviceResources.h"
+#include "Common\GpuProfiler.h"
+#include "Common\InputLog.h"
+#include "Common\PackageFileSystem.h"
+#include "Common\StreamingLoader.h"
 #include "Content\Sample3DSceneRenderer.h"
 #include "Content\SampleFpsTextRenderer.h"
+#include "Content\ParticleRenderer.h"
+#include "Content\SpriteRenderer.h"
 
 // Renders Direct2D and 3D content on the screen.
 namespace Rocklaga
@@ -17,19 +23,59 @@ namespace Rocklaga
 		void Update();
 		bool Render();
 
+		// Pointer input. Events are applied at the start of the next simulation step.
+		void StartTracking();
+		void TrackingUpdate(float positionX);
+		void StopTracking();
+
+		// Input recording and replay.
+		void StartRecording();
+		DX::InputLog StopRecording();
+		bool IsRecording() const { return m_recording; }
+		bool Replay(const DX::InputLog& log);
+
+		// Profiling. Every CPU and GPU scope between the two calls is kept, and returned as
+		// Chrome trace event JSON. GPU scopes of the last few frames are still in flight and
+		// are left out.
+		void StartProfileCapture();
+		std::string StopProfileCapture();
+		bool IsCapturingProfile() const { return m_capturingProfile; }
+
 		// IDeviceNotify
 		virtual void OnDeviceLost();
 		virtual void OnDeviceRestored();
 
 	private:
+		void QueueInput(DX::InputEventType type, float positionX);
+		void ApplyInput(const DX::InputEvent& inputEvent);
+
 		// Cached pointer to device resources.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 
 		// TODO: Replace with your own content renderers.
 		std::unique_ptr<Sample3DSceneRenderer> m_sceneRenderer;
 		std::unique_ptr<SampleFpsTextRenderer> m_fpsTextRenderer;
+		std::unique_ptr<ParticleRenderer> m_particleRenderer;
+		std::unique_ptr<SpriteRenderer> m_spriteRenderer;
 
 		// Rendering loop timer.
 		DX::StepTimer m_timer;
+
+		// Streams assets in the background and finalizes them a few at a time each frame.
+		DX::PackageFileSystem m_packageFileSystem;
+		DX::StreamingLoader m_streamingLoader;
+
+		// Input received since the last simulation step, and the log it is recorded into.
+		std::vector<DX::InputEvent> m_pendingInput;
+		DX::InputLog m_inputLog;
+		bool m_recording;
+
+		// Times each renderer on the GPU, and the scopes captured so far.
+		DX::GpuProfiler m_gpuProfiler;
+		std::vector<DX::ProfileEvent> m_profileCapture;
+		bool m_capturingProfile;
+
+		// Set from device loss until every registered buffer has been recreated.
+		bool m_recovering;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+﻿#include "Profiler.h"
+#include "Check.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+	// Each depth has its own name, so an event put together from two different scopes shows
+	// up as a name at the wrong depth.
+	const char* const ScopeNames[] = { "Frame", "Update", "Simulate" };
+
+	// Fields that don't belong to the scope the rest of the event came from.
+	bool IsTorn(const ProfileEvent& profileEvent, uint64_t collectTime)
+	{
+		if (profileEvent.depth >= 3 || profileEvent.name != ScopeNames[profileEvent.depth])
+			return true;
+
+		return profileEvent.start + profileEvent.duration > collectTime;
+	}
+
+	// Writers record nested scopes as fast as they can while the collector runs every
+	// millisecond, so the rings wrap between collections and slots are overwritten while
+	// being copied. Nothing collected may be torn, and every scope is either collected or
+	// counted as lost. Built with the thread sanitizer where available.
+	void TestConcurrentCollect()
+	{
+		const int writerCount = 3;
+
+		std::atomic<bool> stop(false);
+		std::atomic<uint64_t> recorded(0);
+		std::vector<std::thread> writers;
+
+		for (int writer = 0; writer < writerCount; writer++)
+		{
+			writers.emplace_back([&]()
+			{
+				uint64_t count = 0;
+				while (!stop)
+				{
+					CpuScope frame(ScopeNames[0]);
+					CpuScope update(ScopeNames[1]);
+					CpuScope simulate(ScopeNames[2]);
+					count += 3;
+				}
+				recorded += count;
+			});
+		}
+
+		uint64_t collected = 0;
+		uint64_t lost = 0;
+		uint64_t torn = 0;
+		uint64_t unordered = 0;
+		std::map<uint32_t, uint64_t> lastFrameStarts;
+
+		auto collect = [&]()
+		{
+			std::vector<ProfileEvent> events;
+			lost += CollectCpuEvents(events);
+			uint64_t collectTime = GetProfilerTime();
+
+			for (const ProfileEvent& profileEvent : events)
+			{
+				if (IsTorn(profileEvent, collectTime))
+				{
+					torn++;
+					continue;
+				}
+
+				// A thread's outermost scopes finish in the order they started.
+				if (profileEvent.depth == 0)
+				{
+					uint64_t& lastStart = lastFrameStarts[profileEvent.threadId];
+					if (profileEvent.start < lastStart)
+					{
+						unordered++;
+					}
+					lastStart = profileEvent.start;
+				}
+			}
+
+			collected += events.size();
+		};
+
+		for (int i = 0; i < 50; i++)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			collect();
+		}
+
+		stop = true;
+		for (auto& writer : writers)
+		{
+			writer.join();
+		}
+		collect();
+
+		CHECK(torn == 0);
+		CHECK(unordered == 0);
+		CHECK(collected > 0);
+		CHECK(lastFrameStarts.size() == writerCount);
+		CHECK(collected + lost == recorded);
+
+		// Everything has been collected.
+		std::vector<ProfileEvent> events;
+		CHECK(CollectCpuEvents(events) == 0);
+		CHECK(events.empty());
+	}
+}
+
+int main()
+{
+	TestConcurrentCollect();
+	return CheckResult();
+}
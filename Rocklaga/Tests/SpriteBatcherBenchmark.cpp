@@ -0,0 +1,119 @@
+﻿//
+// SpriteBatcherBenchmark.cpp
+//
+
+#include "SpriteBatcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace Rocklaga;
+using namespace DirectX;
+
+namespace
+{
+	// Small deterministic noise, so every run queues the same sprites.
+	class Noise
+	{
+	public:
+		Noise() : m_state(12345) {}
+
+		uint32_t Next(uint32_t range)
+		{
+			m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+			return static_cast<uint32_t>((m_state >> 33) % range);
+		}
+
+	private:
+		uint64_t m_state;
+	};
+
+	// A frame's worth of sprites, like a busy 2D scene: a few layers, mostly alpha blended,
+	// drawn from a handful of atlas pages, a quarter of them rotated.
+	std::vector<Sprite> GenerateSprites(uint32_t count)
+	{
+		Noise random;
+		std::vector<Sprite> sprites(count);
+		for (Sprite& sprite : sprites)
+		{
+			sprite.destination = XMFLOAT4(static_cast<float>(random.Next(1920)), static_cast<float>(random.Next(1080)), 32.0f, 32.0f);
+			sprite.source = XMFLOAT4(0.0f, 0.0f, 0.25f, 0.25f);
+			sprite.color = 0xFFFFFFFF;
+			sprite.rotation = (random.Next(4) == 0) ? static_cast<float>(random.Next(628)) * 0.01f : 0.0f;
+			sprite.texture = random.Next(8);
+			sprite.blend = (random.Next(8) == 0) ? SpriteBlend::Additive : SpriteBlend::AlphaBlend;
+			sprite.layer = static_cast<uint8_t>(random.Next(4));
+		}
+		return sprites;
+	}
+
+	double Milliseconds(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	// Times what SpriteRenderer::Render does on the CPU for a frame: queue, sort, and write
+	// the vertices and batches, here into a CPU buffer rather than a mapped vertex buffer.
+	void Run(uint32_t count)
+	{
+		std::vector<Sprite> sprites = GenerateSprites(count);
+		std::vector<SpriteVertex> vertices(static_cast<size_t>(count) * 4);
+		std::vector<SpriteBatch> batches;
+
+		SpriteBatcher batcher;
+		const int frames = (count <= 100000) ? 50 : 10;
+		double queueMilliseconds = 0.0;
+		double sortMilliseconds = 0.0;
+		double writeMilliseconds = 0.0;
+
+		// One frame first, so the batcher's lists have grown to size before timing.
+		for (int frame = -1; frame < frames; frame++)
+		{
+			auto start = std::chrono::steady_clock::now();
+
+			batcher.Begin();
+			for (const Sprite& sprite : sprites)
+			{
+				batcher.Draw(sprite);
+			}
+
+			auto queued = std::chrono::steady_clock::now();
+
+			batcher.Sort();
+
+			auto sorted = std::chrono::steady_clock::now();
+
+			batcher.WriteVertices(0, count, vertices.data());
+			batcher.BuildBatches(0, count, batches);
+
+			auto written = std::chrono::steady_clock::now();
+
+			if (frame >= 0)
+			{
+				queueMilliseconds += Milliseconds(start, queued);
+				sortMilliseconds += Milliseconds(queued, sorted);
+				writeMilliseconds += Milliseconds(sorted, written);
+			}
+		}
+
+		queueMilliseconds /= frames;
+		sortMilliseconds /= frames;
+		writeMilliseconds /= frames;
+		double totalMilliseconds = queueMilliseconds + sortMilliseconds + writeMilliseconds;
+
+		std::printf("%8u sprites: %7.3f ms (queue %.3f, sort %.3f, write %.3f), %6.1f M sprites/s, %zu batches\n",
+			count, totalMilliseconds, queueMilliseconds, sortMilliseconds, writeMilliseconds,
+			count / totalMilliseconds / 1000.0, batches.size());
+	}
+}
+
+// Batches 10k to 1M sprites, as one frame's worth each.
+int main()
+{
+	for (uint32_t count : { 10000u, 100000u, 1000000u })
+	{
+		Run(count);
+	}
+	return 0;
+}
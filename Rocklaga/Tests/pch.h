@@ -0,0 +1,5 @@
+﻿#pragma once
+
+// Stands in for the app's precompiled header, which needs the Windows SDK, when the portable
+// tests build sources from Common and Content.
+#include <memory>